@@ -0,0 +1,342 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include "AsyncConvert.h"
+#include "ScratchArena.h"
+
+static constexpr uint32_t DEFAULT_ASYNC_QUEUE_CAPACITY = 256;
+static constexpr uint64_t SLOT_STATE_MASK = 0xffffffffu;
+
+//executor of the current thread, set for the lifetime of each worker
+static thread_local AsyncConverter const *currentConverter = nullptr;
+
+static uint64_t makeSlotState(ConvertTicket const ticket, uint64_t const state) {
+    return (ticket & ~SLOT_STATE_MASK) | state;
+}
+
+/**
+ * Wake a thread sleeping on 'condition' after publishing what it waits for. The fence pairs with the one of the sleeper
+ * between registering in 'sleepers' and checking again, one of the two sees the other.
+ */
+static void wakeSleeper(std::atomic<size_t> const &sleepers, std::mutex &mutex, std::condition_variable &condition,
+                        bool const all) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (all) {
+        condition.notify_all();
+    } else {
+        condition.notify_one();
+    }
+}
+
+AsyncConverter::AsyncConverter(AsyncConvertOptions const &options)
+        : backpressure(options.backpressure),
+          slotCount(options.queueCapacity == 0 ? DEFAULT_ASYNC_QUEUE_CAPACITY : options.queueCapacity),
+          freeSlots(slotCount), submissions(slotCount) {
+    //tickets of a replaced executor don't match the slots of the new one
+    static std::atomic<uint32_t> executorCount{0};
+    uint32_t const firstGeneration = (executorCount.fetch_add(1) & 0xff) << 24;
+
+    slots = std::make_unique<Slot[]>(slotCount);
+    for (uint32_t i = 0; i < slotCount; i++) {
+        slots[i].generation = firstGeneration;
+        slots[i].state.store((static_cast<uint64_t>(firstGeneration) << 32) | SLOT_COLLECTED);
+        freeSlots.push(i);
+    }
+
+    size_t const workers = options.workers == 0 ? std::max<size_t>(std::thread::hardware_concurrency(), 1)
+                                                : options.workers;
+    for (size_t i = 0; i < workers; i++) {
+        threads.emplace_back(&AsyncConverter::run, this);
+    }
+}
+
+AsyncConverter::~AsyncConverter() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto &thread: threads) {
+        thread.join();
+    }
+}
+
+ConvertStatus AsyncConverter::submit(ConvertJob *const job, ConvertCallback const callback, void *const userData,
+                                     ConvertTicket &ticket) {
+    ticket = 0;
+    uint32_t index = 0;
+    if (!freeSlots.pop(index)) {
+        //a callback waiting for a slot could wait for itself
+        if (backpressure == ASYNC_BACKPRESSURE_REJECT || currentConverter == this) {
+            return CONVERT_ERROR_QUEUE_FULL;
+        }
+        std::unique_lock<std::mutex> lock(stateMutex);
+        waitingSubmitters.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        slotAvailable.wait(lock, [&] { return freeSlots.pop(index); });
+        waitingSubmitters.fetch_sub(1);
+    }
+
+    Slot &slot = slots[index];
+    slot.generation = slot.generation == UINT32_MAX ? 1 : slot.generation + 1;
+    slot.job = job;
+    slot.callback = callback;
+    slot.userData = userData;
+    job->output.size = 0;
+    job->output.content = nullptr;
+    job->status = CONVERT_PENDING;
+    slot.references.store(2, std::memory_order_relaxed);
+    ticket = (static_cast<uint64_t>(slot.generation) << 32) | index;
+    slot.state.store(makeSlotState(ticket, SLOT_QUEUED), std::memory_order_release);
+
+    //never full, there are as many cells as slots
+    submissions.push(ticket);
+    wakeSleeper(sleepingWorkers, stateMutex, workAvailable, false);
+    return CONVERT_OK;
+}
+
+ConvertStatus AsyncConverter::wait(ConvertTicket const ticket, uint32_t const timeout) {
+    Slot *const slot = findSlot(ticket);
+    if (slot == nullptr) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    //completed by this call, or the ticket is gone: collected, released by a callback or reused
+    bool collected = false;
+    bool invalid = false;
+    auto const tryCollect = [&]() {
+        uint64_t expected = makeSlotState(ticket, SLOT_COMPLETED);
+        if (slot->state.compare_exchange_strong(expected, makeSlotState(ticket, SLOT_COLLECTED),
+                                                std::memory_order_acquire)) {
+            collected = true;
+        } else {
+            invalid = expected == makeSlotState(ticket, SLOT_COLLECTED) || (expected & ~SLOT_STATE_MASK)
+                                                                          != (ticket & ~SLOT_STATE_MASK);
+        }
+        return collected || invalid;
+    };
+
+    if (!tryCollect() && timeout > 0) {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        waitingCollectors.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (timeout == UINT32_MAX) {
+            jobCompleted.wait(lock, tryCollect);
+        } else {
+            jobCompleted.wait_for(lock, std::chrono::milliseconds(timeout), tryCollect);
+        }
+        waitingCollectors.fetch_sub(1);
+    }
+    if (!collected) {
+        return invalid ? CONVERT_ERROR_INVALID_ARGUMENT : CONVERT_PENDING;
+    }
+
+    ConvertStatus const status = slot->job->status;
+    release(*slot);
+    return status;
+}
+
+ConvertStatus AsyncConverter::cancel(ConvertTicket const ticket) {
+    Slot *const slot = findSlot(ticket);
+    if (slot == nullptr) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    uint64_t expected = makeSlotState(ticket, SLOT_QUEUED);
+    if (!slot->state.compare_exchange_strong(expected, makeSlotState(ticket, SLOT_RUNNING),
+                                             std::memory_order_acquire)) {
+        bool const started = expected == makeSlotState(ticket, SLOT_RUNNING)
+                             || expected == makeSlotState(ticket, SLOT_COMPLETED);
+        return started ? CONVERT_PENDING : CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    //the ticket stays in the submission queue, the worker popping it only drops its reference
+    slot->job->status = CONVERT_CANCELLED;
+    complete(*slot, ticket);
+    return CONVERT_OK;
+}
+
+AsyncConverter::Slot *AsyncConverter::findSlot(ConvertTicket const ticket) {
+    uint64_t const index = ticket & SLOT_STATE_MASK;
+    return ticket == 0 || index >= slotCount ? nullptr : &slots[index];
+}
+
+void AsyncConverter::execute(ConvertTicket const ticket) {
+    Slot &slot = slots[ticket & SLOT_STATE_MASK];
+    uint64_t expected = makeSlotState(ticket, SLOT_QUEUED);
+    if (slot.state.compare_exchange_strong(expected, makeSlotState(ticket, SLOT_RUNNING),
+                                           std::memory_order_acquire)) {
+        //buffers reused by every job executed on this thread
+        ArenaScope arena;
+
+        {
+            ErrorOutputScope const errors(false);
+            slot.job->status = runConvertJob(*slot.job, arena.arena.getImageData());
+        }
+        //the reference of the queue first, the ticket keeps the slot: once collected, the slot is free for a submit
+        release(slot);
+        complete(slot, ticket);
+        return;
+    }
+    release(slot);
+}
+
+void AsyncConverter::complete(Slot &slot, ConvertTicket const ticket) {
+    if (slot.callback != nullptr) {
+        slot.state.store(makeSlotState(ticket, SLOT_COLLECTED), std::memory_order_release);
+        slot.callback(ticket, slot.job, slot.userData);
+        release(slot);
+    } else {
+        slot.state.store(makeSlotState(ticket, SLOT_COMPLETED), std::memory_order_release);
+    }
+    //also wakes the collectors of a ticket released by its callback, they return an error
+    wakeSleeper(waitingCollectors, stateMutex, jobCompleted, true);
+}
+
+void AsyncConverter::release(Slot &slot) {
+    if (slot.references.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    freeSlots.push(static_cast<uint32_t>(&slot - slots.get()));
+    wakeSleeper(waitingSubmitters, stateMutex, slotAvailable, false);
+}
+
+void AsyncConverter::run() {
+    currentConverter = this;
+
+    ConvertTicket ticket = 0;
+    while (true) {
+        if (submissions.pop(ticket)) {
+            execute(ticket);
+            continue;
+        }
+
+        //queued jobs are executed before stopping
+        std::unique_lock<std::mutex> lock(stateMutex);
+        sleepingWorkers.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool popped = false;
+        workAvailable.wait(lock, [&] { return (popped = submissions.pop(ticket)) || stopping; });
+        sleepingWorkers.fetch_sub(1);
+        lock.unlock();
+        if (!popped) {
+            return;
+        }
+        execute(ticket);
+    }
+}
+
+static std::mutex asyncConverterMutex;
+static std::shared_ptr<AsyncConverter> asyncConverter;
+static AsyncConvertOptions asyncConvertOptions{};
+
+std::shared_ptr<AsyncConverter> getAsyncConverter() {
+    std::lock_guard<std::mutex> lock(asyncConverterMutex);
+    if (!asyncConverter) {
+        asyncConverter = std::make_shared<AsyncConverter>(asyncConvertOptions);
+    }
+    return asyncConverter;
+}
+
+/**
+ * Configure the executor of the asynchronous conversions. The previous executor runs its queued jobs and is destroyed
+ * by this call, or by the last call still using it. Its tickets not collected are discarded. Must not be called from a
+ * callback.
+ *
+ * @param options Threads, capacity and backpressure, nullptr for the defaults
+ * @return CONVERT_OK on success
+ */
+[[maybe_unused]] ConvertStatus setAsyncConvertOptions(AsyncConvertOptions const *const options) {
+    AsyncConvertOptions const resolved = options == nullptr ? AsyncConvertOptions{} : *options;
+    if (resolved.backpressure != ASYNC_BACKPRESSURE_BLOCK && resolved.backpressure != ASYNC_BACKPRESSURE_REJECT) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::shared_ptr<AsyncConverter> previous;
+    {
+        std::lock_guard<std::mutex> lock(asyncConverterMutex);
+        asyncConvertOptions = resolved;
+        previous = std::move(asyncConverter);
+    }
+    return CONVERT_OK;
+}
+
+/**
+ * Queue a conversion on the executor and return immediately. The job is run like a job of convertBatch: the input is
+ * borrowed and must stay valid until the job completes, the output is allocated with malloc. Errors are not printed.
+ *
+ * @param job The conversion, 'output' and 'status' are written when it completes. Must stay valid until then.
+ * @param callback Called when the job completes or is cancelled, then the ticket is released. nullptr to collect the
+ *            status with pollConvertJob or waitConvertJob.
+ * @param userData Passed unmodified to 'callback'
+ * @param ticket Receives the ticket of the job
+ * @return CONVERT_OK when queued, CONVERT_ERROR_QUEUE_FULL when every ticket is in use and the backpressure is
+ *            ASYNC_BACKPRESSURE_REJECT, or the call comes from a callback
+ */
+[[maybe_unused]] ConvertStatus submitConvertJob(ConvertJob *const job, ConvertCallback const callback,
+                                                void *const userData, ConvertTicket *const ticket) {
+    if (job == nullptr || ticket == nullptr) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    return getAsyncConverter()->submit(job, callback, userData, *ticket);
+}
+
+/**
+ * Check a job without waiting, same as waitConvertJob with a zero timeout
+ */
+[[maybe_unused]] ConvertStatus pollConvertJob(ConvertTicket const ticket) {
+    return getAsyncConverter()->wait(ticket, 0);
+}
+
+/**
+ * Wait for a job submitted without a callback. Once its status is returned, the ticket is released.
+ *
+ * @param ticket The ticket of the job
+ * @param timeout Milliseconds, UINT32_MAX to wait until the job completes
+ * @return The status of the job, CONVERT_CANCELLED if it was cancelled, CONVERT_PENDING if it has not completed in
+ *            time, CONVERT_ERROR_INVALID_ARGUMENT if the ticket is unknown or already released
+ */
+[[maybe_unused]] ConvertStatus waitConvertJob(ConvertTicket const ticket, uint32_t const timeout) {
+    return getAsyncConverter()->wait(ticket, timeout);
+}
+
+/**
+ * Cancel a job that has not started. It completes with CONVERT_CANCELLED before this call returns: its callback is
+ * called on this thread, or its status is collected as usual.
+ *
+ * @param ticket The ticket of the job
+ * @return CONVERT_OK when cancelled, CONVERT_PENDING when it already started and completes normally,
+ *            CONVERT_ERROR_INVALID_ARGUMENT if the ticket is unknown or already released
+ */
+[[maybe_unused]] ConvertStatus cancelConvertJob(ConvertTicket const ticket) {
+    return getAsyncConverter()->cancel(ticket);
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BatchConvert.h"
+#include "BoundedQueue.h"
+
+/**
+ * Identifies a submitted job until its status is collected, 0 is never a valid ticket
+ */
+typedef uint64_t ConvertTicket;
+
+/**
+ * Called on an executor thread when a job completes, or on the thread cancelling it. 'job' holds the status and the
+ * output, the ticket is released when the callback returns.
+ */
+typedef void (*ConvertCallback)(ConvertTicket ticket, ConvertJob *job, void *userData);
+
+//what submitConvertJob does when every ticket is in use
+enum AsyncBackpressure : int {
+    //wait for a ticket to be released. Submissions from a callback never wait, they are rejected.
+    ASYNC_BACKPRESSURE_BLOCK = 0,
+    //return CONVERT_ERROR_QUEUE_FULL
+    ASYNC_BACKPRESSURE_REJECT = 1,
+};
+
+/**
+ * Executor of the asynchronous conversions, zero-initialized it is one thread per hardware thread and 256 tickets with
+ * blocking submissions
+ */
+class AsyncConvertOptions {
+public:
+    //executor threads, 0 for one per hardware thread
+    unsigned int workers;
+    //jobs queued, running or completed and not collected yet, 0 for 256
+    uint32_t queueCapacity;
+    AsyncBackpressure backpressure;
+};
+
+/**
+ * Runs ConvertJobs on its own threads. Tickets go through a bounded lock-free queue. A ticket holds a slot from its
+ * submission until its status is collected, so the slots bound the memory of pending jobs.
+ */
+class AsyncConverter {
+public:
+    explicit AsyncConverter(AsyncConvertOptions const &options);
+
+    /**
+     * Queued jobs are executed before the threads exit, tickets not collected are discarded
+     */
+    ~AsyncConverter();
+
+    AsyncConverter(AsyncConverter const &) = delete;
+
+    AsyncConverter &operator=(AsyncConverter const &) = delete;
+
+    ConvertStatus submit(ConvertJob *job, ConvertCallback callback, void *userData, ConvertTicket &ticket);
+
+    /**
+     * @param timeout Milliseconds, UINT32_MAX to wait until the job completes and 0 to poll
+     * @return The status of the job, releasing the ticket, or CONVERT_PENDING
+     */
+    ConvertStatus wait(ConvertTicket ticket, uint32_t timeout);
+
+    ConvertStatus cancel(ConvertTicket ticket);
+
+private:
+    enum SlotState : uint64_t {
+        SLOT_QUEUED = 0,
+        //claimed by a worker or by cancel
+        SLOT_RUNNING = 1,
+        SLOT_COMPLETED = 2,
+        SLOT_COLLECTED = 3,
+    };
+
+    class Slot {
+    public:
+        //generation of the current ticket in the high 32 bits and SlotState in the low bits, so a transition only
+        //succeeds for the ticket it was meant for
+        std::atomic<uint64_t> state{SLOT_COLLECTED};
+        //one held by the submission queue and one by the ticket, the slot is free when both are released
+        std::atomic<int> references{0};
+        uint32_t generation = 0;
+        ConvertJob *job = nullptr;
+        ConvertCallback callback = nullptr;
+        void *userData = nullptr;
+    };
+
+    Slot *findSlot(ConvertTicket ticket);
+
+    void execute(ConvertTicket ticket);
+
+    void complete(Slot &slot, ConvertTicket ticket);
+
+    void release(Slot &slot);
+
+    void run();
+
+    AsyncBackpressure backpressure;
+    std::unique_ptr<Slot[]> slots;
+    uint32_t slotCount = 0;
+    BoundedQueue<uint32_t> freeSlots;
+    BoundedQueue<ConvertTicket> submissions;
+    std::vector<std::thread> threads;
+
+    //threads sleep only when there is nothing to pop, the lock is taken to wake them only when someone sleeps
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable slotAvailable;
+    std::condition_variable jobCompleted;
+    std::atomic<size_t> sleepingWorkers{0};
+    std::atomic<size_t> waitingSubmitters{0};
+    std::atomic<size_t> waitingCollectors{0};
+    bool stopping = false;
+};
+
+/**
+ * The executor of the asynchronous API, created on first use
+ */
+std::shared_ptr<AsyncConverter> getAsyncConverter();
+
+extern "C" {
+[[maybe_unused]] LIBEXPORT ConvertStatus setAsyncConvertOptions(AsyncConvertOptions const *options);
+[[maybe_unused]] LIBEXPORT ConvertStatus submitConvertJob(ConvertJob *job, ConvertCallback callback, void *userData,
+                                                          ConvertTicket *ticket);
+[[maybe_unused]] LIBEXPORT ConvertStatus pollConvertJob(ConvertTicket ticket);
+[[maybe_unused]] LIBEXPORT ConvertStatus waitConvertJob(ConvertTicket ticket, uint32_t timeout);
+[[maybe_unused]] LIBEXPORT ConvertStatus cancelConvertJob(ConvertTicket ticket);
+}
@@ -0,0 +1,768 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include "BCDecoder.h"
+#include "BCTables.h"
+#include "CpuFeatures.h"
+#include "ScratchArena.h"
+#include "ThreadPool.h"
+
+//blocks decoded by each task, a task per block row is too small for narrow images
+static constexpr size_t BC_DECODE_TASK_BLOCKS = 16384;
+
+/**
+ * Reader of the 128 bits of a BC6H or BC7 block, least significant bit first
+ */
+class BlockBits {
+public:
+    explicit BlockBits(unsigned char const *const block) {
+        for (int i = 7; i >= 0; i--) {
+            low = (low << 8u) | block[i];
+            high = (high << 8u) | block[i + 8];
+        }
+    }
+
+    unsigned int read(unsigned int const count) {
+        uint64_t value;
+        if (position >= 64) {
+            value = high >> (position - 64);
+        } else if (position + count <= 64) {
+            value = low >> position;
+        } else {
+            value = (low >> position) | (high << (64 - position));
+        }
+        position += count;
+        return static_cast<unsigned int>(value & ((uint64_t{1} << count) - 1));
+    }
+
+private:
+    uint64_t low = 0;
+    uint64_t high = 0;
+    unsigned int position = 0;
+};
+
+static void writeBlock(unsigned char const *const pixels, unsigned char *const output, size_t const rowPitch) {
+    for (size_t row = 0; row < 4; row++) {
+        std::memcpy(output + row * rowPitch, pixels + row * 16, 16);
+    }
+}
+
+static void decodeBC1Block(unsigned char const *const block, bool const allowTransparent,
+                           unsigned char *const pixels) {
+    unsigned char palette[16];
+    getBC1Palette(block, allowTransparent, palette);
+    unsigned int const indices = block[4] | (block[5] << 8u) | (block[6] << 16u)
+                                 | (static_cast<unsigned int>(block[7]) << 24u);
+    for (unsigned int i = 0; i < 16; i++) {
+        std::memcpy(pixels + i * 4, palette + ((indices >> (i * 2)) & 3u) * 4, 4);
+    }
+}
+
+static void decodeBC4Block(unsigned char const *const block, bool const snorm, unsigned char *const pixels,
+                           size_t const stride) {
+    unsigned char palette[8];
+    getBC4Palette(block, snorm, palette);
+    uint64_t const indices = getBC4Indices(block);
+    for (unsigned int i = 0; i < 16; i++) {
+        pixels[i * stride] = palette[(indices >> (i * 3)) & 7u];
+    }
+}
+
+void decodeBC1RowScalar(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                        size_t const rowPitch) {
+    unsigned char pixels[64];
+    for (size_t b = 0; b < blockCount; b++) {
+        decodeBC1Block(blocks + b * 8, true, pixels);
+        writeBlock(pixels, output + b * 16, rowPitch);
+    }
+}
+
+void decodeBC2RowScalar(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                        size_t const rowPitch) {
+    unsigned char pixels[64];
+    for (size_t b = 0; b < blockCount; b++) {
+        unsigned char const *block = blocks + b * 16;
+        decodeBC1Block(block + 8, false, pixels);
+        for (unsigned int i = 0; i < 16; i++) {
+            unsigned int const alpha = (block[i / 2] >> ((i & 1u) * 4)) & 0xfu;
+            pixels[i * 4 + 3] = static_cast<unsigned char>(alpha * 17);
+        }
+        writeBlock(pixels, output + b * 16, rowPitch);
+    }
+}
+
+void decodeBC3RowScalar(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                        size_t const rowPitch) {
+    unsigned char pixels[64];
+    for (size_t b = 0; b < blockCount; b++) {
+        unsigned char const *block = blocks + b * 16;
+        decodeBC1Block(block + 8, false, pixels);
+        decodeBC4Block(block, false, pixels + 3, 4);
+        writeBlock(pixels, output + b * 16, rowPitch);
+    }
+}
+
+static void decodeBC4Row(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                         size_t const rowPitch, bool const snorm) {
+    unsigned char pixels[64];
+    for (size_t b = 0; b < blockCount; b++) {
+        decodeBC4Block(blocks + b * 8, snorm, pixels, 4);
+        for (unsigned int i = 0; i < 16; i++) {
+            pixels[i * 4 + 1] = pixels[i * 4];
+            pixels[i * 4 + 2] = pixels[i * 4];
+            pixels[i * 4 + 3] = 0xff;
+        }
+        writeBlock(pixels, output + b * 16, rowPitch);
+    }
+}
+
+static void decodeBC5Row(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                         size_t const rowPitch, bool const snorm) {
+    unsigned char pixels[64];
+    //the missing blue channel is 0, biased like the others for the signed format
+    unsigned char const blue = snorm ? interpolateSnorm(0, 0, 1, 0) : 0;
+    for (size_t b = 0; b < blockCount; b++) {
+        decodeBC4Block(blocks + b * 16, snorm, pixels, 4);
+        decodeBC4Block(blocks + b * 16 + 8, snorm, pixels + 1, 4);
+        for (unsigned int i = 0; i < 16; i++) {
+            pixels[i * 4 + 2] = blue;
+            pixels[i * 4 + 3] = 0xff;
+        }
+        writeBlock(pixels, output + b * 16, rowPitch);
+    }
+}
+
+void decodeBC4RowScalar(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                        size_t const rowPitch) {
+    decodeBC4Row(blocks, blockCount, output, rowPitch, false);
+}
+
+void decodeBC4SnormRowScalar(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                             size_t const rowPitch) {
+    decodeBC4Row(blocks, blockCount, output, rowPitch, true);
+}
+
+void decodeBC5RowScalar(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                        size_t const rowPitch) {
+    decodeBC5Row(blocks, blockCount, output, rowPitch, false);
+}
+
+void decodeBC5SnormRowScalar(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                             size_t const rowPitch) {
+    decodeBC5Row(blocks, blockCount, output, rowPitch, true);
+}
+
+/*
+ * BC6H
+ */
+
+enum BC6HField : uint8_t {
+    RW, GW, BW, RX, GX, BX, RY, GY, BY, RZ, GZ, BZ, D,
+};
+
+/**
+ * Bits of an endpoint field: 'count' bits read in order are stored from bit 'shift' of the field
+ */
+class BC6HSegment {
+public:
+    BC6HField field;
+    uint8_t shift;
+    uint8_t count;
+};
+
+class BC6HMode {
+public:
+    uint8_t regions;
+    bool transformed;
+    uint8_t endpointBits;
+    uint8_t deltaBits[3];
+    BC6HSegment segments[32];
+};
+
+//header layout of the 14 modes after the mode bits, from the BC6H format specification
+static constexpr BC6HMode BC6H_MODES[14] = {
+        {2, true, 10, {5, 5, 5},
+         {{GY, 4, 1}, {BY, 4, 1}, {BZ, 4, 1}, {RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 5}, {GZ, 4, 1},
+          {GY, 0, 4}, {GX, 0, 5}, {BZ, 0, 1}, {GZ, 0, 4}, {BX, 0, 5}, {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 5},
+          {BZ, 2, 1}, {RZ, 0, 5}, {BZ, 3, 1}, {D, 0, 5}}},
+        {2, true, 7, {6, 6, 6},
+         {{GY, 5, 1}, {GZ, 4, 1}, {GZ, 5, 1}, {RW, 0, 7}, {BZ, 0, 1}, {BZ, 1, 1}, {BY, 4, 1}, {GW, 0, 7},
+          {BY, 5, 1}, {BZ, 2, 1}, {GY, 4, 1}, {BW, 0, 7}, {BZ, 3, 1}, {BZ, 5, 1}, {BZ, 4, 1}, {RX, 0, 6},
+          {GY, 0, 4}, {GX, 0, 6}, {GZ, 0, 4}, {BX, 0, 6}, {BY, 0, 4}, {RY, 0, 6}, {RZ, 0, 6}, {D, 0, 5}}},
+        {2, true, 11, {5, 4, 4},
+         {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 5}, {RW, 10, 1}, {GY, 0, 4}, {GX, 0, 4}, {GW, 10, 1},
+          {BZ, 0, 1}, {GZ, 0, 4}, {BX, 0, 4}, {BW, 10, 1}, {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 5}, {BZ, 2, 1},
+          {RZ, 0, 5}, {BZ, 3, 1}, {D, 0, 5}}},
+        {2, true, 11, {4, 5, 4},
+         {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 4}, {RW, 10, 1}, {GZ, 4, 1}, {GY, 0, 4}, {GX, 0, 5},
+          {GW, 10, 1}, {GZ, 0, 4}, {BX, 0, 4}, {BW, 10, 1}, {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 4}, {BZ, 0, 1},
+          {BZ, 2, 1}, {RZ, 0, 4}, {GY, 4, 1}, {BZ, 3, 1}, {D, 0, 5}}},
+        {2, true, 11, {4, 4, 5},
+         {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 4}, {RW, 10, 1}, {BY, 4, 1}, {GY, 0, 4}, {GX, 0, 4},
+          {GW, 10, 1}, {BZ, 0, 1}, {GZ, 0, 4}, {BX, 0, 5}, {BW, 10, 1}, {BY, 0, 4}, {RY, 0, 4}, {BZ, 1, 1},
+          {BZ, 2, 1}, {RZ, 0, 4}, {BZ, 4, 1}, {BZ, 3, 1}, {D, 0, 5}}},
+        {2, true, 9, {5, 5, 5},
+         {{RW, 0, 9}, {BY, 4, 1}, {GW, 0, 9}, {GY, 4, 1}, {BW, 0, 9}, {BZ, 4, 1}, {RX, 0, 5}, {GZ, 4, 1},
+          {GY, 0, 4}, {GX, 0, 5}, {BZ, 0, 1}, {GZ, 0, 4}, {BX, 0, 5}, {BZ, 1, 1}, {BY, 0, 4}, {RY, 0, 5},
+          {BZ, 2, 1}, {RZ, 0, 5}, {BZ, 3, 1}, {D, 0, 5}}},
+        {2, true, 8, {6, 5, 5},
+         {{RW, 0, 8}, {GZ, 4, 1}, {BY, 4, 1}, {GW, 0, 8}, {BZ, 2, 1}, {GY, 4, 1}, {BW, 0, 8}, {BZ, 3, 1},
+          {BZ, 4, 1}, {RX, 0, 6}, {GY, 0, 4}, {GX, 0, 5}, {BZ, 0, 1}, {GZ, 0, 4}, {BX, 0, 5}, {BZ, 1, 1},
+          {BY, 0, 4}, {RY, 0, 6}, {RZ, 0, 6}, {D, 0, 5}}},
+        {2, true, 8, {5, 6, 5},
+         {{RW, 0, 8}, {BZ, 0, 1}, {BY, 4, 1}, {GW, 0, 8}, {GY, 5, 1}, {GY, 4, 1}, {BW, 0, 8}, {GZ, 5, 1},
+          {BZ, 4, 1}, {RX, 0, 5}, {GZ, 4, 1}, {GY, 0, 4}, {GX, 0, 6}, {GZ, 0, 4}, {BX, 0, 5}, {BZ, 1, 1},
+          {BY, 0, 4}, {RY, 0, 5}, {BZ, 2, 1}, {RZ, 0, 5}, {BZ, 3, 1}, {D, 0, 5}}},
+        {2, true, 8, {5, 5, 6},
+         {{RW, 0, 8}, {BZ, 1, 1}, {BY, 4, 1}, {GW, 0, 8}, {BY, 5, 1}, {GY, 4, 1}, {BW, 0, 8}, {BZ, 5, 1},
+          {BZ, 4, 1}, {RX, 0, 5}, {GZ, 4, 1}, {GY, 0, 4}, {GX, 0, 5}, {BZ, 0, 1}, {GZ, 0, 4}, {BX, 0, 6},
+          {BY, 0, 4}, {RY, 0, 5}, {BZ, 2, 1}, {RZ, 0, 5}, {BZ, 3, 1}, {D, 0, 5}}},
+        {2, false, 6, {6, 6, 6},
+         {{RW, 0, 6}, {GZ, 4, 1}, {BZ, 0, 1}, {BZ, 1, 1}, {BY, 4, 1}, {GW, 0, 6}, {GY, 5, 1}, {BY, 5, 1},
+          {BZ, 2, 1}, {GY, 4, 1}, {BW, 0, 6}, {GZ, 5, 1}, {BZ, 3, 1}, {BZ, 5, 1}, {BZ, 4, 1}, {RX, 0, 6},
+          {GY, 0, 4}, {GX, 0, 6}, {GZ, 0, 4}, {BX, 0, 6}, {BY, 0, 4}, {RY, 0, 6}, {RZ, 0, 6}, {D, 0, 5}}},
+        {1, false, 10, {10, 10, 10},
+         {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 10}, {GX, 0, 10}, {BX, 0, 10}}},
+        {1, true, 11, {9, 9, 9},
+         {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 9}, {RW, 10, 1}, {GX, 0, 9}, {GW, 10, 1}, {BX, 0, 9},
+          {BW, 10, 1}}},
+        //the high bits of the base endpoint are stored in reverse order
+        {1, true, 12, {8, 8, 8},
+         {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 8}, {RW, 11, 1}, {RW, 10, 1}, {GX, 0, 8}, {GW, 11, 1},
+          {GW, 10, 1}, {BX, 0, 8}, {BW, 11, 1}, {BW, 10, 1}}},
+        {1, true, 16, {4, 4, 4},
+         {{RW, 0, 10}, {GW, 0, 10}, {BW, 0, 10}, {RX, 0, 4}, {RW, 15, 1}, {RW, 14, 1}, {RW, 13, 1}, {RW, 12, 1},
+          {RW, 11, 1}, {RW, 10, 1}, {GX, 0, 4}, {GW, 15, 1}, {GW, 14, 1}, {GW, 13, 1}, {GW, 12, 1}, {GW, 11, 1},
+          {GW, 10, 1}, {BX, 0, 4}, {BW, 15, 1}, {BW, 14, 1}, {BW, 13, 1}, {BW, 12, 1}, {BW, 11, 1},
+          {BW, 10, 1}}},
+};
+
+/**
+ * Index in BC6H_MODES of a 5-bit mode, -1 for the reserved modes
+ */
+static int getBC6HMode(unsigned int const modeBits) {
+    switch (modeBits) {
+        case 0x02:
+            return 2;
+        case 0x06:
+            return 3;
+        case 0x0a:
+            return 4;
+        case 0x0e:
+            return 5;
+        case 0x12:
+            return 6;
+        case 0x16:
+            return 7;
+        case 0x1a:
+            return 8;
+        case 0x1e:
+            return 9;
+        case 0x03:
+            return 10;
+        case 0x07:
+            return 11;
+        case 0x0b:
+            return 12;
+        case 0x0f:
+            return 13;
+        default:
+            return -1;
+    }
+}
+
+static int signExtend(int const value, unsigned int const bits) {
+    int const sign = 1 << (bits - 1);
+    return ((value & ((1 << bits) - 1)) ^ sign) - sign;
+}
+
+static int unquantizeBC6H(int const value, unsigned int const bits, bool const isSigned) {
+    if (!isSigned) {
+        if (bits >= 15 || value == 0) {
+            return value;
+        }
+        if (value == (1 << bits) - 1) {
+            return 0xffff;
+        }
+        return ((value << 16) + 0x8000) >> bits;
+    }
+
+    if (bits >= 16) {
+        return value;
+    }
+    int const magnitude = value < 0 ? -value : value;
+    int result;
+    if (magnitude == 0) {
+        result = 0;
+    } else if (magnitude >= (1 << (bits - 1)) - 1) {
+        result = 0x7fff;
+    } else {
+        result = ((magnitude << 15) + 0x4000) >> (bits - 1);
+    }
+    return value < 0 ? -result : result;
+}
+
+/**
+ * Half float bits of an interpolated value
+ */
+static uint16_t finishUnquantizeBC6H(int const value, bool const isSigned) {
+    if (!isSigned) {
+        return static_cast<uint16_t>((value * 31) >> 6);
+    }
+    if (value < 0) {
+        return static_cast<uint16_t>(0x8000 | (((-value) * 31) >> 5));
+    }
+    return static_cast<uint16_t>((value * 31) >> 5);
+}
+
+/**
+ * 8-bit value of each half float in [0, 1], rounded to nearest even
+ */
+class HalfToUnormTable {
+public:
+    static constexpr uint16_t ONE = 0x3c00;
+
+    HalfToUnormTable() {
+        for (unsigned int h = 0; h <= ONE; h++) {
+            unsigned int const exponent = h >> 10u;
+            float const mantissa = static_cast<float>(h & 0x3ffu) / 1024.0f;
+            float const value = exponent == 0 ? std::ldexp(mantissa, -14)
+                                              : std::ldexp(1.0f + mantissa, static_cast<int>(exponent) - 15);
+            values[h] = static_cast<unsigned char>(std::nearbyint(value * 255.0f));
+        }
+    }
+
+    [[nodiscard]] unsigned char get(uint16_t const half) const {
+        if (half & 0x8000u) {
+            return 0;
+        }
+        return half >= ONE ? 0xff : values[half];
+    }
+
+private:
+    unsigned char values[ONE + 1] = {};
+};
+
+static HalfToUnormTable const halfToUnorm;
+
+static void decodeBC6HBlock(unsigned char const *const block, bool const isSigned, unsigned char *const pixels) {
+    BlockBits bits(block);
+    unsigned int modeBits = bits.read(2);
+    int const modeIndex = modeBits < 2 ? static_cast<int>(modeBits) : getBC6HMode(modeBits | (bits.read(3) << 2u));
+    if (modeIndex < 0) {
+        //reserved modes decode to black
+        for (unsigned int i = 0; i < 16; i++) {
+            pixels[i * 4] = 0;
+            pixels[i * 4 + 1] = 0;
+            pixels[i * 4 + 2] = 0;
+            pixels[i * 4 + 3] = 0xff;
+        }
+        return;
+    }
+    BC6HMode const &mode = BC6H_MODES[modeIndex];
+
+    int fields[D + 1] = {};
+    for (BC6HSegment const &segment: mode.segments) {
+        if (segment.count == 0) {
+            break;
+        }
+        fields[segment.field] |= static_cast<int>(bits.read(segment.count) << segment.shift);
+    }
+
+    //endpoints A and B of each region, by channel
+    int endpoints[4][3];
+    unsigned int const endpointCount = mode.regions * 2u;
+    for (unsigned int ch = 0; ch < 3; ch++) {
+        endpoints[0][ch] = fields[RW + ch];
+        endpoints[1][ch] = fields[RX + ch];
+        endpoints[2][ch] = fields[RY + ch];
+        endpoints[3][ch] = fields[RZ + ch];
+
+        if (isSigned) {
+            endpoints[0][ch] = signExtend(endpoints[0][ch], mode.endpointBits);
+        }
+        if (isSigned || mode.transformed) {
+            for (unsigned int e = 1; e < endpointCount; e++) {
+                endpoints[e][ch] = signExtend(endpoints[e][ch], mode.deltaBits[ch]);
+            }
+        }
+        if (mode.transformed) {
+            for (unsigned int e = 1; e < endpointCount; e++) {
+                endpoints[e][ch] = (endpoints[0][ch] + endpoints[e][ch]) & ((1 << mode.endpointBits) - 1);
+                if (isSigned) {
+                    endpoints[e][ch] = signExtend(endpoints[e][ch], mode.endpointBits);
+                }
+            }
+        }
+        for (unsigned int e = 0; e < endpointCount; e++) {
+            endpoints[e][ch] = unquantizeBC6H(endpoints[e][ch], mode.endpointBits, isSigned);
+        }
+    }
+
+    unsigned int const partition = static_cast<unsigned int>(fields[D]);
+    unsigned int const indexBits = mode.regions == 2 ? 3 : 4;
+    uint8_t const *weights = mode.regions == 2 ? BC_WEIGHTS3 : BC_WEIGHTS4;
+    for (unsigned int i = 0; i < 16; i++) {
+        unsigned int region = 0;
+        bool anchor = i == 0;
+        if (mode.regions == 2) {
+            region = (BC_PARTITION2[partition] >> i) & 1u;
+            anchor = anchor || i == BC_ANCHOR2[partition];
+        }
+        int const weight = weights[bits.read(indexBits - (anchor ? 1 : 0))];
+
+        for (unsigned int ch = 0; ch < 3; ch++) {
+            int const a = endpoints[region * 2][ch];
+            int const b = endpoints[region * 2 + 1][ch];
+            int const value = (a * (64 - weight) + b * weight + 32) >> 6;
+            pixels[i * 4 + ch] = halfToUnorm.get(finishUnquantizeBC6H(value, isSigned));
+        }
+        pixels[i * 4 + 3] = 0xff;
+    }
+}
+
+void decodeBC6HRowScalar(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                         size_t const rowPitch) {
+    unsigned char pixels[64];
+    for (size_t b = 0; b < blockCount; b++) {
+        decodeBC6HBlock(blocks + b * 16, false, pixels);
+        writeBlock(pixels, output + b * 16, rowPitch);
+    }
+}
+
+void decodeBC6HSignedRowScalar(unsigned char const *const blocks, size_t const blockCount,
+                               unsigned char *const output, size_t const rowPitch) {
+    unsigned char pixels[64];
+    for (size_t b = 0; b < blockCount; b++) {
+        decodeBC6HBlock(blocks + b * 16, true, pixels);
+        writeBlock(pixels, output + b * 16, rowPitch);
+    }
+}
+
+/*
+ * BC7
+ */
+
+class BC7Mode {
+public:
+    uint8_t subsets;
+    uint8_t partitionBits;
+    uint8_t rotationBits;
+    uint8_t indexSelectionBits;
+    uint8_t colorBits;
+    uint8_t alphaBits;
+    bool endpointPBits;
+    bool sharedPBits;
+    uint8_t indexBits;
+    uint8_t index2Bits;
+};
+
+static constexpr BC7Mode BC7_MODES[8] = {
+        {3, 4, 0, 0, 4, 0, true, false, 3, 0},
+        {2, 6, 0, 0, 6, 0, false, true, 3, 0},
+        {3, 6, 0, 0, 5, 0, false, false, 2, 0},
+        {2, 6, 0, 0, 7, 0, true, false, 2, 0},
+        {1, 0, 2, 1, 5, 6, false, false, 2, 3},
+        {1, 0, 2, 0, 7, 8, false, false, 2, 2},
+        {1, 0, 0, 0, 7, 7, true, false, 4, 0},
+        {2, 6, 0, 0, 5, 5, true, false, 2, 0},
+};
+
+static uint8_t const *getBC7Weights(unsigned int const indexBits) {
+    switch (indexBits) {
+        case 2:
+            return BC_WEIGHTS2;
+        case 3:
+            return BC_WEIGHTS3;
+        default:
+            return BC_WEIGHTS4;
+    }
+}
+
+static void decodeBC7Block(unsigned char const *const block, unsigned char *const pixels) {
+    unsigned int modeIndex = 0;
+    while (modeIndex < 8 && !(block[0] & (1u << modeIndex))) {
+        modeIndex++;
+    }
+    if (modeIndex == 8) {
+        //invalid blocks decode to transparent black
+        std::memset(pixels, 0, 64);
+        return;
+    }
+    BC7Mode const &mode = BC7_MODES[modeIndex];
+
+    BlockBits bits(block);
+    bits.read(modeIndex + 1);
+    unsigned int const partition = bits.read(mode.partitionBits);
+    unsigned int const rotation = bits.read(mode.rotationBits);
+    unsigned int const indexSelection = bits.read(mode.indexSelectionBits);
+
+    unsigned int endpoints[6][4];
+    unsigned int const endpointCount = mode.subsets * 2u;
+    for (unsigned int ch = 0; ch < 4; ch++) {
+        unsigned int const channelBits = ch < 3 ? mode.colorBits : mode.alphaBits;
+        for (unsigned int e = 0; e < endpointCount; e++) {
+            endpoints[e][ch] = bits.read(channelBits);
+        }
+    }
+
+    unsigned int pBits[6] = {};
+    if (mode.endpointPBits) {
+        for (unsigned int e = 0; e < endpointCount; e++) {
+            pBits[e] = bits.read(1);
+        }
+    } else if (mode.sharedPBits) {
+        for (unsigned int s = 0; s < mode.subsets; s++) {
+            pBits[s * 2] = pBits[s * 2 + 1] = bits.read(1);
+        }
+    }
+
+    unsigned int const pBitCount = mode.endpointPBits || mode.sharedPBits ? 1 : 0;
+    for (unsigned int e = 0; e < endpointCount; e++) {
+        for (unsigned int ch = 0; ch < 4; ch++) {
+            if (ch == 3 && mode.alphaBits == 0) {
+                endpoints[e][ch] = 0xff;
+                continue;
+            }
+            unsigned int const precision = (ch < 3 ? mode.colorBits : mode.alphaBits) + pBitCount;
+            unsigned int value = ((endpoints[e][ch] << pBitCount) | pBits[e]) << (8 - precision);
+            endpoints[e][ch] = value | (value >> precision);
+        }
+    }
+
+    unsigned int subsets[16];
+    bool anchors[16] = {};
+    anchors[0] = true;
+    for (unsigned int i = 0; i < 16; i++) {
+        if (mode.subsets == 2) {
+            subsets[i] = (BC_PARTITION2[partition] >> i) & 1u;
+        } else if (mode.subsets == 3) {
+            subsets[i] = BC_PARTITION3[partition][i];
+        } else {
+            subsets[i] = 0;
+        }
+    }
+    if (mode.subsets == 2) {
+        anchors[BC_ANCHOR2[partition]] = true;
+    } else if (mode.subsets == 3) {
+        anchors[BC_ANCHOR3_SECOND[partition]] = true;
+        anchors[BC_ANCHOR3_THIRD[partition]] = true;
+    }
+
+    unsigned int indices[16];
+    unsigned int indices2[16] = {};
+    for (unsigned int i = 0; i < 16; i++) {
+        indices[i] = bits.read(mode.indexBits - (anchors[i] ? 1 : 0));
+    }
+    if (mode.index2Bits > 0) {
+        for (unsigned int i = 0; i < 16; i++) {
+            indices2[i] = bits.read(mode.index2Bits - (i == 0 ? 1 : 0));
+        }
+    }
+
+    uint8_t const *weights = getBC7Weights(mode.indexBits);
+    uint8_t const *weights2 = getBC7Weights(mode.index2Bits);
+    for (unsigned int i = 0; i < 16; i++) {
+        unsigned int colorWeight = weights[indices[i]];
+        unsigned int alphaWeight = colorWeight;
+        if (mode.index2Bits > 0) {
+            alphaWeight = weights2[indices2[i]];
+            if (indexSelection) {
+                std::swap(colorWeight, alphaWeight);
+            }
+        }
+
+        unsigned int const *e0 = endpoints[subsets[i] * 2];
+        unsigned int const *e1 = endpoints[subsets[i] * 2 + 1];
+        unsigned char *pixel = pixels + i * 4;
+        for (unsigned int ch = 0; ch < 4; ch++) {
+            unsigned int const weight = ch < 3 ? colorWeight : alphaWeight;
+            pixel[ch] = static_cast<unsigned char>((e0[ch] * (64 - weight) + e1[ch] * weight + 32) >> 6);
+        }
+        if (rotation > 0) {
+            std::swap(pixel[rotation - 1], pixel[3]);
+        }
+    }
+}
+
+void decodeBC7RowScalar(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                        size_t const rowPitch) {
+    unsigned char pixels[64];
+    for (size_t b = 0; b < blockCount; b++) {
+        decodeBC7Block(blocks + b * 16, pixels);
+        writeBlock(pixels, output + b * 16, rowPitch);
+    }
+}
+
+static BCDecodeKernels selectBCDecodeKernels() {
+#ifdef DXTWRAPPER_X86
+    CpuFeatures const &cpu = getCpuFeatures();
+    if (cpu.avx2) {
+        return {"avx2", decodeBC1RowAvx2, decodeBC2RowAvx2, decodeBC3RowAvx2, decodeBC4RowAvx2,
+                decodeBC4SnormRowAvx2, decodeBC5RowAvx2, decodeBC5SnormRowAvx2};
+    }
+    if (cpu.sse41) {
+        return {"sse41", decodeBC1RowSse41, decodeBC2RowSse41, decodeBC3RowSse41, decodeBC4RowSse41,
+                decodeBC4SnormRowSse41, decodeBC5RowSse41, decodeBC5SnormRowSse41};
+    }
+#endif
+    return {"scalar", decodeBC1RowScalar, decodeBC2RowScalar, decodeBC3RowScalar, decodeBC4RowScalar,
+            decodeBC4SnormRowScalar, decodeBC5RowScalar, decodeBC5SnormRowScalar};
+}
+
+//selected during static initialization, when the library is loaded
+static BCDecodeKernels const bcDecodeKernels = selectBCDecodeKernels();
+
+BCDecodeKernels const &getBCDecodeKernels() {
+    return bcDecodeKernels;
+}
+
+static BCRowDecoder getBCRowDecoder(DXGI_FORMAT const format) {
+    switch (format) {
+        case DXGI_FORMAT_BC1_TYPELESS:
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            return bcDecodeKernels.bc1;
+        case DXGI_FORMAT_BC2_TYPELESS:
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+            return bcDecodeKernels.bc2;
+        case DXGI_FORMAT_BC3_TYPELESS:
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            return bcDecodeKernels.bc3;
+        case DXGI_FORMAT_BC4_TYPELESS:
+        case DXGI_FORMAT_BC4_UNORM:
+            return bcDecodeKernels.bc4;
+        case DXGI_FORMAT_BC4_SNORM:
+            return bcDecodeKernels.bc4Snorm;
+        case DXGI_FORMAT_BC5_TYPELESS:
+        case DXGI_FORMAT_BC5_UNORM:
+            return bcDecodeKernels.bc5;
+        case DXGI_FORMAT_BC5_SNORM:
+            return bcDecodeKernels.bc5Snorm;
+        case DXGI_FORMAT_BC6H_TYPELESS:
+        case DXGI_FORMAT_BC6H_UF16:
+            return decodeBC6HRowScalar;
+        case DXGI_FORMAT_BC6H_SF16:
+            return decodeBC6HSignedRowScalar;
+        case DXGI_FORMAT_BC7_TYPELESS:
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return decodeBC7RowScalar;
+        default:
+            return nullptr;
+    }
+}
+
+bool isBCFormat(DXGI_FORMAT const format) {
+    return getBCRowDecoder(format) != nullptr;
+}
+
+size_t getBCBlockSize(DXGI_FORMAT const format) {
+    switch (format) {
+        case DXGI_FORMAT_BC1_TYPELESS:
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_TYPELESS:
+        case DXGI_FORMAT_BC4_UNORM:
+        case DXGI_FORMAT_BC4_SNORM:
+            return 8;
+        default:
+            return isBCFormat(format) ? 16 : 0;
+    }
+}
+
+ConvertStatus decodeBC(DXGI_FORMAT const format, unsigned char const *const blocks, size_t const size,
+                       size_t const width, size_t const height, unsigned char *const output) {
+    BCRowDecoder const decoder = getBCRowDecoder(format);
+    if (decoder == nullptr || blocks == nullptr || output == nullptr) {
+        return CONVERT_ERROR_DECODE;
+    }
+
+    size_t const blockSize = getBCBlockSize(format);
+    size_t const blocksWide = (width + 3) / 4;
+    size_t const blocksHigh = (height + 3) / 4;
+    if (blocksWide == 0 || blocksHigh == 0 || size / blockSize / blocksWide < blocksHigh) {
+        return CONVERT_ERROR_DECODE;
+    }
+
+    size_t const blockRowSize = blocksWide * blockSize;
+    size_t const rowPitch = width * 4;
+    size_t const rowsPerTask = std::max<size_t>(1, BC_DECODE_TASK_BLOCKS / blocksWide);
+    size_t const taskCount = (blocksHigh + rowsPerTask - 1) / rowsPerTask;
+
+    //set by a task that can't get its staging buffer, the tasks after it return without decoding
+    std::atomic<bool> outOfMemory{false};
+    auto const decodeRows = [&](size_t const task, [[maybe_unused]] size_t const worker) {
+        if (outOfMemory.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        //partial blocks of the right and bottom edges are decoded into 'staging' and clipped, from the arena of the
+        //thread running the task
+        ArenaFrame frame;
+        size_t const stagingPitch = blocksWide * 16;
+        unsigned char *staging = nullptr;
+
+        size_t const end = std::min(blocksHigh, (task + 1) * rowsPerTask);
+        for (size_t by = task * rowsPerTask; by < end; by++) {
+            unsigned char const *src = blocks + by * blockRowSize;
+            unsigned char *dst = output + by * 4 * rowPitch;
+            size_t const rows = std::min<size_t>(4, height - by * 4);
+            if (width % 4 == 0 && rows == 4) {
+                decoder(src, blocksWide, dst, rowPitch);
+                continue;
+            }
+
+            if (staging == nullptr) {
+                staging = frame.arena.allocateArray<unsigned char>(stagingPitch * 4);
+                if (staging == nullptr) {
+                    outOfMemory.store(true, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            decoder(src, blocksWide, staging, stagingPitch);
+            for (size_t row = 0; row < rows; row++) {
+                std::memcpy(dst + row * rowPitch, staging + row * stagingPitch, rowPitch);
+            }
+        }
+    };
+
+    if (taskCount == 1) {
+        decodeRows(0, 0);
+    } else {
+        getThreadPool()->parallelFor(taskCount, decodeRows);
+    }
+    if (outOfMemory.load()) {
+        return CONVERT_ERROR_OUT_OF_MEMORY;
+    }
+    return CONVERT_OK;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+#include <DirectXTex.h>
+#include "ConvertStatus.h"
+
+/**
+ * Decode one row of 4x4 blocks to 8-bit RGBA
+ *
+ * @param blocks The blocks
+ * @param blockCount Number of blocks
+ * @param output First pixel of the 4 rows, blockCount * 4 pixels per row
+ * @param rowPitch The size(in bytes) of an output row
+ */
+typedef void (*BCRowDecoder)(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+
+class BCDecodeKernels {
+public:
+    char const *name;
+    BCRowDecoder bc1;
+    BCRowDecoder bc2;
+    BCRowDecoder bc3;
+    BCRowDecoder bc4;
+    BCRowDecoder bc4Snorm;
+    BCRowDecoder bc5;
+    BCRowDecoder bc5Snorm;
+};
+
+/**
+ * Kernels selected for this CPU when the library was loaded. BC6H and BC7 have only the scalar decoder, their blocks
+ * are parsed bit by bit with per-block modes.
+ */
+BCDecodeKernels const &getBCDecodeKernels();
+
+/**
+ * @return True if the format is one of the BC1 to BC7 formats
+ */
+bool isBCFormat(DXGI_FORMAT format);
+
+/**
+ * Decode a BC1 to BC7 image to 8-bit RGBA, block rows are decoded in parallel on the shared thread pool.
+ *
+ * BC4 is written as gray, BC5 as red and green, signed formats are biased from [-1, 1] to [0, 255] and BC6H is
+ * clamped to [0, 1]. The sRGB formats are not converted.
+ *
+ * @param format The BC format
+ * @param blocks The blocks of the image
+ * @param size The size(in bytes) of blocks
+ * @param width Width of the image
+ * @param height Height of the image
+ * @param output Receives width * height pixels, the row pitch is width * 4
+ * @return CONVERT_OK on success, CONVERT_ERROR_DECODE if blocks is too small or the format is not supported,
+ *         CONVERT_ERROR_OUT_OF_MEMORY if the buffer for the edge blocks can't be allocated
+ */
+ConvertStatus decodeBC(DXGI_FORMAT format, unsigned char const *blocks, size_t size, size_t width, size_t height,
+                       unsigned char *output);
+
+/**
+ * The size(in bytes) of a 4x4 block of the format, 0 when it is not a BC format
+ */
+size_t getBCBlockSize(DXGI_FORMAT format);
+
+void decodeBC1RowScalar(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC2RowScalar(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC3RowScalar(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC4RowScalar(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC4SnormRowScalar(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC5RowScalar(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC5SnormRowScalar(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC6HRowScalar(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC6HSignedRowScalar(unsigned char const *blocks, size_t blockCount, unsigned char *output,
+                               size_t rowPitch);
+void decodeBC7RowScalar(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+
+void decodeBC1RowSse41(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC2RowSse41(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC3RowSse41(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC4RowSse41(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC4SnormRowSse41(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC5RowSse41(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC5SnormRowSse41(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+
+void decodeBC1RowAvx2(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC2RowAvx2(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC3RowAvx2(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC4RowAvx2(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC4SnormRowAvx2(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC5RowAvx2(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
+void decodeBC5SnormRowAvx2(unsigned char const *blocks, size_t blockCount, unsigned char *output, size_t rowPitch);
@@ -0,0 +1,219 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include "BCDecoder.h"
+#include "BCTables.h"
+#include "CpuFeatures.h"
+
+#ifdef DXTWRAPPER_X86
+
+#include <immintrin.h>
+
+/*
+ * Two horizontally adjacent blocks are decoded together, one per 128-bit lane, so each row of the pair is a single
+ * 32-byte store. An odd last block is left to the SSE4.1 kernel.
+ */
+
+static inline __m256i combineLanes(__m128i const low, __m128i const high) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+static inline __m256i loadBC1Palettes(unsigned char const *const block0, unsigned char const *const block1,
+                                      bool const allowTransparent) {
+    alignas(32) unsigned char palettes[32];
+    getBC1Palette(block0, allowTransparent, palettes);
+    getBC1Palette(block1, allowTransparent, palettes + 16);
+    return _mm256_load_si256(reinterpret_cast<__m256i const *>(palettes));
+}
+
+static inline __m256i getBC1Masks(unsigned char const *const block0, unsigned char const *const block1,
+                                  int const row) {
+    return combineLanes(_mm_load_si128(reinterpret_cast<__m128i const *>(BC1_SHUFFLE.masks[block0[4 + row]])),
+                        _mm_load_si128(reinterpret_cast<__m128i const *>(BC1_SHUFFLE.masks[block1[4 + row]])));
+}
+
+static inline __m256i decodeBC4Values(unsigned char const *const block0, unsigned char const *const block1,
+                                      bool const snorm) {
+    alignas(32) unsigned char palettes[32] = {};
+    getBC4Palette(block0, snorm, palettes);
+    getBC4Palette(block1, snorm, palettes + 16);
+
+    __m256i const bits = combineLanes(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(block0)),
+                                      _mm_loadl_epi64(reinterpret_cast<__m128i const *>(block1)));
+    __m256i const low = _mm256_shuffle_epi8(bits, _mm256_setr_epi8(2, 3, 2, 3, 2, 3, 3, 4, 3, 4, 3, 4, 4, 5, 4, 5,
+                                                                   2, 3, 2, 3, 2, 3, 3, 4, 3, 4, 3, 4, 4, 5, 4, 5));
+    __m256i const high = _mm256_shuffle_epi8(bits, _mm256_setr_epi8(5, 6, 5, 6, 5, 6, 6, 7, 6, 7, 6, 7, 7, -1, 7, -1,
+                                                                    5, 6, 5, 6, 5, 6, 6, 7, 6, 7, 6, 7, 7, -1, 7, -1));
+    //shift each lane left by 8 - (3 * pixel) % 8, the index lands in bits 8-10
+    __m256i const shift = _mm256_setr_epi16(256, 32, 4, 128, 16, 2, 64, 8, 256, 32, 4, 128, 16, 2, 64, 8);
+    __m256i const mask = _mm256_set1_epi16(7);
+    __m256i const lowIndices = _mm256_and_si256(_mm256_srli_epi16(_mm256_mullo_epi16(low, shift), 8), mask);
+    __m256i const highIndices = _mm256_and_si256(_mm256_srli_epi16(_mm256_mullo_epi16(high, shift), 8), mask);
+
+    return _mm256_shuffle_epi8(_mm256_load_si256(reinterpret_cast<__m256i const *>(palettes)),
+                               _mm256_packus_epi16(lowIndices, highIndices));
+}
+
+static inline __m256i decodeBC2Alpha(unsigned char const *const block0, unsigned char const *const block1) {
+    __m256i const bits = combineLanes(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(block0)),
+                                      _mm_loadl_epi64(reinterpret_cast<__m128i const *>(block1)));
+    __m256i const nibble = _mm256_set1_epi8(0x0f);
+    __m256i const alpha = _mm256_unpacklo_epi8(_mm256_and_si256(bits, nibble),
+                                               _mm256_and_si256(_mm256_srli_epi16(bits, 4), nibble));
+    return _mm256_or_si256(alpha, _mm256_slli_epi16(alpha, 4));
+}
+
+static inline __m256i getRowAlpha(__m256i const alpha, int const row) {
+    char const i = static_cast<char>(row * 4);
+    char const i1 = static_cast<char>(i + 1);
+    char const i2 = static_cast<char>(i + 2);
+    char const i3 = static_cast<char>(i + 3);
+    return _mm256_shuffle_epi8(alpha, _mm256_setr_epi8(-1, -1, -1, i, -1, -1, -1, i1, -1, -1, -1, i2, -1, -1, -1, i3,
+                                                       -1, -1, -1, i, -1, -1, -1, i1, -1, -1, -1, i2, -1, -1, -1, i3));
+}
+
+static inline void storeBC1RowsWithAlpha(__m256i const palettes, __m256i const alpha,
+                                         unsigned char const *const color0, unsigned char const *const color1,
+                                         unsigned char *const output, size_t const rowPitch) {
+    __m256i const alphaLanes = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+    for (int row = 0; row < 4; row++) {
+        __m256i const color = _mm256_shuffle_epi8(palettes, getBC1Masks(color0, color1, row));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + row * rowPitch),
+                            _mm256_blendv_epi8(color, getRowAlpha(alpha, row), alphaLanes));
+    }
+}
+
+void decodeBC1RowAvx2(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                      size_t const rowPitch) {
+    size_t b = 0;
+    for (; b + 2 <= blockCount; b += 2) {
+        unsigned char const *block0 = blocks + b * 8;
+        unsigned char const *block1 = block0 + 8;
+        __m256i const palettes = loadBC1Palettes(block0, block1, true);
+        for (int row = 0; row < 4; row++) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + row * rowPitch + b * 16),
+                                _mm256_shuffle_epi8(palettes, getBC1Masks(block0, block1, row)));
+        }
+    }
+    decodeBC1RowSse41(blocks + b * 8, blockCount - b, output + b * 16, rowPitch);
+}
+
+void decodeBC2RowAvx2(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                      size_t const rowPitch) {
+    size_t b = 0;
+    for (; b + 2 <= blockCount; b += 2) {
+        unsigned char const *block0 = blocks + b * 16;
+        unsigned char const *block1 = block0 + 16;
+        storeBC1RowsWithAlpha(loadBC1Palettes(block0 + 8, block1 + 8, false), decodeBC2Alpha(block0, block1),
+                              block0 + 8, block1 + 8, output + b * 16, rowPitch);
+    }
+    decodeBC2RowSse41(blocks + b * 16, blockCount - b, output + b * 16, rowPitch);
+}
+
+void decodeBC3RowAvx2(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                      size_t const rowPitch) {
+    size_t b = 0;
+    for (; b + 2 <= blockCount; b += 2) {
+        unsigned char const *block0 = blocks + b * 16;
+        unsigned char const *block1 = block0 + 16;
+        storeBC1RowsWithAlpha(loadBC1Palettes(block0 + 8, block1 + 8, false), decodeBC4Values(block0, block1, false),
+                              block0 + 8, block1 + 8, output + b * 16, rowPitch);
+    }
+    decodeBC3RowSse41(blocks + b * 16, blockCount - b, output + b * 16, rowPitch);
+}
+
+static inline void decodeBC4Row(unsigned char const *const blocks, size_t const blockCount,
+                                unsigned char *const output, size_t const rowPitch, bool const snorm) {
+    __m256i const alpha = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+    size_t b = 0;
+    for (; b + 2 <= blockCount; b += 2) {
+        __m256i const values = decodeBC4Values(blocks + b * 8, blocks + b * 8 + 8, snorm);
+        for (int row = 0; row < 4; row++) {
+            char const i = static_cast<char>(row * 4);
+            char const i1 = static_cast<char>(i + 1);
+            char const i2 = static_cast<char>(i + 2);
+            char const i3 = static_cast<char>(i + 3);
+            __m256i const gray = _mm256_shuffle_epi8(values, _mm256_setr_epi8(i, i, i, -1, i1, i1, i1, -1, i2, i2, i2,
+                                                                              -1, i3, i3, i3, -1, i, i, i, -1, i1, i1,
+                                                                              i1, -1, i2, i2, i2, -1, i3, i3, i3, -1));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + row * rowPitch + b * 16),
+                                _mm256_or_si256(gray, alpha));
+        }
+    }
+    if (snorm) {
+        decodeBC4SnormRowSse41(blocks + b * 8, blockCount - b, output + b * 16, rowPitch);
+    } else {
+        decodeBC4RowSse41(blocks + b * 8, blockCount - b, output + b * 16, rowPitch);
+    }
+}
+
+static inline void decodeBC5Row(unsigned char const *const blocks, size_t const blockCount,
+                                unsigned char *const output, size_t const rowPitch, bool const snorm) {
+    //blue and alpha of each pixel, blue is 0 biased like the other channels for the signed format
+    unsigned int const blue = snorm ? interpolateSnorm(0, 0, 1, 0) : 0;
+    __m256i const blueAlpha = _mm256_set1_epi16(static_cast<short>(0xff00u | blue));
+    size_t b = 0;
+    for (; b + 2 <= blockCount; b += 2) {
+        unsigned char const *block0 = blocks + b * 16;
+        unsigned char const *block1 = block0 + 16;
+        __m256i const red = decodeBC4Values(block0, block1, snorm);
+        __m256i const green = decodeBC4Values(block0 + 8, block1 + 8, snorm);
+        __m256i const low = _mm256_unpacklo_epi8(red, green);
+        __m256i const high = _mm256_unpackhi_epi8(red, green);
+        unsigned char *out = output + b * 16;
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_unpacklo_epi16(low, blueAlpha));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + rowPitch), _mm256_unpackhi_epi16(low, blueAlpha));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2 * rowPitch), _mm256_unpacklo_epi16(high, blueAlpha));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 3 * rowPitch), _mm256_unpackhi_epi16(high, blueAlpha));
+    }
+    if (snorm) {
+        decodeBC5SnormRowSse41(blocks + b * 16, blockCount - b, output + b * 16, rowPitch);
+    } else {
+        decodeBC5RowSse41(blocks + b * 16, blockCount - b, output + b * 16, rowPitch);
+    }
+}
+
+void decodeBC4RowAvx2(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                      size_t const rowPitch) {
+    decodeBC4Row(blocks, blockCount, output, rowPitch, false);
+}
+
+void decodeBC4SnormRowAvx2(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                           size_t const rowPitch) {
+    decodeBC4Row(blocks, blockCount, output, rowPitch, true);
+}
+
+void decodeBC5RowAvx2(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                      size_t const rowPitch) {
+    decodeBC5Row(blocks, blockCount, output, rowPitch, false);
+}
+
+void decodeBC5SnormRowAvx2(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                           size_t const rowPitch) {
+    decodeBC5Row(blocks, blockCount, output, rowPitch, true);
+}
+
+#endif
@@ -0,0 +1,185 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include "BCDecoder.h"
+#include "BCTables.h"
+#include "CpuFeatures.h"
+
+#ifdef DXTWRAPPER_X86
+
+#include <smmintrin.h>
+
+/**
+ * Palette of a BC1 color block, alpha cleared when it is replaced by the alpha block of BC2 and BC3
+ */
+static inline __m128i loadBC1Palette(unsigned char const *const block, bool const allowTransparent) {
+    alignas(16) unsigned char palette[16];
+    getBC1Palette(block, allowTransparent, palette);
+    return _mm_load_si128(reinterpret_cast<__m128i const *>(palette));
+}
+
+/**
+ * The 16 values of a BC4 block in pixel order. The 3-bit indices are gathered in 16-bit lanes and shifted into place
+ * with a multiply, then looked up in the palette with pshufb.
+ */
+static inline __m128i decodeBC4Values(unsigned char const *const block, bool const snorm) {
+    alignas(16) unsigned char palette[16] = {};
+    getBC4Palette(block, snorm, palette);
+
+    __m128i const bits = _mm_loadl_epi64(reinterpret_cast<__m128i const *>(block));
+    __m128i const low = _mm_shuffle_epi8(bits, _mm_setr_epi8(2, 3, 2, 3, 2, 3, 3, 4, 3, 4, 3, 4, 4, 5, 4, 5));
+    __m128i const high = _mm_shuffle_epi8(bits, _mm_setr_epi8(5, 6, 5, 6, 5, 6, 6, 7, 6, 7, 6, 7, 7, -1, 7, -1));
+    //shift each lane left by 8 - (3 * pixel) % 8, the index lands in bits 8-10
+    __m128i const shift = _mm_setr_epi16(256, 32, 4, 128, 16, 2, 64, 8);
+    __m128i const mask = _mm_set1_epi16(7);
+    __m128i const lowIndices = _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(low, shift), 8), mask);
+    __m128i const highIndices = _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(high, shift), 8), mask);
+
+    return _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<__m128i const *>(palette)),
+                            _mm_packus_epi16(lowIndices, highIndices));
+}
+
+/**
+ * The 16 alphas of a BC2 block in pixel order
+ */
+static inline __m128i decodeBC2Alpha(unsigned char const *const block) {
+    __m128i const bits = _mm_loadl_epi64(reinterpret_cast<__m128i const *>(block));
+    __m128i const nibble = _mm_set1_epi8(0x0f);
+    __m128i const alpha = _mm_unpacklo_epi8(_mm_and_si128(bits, nibble),
+                                            _mm_and_si128(_mm_srli_epi16(bits, 4), nibble));
+    return _mm_or_si128(alpha, _mm_slli_epi16(alpha, 4));
+}
+
+/**
+ * Move the alpha of the 4 pixels of a row to the alpha byte of each pixel
+ */
+static inline __m128i getRowAlpha(__m128i const alpha, int const row) {
+    char const i = static_cast<char>(row * 4);
+    return _mm_shuffle_epi8(alpha, _mm_setr_epi8(-1, -1, -1, i, -1, -1, -1, static_cast<char>(i + 1), -1, -1, -1,
+                                                 static_cast<char>(i + 2), -1, -1, -1, static_cast<char>(i + 3)));
+}
+
+static inline void storeBC1Rows(__m128i const palette, unsigned char const *const block, unsigned char *const output,
+                                size_t const rowPitch) {
+    for (int row = 0; row < 4; row++) {
+        __m128i const mask = _mm_load_si128(reinterpret_cast<__m128i const *>(BC1_SHUFFLE.masks[block[4 + row]]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + row * rowPitch), _mm_shuffle_epi8(palette, mask));
+    }
+}
+
+static inline void storeBC1RowsWithAlpha(__m128i const palette, __m128i const alpha, unsigned char const *const block,
+                                         unsigned char *const output, size_t const rowPitch) {
+    __m128i const alphaLanes = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    for (int row = 0; row < 4; row++) {
+        __m128i const mask = _mm_load_si128(reinterpret_cast<__m128i const *>(BC1_SHUFFLE.masks[block[4 + row]]));
+        __m128i const color = _mm_shuffle_epi8(palette, mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + row * rowPitch),
+                         _mm_blendv_epi8(color, getRowAlpha(alpha, row), alphaLanes));
+    }
+}
+
+void decodeBC1RowSse41(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                       size_t const rowPitch) {
+    for (size_t b = 0; b < blockCount; b++) {
+        unsigned char const *block = blocks + b * 8;
+        storeBC1Rows(loadBC1Palette(block, true), block, output + b * 16, rowPitch);
+    }
+}
+
+void decodeBC2RowSse41(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                       size_t const rowPitch) {
+    for (size_t b = 0; b < blockCount; b++) {
+        unsigned char const *block = blocks + b * 16;
+        storeBC1RowsWithAlpha(loadBC1Palette(block + 8, false), decodeBC2Alpha(block), block + 8, output + b * 16,
+                              rowPitch);
+    }
+}
+
+void decodeBC3RowSse41(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                       size_t const rowPitch) {
+    for (size_t b = 0; b < blockCount; b++) {
+        unsigned char const *block = blocks + b * 16;
+        storeBC1RowsWithAlpha(loadBC1Palette(block + 8, false), decodeBC4Values(block, false), block + 8,
+                              output + b * 16, rowPitch);
+    }
+}
+
+static inline void decodeBC4Row(unsigned char const *const blocks, size_t const blockCount,
+                                unsigned char *const output, size_t const rowPitch, bool const snorm) {
+    __m128i const alpha = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    for (size_t b = 0; b < blockCount; b++) {
+        __m128i const values = decodeBC4Values(blocks + b * 8, snorm);
+        for (int row = 0; row < 4; row++) {
+            char const i = static_cast<char>(row * 4);
+            char const i1 = static_cast<char>(i + 1);
+            char const i2 = static_cast<char>(i + 2);
+            char const i3 = static_cast<char>(i + 3);
+            __m128i const gray = _mm_shuffle_epi8(values, _mm_setr_epi8(i, i, i, -1, i1, i1, i1, -1, i2, i2, i2, -1,
+                                                                        i3, i3, i3, -1));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output + row * rowPitch + b * 16), _mm_or_si128(gray, alpha));
+        }
+    }
+}
+
+static inline void decodeBC5Row(unsigned char const *const blocks, size_t const blockCount,
+                                unsigned char *const output, size_t const rowPitch, bool const snorm) {
+    //blue and alpha of each pixel, blue is 0 biased like the other channels for the signed format
+    unsigned int const blue = snorm ? interpolateSnorm(0, 0, 1, 0) : 0;
+    __m128i const blueAlpha = _mm_set1_epi16(static_cast<short>(0xff00u | blue));
+    for (size_t b = 0; b < blockCount; b++) {
+        __m128i const red = decodeBC4Values(blocks + b * 16, snorm);
+        __m128i const green = decodeBC4Values(blocks + b * 16 + 8, snorm);
+        __m128i const low = _mm_unpacklo_epi8(red, green);
+        __m128i const high = _mm_unpackhi_epi8(red, green);
+        unsigned char *out = output + b * 16;
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_unpacklo_epi16(low, blueAlpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + rowPitch), _mm_unpackhi_epi16(low, blueAlpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * rowPitch), _mm_unpacklo_epi16(high, blueAlpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 3 * rowPitch), _mm_unpackhi_epi16(high, blueAlpha));
+    }
+}
+
+void decodeBC4RowSse41(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                       size_t const rowPitch) {
+    decodeBC4Row(blocks, blockCount, output, rowPitch, false);
+}
+
+void decodeBC4SnormRowSse41(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                            size_t const rowPitch) {
+    decodeBC4Row(blocks, blockCount, output, rowPitch, true);
+}
+
+void decodeBC5RowSse41(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                       size_t const rowPitch) {
+    decodeBC5Row(blocks, blockCount, output, rowPitch, false);
+}
+
+void decodeBC5SnormRowSse41(unsigned char const *const blocks, size_t const blockCount, unsigned char *const output,
+                            size_t const rowPitch) {
+    decodeBC5Row(blocks, blockCount, output, rowPitch, true);
+}
+
+#endif
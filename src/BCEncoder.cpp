@@ -0,0 +1,1147 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "BCDecoder.h"
+#include "BCEncoder.h"
+#include "BCTables.h"
+#include "CpuFeatures.h"
+#include "ThreadPool.h"
+
+//blocks encoded by each task, encoding is two orders of magnitude slower than decoding
+static constexpr size_t BC_ENCODE_TASK_BLOCKS = 256;
+
+//partitions of BC7 mode 1 encoded after ranking all 64 by their estimated error
+static constexpr size_t BC7_PARTITION_CANDIDATES = 4;
+
+//fraction of the second endpoint selected by each index
+static constexpr float BC1_WEIGHTS4[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+static constexpr float BC1_WEIGHTS3[3] = {0.0f, 1.0f, 0.5f};
+static constexpr float BC4_WEIGHTS8[8] = {0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f,
+                                          6.0f / 7.0f};
+static constexpr float BC4_WEIGHTS6[6] = {0.0f, 1.0f, 0.2f, 0.4f, 0.6f, 0.8f};
+static constexpr float BC7_WEIGHTS3[8] = {0.0f, 9.0f / 64, 18.0f / 64, 27.0f / 64, 37.0f / 64, 46.0f / 64, 55.0f / 64,
+                                          1.0f};
+static constexpr float BC7_WEIGHTS4[16] = {0.0f, 4.0f / 64, 9.0f / 64, 13.0f / 64, 17.0f / 64, 21.0f / 64, 26.0f / 64,
+                                           30.0f / 64, 34.0f / 64, 38.0f / 64, 43.0f / 64, 47.0f / 64, 51.0f / 64,
+                                           55.0f / 64, 60.0f / 64, 1.0f};
+
+/**
+ * Writer of the 128 bits of a BC7 block, least significant bit first
+ */
+class BlockWriter {
+public:
+    void write(unsigned int const value, unsigned int const count) {
+        uint64_t const bits = value & ((uint64_t{1} << count) - 1);
+        if (position >= 64) {
+            high |= bits << (position - 64);
+        } else {
+            low |= bits << position;
+            if (position + count > 64) {
+                high |= bits >> (64 - position);
+            }
+        }
+        position += count;
+    }
+
+    void store(unsigned char *const block) const {
+        for (unsigned int i = 0; i < 8; i++) {
+            block[i] = static_cast<unsigned char>(low >> (i * 8));
+            block[i + 8] = static_cast<unsigned char>(high >> (i * 8));
+        }
+    }
+
+private:
+    uint64_t low = 0;
+    uint64_t high = 0;
+    unsigned int position = 0;
+};
+
+uint32_t findBCIndicesScalar(unsigned char const *const pixels, unsigned char const *const palette,
+                             size_t const count, unsigned char *const indices) {
+    uint32_t total = 0;
+    for (size_t i = 0; i < 16; i++) {
+        unsigned char const *pixel = pixels + i * 4;
+        uint32_t best = UINT32_MAX;
+        size_t bestIndex = 0;
+        for (size_t j = 0; j < count; j++) {
+            unsigned char const *color = palette + j * 4;
+            uint32_t error = 0;
+            for (size_t ch = 0; ch < 4; ch++) {
+                int const diff = pixel[ch] - color[ch];
+                error += static_cast<uint32_t>(diff * diff);
+            }
+            if (error < best) {
+                best = error;
+                bestIndex = j;
+            }
+        }
+        indices[i] = static_cast<unsigned char>(bestIndex);
+        total += best;
+    }
+    return total;
+}
+
+static BCEncodeKernels selectBCEncodeKernels() {
+#ifdef DXTWRAPPER_X86
+    CpuFeatures const &cpu = getCpuFeatures();
+    if (cpu.avx2) {
+        return {"avx2", findBCIndicesAvx2};
+    }
+    if (cpu.sse41) {
+        return {"sse41", findBCIndicesSse41};
+    }
+#endif
+    return {"scalar", findBCIndicesScalar};
+}
+
+//selected during static initialization, when the library is loaded
+static BCEncodeKernels const bcEncodeKernels = selectBCEncodeKernels();
+
+BCEncodeKernels const &getBCEncodeKernels() {
+    return bcEncodeKernels;
+}
+
+static uint32_t getPixelError(unsigned char const *const pixel, unsigned char const *const color) {
+    uint32_t error = 0;
+    for (size_t ch = 0; ch < 4; ch++) {
+        int const diff = pixel[ch] - color[ch];
+        error += static_cast<uint32_t>(diff * diff);
+    }
+    return error;
+}
+
+/**
+ * Index search restricted to the pixels in 'mask'. The subset is padded to 16 pixels with its first pixel, whose
+ * error is subtracted again. Indices of the pixels outside the mask are left untouched.
+ */
+static uint32_t findSubsetIndices(unsigned char const *const pixels, unsigned int const mask,
+                                  unsigned char const *const palette, size_t const count,
+                                  unsigned char *const indices) {
+    if (mask == 0xffffu) {
+        return bcEncodeKernels.findIndices(pixels, palette, count, indices);
+    }
+
+    alignas(32) unsigned char subset[64];
+    unsigned char subsetIndices[16];
+    unsigned char positions[16];
+    unsigned int size = 0;
+    for (unsigned int i = 0; i < 16; i++) {
+        if (mask & (1u << i)) {
+            std::memcpy(subset + size * 4, pixels + i * 4, 4);
+            positions[size++] = static_cast<unsigned char>(i);
+        }
+    }
+    if (size == 0) {
+        return 0;
+    }
+    for (unsigned int i = size; i < 16; i++) {
+        std::memcpy(subset + i * 4, subset, 4);
+    }
+
+    uint32_t const error = bcEncodeKernels.findIndices(subset, palette, count, subsetIndices);
+    for (unsigned int i = 0; i < size; i++) {
+        indices[positions[i]] = subsetIndices[i];
+    }
+    return error - (16 - size) * getPixelError(subset, palette + subsetIndices[0] * 4);
+}
+
+/**
+ * Sums of the channels and of their products over the pixels of a subset, integers so a subset can be subtracted from
+ * the whole block. Channels that are constant in the block, like the alpha of BC1, add nothing to the covariance.
+ */
+class ChannelMoments {
+public:
+    int count = 0;
+    int sums[4] = {};
+    int products[10] = {};
+
+    ChannelMoments(unsigned char const *const pixels, unsigned int const mask) {
+        for (unsigned int i = 0; i < 16; i++) {
+            if (!(mask & (1u << i))) {
+                continue;
+            }
+            int const r = pixels[i * 4];
+            int const g = pixels[i * 4 + 1];
+            int const b = pixels[i * 4 + 2];
+            int const a = pixels[i * 4 + 3];
+            count++;
+            sums[0] += r;
+            sums[1] += g;
+            sums[2] += b;
+            sums[3] += a;
+            products[0] += r * r;
+            products[1] += r * g;
+            products[2] += r * b;
+            products[3] += r * a;
+            products[4] += g * g;
+            products[5] += g * b;
+            products[6] += g * a;
+            products[7] += b * b;
+            products[8] += b * a;
+            products[9] += a * a;
+        }
+    }
+
+    ChannelMoments &operator-=(ChannelMoments const &other) {
+        count -= other.count;
+        for (unsigned int i = 0; i < 4; i++) {
+            sums[i] -= other.sums[i];
+        }
+        for (unsigned int i = 0; i < 10; i++) {
+            products[i] -= other.products[i];
+        }
+        return *this;
+    }
+};
+
+/**
+ * Mean and principal axis of a subset, found by power iteration on the covariance matrix
+ *
+ * @return The squared distance of the pixels to the axis, the error of an ideal line fit
+ */
+static float computePrincipalAxis(ChannelMoments const &moments, float mean[4], float axis[4]) {
+    std::fill(mean, mean + 4, 0.0f);
+    std::fill(axis, axis + 4, 0.0f);
+    if (moments.count == 0) {
+        return 0.0f;
+    }
+
+    float const inverseCount = 1.0f / static_cast<float>(moments.count);
+    for (unsigned int ch = 0; ch < 4; ch++) {
+        mean[ch] = static_cast<float>(moments.sums[ch]) * inverseCount;
+    }
+    float covariance[4][4];
+    for (unsigned int row = 0, product = 0; row < 4; row++) {
+        for (unsigned int col = row; col < 4; col++, product++) {
+            covariance[row][col] = static_cast<float>(moments.products[product])
+                                   - static_cast<float>(moments.sums[row]) * mean[col];
+            covariance[col][row] = covariance[row][col];
+        }
+    }
+    float const trace = covariance[0][0] + covariance[1][1] + covariance[2][2] + covariance[3][3];
+    unsigned int largest = 0;
+    for (unsigned int ch = 1; ch < 4; ch++) {
+        largest = covariance[ch][ch] > covariance[largest][largest] ? ch : largest;
+    }
+    if (covariance[largest][largest] <= 0.0f) {
+        return 0.0f;
+    }
+
+    //the column of the largest variance is never orthogonal to the principal axis. The matrix is scaled by the trace,
+    //an upper bound of its eigenvalues, so the vector needs no normalization between iterations.
+    float const inverseTrace = 1.0f / trace;
+    for (auto &row : covariance) {
+        for (float &value : row) {
+            value *= inverseTrace;
+        }
+    }
+    float vector[4];
+    for (unsigned int ch = 0; ch < 4; ch++) {
+        vector[ch] = covariance[ch][largest];
+    }
+    for (unsigned int iteration = 0; iteration < 4; iteration++) {
+        float next[4];
+        for (unsigned int row = 0; row < 4; row++) {
+            next[row] = covariance[row][0] * vector[0] + covariance[row][1] * vector[1]
+                        + covariance[row][2] * vector[2] + covariance[row][3] * vector[3];
+        }
+        std::copy(next, next + 4, vector);
+    }
+
+    float const inverseLength = 1.0f / std::sqrt(vector[0] * vector[0] + vector[1] * vector[1]
+                                                  + vector[2] * vector[2] + vector[3] * vector[3]);
+    float variance = 0.0f;
+    for (unsigned int row = 0; row < 4; row++) {
+        axis[row] = vector[row] * inverseLength;
+    }
+    for (unsigned int row = 0; row < 4; row++) {
+        variance += axis[row] * (covariance[row][0] * axis[0] + covariance[row][1] * axis[1]
+                                 + covariance[row][2] * axis[2] + covariance[row][3] * axis[3]);
+    }
+    return std::max(0.0f, trace * (1.0f - variance));
+}
+
+/**
+ * Endpoints at the extremes of the projection of the pixels on their principal axis
+ */
+static void fitAxisEndpoints(unsigned char const *const pixels, unsigned int const mask, float endpoint0[4],
+                             float endpoint1[4]) {
+    float mean[4];
+    float axis[4];
+    computePrincipalAxis(ChannelMoments(pixels, mask), mean, axis);
+
+    float minimum = 0.0f;
+    float maximum = 0.0f;
+    for (unsigned int i = 0; i < 16; i++) {
+        if (!(mask & (1u << i))) {
+            continue;
+        }
+        unsigned char const *pixel = pixels + i * 4;
+        float const projection = (static_cast<float>(pixel[0]) - mean[0]) * axis[0]
+                                 + (static_cast<float>(pixel[1]) - mean[1]) * axis[1]
+                                 + (static_cast<float>(pixel[2]) - mean[2]) * axis[2]
+                                 + (static_cast<float>(pixel[3]) - mean[3]) * axis[3];
+        minimum = std::min(minimum, projection);
+        maximum = std::max(maximum, projection);
+    }
+    for (unsigned int ch = 0; ch < 4; ch++) {
+        endpoint0[ch] = std::clamp(mean[ch] + axis[ch] * minimum, 0.0f, 255.0f);
+        endpoint1[ch] = std::clamp(mean[ch] + axis[ch] * maximum, 0.0f, 255.0f);
+    }
+}
+
+/**
+ * Least squares endpoints for the indices chosen with the previous endpoints
+ *
+ * @param weights Fraction of the second endpoint selected by each index
+ * @return False when every pixel selects the same weight and the system has no single solution
+ */
+static bool solveEndpoints(unsigned char const *const pixels, unsigned int const mask, unsigned int const channels,
+                           unsigned char const *const indices, float const *const weights, float endpoint0[4],
+                           float endpoint1[4]) {
+    float aa = 0.0f;
+    float bb = 0.0f;
+    float ab = 0.0f;
+    float ax[4] = {};
+    float bx[4] = {};
+    for (unsigned int i = 0; i < 16; i++) {
+        if (!(mask & (1u << i))) {
+            continue;
+        }
+        float const b = weights[indices[i]];
+        float const a = 1.0f - b;
+        aa += a * a;
+        bb += b * b;
+        ab += a * b;
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            ax[ch] += a * pixels[i * 4 + ch];
+            bx[ch] += b * pixels[i * 4 + ch];
+        }
+    }
+
+    float const determinant = aa * bb - ab * ab;
+    if (std::fabs(determinant) < 1e-6f) {
+        return false;
+    }
+    for (unsigned int ch = 0; ch < channels; ch++) {
+        endpoint0[ch] = std::clamp((ax[ch] * bb - bx[ch] * ab) / determinant, 0.0f, 255.0f);
+        endpoint1[ch] = std::clamp((bx[ch] * aa - ax[ch] * ab) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+/**
+ * Round half up a value clamped to [0, maximum], cheaper than lround
+ */
+static unsigned int roundClamped(float const value, unsigned int const maximum) {
+    return static_cast<unsigned int>(std::clamp(value, 0.0f, static_cast<float>(maximum)) + 0.5f);
+}
+
+static unsigned int quantizeUnorm(float const value, unsigned int const maximum) {
+    return roundClamped(value * static_cast<float>(maximum) / 255.0f, maximum);
+}
+
+/**
+ * Pixels of a BC1 color block. Alpha is 255, BC1 transparent pixels are left out of the mask and select index 3.
+ */
+class BC1Source {
+public:
+    alignas(32) unsigned char pixels[64];
+    unsigned int mask;
+    bool allowTransparent;
+};
+
+/**
+ * Endpoints of a BC1 block as 5:6:5 components
+ */
+class BC1Endpoints {
+public:
+    unsigned int components[2][3];
+
+    uint16_t pack(unsigned int const endpoint) const {
+        return static_cast<uint16_t>((components[endpoint][0] << 11u) | (components[endpoint][1] << 5u)
+                                     | components[endpoint][2]);
+    }
+};
+
+static constexpr unsigned int BC1_MAXIMUM[3] = {31, 63, 31};
+
+static BC1Endpoints quantizeBC1(float const endpoint0[4], float const endpoint1[4]) {
+    BC1Endpoints endpoints{};
+    for (unsigned int ch = 0; ch < 3; ch++) {
+        endpoints.components[0][ch] = quantizeUnorm(endpoint0[ch], BC1_MAXIMUM[ch]);
+        endpoints.components[1][ch] = quantizeUnorm(endpoint1[ch], BC1_MAXIMUM[ch]);
+    }
+    return endpoints;
+}
+
+/**
+ * Endpoint pairs whose 2/3 interpolation is the closest to each 8-bit value, used for single color blocks
+ */
+class BC1SingleColorTable {
+public:
+    unsigned char endpoints[3][256][2] = {};
+
+    BC1SingleColorTable() {
+        for (unsigned int ch = 0; ch < 3; ch++) {
+            unsigned int const maximum = BC1_MAXIMUM[ch];
+            for (unsigned int value = 0; value < 256; value++) {
+                int bestError = INT_MAX;
+                for (unsigned int e0 = 0; e0 <= maximum; e0++) {
+                    for (unsigned int e1 = 0; e1 <= maximum; e1++) {
+                        int const error = std::abs(interpolateUnorm(e0, e1, 2, 1, maximum) - static_cast<int>(value));
+                        if (error < bestError) {
+                            bestError = error;
+                            endpoints[ch][value][0] = static_cast<unsigned char>(e0);
+                            endpoints[ch][value][1] = static_cast<unsigned char>(e1);
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
+
+static BC1SingleColorTable const &getBC1SingleColorTable() {
+    //built on first use, not when the library is loaded
+    static BC1SingleColorTable const table;
+    return table;
+}
+
+/**
+ * Write the endpoints in the order of the mode, 4 colors when c0 > c1, 3 colors and transparent black otherwise, then
+ * select the indices
+ *
+ * @return The squared error of the block
+ */
+static uint32_t encodeBC1Colors(BC1Source const &source, BC1Endpoints const &endpoints, bool const threeColors,
+                                unsigned char *const block, unsigned char *const indices) {
+    uint16_t c0 = endpoints.pack(0);
+    uint16_t c1 = endpoints.pack(1);
+    if (threeColors ? c0 > c1 : c0 < c1) {
+        std::swap(c0, c1);
+    }
+    block[0] = static_cast<unsigned char>(c0);
+    block[1] = static_cast<unsigned char>(c0 >> 8u);
+    block[2] = static_cast<unsigned char>(c1);
+    block[3] = static_cast<unsigned char>(c1 >> 8u);
+
+    alignas(16) unsigned char palette[16];
+    getBC1Palette(block, source.allowTransparent, palette);
+    //transparent black is only selected by the pixels outside the mask
+    size_t const count = c0 > c1 || !source.allowTransparent ? 4 : 3;
+    uint32_t const error = findSubsetIndices(source.pixels, source.mask, palette, count, indices);
+
+    uint32_t bits = 0;
+    for (unsigned int i = 0; i < 16; i++) {
+        unsigned int const index = source.mask & (1u << i) ? indices[i] : 3u;
+        bits |= index << (i * 2);
+    }
+    for (unsigned int i = 0; i < 4; i++) {
+        block[4 + i] = static_cast<unsigned char>(bits >> (i * 8));
+    }
+    return error;
+}
+
+/**
+ * Best BC1 block of one mode: principal axis endpoints refined by least squares, then by moving each 5:6:5 component
+ * by one step while the error decreases
+ */
+static uint32_t searchBC1Mode(BC1Source const &source, BCQuality const quality, bool const threeColors,
+                              unsigned char *const block) {
+    float endpoint0[4];
+    float endpoint1[4];
+    fitAxisEndpoints(source.pixels, source.mask, endpoint0, endpoint1);
+
+    BC1Endpoints best = quantizeBC1(endpoint0, endpoint1);
+    unsigned char indices[16];
+    uint32_t bestError = encodeBC1Colors(source, best, threeColors, block, indices);
+    if (quality == BC_QUALITY_FAST) {
+        return bestError;
+    }
+
+    unsigned char candidate[8];
+    unsigned char candidateIndices[16];
+    unsigned int const refinements = quality == BC_QUALITY_HIGH ? 3 : 1;
+    for (unsigned int i = 0; i < refinements && bestError > 0; i++) {
+        //the order of the endpoints is fixed again by encodeBC1Colors
+        if (!solveEndpoints(source.pixels, source.mask, 3, indices, threeColors ? BC1_WEIGHTS3 : BC1_WEIGHTS4,
+                            endpoint0, endpoint1)) {
+            break;
+        }
+        BC1Endpoints const refined = quantizeBC1(endpoint0, endpoint1);
+        uint32_t const error = encodeBC1Colors(source, refined, threeColors, candidate, candidateIndices);
+        if (error >= bestError) {
+            break;
+        }
+        best = refined;
+        bestError = error;
+        std::memcpy(block, candidate, 8);
+        std::memcpy(indices, candidateIndices, 16);
+    }
+
+    if (quality != BC_QUALITY_HIGH) {
+        return bestError;
+    }
+
+    bool improved = true;
+    for (unsigned int pass = 0; pass < 4 && improved && bestError > 0; pass++) {
+        improved = false;
+        for (unsigned int component = 0; component < 6; component++) {
+            unsigned int const endpoint = component / 3;
+            unsigned int const ch = component % 3;
+            for (int step = -1; step <= 1; step += 2) {
+                int const value = static_cast<int>(best.components[endpoint][ch]) + step;
+                if (value < 0 || value > static_cast<int>(BC1_MAXIMUM[ch])) {
+                    continue;
+                }
+                BC1Endpoints moved = best;
+                moved.components[endpoint][ch] = static_cast<unsigned int>(value);
+                uint32_t const error = encodeBC1Colors(source, moved, threeColors, candidate, candidateIndices);
+                if (error < bestError) {
+                    best = moved;
+                    bestError = error;
+                    std::memcpy(block, candidate, 8);
+                    improved = true;
+                }
+            }
+        }
+    }
+    return bestError;
+}
+
+/**
+ * Encode the color block of BC1, BC2 and BC3
+ *
+ * @param pixels The 16 RGBA pixels
+ * @param allowTransparent True for BC1, pixels with alpha below 128 are encoded as transparent black
+ */
+static void encodeBC1Block(unsigned char const *const pixels, BCQuality const quality, bool const allowTransparent,
+                           unsigned char *const block) {
+    BC1Source source{};
+    source.allowTransparent = allowTransparent;
+    source.mask = 0;
+    for (unsigned int i = 0; i < 16; i++) {
+        std::memcpy(source.pixels + i * 4, pixels + i * 4, 3);
+        source.pixels[i * 4 + 3] = 0xff;
+        if (!allowTransparent || pixels[i * 4 + 3] >= 128) {
+            source.mask |= 1u << i;
+        }
+    }
+
+    if (source.mask == 0) {
+        //c0 == c1 selects the 3 color mode, every index selects transparent black
+        std::memset(block, 0, 4);
+        std::memset(block + 4, 0xff, 4);
+        return;
+    }
+
+    bool const transparent = source.mask != 0xffffu;
+    bool singleColor = !transparent;
+    for (unsigned int i = 1; i < 16 && singleColor; i++) {
+        singleColor = std::memcmp(source.pixels, source.pixels + i * 4, 3) == 0;
+    }
+    if (singleColor) {
+        BC1SingleColorTable const &table = getBC1SingleColorTable();
+        BC1Endpoints endpoints{};
+        for (unsigned int ch = 0; ch < 3; ch++) {
+            endpoints.components[0][ch] = table.endpoints[ch][source.pixels[ch]][0];
+            endpoints.components[1][ch] = table.endpoints[ch][source.pixels[ch]][1];
+        }
+        unsigned char indices[16];
+        encodeBC1Colors(source, endpoints, false, block, indices);
+        return;
+    }
+
+    uint32_t const error = searchBC1Mode(source, quality, transparent, block);
+    if (quality == BC_QUALITY_HIGH && allowTransparent && !transparent && error > 0) {
+        //the midpoint of the 3 color mode can be closer than the thirds of the 4 color mode
+        unsigned char candidate[8];
+        if (searchBC1Mode(source, quality, true, candidate) < error) {
+            std::memcpy(block, candidate, 8);
+        }
+    }
+}
+
+/**
+ * Write the BC4 endpoints and select the indices, 8 values when e0 > e1, 6 values with 0 and 255 otherwise
+ *
+ * @param pixels The values in the first channel of 16 pixels, the other channels zero
+ * @return The squared error of the block
+ */
+static uint32_t encodeBC4Values(unsigned char const *const pixels, unsigned int const endpoint0,
+                                unsigned int const endpoint1, unsigned char *const block,
+                                unsigned char *const indices) {
+    block[0] = static_cast<unsigned char>(endpoint0);
+    block[1] = static_cast<unsigned char>(endpoint1);
+    unsigned char values[8];
+    getBC4Palette(block, false, values);
+
+    alignas(16) unsigned char palette[32] = {};
+    for (unsigned int i = 0; i < 8; i++) {
+        palette[i * 4] = values[i];
+    }
+    uint32_t const error = bcEncodeKernels.findIndices(pixels, palette, 8, indices);
+
+    uint64_t bits = 0;
+    for (unsigned int i = 0; i < 16; i++) {
+        bits |= static_cast<uint64_t>(indices[i]) << (i * 3);
+    }
+    for (unsigned int i = 0; i < 6; i++) {
+        block[2 + i] = static_cast<unsigned char>(bits >> (i * 8));
+    }
+    return error;
+}
+
+/**
+ * Encode a BC4 block from one channel of 16 RGBA pixels, also the alpha block of BC3 and the channels of BC5
+ */
+static void encodeBC4Block(unsigned char const *const pixels, unsigned int const channel, BCQuality const quality,
+                           unsigned char *const block) {
+    alignas(32) unsigned char values[64] = {};
+    unsigned int minimum = 255;
+    unsigned int maximum = 0;
+    unsigned int innerMinimum = 255;
+    unsigned int innerMaximum = 0;
+    for (unsigned int i = 0; i < 16; i++) {
+        unsigned int const value = pixels[i * 4 + channel];
+        values[i * 4] = static_cast<unsigned char>(value);
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+        if (value > 0 && value < 255) {
+            innerMinimum = std::min(innerMinimum, value);
+            innerMaximum = std::max(innerMaximum, value);
+        }
+    }
+
+    unsigned char indices[16];
+    if (minimum == maximum) {
+        encodeBC4Values(values, minimum, minimum, block, indices);
+        return;
+    }
+    uint32_t bestError = encodeBC4Values(values, maximum, minimum, block, indices);
+    if (quality == BC_QUALITY_FAST || bestError == 0) {
+        return;
+    }
+
+    unsigned char candidate[8];
+    unsigned char candidateIndices[16];
+    auto const tryEndpoints = [&](unsigned int const endpoint0, unsigned int const endpoint1) {
+        uint32_t const error = encodeBC4Values(values, endpoint0, endpoint1, candidate, candidateIndices);
+        if (error < bestError) {
+            bestError = error;
+            std::memcpy(block, candidate, 8);
+            std::memcpy(indices, candidateIndices, 16);
+            return true;
+        }
+        return false;
+    };
+
+    //the 6 value mode has exact 0 and 255 for the pixels at the extremes
+    if ((minimum == 0 || maximum == 255) && innerMinimum <= innerMaximum) {
+        tryEndpoints(innerMinimum, innerMaximum);
+    }
+
+    unsigned int const refinements = quality == BC_QUALITY_HIGH ? 3 : 1;
+    for (unsigned int i = 0; i < refinements && bestError > 0; i++) {
+        bool const eightValues = block[0] > block[1];
+        unsigned int mask = 0;
+        for (unsigned int p = 0; p < 16; p++) {
+            mask |= eightValues || indices[p] < 6 ? 1u << p : 0u;
+        }
+        float endpoint0[4];
+        float endpoint1[4];
+        if (!solveEndpoints(values, mask, 1, indices, eightValues ? BC4_WEIGHTS8 : BC4_WEIGHTS6, endpoint0,
+                            endpoint1)) {
+            break;
+        }
+        unsigned int e0 = roundClamped(endpoint0[0], 255);
+        unsigned int e1 = roundClamped(endpoint1[0], 255);
+        if (eightValues ? e0 < e1 : e0 > e1) {
+            std::swap(e0, e1);
+        }
+        if (eightValues && e0 == e1) {
+            if (e0 < 255) {
+                e0++;
+            } else {
+                e1--;
+            }
+        }
+        if (!tryEndpoints(e0, e1)) {
+            break;
+        }
+    }
+
+    if (quality != BC_QUALITY_HIGH) {
+        return;
+    }
+
+    bool improved = true;
+    for (unsigned int pass = 0; pass < 4 && improved && bestError > 0; pass++) {
+        improved = false;
+        for (unsigned int endpoint = 0; endpoint < 2; endpoint++) {
+            for (int step = -1; step <= 1; step += 2) {
+                int e0 = block[0];
+                int e1 = block[1];
+                (endpoint == 0 ? e0 : e1) += step;
+                //moving an endpoint past the other one would switch the mode
+                if (e0 < 0 || e0 > 255 || e1 < 0 || e1 > 255 || (block[0] > block[1]) != (e0 > e1)) {
+                    continue;
+                }
+                improved = tryEndpoints(static_cast<unsigned int>(e0), static_cast<unsigned int>(e1)) || improved;
+            }
+        }
+    }
+}
+
+/**
+ * Endpoints of BC7 mode 6: 7 bits per channel and a p-bit per endpoint, together 8 bits
+ */
+class BC7Mode6Endpoints {
+public:
+    unsigned int codes[2][4];
+    unsigned int pBits[2];
+};
+
+static unsigned int quantizeBC7Mode6(float const value, unsigned int const pBit) {
+    return roundClamped((value - static_cast<float>(pBit)) / 2.0f, 127);
+}
+
+static uint32_t evaluateBC7Mode6(unsigned char const *const pixels, BC7Mode6Endpoints const &endpoints,
+                                 unsigned char *const indices) {
+    alignas(16) unsigned char palette[64];
+    for (unsigned int i = 0; i < 16; i++) {
+        unsigned int const weight = BC_WEIGHTS4[i];
+        for (unsigned int ch = 0; ch < 4; ch++) {
+            unsigned int const e0 = endpoints.codes[0][ch] * 2 + endpoints.pBits[0];
+            unsigned int const e1 = endpoints.codes[1][ch] * 2 + endpoints.pBits[1];
+            palette[i * 4 + ch] = static_cast<unsigned char>((e0 * (64 - weight) + e1 * weight + 32) >> 6);
+        }
+    }
+    return bcEncodeKernels.findIndices(pixels, palette, 16, indices);
+}
+
+/**
+ * Quantize float endpoints for mode 6, trying every p-bit combination or picking the p-bits closest to the endpoints
+ */
+static uint32_t quantizeBC7Mode6Endpoints(unsigned char const *const pixels, float const endpoint0[4],
+                                          float const endpoint1[4], bool const allPBits,
+                                          BC7Mode6Endpoints &endpoints, unsigned char *const indices) {
+    float const *const source[2] = {endpoint0, endpoint1};
+    if (!allPBits) {
+        for (unsigned int e = 0; e < 2; e++) {
+            float errors[2] = {};
+            for (unsigned int pBit = 0; pBit < 2; pBit++) {
+                for (unsigned int ch = 0; ch < 4; ch++) {
+                    float const diff = static_cast<float>(quantizeBC7Mode6(source[e][ch], pBit) * 2 + pBit)
+                                       - source[e][ch];
+                    errors[pBit] += diff * diff;
+                }
+            }
+            endpoints.pBits[e] = errors[1] < errors[0] ? 1 : 0;
+            for (unsigned int ch = 0; ch < 4; ch++) {
+                endpoints.codes[e][ch] = quantizeBC7Mode6(source[e][ch], endpoints.pBits[e]);
+            }
+        }
+        return evaluateBC7Mode6(pixels, endpoints, indices);
+    }
+
+    uint32_t bestError = UINT32_MAX;
+    unsigned char candidateIndices[16];
+    for (unsigned int pBits = 0; pBits < 4; pBits++) {
+        BC7Mode6Endpoints candidate{};
+        for (unsigned int e = 0; e < 2; e++) {
+            candidate.pBits[e] = (pBits >> e) & 1u;
+            for (unsigned int ch = 0; ch < 4; ch++) {
+                candidate.codes[e][ch] = quantizeBC7Mode6(source[e][ch], candidate.pBits[e]);
+            }
+        }
+        uint32_t const error = evaluateBC7Mode6(pixels, candidate, candidateIndices);
+        if (error < bestError) {
+            bestError = error;
+            endpoints = candidate;
+            std::memcpy(indices, candidateIndices, 16);
+        }
+    }
+    return bestError;
+}
+
+static void packBC7Mode6(BC7Mode6Endpoints endpoints, unsigned char const *const selected,
+                         unsigned char *const block) {
+    unsigned char indices[16];
+    std::memcpy(indices, selected, 16);
+    //the most significant bit of the first index is implicit zero
+    if (indices[0] >= 8) {
+        std::swap(endpoints.codes[0], endpoints.codes[1]);
+        std::swap(endpoints.pBits[0], endpoints.pBits[1]);
+        for (unsigned char &index : indices) {
+            index = static_cast<unsigned char>(15 - index);
+        }
+    }
+
+    BlockWriter writer;
+    writer.write(1u << 6u, 7);
+    for (unsigned int ch = 0; ch < 4; ch++) {
+        writer.write(endpoints.codes[0][ch], 7);
+        writer.write(endpoints.codes[1][ch], 7);
+    }
+    writer.write(endpoints.pBits[0], 1);
+    writer.write(endpoints.pBits[1], 1);
+    for (unsigned int i = 0; i < 16; i++) {
+        writer.write(indices[i], i == 0 ? 3 : 4);
+    }
+    writer.store(block);
+}
+
+/**
+ * BC7 mode 6, a single subset with 4-bit indices for color and alpha
+ */
+static uint32_t encodeBC7Mode6(unsigned char const *const pixels, BCQuality const quality,
+                               unsigned char *const block) {
+    float endpoint0[4];
+    float endpoint1[4];
+    fitAxisEndpoints(pixels, 0xffffu, endpoint0, endpoint1);
+
+    bool const allPBits = quality != BC_QUALITY_FAST;
+    BC7Mode6Endpoints best{};
+    unsigned char indices[16];
+    uint32_t bestError = quantizeBC7Mode6Endpoints(pixels, endpoint0, endpoint1, allPBits, best, indices);
+
+    BC7Mode6Endpoints candidate{};
+    unsigned char candidateIndices[16];
+    unsigned int const refinements = quality == BC_QUALITY_HIGH ? 2 : quality == BC_QUALITY_NORMAL ? 1 : 0;
+    for (unsigned int i = 0; i < refinements && bestError > 0; i++) {
+        if (!solveEndpoints(pixels, 0xffffu, 4, indices, BC7_WEIGHTS4, endpoint0, endpoint1)) {
+            break;
+        }
+        uint32_t const error = quantizeBC7Mode6Endpoints(pixels, endpoint0, endpoint1, true, candidate,
+                                                         candidateIndices);
+        if (error >= bestError) {
+            break;
+        }
+        best = candidate;
+        bestError = error;
+        std::memcpy(indices, candidateIndices, 16);
+    }
+
+    if (quality == BC_QUALITY_HIGH) {
+        bool improved = true;
+        for (unsigned int pass = 0; pass < 2 && improved && bestError > 0; pass++) {
+            improved = false;
+            for (unsigned int component = 0; component < 8; component++) {
+                for (int step = -1; step <= 1; step += 2) {
+                    candidate = best;
+                    unsigned int &code = candidate.codes[component / 4][component % 4];
+                    int const value = static_cast<int>(code) + step;
+                    if (value < 0 || value > 127) {
+                        continue;
+                    }
+                    code = static_cast<unsigned int>(value);
+                    uint32_t const error = evaluateBC7Mode6(pixels, candidate, candidateIndices);
+                    if (error < bestError) {
+                        best = candidate;
+                        bestError = error;
+                        std::memcpy(indices, candidateIndices, 16);
+                        improved = true;
+                    }
+                }
+            }
+        }
+    }
+
+    packBC7Mode6(best, indices, block);
+    return bestError;
+}
+
+/**
+ * Endpoints of a BC7 mode 1 subset: 6 bits per color channel and a p-bit shared by both endpoints
+ */
+class BC7Mode1Endpoints {
+public:
+    unsigned int codes[2][3];
+    unsigned int pBit;
+};
+
+static unsigned int expandBC7Mode1(unsigned int const code, unsigned int const pBit) {
+    unsigned int const value = code * 2 + pBit;
+    return (value << 1u) | (value >> 6u);
+}
+
+/**
+ * Quantize the endpoints of a subset with both p-bits and select the indices of its pixels
+ */
+static uint32_t quantizeBC7Mode1Subset(unsigned char const *const pixels, unsigned int const mask,
+                                       float const endpoint0[4], float const endpoint1[4],
+                                       BC7Mode1Endpoints &endpoints, unsigned char *const indices) {
+    float const *const source[2] = {endpoint0, endpoint1};
+    uint32_t bestError = UINT32_MAX;
+    unsigned char candidateIndices[16];
+    for (unsigned int pBit = 0; pBit < 2; pBit++) {
+        BC7Mode1Endpoints candidate{};
+        candidate.pBit = pBit;
+        unsigned int expanded[2][3];
+        for (unsigned int e = 0; e < 2; e++) {
+            for (unsigned int ch = 0; ch < 3; ch++) {
+                float const value = source[e][ch] * 127.0f / 255.0f;
+                candidate.codes[e][ch] = roundClamped((value - static_cast<float>(pBit)) / 2.0f, 63);
+                expanded[e][ch] = expandBC7Mode1(candidate.codes[e][ch], pBit);
+            }
+        }
+
+        alignas(16) unsigned char palette[32];
+        for (unsigned int i = 0; i < 8; i++) {
+            unsigned int const weight = BC_WEIGHTS3[i];
+            for (unsigned int ch = 0; ch < 3; ch++) {
+                palette[i * 4 + ch] =
+                        static_cast<unsigned char>((expanded[0][ch] * (64 - weight) + expanded[1][ch] * weight + 32)
+                                                   >> 6);
+            }
+            palette[i * 4 + 3] = 0xff;
+        }
+
+        uint32_t const error = findSubsetIndices(pixels, mask, palette, 8, candidateIndices);
+        if (error < bestError) {
+            bestError = error;
+            endpoints = candidate;
+            for (unsigned int i = 0; i < 16; i++) {
+                if (mask & (1u << i)) {
+                    indices[i] = candidateIndices[i];
+                }
+            }
+        }
+    }
+    return bestError;
+}
+
+/**
+ * BC7 mode 1 with a given partition, two subsets with 3-bit indices, opaque blocks only
+ */
+static uint32_t encodeBC7Mode1(unsigned char const *const pixels, unsigned int const partition,
+                               unsigned char *const block) {
+    unsigned int const masks[2] = {~BC_PARTITION2[partition] & 0xffffu, BC_PARTITION2[partition]};
+    BC7Mode1Endpoints endpoints[2];
+    unsigned char indices[16];
+    uint32_t totalError = 0;
+    for (unsigned int subset = 0; subset < 2; subset++) {
+        float endpoint0[4];
+        float endpoint1[4];
+        fitAxisEndpoints(pixels, masks[subset], endpoint0, endpoint1);
+        uint32_t error = quantizeBC7Mode1Subset(pixels, masks[subset], endpoint0, endpoint1, endpoints[subset],
+                                                indices);
+
+        BC7Mode1Endpoints candidate{};
+        unsigned char candidateIndices[16];
+        if (error > 0 && solveEndpoints(pixels, masks[subset], 3, indices, BC7_WEIGHTS3, endpoint0, endpoint1)) {
+            uint32_t const refined = quantizeBC7Mode1Subset(pixels, masks[subset], endpoint0, endpoint1, candidate,
+                                                            candidateIndices);
+            if (refined < error) {
+                error = refined;
+                endpoints[subset] = candidate;
+                for (unsigned int i = 0; i < 16; i++) {
+                    if (masks[subset] & (1u << i)) {
+                        indices[i] = candidateIndices[i];
+                    }
+                }
+            }
+        }
+        totalError += error;
+
+        //the most significant bit of the anchor index is implicit zero
+        unsigned int const anchor = subset == 0 ? 0 : BC_ANCHOR2[partition];
+        if (indices[anchor] >= 4) {
+            std::swap(endpoints[subset].codes[0], endpoints[subset].codes[1]);
+            for (unsigned int i = 0; i < 16; i++) {
+                if (masks[subset] & (1u << i)) {
+                    indices[i] = static_cast<unsigned char>(7 - indices[i]);
+                }
+            }
+        }
+    }
+
+    BlockWriter writer;
+    writer.write(1u << 1u, 2);
+    writer.write(partition, 6);
+    for (unsigned int ch = 0; ch < 3; ch++) {
+        for (auto const &subset : endpoints) {
+            writer.write(subset.codes[0][ch], 6);
+            writer.write(subset.codes[1][ch], 6);
+        }
+    }
+    writer.write(endpoints[0].pBit, 1);
+    writer.write(endpoints[1].pBit, 1);
+    for (unsigned int i = 0; i < 16; i++) {
+        writer.write(indices[i], i == 0 || i == BC_ANCHOR2[partition] ? 2 : 3);
+    }
+    writer.store(block);
+    return totalError;
+}
+
+static void encodeBC7Block(unsigned char const *const pixels, BCQuality const quality, unsigned char *const block) {
+    uint32_t const error = encodeBC7Mode6(pixels, quality, block);
+    if (quality != BC_QUALITY_HIGH || error == 0) {
+        return;
+    }
+    for (unsigned int i = 0; i < 16; i++) {
+        if (pixels[i * 4 + 3] != 0xff) {
+            return;
+        }
+    }
+
+    //rank the partitions by the distance of each subset to its principal axis, encode the best ones
+    unsigned int candidates[BC7_PARTITION_CANDIDATES] = {};
+    float candidateErrors[BC7_PARTITION_CANDIDATES] = {};
+    size_t candidateCount = 0;
+    ChannelMoments const whole(pixels, 0xffffu);
+    for (unsigned int partition = 0; partition < 64; partition++) {
+        ChannelMoments const second(pixels, BC_PARTITION2[partition]);
+        ChannelMoments first = whole;
+        first -= second;
+        float mean[4];
+        float axis[4];
+        float const estimate = computePrincipalAxis(first, mean, axis) + computePrincipalAxis(second, mean, axis);
+        size_t position = candidateCount;
+        while (position > 0 && candidateErrors[position - 1] > estimate) {
+            position--;
+        }
+        if (position >= BC7_PARTITION_CANDIDATES) {
+            continue;
+        }
+        candidateCount = std::min(candidateCount + 1, BC7_PARTITION_CANDIDATES);
+        for (size_t i = candidateCount - 1; i > position; i--) {
+            candidates[i] = candidates[i - 1];
+            candidateErrors[i] = candidateErrors[i - 1];
+        }
+        candidates[position] = partition;
+        candidateErrors[position] = estimate;
+    }
+
+    uint32_t bestError = error;
+    unsigned char candidate[16];
+    for (size_t i = 0; i < candidateCount; i++) {
+        uint32_t const partitionError = encodeBC7Mode1(pixels, candidates[i], candidate);
+        if (partitionError < bestError) {
+            bestError = partitionError;
+            std::memcpy(block, candidate, 16);
+        }
+    }
+}
+
+typedef void (*BCBlockEncoder)(unsigned char const *pixels, BCQuality quality, unsigned char *block);
+
+static void encodeBC1(unsigned char const *const pixels, BCQuality const quality, unsigned char *const block) {
+    encodeBC1Block(pixels, quality, true, block);
+}
+
+static void encodeBC3(unsigned char const *const pixels, BCQuality const quality, unsigned char *const block) {
+    encodeBC4Block(pixels, 3, quality, block);
+    encodeBC1Block(pixels, quality, false, block + 8);
+}
+
+static void encodeBC4(unsigned char const *const pixels, BCQuality const quality, unsigned char *const block) {
+    encodeBC4Block(pixels, 0, quality, block);
+}
+
+static void encodeBC5(unsigned char const *const pixels, BCQuality const quality, unsigned char *const block) {
+    encodeBC4Block(pixels, 0, quality, block);
+    encodeBC4Block(pixels, 1, quality, block + 8);
+}
+
+static BCBlockEncoder getBCBlockEncoder(DXGI_FORMAT const format) {
+    switch (format) {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            return encodeBC1;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            return encodeBC3;
+        case DXGI_FORMAT_BC4_UNORM:
+            return encodeBC4;
+        case DXGI_FORMAT_BC5_UNORM:
+            return encodeBC5;
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return encodeBC7Block;
+        default:
+            return nullptr;
+    }
+}
+
+bool isBCEncodeFormat(DXGI_FORMAT const format) {
+    return getBCBlockEncoder(format) != nullptr;
+}
+
+/**
+ * Copy a 4x4 block, pixels past the right and bottom edges repeat the last column and row
+ */
+static void loadBlock(DirectX::Image const &image, size_t const blockX, size_t const blockY,
+                      unsigned char *const pixels) {
+    size_t const x = blockX * 4;
+    for (size_t row = 0; row < 4; row++) {
+        unsigned char const *src = image.pixels + std::min(blockY * 4 + row, image.height - 1) * image.rowPitch;
+        if (x + 4 <= image.width) {
+            std::memcpy(pixels + row * 16, src + x * 4, 16);
+            continue;
+        }
+        for (size_t col = 0; col < 4; col++) {
+            std::memcpy(pixels + row * 16 + col * 4, src + std::min(x + col, image.width - 1) * 4, 4);
+        }
+    }
+}
+
+ConvertStatus encodeBC(DXGI_FORMAT const format, BCQuality const quality, DirectX::Image const &image,
+                       unsigned char *const output) {
+    BCBlockEncoder const encoder = getBCBlockEncoder(format);
+    if (encoder == nullptr || output == nullptr || image.pixels == nullptr || image.width == 0 || image.height == 0
+        || (image.format != DXGI_FORMAT_R8G8B8A8_UNORM && image.format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    size_t const blockSize = getBCBlockSize(format);
+    size_t const blocksWide = (image.width + 3) / 4;
+    size_t const blockCount = blocksWide * ((image.height + 3) / 4);
+    size_t const taskCount = (blockCount + BC_ENCODE_TASK_BLOCKS - 1) / BC_ENCODE_TASK_BLOCKS;
+
+    auto const encodeBlocks = [&](size_t const task, [[maybe_unused]] size_t const worker) {
+        alignas(32) unsigned char pixels[64];
+        size_t const end = std::min(blockCount, (task + 1) * BC_ENCODE_TASK_BLOCKS);
+        for (size_t b = task * BC_ENCODE_TASK_BLOCKS; b < end; b++) {
+            loadBlock(image, b % blocksWide, b / blocksWide, pixels);
+            encoder(pixels, quality, output + b * blockSize);
+        }
+    };
+
+    if (taskCount == 1) {
+        encodeBlocks(0, 0);
+    } else {
+        getThreadPool()->parallelFor(taskCount, encodeBlocks);
+    }
+    return CONVERT_OK;
+}
@@ -0,0 +1,81 @@
+#pragma once
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <DirectXTex.h>
+#include "ConvertStatus.h"
+#include "DDSEncodeOptions.h"
+
+/**
+ * Find the nearest palette entry of each pixel of a 4x4 block, as the sum of the squared differences of the four
+ * channels. Ties select the lowest index.
+ *
+ * @param pixels The 16 RGBA pixels of the block
+ * @param palette RGBA palette
+ * @param count Number of palette entries, 16 at most
+ * @param indices Receives the index of each pixel
+ * @return The squared error of the block
+ */
+typedef uint32_t (*BCIndexSearch)(unsigned char const *pixels, unsigned char const *palette, size_t count,
+                                  unsigned char *indices);
+
+class BCEncodeKernels {
+public:
+    char const *name;
+    BCIndexSearch findIndices;
+};
+
+/**
+ * Kernels selected for this CPU when the library was loaded. The index search is the inner loop of every endpoint
+ * search, the endpoints themselves are fitted with scalar code.
+ */
+BCEncodeKernels const &getBCEncodeKernels();
+
+/**
+ * @return True if encodeBC supports the format: BC1, BC3 and BC7 UNORM or UNORM_SRGB, BC4 and BC5 UNORM
+ */
+bool isBCEncodeFormat(DXGI_FORMAT format);
+
+/**
+ * Encode a 8-bit RGBA image to BC blocks, blocks are encoded in parallel on the shared thread pool. BC4 stores the
+ * red channel and BC5 red and green. The sRGB formats are encoded without conversion.
+ *
+ * @param format The BC format
+ * @param quality The encoder quality
+ * @param image The image, DXGI_FORMAT_R8G8B8A8_UNORM
+ * @param output Receives the blocks, rows of ((width + 3) / 4) blocks without padding
+ * @return CONVERT_OK on success, CONVERT_ERROR_INVALID_ARGUMENT if the format is not supported
+ */
+ConvertStatus encodeBC(DXGI_FORMAT format, BCQuality quality, DirectX::Image const &image, unsigned char *output);
+
+uint32_t findBCIndicesScalar(unsigned char const *pixels, unsigned char const *palette, size_t count,
+                             unsigned char *indices);
+uint32_t findBCIndicesSse41(unsigned char const *pixels, unsigned char const *palette, size_t count,
+                            unsigned char *indices);
+uint32_t findBCIndicesAvx2(unsigned char const *pixels, unsigned char const *palette, size_t count,
+                           unsigned char *indices);
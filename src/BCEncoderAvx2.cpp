@@ -0,0 +1,82 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstring>
+#include "BCEncoder.h"
+#include "CpuFeatures.h"
+
+#ifdef DXTWRAPPER_X86
+
+#include <immintrin.h>
+
+/**
+ * Squared error of 8 pixels to one color, in the order 0 1 4 5 2 3 6 7 left by hadd within each 128-bit lane
+ */
+static inline __m256i getPixelErrors(__m128i const first, __m128i const second, __m256i const color) {
+    __m256i const low = _mm256_sub_epi16(_mm256_cvtepu8_epi16(first), color);
+    __m256i const high = _mm256_sub_epi16(_mm256_cvtepu8_epi16(second), color);
+    return _mm256_hadd_epi32(_mm256_madd_epi16(low, low), _mm256_madd_epi16(high, high));
+}
+
+uint32_t findBCIndicesAvx2(unsigned char const *const pixels, unsigned char const *const palette,
+                           size_t const count, unsigned char *const indices) {
+    __m128i rows[4];
+    for (size_t i = 0; i < 4; i++) {
+        rows[i] = _mm_loadu_si128(reinterpret_cast<__m128i const *>(pixels + i * 16));
+    }
+    __m256i best[2] = {_mm256_set1_epi32(INT32_MAX), _mm256_set1_epi32(INT32_MAX)};
+    __m256i bestIndices[2] = {_mm256_setzero_si256(), _mm256_setzero_si256()};
+
+    for (size_t j = 0; j < count; j++) {
+        int color;
+        std::memcpy(&color, palette + j * 4, 4);
+        __m256i const color16 = _mm256_cvtepu8_epi16(_mm_set1_epi32(color));
+        __m256i const index = _mm256_set1_epi32(static_cast<int>(j));
+        for (size_t i = 0; i < 2; i++) {
+            __m256i const error = getPixelErrors(rows[i * 2], rows[i * 2 + 1], color16);
+            //strictly lower, ties keep the lowest index like the scalar search
+            __m256i const lower = _mm256_cmpgt_epi32(best[i], error);
+            best[i] = _mm256_min_epi32(error, best[i]);
+            bestIndices[i] = _mm256_blendv_epi8(bestIndices[i], index, lower);
+        }
+    }
+
+    //restore the pixel order, then narrow to bytes
+    __m256i const order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+    __m256i const first = _mm256_permutevar8x32_epi32(bestIndices[0], order);
+    __m256i const second = _mm256_permutevar8x32_epi32(bestIndices[1], order);
+    __m256i const words = _mm256_permute4x64_epi64(_mm256_packus_epi32(first, second), _MM_SHUFFLE(3, 1, 2, 0));
+    __m128i const packed = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(indices), packed);
+
+    __m256i const total = _mm256_add_epi32(best[0], best[1]);
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+}
+
+#endif
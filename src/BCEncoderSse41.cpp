@@ -0,0 +1,80 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstring>
+#include "BCEncoder.h"
+#include "CpuFeatures.h"
+
+#ifdef DXTWRAPPER_X86
+
+#include <smmintrin.h>
+
+/**
+ * Squared error of 4 pixels to one color. Channels are widened to 16 bits, madd sums red with green and blue with
+ * alpha, hadd sums the pairs of each pixel.
+ */
+static inline __m128i getPixelErrors(__m128i const pixels, __m128i const color) {
+    __m128i const low = _mm_sub_epi16(_mm_cvtepu8_epi16(pixels), color);
+    __m128i const high = _mm_sub_epi16(_mm_unpackhi_epi8(pixels, _mm_setzero_si128()), color);
+    return _mm_hadd_epi32(_mm_madd_epi16(low, low), _mm_madd_epi16(high, high));
+}
+
+uint32_t findBCIndicesSse41(unsigned char const *const pixels, unsigned char const *const palette,
+                            size_t const count, unsigned char *const indices) {
+    __m128i rows[4];
+    __m128i best[4];
+    __m128i bestIndices[4];
+    for (size_t i = 0; i < 4; i++) {
+        rows[i] = _mm_loadu_si128(reinterpret_cast<__m128i const *>(pixels + i * 16));
+        best[i] = _mm_set1_epi32(INT32_MAX);
+        bestIndices[i] = _mm_setzero_si128();
+    }
+
+    for (size_t j = 0; j < count; j++) {
+        int color;
+        std::memcpy(&color, palette + j * 4, 4);
+        __m128i const color16 = _mm_cvtepu8_epi16(_mm_set1_epi32(color));
+        __m128i const index = _mm_set1_epi32(static_cast<int>(j));
+        for (size_t i = 0; i < 4; i++) {
+            __m128i const error = getPixelErrors(rows[i], color16);
+            //strictly lower, ties keep the lowest index like the scalar search
+            __m128i const lower = _mm_cmplt_epi32(error, best[i]);
+            best[i] = _mm_min_epi32(error, best[i]);
+            bestIndices[i] = _mm_blendv_epi8(bestIndices[i], index, lower);
+        }
+    }
+
+    __m128i const packed = _mm_packus_epi16(_mm_packus_epi32(bestIndices[0], bestIndices[1]),
+                                            _mm_packus_epi32(bestIndices[2], bestIndices[3]));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(indices), packed);
+
+    __m128i sum = _mm_add_epi32(_mm_add_epi32(best[0], best[1]), _mm_add_epi32(best[2], best[3]));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+}
+
+#endif
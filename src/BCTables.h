@@ -0,0 +1,242 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdint>
+
+/*
+ * Tables and palette builders shared by the BC decoder kernels. The functions are static so every kernel file gets a
+ * copy compiled for its own instruction set.
+ */
+
+//subset of each pixel for the 2-subset partitions of BC6H and BC7, bit i is the subset of pixel i
+inline constexpr uint16_t BC_PARTITION2[64] = {
+        0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+        0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+        0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+        0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+        0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+        0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+        0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+        0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+};
+
+//subset of each pixel for the 3-subset partitions of BC7
+inline constexpr uint8_t BC_PARTITION3[64][16] = {
+        {0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2}, {0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1},
+        {0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1}, {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1},
+        {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2}, {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2},
+        {0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1}, {0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+        {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2}, {0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2},
+        {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2},
+        {0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2}, {0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2},
+        {0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2}, {0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0},
+        {0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2}, {0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0},
+        {0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2}, {0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1},
+        {0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2}, {0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1},
+        {0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2}, {0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0},
+        {0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0}, {0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2},
+        {0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0}, {0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1},
+        {0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2}, {0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2},
+        {0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1}, {0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1},
+        {0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2}, {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1},
+        {0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2}, {0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0},
+        {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0}, {0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0},
+        {0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0}, {0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1},
+        {0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1}, {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+        {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1}, {0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2},
+        {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1}, {0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1},
+        {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1}, {0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1},
+        {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2}, {0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1},
+        {0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2}, {0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2},
+        {0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2}, {0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2},
+        {0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2}, {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2},
+        {0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2},
+        {0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2},
+        {0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1}, {0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2},
+        {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0},
+};
+
+//anchor pixel of the second subset of the 2-subset partitions
+inline constexpr uint8_t BC_ANCHOR2[64] = {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+        15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+        6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+};
+
+//anchor pixels of the second and third subsets of the 3-subset partitions
+inline constexpr uint8_t BC_ANCHOR3_SECOND[64] = {
+        3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+        3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+        8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+        3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3,
+};
+
+inline constexpr uint8_t BC_ANCHOR3_THIRD[64] = {
+        15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+        15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+        15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+        15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8,
+};
+
+//interpolation weights of 2, 3 and 4-bit indices, out of 64
+inline constexpr uint8_t BC_WEIGHTS2[4] = {0, 21, 43, 64};
+inline constexpr uint8_t BC_WEIGHTS3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+inline constexpr uint8_t BC_WEIGHTS4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+/**
+ * pshufb masks selecting the palette color of 4 pixels, indexed by a byte of 2-bit BC1 indices
+ */
+class BC1ShuffleTable {
+public:
+    alignas(16) unsigned char masks[256][16] = {};
+
+    constexpr BC1ShuffleTable() {
+        for (unsigned int indices = 0; indices < 256; indices++) {
+            for (unsigned int pixel = 0; pixel < 4; pixel++) {
+                for (unsigned int ch = 0; ch < 4; ch++) {
+                    masks[indices][pixel * 4 + ch] =
+                            static_cast<unsigned char>(((indices >> (pixel * 2)) & 3u) * 4 + ch);
+                }
+            }
+        }
+    }
+};
+
+inline constexpr BC1ShuffleTable BC1_SHUFFLE{};
+
+/**
+ * (a * weightA + b * weightB) / (weightA + weightB) of two endpoints with 'maximum' as 1.0, scaled to 8 bits and
+ * rounded half up. The exact rational result matches the float interpolation of DirectXTex.
+ */
+static inline unsigned char interpolateUnorm(unsigned int const a, unsigned int const b, unsigned int const weightA,
+                                             unsigned int const weightB, unsigned int const maximum) {
+    unsigned int const divisor = (weightA + weightB) * maximum;
+    return static_cast<unsigned char>((510 * (a * weightA + b * weightB) + divisor) / (2 * divisor));
+}
+
+/**
+ * Same as interpolateUnorm for signed endpoints in [-127, 127], the result is biased from [-1, 1] to [0, 255]
+ */
+static inline unsigned char interpolateSnorm(int const a, int const b, int const weightA, int const weightB) {
+    int const divisor = (weightA + weightB) * 127;
+    return static_cast<unsigned char>((510 * (a * weightA + b * weightB + divisor) + 2 * divisor) / (4 * divisor));
+}
+
+static inline void getBC1Channel(unsigned int const e0, unsigned int const e1, unsigned int const maximum,
+                                 bool const fourColors, unsigned char *const palette) {
+    palette[0] = interpolateUnorm(e0, e1, 1, 0, maximum);
+    palette[4] = interpolateUnorm(e0, e1, 0, 1, maximum);
+    if (fourColors) {
+        palette[8] = interpolateUnorm(e0, e1, 2, 1, maximum);
+        palette[12] = interpolateUnorm(e0, e1, 1, 2, maximum);
+    } else {
+        palette[8] = interpolateUnorm(e0, e1, 1, 1, maximum);
+        palette[12] = 0;
+    }
+}
+
+/**
+ * Colors of a BC1 block, also the color half of BC2 and BC3
+ *
+ * @param block The 8-byte color block
+ * @param allowTransparent True for BC1, where c0 <= c1 selects 3 colors and transparent black
+ * @param palette Receives 4 RGBA colors
+ */
+static inline void getBC1Palette(unsigned char const *const block, bool const allowTransparent,
+                                 unsigned char palette[16]) {
+    unsigned int const c0 = block[0] | (block[1] << 8u);
+    unsigned int const c1 = block[2] | (block[3] << 8u);
+    bool const fourColors = c0 > c1 || !allowTransparent;
+
+    //constant maximums let the compiler turn the divisions into multiplications
+    getBC1Channel(c0 >> 11u, c1 >> 11u, 31, fourColors, palette);
+    getBC1Channel((c0 >> 5u) & 0x3fu, (c1 >> 5u) & 0x3fu, 63, fourColors, palette + 1);
+    getBC1Channel(c0 & 0x1fu, c1 & 0x1fu, 31, fourColors, palette + 2);
+    palette[3] = 0xff;
+    palette[7] = 0xff;
+    palette[11] = 0xff;
+    palette[15] = fourColors ? 0xff : 0;
+}
+
+/**
+ * Values of a BC4 block, also the alpha of BC3 and each channel of BC5
+ *
+ * @param block The 8-byte block
+ * @param snorm True for the signed formats, biased to [0, 255]
+ * @param palette Receives 8 values
+ */
+static inline void getBC4Palette(unsigned char const *const block, bool const snorm, unsigned char palette[8]) {
+    if (snorm) {
+        //-128 and -127 are both -1.0
+        int const r0 = std::max(static_cast<int>(static_cast<int8_t>(block[0])), -127);
+        int const r1 = std::max(static_cast<int>(static_cast<int8_t>(block[1])), -127);
+        palette[0] = interpolateSnorm(r0, r1, 1, 0);
+        palette[1] = interpolateSnorm(r0, r1, 0, 1);
+        if (r0 > r1) {
+            for (int i = 2; i < 8; i++) {
+                palette[i] = interpolateSnorm(r0, r1, 8 - i, i - 1);
+            }
+        } else {
+            for (int i = 2; i < 6; i++) {
+                palette[i] = interpolateSnorm(r0, r1, 6 - i, i - 1);
+            }
+            palette[6] = 0;
+            palette[7] = 0xff;
+        }
+        return;
+    }
+
+    unsigned int const r0 = block[0];
+    unsigned int const r1 = block[1];
+    palette[0] = static_cast<unsigned char>(r0);
+    palette[1] = static_cast<unsigned char>(r1);
+    if (r0 > r1) {
+        for (unsigned int i = 2; i < 8; i++) {
+            palette[i] = interpolateUnorm(r0, r1, 8 - i, i - 1, 255);
+        }
+    } else {
+        for (unsigned int i = 2; i < 6; i++) {
+            palette[i] = interpolateUnorm(r0, r1, 6 - i, i - 1, 255);
+        }
+        palette[6] = 0;
+        palette[7] = 0xff;
+    }
+}
+
+/**
+ * The 48 index bits of a BC4 block, 3 bits per pixel
+ */
+static inline uint64_t getBC4Indices(unsigned char const *const block) {
+    uint64_t bits = 0;
+    for (int i = 7; i >= 2; i--) {
+        bits = (bits << 8u) | block[i];
+    }
+    return bits;
+}
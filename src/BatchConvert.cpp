@@ -0,0 +1,98 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include "BatchConvert.h"
+#include "ScratchArena.h"
+#include "ThreadPool.h"
+
+/**
+ * Convert many textures in parallel on the shared work-stealing pool. Errors are not printed, each job reports its own
+ * status.
+ *
+ * @param jobs The conversions, 'output' and 'status' of every job are written
+ * @param count Number of jobs
+ * @return CONVERT_OK when every job succeeded, otherwise the status of the first failed job
+ */
+[[maybe_unused]] ConvertStatus convertBatch(ConvertJob *const jobs, size_t const count) {
+    if (jobs == nullptr && count > 0) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::shared_ptr<ThreadPool> pool = getThreadPool();
+    pool->parallelFor(count, [jobs](size_t const index, [[maybe_unused]] size_t const worker) {
+        //buffers reused by every job executed on this worker
+        ArenaScope arena;
+
+        ErrorOutputScope const errors(false);
+        jobs[index].status = runConvertJob(jobs[index], arena.arena.getImageData());
+    });
+
+    for (size_t i = 0; i < count; i++) {
+        if (jobs[i].status != CONVERT_OK) {
+            return jobs[i].status;
+        }
+    }
+    return CONVERT_OK;
+}
+
+/**
+ * Set the number of threads used by the batch conversions
+ *
+ * @param workers Number of threads, 0 to use one per hardware thread
+ */
+[[maybe_unused]] void setWorkerCount(unsigned int const workers) {
+    setThreadPoolWorkers(workers);
+}
+
+/**
+ * @return Number of threads used by the batch conversions
+ */
+[[maybe_unused]] unsigned int getWorkerCount() {
+    return static_cast<unsigned int>(getThreadPool()->getWorkerCount());
+}
+
+ConvertStatus runConvertJob(ConvertJob &job, ImageData &scratch) {
+    job.output.size = 0;
+    job.output.content = nullptr;
+
+    switch (job.direction) {
+        case CONVERT_PNG_TO_DDS:
+            if (job.ddsOptions != nullptr) {
+                return convertPNGtoDDSCompressedWithScratch(job.data, job.size, job.ddsOptions, nullptr, nullptr,
+                                                            &job.output, scratch);
+            }
+            if (job.streaming) {
+                return convertPNGtoDDSStreamEx(job.data, job.size, job.dx10ext, job.bgra, nullptr, nullptr,
+                                               &job.output);
+            }
+            return convertPNGtoDDSWithScratch(job.data, job.size, job.dx10ext, job.bgra, nullptr, nullptr,
+                                              &job.output, scratch);
+        case CONVERT_DDS_TO_PNG:
+            return convertDDStoPNGEx(job.data, job.size, job.pngOptions, nullptr, nullptr, &job.output);
+        default:
+            return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include "DxTexWrapper.h"
+
+enum ConvertDirection : int {
+    CONVERT_PNG_TO_DDS = 0,
+    CONVERT_DDS_TO_PNG = 1,
+};
+
+/**
+ * A conversion of the batch. The input is borrowed, the output is allocated with malloc and must be released with
+ * freeContentBuffer.
+ */
+class ConvertJob {
+public:
+    void const *data;
+    size_t size;
+    ConvertDirection direction;
+    bool dx10ext;
+    bool bgra;
+    //CONVERT_PNG_TO_DDS decodes row by row, see convertPNGtoDDSStreamEx
+    bool streaming;
+    //PNG encoder settings of CONVERT_DDS_TO_PNG, nullptr for PNG_PROFILE_BALANCED without content detection
+    PngEncodeOptions const *pngOptions;
+    //output format of CONVERT_PNG_TO_DDS, replaces dx10ext, bgra and streaming. nullptr for uncompressed.
+    DDSEncodeOptions const *ddsOptions;
+
+    ContentBuffer output;
+    ConvertStatus status;
+};
+
+ConvertStatus runConvertJob(ConvertJob &job, ImageData &scratch);
+
+extern "C" {
+[[maybe_unused]] LIBEXPORT ConvertStatus convertBatch(ConvertJob *jobs, size_t count);
+[[maybe_unused]] LIBEXPORT void setWorkerCount(unsigned int workers);
+[[maybe_unused]] LIBEXPORT unsigned int getWorkerCount();
+}
@@ -1,7 +1,24 @@
 #pragma once
 
+#include <cstddef>
+
 class Content {
 public:
     unsigned int size;
     void *content;
 };
+
+class ContentBuffer {
+public:
+    size_t size;
+    void *content;
+};
+
+/**
+ * Allocator used by the *Ex conversion functions to obtain the output buffer. The returned memory is owned by the caller.
+ *
+ * @param size The size(in bytes) of the output
+ * @param userData The pointer passed by the caller to the conversion function
+ * @return A buffer of at least 'size' bytes, or nullptr to abort the conversion
+ */
+typedef void *(*ContentAllocator)(size_t size, void *userData);
@@ -0,0 +1,419 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <vector>
+#include "ConvertCache.h"
+
+static constexpr uint32_t CACHE_INDEX_MAGIC = 0x43545844;
+static constexpr uint32_t CACHE_INDEX_VERSION = 1;
+//slots of the index hash table, at most 3/4 of them are used
+static constexpr uint64_t CACHE_INDEX_SLOTS = 65536;
+static constexpr uint64_t CACHE_MAX_ENTRIES = CACHE_INDEX_SLOTS / 4 * 3;
+
+//conversion of a cache key, the key of the same input differs for each
+enum CacheDirection : uint32_t {
+    CACHE_PNG_TO_DDS = 1,
+    CACHE_PNG_TO_DDS_COMPRESSED = 2,
+    CACHE_DDS_TO_PNG = 3,
+};
+
+class CacheIndexHeader {
+public:
+    uint32_t magic;
+    uint32_t version;
+    uint64_t slotCount;
+    uint64_t entries;
+    uint64_t totalBytes;
+    //incremented on every use, the entry with the lowest value is the least recently used
+    uint64_t clock;
+};
+
+/**
+ * An entry of the index, empty when size is 0. Linear probing on the low word of the key.
+ */
+class CacheIndexSlot {
+public:
+    uint64_t keyLow;
+    uint64_t keyHigh;
+    uint64_t size;
+    uint64_t lastUse;
+};
+
+static constexpr size_t CACHE_INDEX_SIZE = sizeof(CacheIndexHeader) + CACHE_INDEX_SLOTS * sizeof(CacheIndexSlot);
+
+/**
+ * Both locks of the index, the mutex of this process first
+ */
+class IndexLock {
+public:
+    IndexLock(std::mutex &mutex, MappedFile &index) : guard(mutex), index(index) {
+        locked = index.lock();
+    }
+
+    ~IndexLock() {
+        if (locked) {
+            index.unlock();
+        }
+    }
+
+    IndexLock(IndexLock const &) = delete;
+
+    IndexLock &operator=(IndexLock const &) = delete;
+
+    std::lock_guard<std::mutex> guard;
+    MappedFile &index;
+    bool locked;
+};
+
+ConvertCache::ConvertCache(std::string directory, uint64_t const maxBytes) : directory(std::move(directory)),
+                                                                             maxBytes(maxBytes) {
+}
+
+ConvertStatus ConvertCache::open() {
+    if (!createDirectory(directory.c_str())) {
+        printError("Error creating cache directory %s\n", directory.c_str());
+        return CONVERT_ERROR_IO;
+    }
+    std::string const indexPath = directory + "/index";
+    if (!index.openShared(indexPath.c_str(), CACHE_INDEX_SIZE)) {
+        printError("Error opening cache index %s\n", indexPath.c_str());
+        return CONVERT_ERROR_IO;
+    }
+
+    IndexLock lock(mutex, index);
+    if (!lock.locked) {
+        return CONVERT_ERROR_IO;
+    }
+    CacheIndexHeader &header = getHeader();
+    if (header.magic != CACHE_INDEX_MAGIC || header.version != CACHE_INDEX_VERSION
+        || header.slotCount != CACHE_INDEX_SLOTS) {
+        //new or incompatible index, the files of the entries it doesn't know would never be evicted
+        removeEntryFiles();
+        std::memset(index.getData(), 0, CACHE_INDEX_SIZE);
+        header.magic = CACHE_INDEX_MAGIC;
+        header.version = CACHE_INDEX_VERSION;
+        header.slotCount = CACHE_INDEX_SLOTS;
+    }
+    return CONVERT_OK;
+}
+
+CacheIndexHeader &ConvertCache::getHeader() const {
+    return *reinterpret_cast<CacheIndexHeader *>(index.getData());
+}
+
+CacheIndexSlot *ConvertCache::getSlots() const {
+    return reinterpret_cast<CacheIndexSlot *>(index.getData() + sizeof(CacheIndexHeader));
+}
+
+std::string ConvertCache::getEntryPath(Hash128 const &key) const {
+    char name[40];
+    std::snprintf(name, sizeof(name), "/%016llx%016llx", static_cast<unsigned long long>(key.high),
+                  static_cast<unsigned long long>(key.low));
+    return directory + name;
+}
+
+/**
+ * True for the name of an entry file, 32 hex digits, and for the temporary files AtomicFile writes it from
+ */
+static bool isEntryFileName(std::string const &name) {
+    size_t const keyLength = 32;
+    if (name.size() < keyLength || !std::all_of(name.begin(), name.begin() + keyLength, [](char const c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+    })) {
+        return false;
+    }
+    return name.size() == keyLength
+           || (name[keyLength] == '.' && name.compare(name.size() - 4, 4, ".tmp") == 0);
+}
+
+void ConvertCache::removeEntryFiles() const {
+    std::vector<std::string> names;
+    if (!listDirectory(directory.c_str(), names)) {
+        return;
+    }
+    //a file still open in another process can't be deleted on Windows, it is replaced when stored again
+    for (std::string const &name: names) {
+        if (isEntryFileName(name)) {
+            removeFile((directory + "/" + name).c_str());
+        }
+    }
+}
+
+CacheIndexSlot *ConvertCache::find(Hash128 const &key) const {
+    //the index is shared with other processes, a corrupt one may have no empty slot left
+    CacheIndexSlot *const slots = getSlots();
+    uint64_t i = key.low % CACHE_INDEX_SLOTS;
+    for (uint64_t probe = 0; probe < CACHE_INDEX_SLOTS; probe++, i = (i + 1) % CACHE_INDEX_SLOTS) {
+        CacheIndexSlot &slot = slots[i];
+        if (slot.size == 0) {
+            return nullptr;
+        }
+        if (slot.keyLow == key.low && slot.keyHigh == key.high) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+void ConvertCache::remove(CacheIndexSlot *const slot) {
+    //the counts of an inconsistent header stop at 0, the next eviction counts them again
+    CacheIndexHeader &header = getHeader();
+    header.entries -= std::min<uint64_t>(header.entries, 1);
+    header.totalBytes -= std::min(header.totalBytes, slot->size);
+
+    //backward shift, the entries after the hole that probed past it move into it
+    CacheIndexSlot *const slots = getSlots();
+    auto hole = static_cast<uint64_t>(slot - slots);
+    uint64_t i = (hole + 1) % CACHE_INDEX_SLOTS;
+    for (uint64_t probe = 1; probe < CACHE_INDEX_SLOTS && slots[i].size != 0;
+         probe++, i = (i + 1) % CACHE_INDEX_SLOTS) {
+        uint64_t const home = slots[i].keyLow % CACHE_INDEX_SLOTS;
+        //distance from home, the entry can move if the hole is between its home and its slot
+        if ((i - home + CACHE_INDEX_SLOTS) % CACHE_INDEX_SLOTS >= (i - hole + CACHE_INDEX_SLOTS) % CACHE_INDEX_SLOTS) {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    slots[hole] = CacheIndexSlot{};
+}
+
+void ConvertCache::evict(uint64_t const bytes, uint64_t const entries) {
+    CacheIndexHeader &header = getHeader();
+    CacheIndexSlot *const slots = getSlots();
+    while (header.entries > 0 && (header.totalBytes > bytes || header.entries > entries)) {
+        CacheIndexSlot *oldest = nullptr;
+        for (uint64_t i = 0; i < CACHE_INDEX_SLOTS; i++) {
+            if (slots[i].size != 0 && (oldest == nullptr || slots[i].lastUse < oldest->lastUse)) {
+                oldest = &slots[i];
+            }
+        }
+        if (oldest == nullptr) {
+            //the header counts entries the slots don't have
+            recount();
+            return;
+        }
+        //a file still mapped by a reader can't be deleted on Windows, it is replaced when stored again
+        removeFile(getEntryPath({oldest->keyLow, oldest->keyHigh}).c_str());
+        remove(oldest);
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ConvertCache::recount() {
+    CacheIndexHeader &header = getHeader();
+    CacheIndexSlot const *const slots = getSlots();
+    header.entries = 0;
+    header.totalBytes = 0;
+    for (uint64_t i = 0; i < CACHE_INDEX_SLOTS; i++) {
+        if (slots[i].size != 0) {
+            header.entries++;
+            header.totalBytes += slots[i].size;
+        }
+    }
+}
+
+bool ConvertCache::read(Hash128 const &key, ContentAllocator const allocator, void *const userData,
+                        ContentBuffer *const output) {
+    uint64_t size = 0;
+    {
+        IndexLock lock(mutex, index);
+        CacheIndexSlot *slot = lock.locked ? find(key) : nullptr;
+        if (slot == nullptr) {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slot->lastUse = ++getHeader().clock;
+        size = slot->size;
+    }
+
+    //the entry may be evicted by another process meanwhile, a mapped file stays readable until unmapped
+    MappedFile entry;
+    if (!entry.openRead(getEntryPath(key).c_str()) || entry.getSize() != size) {
+        IndexLock lock(mutex, index);
+        CacheIndexSlot *slot = lock.locked ? find(key) : nullptr;
+        if (slot != nullptr && slot->size == size) {
+            remove(slot);
+        }
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void *content = allocateContent(allocator, userData, entry.getSize());
+    if (content == nullptr) {
+        return false;
+    }
+    std::memcpy(content, entry.getData(), entry.getSize());
+    output->content = content;
+    output->size = entry.getSize();
+    hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ConvertCache::write(Hash128 const &key, void const *const content, size_t const size) {
+    if (content == nullptr || size == 0 || size > maxBytes) {
+        return;
+    }
+
+    //written and synced to the disk outside the lock, renamed into place under it: a file the index doesn't record
+    //would never be evicted, and an eviction of the same key by another process could delete it after the rename
+    AtomicFile file;
+    if (!file.open(getEntryPath(key).c_str()) || !file.write(content, size) || !file.sync()) {
+        return;
+    }
+
+    IndexLock lock(mutex, index);
+    if (!lock.locked) {
+        return;
+    }
+    CacheIndexHeader &header = getHeader();
+    if (CacheIndexSlot *slot = find(key)) {
+        //stored by another thread or process meanwhile, the bytes are the same
+        slot->lastUse = ++header.clock;
+        return;
+    }
+
+    //room for the new entry first, so it is never the one evicted
+    evict(maxBytes - size, CACHE_MAX_ENTRIES - 1);
+
+    //the slot is found before the rename, the file of an entry the index can't record would never be evicted
+    CacheIndexSlot *const slots = getSlots();
+    uint64_t i = key.low % CACHE_INDEX_SLOTS;
+    for (uint64_t probe = 1; slots[i].size != 0; probe++) {
+        if (probe == CACHE_INDEX_SLOTS) {
+            //every slot is used, only possible when the header counts less entries than the slots
+            recount();
+            return;
+        }
+        i = (i + 1) % CACHE_INDEX_SLOTS;
+    }
+    if (!file.commit()) {
+        return;
+    }
+    slots[i] = {key.low, key.high, size, ++header.clock};
+    header.entries++;
+    header.totalBytes += size;
+    stores.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ConvertCache::getStats(ConvertCacheStats &stats) {
+    stats.hits = hits.load(std::memory_order_relaxed);
+    stats.misses = misses.load(std::memory_order_relaxed);
+    stats.stores = stores.load(std::memory_order_relaxed);
+    stats.evictions = evictions.load(std::memory_order_relaxed);
+    IndexLock lock(mutex, index);
+    stats.entries = getHeader().entries;
+    stats.totalBytes = getHeader().totalBytes;
+}
+
+static std::mutex convertCacheMutex;
+static std::shared_ptr<ConvertCache> convertCache;
+
+std::shared_ptr<ConvertCache> getConvertCache() {
+    std::lock_guard<std::mutex> lock(convertCacheMutex);
+    return convertCache;
+}
+
+/**
+ * Key of a conversion: the hash of the input, the conversion settings, the PNG backend and CONVERT_CACHE_VERSION
+ */
+static Hash128 getCacheKey(void const *const data, size_t const size, uint32_t const *const settings,
+                           size_t const count) {
+    Hash128 const input = hashBytes(data, size);
+#ifdef DXTWRAPPER_USE_LIBSPNG
+    uint32_t const backend = 1;
+#else
+    uint32_t const backend = 2;
+#endif
+    uint32_t key[16] = {static_cast<uint32_t>(input.low), static_cast<uint32_t>(input.low >> 32),
+                        static_cast<uint32_t>(input.high), static_cast<uint32_t>(input.high >> 32),
+                        CONVERT_CACHE_VERSION, backend};
+    std::memcpy(key + 6, settings, std::min<size_t>(count, 10) * sizeof(uint32_t));
+    return hashBytes(key, (6 + std::min<size_t>(count, 10)) * sizeof(uint32_t));
+}
+
+Hash128 getPNGtoDDSCacheKey(void const *const data, size_t const size, bool const dx10ext, bool const bgra) {
+    uint32_t const settings[] = {CACHE_PNG_TO_DDS, dx10ext, bgra};
+    return getCacheKey(data, size, settings, std::size(settings));
+}
+
+Hash128 getPNGtoDDSCacheKey(void const *const data, size_t const size, DDSEncodeOptions const &options) {
+    uint32_t const settings[] = {CACHE_PNG_TO_DDS_COMPRESSED, static_cast<uint32_t>(options.format),
+                                 static_cast<uint32_t>(options.quality), options.dx10ext,
+                                 static_cast<uint32_t>(options.mips.filter), options.mips.srgb,
+                                 options.mips.alphaCoverageReference};
+    return getCacheKey(data, size, settings, std::size(settings));
+}
+
+Hash128 getDDStoPNGCacheKey(void const *const data, size_t const size, PngEncodeOptions const *const options) {
+    PngEncodeOptions const resolved = getPngEncodeOptionsOrDefault(options);
+    uint32_t const settings[] = {CACHE_DDS_TO_PNG, static_cast<uint32_t>(resolved.compressionLevel),
+                                 static_cast<uint32_t>(resolved.compressionStrategy),
+                                 static_cast<uint32_t>(resolved.filterChoice), resolved.detectContent};
+    return getCacheKey(data, size, settings, std::size(settings));
+}
+
+/**
+ * Cache the outputs of the PNG to DDS and DDS to PNG conversions in a directory, shared with other processes using the
+ * same directory. A conversion of an input already converted with the same settings reads the stored output instead.
+ * Covers the *Ex conversions, convertPNGtoDDS, convertDDStoPNG and the batch conversions.
+ *
+ * @param directory The cache directory, UTF-8 encoded, created if its parent exists. nullptr to disable the cache.
+ * @param maxBytes Size limit of the stored outputs, least recently used outputs are deleted above it
+ * @return CONVERT_OK on success, CONVERT_ERROR_IO if the directory or its index can't be opened
+ */
+[[maybe_unused]] ConvertStatus setConvertCache(char const *const directory, uint64_t const maxBytes) {
+    std::shared_ptr<ConvertCache> cache;
+    if (directory != nullptr && directory[0] != '\0') {
+        cache = std::make_shared<ConvertCache>(directory, maxBytes);
+        ConvertStatus const status = cache->open();
+        if (status != CONVERT_OK) {
+            return status;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(convertCacheMutex);
+    convertCache = std::move(cache);
+    return CONVERT_OK;
+}
+
+/**
+ * Read the counters of the cache set with setConvertCache
+ *
+ * @param stats Receives the counters
+ * @return CONVERT_OK on success, CONVERT_ERROR_INVALID_ARGUMENT when no cache is set
+ */
+[[maybe_unused]] ConvertStatus getConvertCacheStats(ConvertCacheStats *const stats) {
+    std::shared_ptr<ConvertCache> const cache = getConvertCache();
+    if (stats == nullptr || !cache) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    cache->getStats(*stats);
+    return CONVERT_OK;
+}
@@ -0,0 +1,134 @@
+#pragma once
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "DxTexWrapper.h"
+#include "FileIO.h"
+#include "Hash.h"
+
+//part of every cache key, increase it whenever a conversion writes different bytes for the same input and settings
+constexpr uint32_t CONVERT_CACHE_VERSION = 1;
+
+/**
+ * Counters of the conversion cache. Hits, misses, stores and evictions are counted by this process since the cache was
+ * set, entries and bytes are those of the shared index.
+ */
+class ConvertCacheStats {
+public:
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t evictions;
+    uint64_t entries;
+    uint64_t totalBytes;
+};
+
+class CacheIndexHeader;
+class CacheIndexSlot;
+
+/**
+ * Content-addressed cache of conversion outputs in a directory shared between processes. Each output is stored in a
+ * file named after its key, written to a temporary file and renamed into place, so readers never see a partial file.
+ * The index is a hash table in a file mapped by every process and modified under a file lock, it records the size and
+ * last use of each entry. Least recently used entries are evicted when a store exceeds the size limit.
+ */
+class ConvertCache {
+public:
+    ConvertCache(std::string directory, uint64_t maxBytes);
+
+    ConvertCache(ConvertCache const &) = delete;
+
+    ConvertCache &operator=(ConvertCache const &) = delete;
+
+    /**
+     * Create the directory and map the index
+     */
+    ConvertStatus open();
+
+    /**
+     * Copy the output stored for 'key' to a buffer obtained from 'allocator'
+     *
+     * @return True on a hit, false when the key isn't stored or the output can't be read
+     */
+    bool read(Hash128 const &key, ContentAllocator allocator, void *userData, ContentBuffer *output);
+
+    /**
+     * Store the output of a conversion, errors are ignored
+     */
+    void write(Hash128 const &key, void const *content, size_t size);
+
+    void getStats(ConvertCacheStats &stats);
+
+private:
+    [[nodiscard]] std::string getEntryPath(Hash128 const &key) const;
+
+    //delete the entry files and the temporary files of unfinished stores, called when the index is reset
+    void removeEntryFiles() const;
+
+    CacheIndexHeader &getHeader() const;
+
+    CacheIndexSlot *getSlots() const;
+
+    //the index functions below are called with the index locked
+    CacheIndexSlot *find(Hash128 const &key) const;
+
+    void remove(CacheIndexSlot *slot);
+
+    //delete least recently used entries until the index is within both limits
+    void evict(uint64_t bytes, uint64_t entries);
+
+    //count the entries and bytes of the header again from the slots
+    void recount();
+
+    std::string directory;
+    uint64_t maxBytes;
+    MappedFile index;
+    //threads of this process, the file lock only excludes other processes
+    std::mutex mutex;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> stores{0};
+    std::atomic<uint64_t> evictions{0};
+};
+
+/**
+ * The cache set with setConvertCache, nullptr when disabled
+ */
+std::shared_ptr<ConvertCache> getConvertCache();
+
+Hash128 getPNGtoDDSCacheKey(void const *data, size_t size, bool dx10ext, bool bgra);
+Hash128 getPNGtoDDSCacheKey(void const *data, size_t size, DDSEncodeOptions const &options);
+Hash128 getDDStoPNGCacheKey(void const *data, size_t size, PngEncodeOptions const *options);
+
+extern "C" {
+[[maybe_unused]] LIBEXPORT ConvertStatus setConvertCache(char const *directory, uint64_t maxBytes);
+[[maybe_unused]] LIBEXPORT ConvertStatus getConvertCacheStats(ConvertCacheStats *stats);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+enum ConvertStatus : int {
+    CONVERT_OK = 0,
+    CONVERT_ERROR_INVALID_ARGUMENT = 1,
+    CONVERT_ERROR_DECODE = 2,
+    CONVERT_ERROR_ENCODE = 3,
+    CONVERT_ERROR_BUFFER_TOO_SMALL = 4,
+    CONVERT_ERROR_OUT_OF_MEMORY = 5,
+    CONVERT_ERROR_IO = 6,
+    CONVERT_ERROR_QUEUE_FULL = 7,
+    CONVERT_PENDING = 8,
+    CONVERT_CANCELLED = 9,
+};
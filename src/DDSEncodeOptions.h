@@ -0,0 +1,75 @@
+#pragma once
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <DirectXTex.h>
+
+//speed and quality tradeoff of the BC encoder
+enum BCQuality : int {
+    //principal axis endpoints, no refinement
+    BC_QUALITY_FAST = 0,
+    //endpoints refined by least squares, every p-bit combination of BC7 tried
+    BC_QUALITY_NORMAL = 1,
+    //endpoints refined by a neighborhood search, BC1 3-color mode and BC7 2-subset partitions tried
+    BC_QUALITY_HIGH = 2,
+};
+
+//filter of the generated mip levels
+enum MipFilter : int {
+    //2x2 average, the last row and column of odd sized levels also cover the odd row and column of the level above
+    MIP_FILTER_BOX = 0,
+    //tent filter, 4 taps per axis when halving
+    MIP_FILTER_TRIANGLE = 1,
+    //Kaiser windowed sinc, 12 taps per axis when halving. Sharpest, may ring on hard edges.
+    MIP_FILTER_KAISER = 2,
+};
+
+/**
+ * Mip level generation, zero-initialized it is the box filter used by every PNG to DDS conversion
+ */
+class MipOptions {
+public:
+    MipFilter filter;
+    //filter the color channels in linear light, for sRGB content. Implied by the sRGB formats.
+    bool srgb;
+    //alpha test reference, when nonzero the alpha of every level is scaled to keep the fraction of pixels with alpha
+    //greater or equal to the reference of the first level
+    unsigned char alphaCoverageReference;
+};
+
+/**
+ * Output format of the PNG to DDS conversion
+ */
+class DDSEncodeOptions {
+public:
+    //DXGI_FORMAT_R8G8B8A8_UNORM or B8G8R8A8_UNORM for uncompressed textures, or one of the BC1, BC3, BC4, BC5 and BC7
+    //formats, UNORM or UNORM_SRGB. BC4 stores the red channel, BC5 red and green.
+    DXGI_FORMAT format;
+    BCQuality quality;
+    //write the DX10 header extension, always used for BC7
+    bool dx10ext;
+    MipOptions mips;
+};
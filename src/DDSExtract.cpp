@@ -0,0 +1,354 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "BCDecoder.h"
+#include "DDSExtract.h"
+#include "DDSHeader.h"
+#include "ScratchArena.h"
+#include "Stats.h"
+#include "Swizzle.h"
+#include "ThreadPool.h"
+
+/**
+ * Formats read straight from the DDS buffer, the others are loaded with DirectXTex
+ */
+static bool isDirectFormat(DXGI_FORMAT const format) {
+    switch (format) {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            return true;
+        default:
+            return isBCFormat(format);
+    }
+}
+
+/**
+ * Read one image from the DDS buffer as 8-bit RGBA. Only its blocks are decoded, RGBA images are not copied at all
+ * unless their alpha must be forced opaque.
+ */
+static ConvertStatus readDirectImage(unsigned char const *const data, size_t const size, DDSInfo const &info,
+                                     DDSSubresource const &subresource, DirectX::ScratchImage &storage,
+                                     DirectX::Image &image, StatsScope &scope) {
+    DDSImageLocation location;
+    if (!getDDSImageLocation(info, subresource.mip, subresource.item, subresource.slice, location)) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    if (location.offset > size || location.size > size - location.offset) {
+        printError("Error reading DDS image, truncated data\n");
+        return CONVERT_ERROR_DECODE;
+    }
+    unsigned char const *pixels = data + location.offset;
+    scope.setBytesIn(location.size);
+
+    bool const rgba = info.format == DXGI_FORMAT_R8G8B8A8_UNORM || info.format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    if (rgba && !info.noAlpha) {
+        //the image is only read by the PNG encoder
+        image = {};
+        image.width = location.width;
+        image.height = location.height;
+        image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        image.rowPitch = location.rowPitch;
+        image.slicePitch = location.size;
+        image.pixels = const_cast<uint8_t *>(pixels);
+        return CONVERT_OK;
+    }
+
+    ScratchArena &arena = getScratchArena();
+    if (arena.isActive()) {
+        //released with the conversion
+        image = {};
+        image.width = location.width;
+        image.height = location.height;
+        image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        image.rowPitch = location.width * 4;
+        image.slicePitch = image.rowPitch * location.height;
+        bool const overflow = location.width > SIZE_MAX / 4 / location.height;
+        image.pixels = overflow ? nullptr : static_cast<uint8_t *>(arena.allocate(image.slicePitch));
+        if (image.pixels == nullptr) {
+            printError("Error allocating image\n");
+            return CONVERT_ERROR_OUT_OF_MEMORY;
+        }
+    } else {
+        HRESULT hr = storage.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, location.width, location.height, 1, 1);
+        if (FAILED(hr)) {
+            printError("Error allocating image: ");
+            printErrorDescription(hr);
+            return CONVERT_ERROR_OUT_OF_MEMORY;
+        }
+        StatsScope::countAllocation(storage.GetPixelsSize());
+        image = *storage.GetImage(0, 0, 0);
+    }
+
+    if (isBCFormat(info.format)) {
+        ConvertStatus status = decodeBC(info.format, pixels, location.size, location.width, location.height,
+                                        image.pixels);
+        if (status == CONVERT_ERROR_OUT_OF_MEMORY) {
+            printError("Error allocating BC decode buffers\n");
+        } else if (status != CONVERT_OK) {
+            printError("Error decoding BC texture, truncated data\n");
+        }
+        return status;
+    }
+
+    //RGBA, BGRA and BGRX have the same pitch as the output
+    std::memcpy(image.pixels, pixels, image.slicePitch);
+    if (!rgba) {
+        swizzleRGBAtoBGRA(image.pixels, image.slicePitch);
+    }
+    if (info.noAlpha || info.format == DXGI_FORMAT_B8G8R8X8_UNORM || info.format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB) {
+        for (size_t i = 3; i < image.slicePitch; i += 4) {
+            image.pixels[i] = 0xff;
+        }
+    }
+    return CONVERT_OK;
+}
+
+static ConvertStatus loadDirectImage(unsigned char const *const data, size_t const size, DDSInfo const &info,
+                                     DDSSubresource const &subresource, DirectX::ScratchImage &storage,
+                                     DirectX::Image &image) {
+    StatsScope scope(STATS_STAGE_DDS_LOAD, 0);
+    ConvertStatus const status = readDirectImage(data, size, info, subresource, storage, image, scope);
+    return scope.finish(status, status == CONVERT_OK ? image.slicePitch : 0);
+}
+
+/**
+ * Select one image of a texture loaded by DirectXTex, converted to 8-bit RGBA when needed
+ */
+static ConvertStatus selectLoadedImage(DirectX::ScratchImage const &texture, DDSSubresource const &subresource,
+                                       DirectX::ScratchImage &storage, DirectX::Image &image) {
+    DirectX::Image const *selected = texture.GetImage(subresource.mip, subresource.item, subresource.slice);
+    if (selected == nullptr) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    if (selected->format == DXGI_FORMAT_R8G8B8A8_UNORM || selected->format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB) {
+        image = *selected;
+        return CONVERT_OK;
+    }
+
+    try {
+        HRESULT hr = DirectX::Convert(*selected, DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::TEX_FILTER_DEFAULT,
+                                      DirectX::TEX_THRESHOLD_DEFAULT, storage);
+        if (FAILED(hr)) {
+            printError("Error converting image: ");
+            printErrorDescription(hr);
+            return CONVERT_ERROR_DECODE;
+        }
+    } catch (...) {
+        printError("Error converting image\n");
+        return CONVERT_ERROR_DECODE;
+    }
+    image = *storage.GetImage(0, 0, 0);
+    return CONVERT_OK;
+}
+
+/**
+ * Load one image of a DDS texture as 8-bit RGBA. BC and 8-bit RGBA/BGRA images are read straight from 'data', other
+ * formats load the whole texture with DirectXTex.
+ *
+ * @param data The DDS texture
+ * @param size The size(in bytes) of data
+ * @param subresource The image
+ * @param storage Holds the pixels of 'image' when they are not in 'data'
+ * @param image Receives the image, may point inside 'data' and must only be read
+ * @return CONVERT_OK on success, CONVERT_ERROR_INVALID_ARGUMENT if the texture has no such image
+ */
+ConvertStatus loadDDSImage(void const *const data, size_t const size, DDSSubresource const &subresource,
+                           DirectX::ScratchImage &storage, DirectX::Image &image) {
+    DDSInfo info{};
+    if (parseDDSHeader(data, size, info) && isDirectFormat(info.format)) {
+        return loadDirectImage(static_cast<unsigned char const *>(data), size, info, subresource, storage, image);
+    }
+
+    DirectX::ScratchImage texture{};
+    ConvertStatus status = loadDDS(data, size, texture);
+    if (status != CONVERT_OK) {
+        return status;
+    }
+    status = selectLoadedImage(texture, subresource, storage, image);
+    if (status == CONVERT_OK && image.pixels != storage.GetPixels()) {
+        //the image belongs to the texture, which is released on return
+        storage = std::move(texture);
+    }
+    return status;
+}
+
+static ConvertStatus encodeImage(DirectX::Image const &image, PngEncodeOptions const *const options,
+                                 ContentAllocator const allocator, void *const userData, ContentBuffer &output) {
+    PngOutput png{};
+    png.allocator = allocator;
+    png.userData = userData;
+    ConvertStatus status = encodePng(image, resolvePngEncodeOptions(options, image), png);
+    if (status != CONVERT_OK) {
+        return status;
+    }
+
+    output.size = png.size;
+    output.content = png.content;
+    return CONVERT_OK;
+}
+
+/**
+ * Convert some images of a DDS texture to PNG. Only the requested images are decoded, BC blocks and RGBA pixels are
+ * read straight from 'data' (which can be a memory-mapped file). The images are converted in parallel on the shared
+ * work-stealing pool.
+ *
+ * @param data The DDS texture
+ * @param size The size(in bytes) of data
+ * @param subresources The images to convert
+ * @param count Number of images
+ * @param options PNG encoder settings, nullptr for PNG_PROFILE_BALANCED without content detection. Fields out of
+ *            range return CONVERT_ERROR_INVALID_ARGUMENT.
+ * @param allocator Allocator for the output buffers, when nullptr the buffers are allocated with malloc and must be
+ *            released with freeContentBuffer
+ * @param userData Passed unmodified to 'allocator', which must be thread-safe
+ * @param outputs Receives size and pointer of each PNG, empty when the conversion of the image failed
+ * @param statuses Receives the status of each image, CONVERT_ERROR_INVALID_ARGUMENT when the texture has no such image
+ * @return CONVERT_OK when every image was converted, otherwise the status of the first failure
+ */
+[[maybe_unused]] ConvertStatus convertDDSSubresourcesToPNG(void const *const data, size_t const size,
+                                                           DDSSubresource const *const subresources,
+                                                           size_t const count, PngEncodeOptions const *const options,
+                                                           ContentAllocator const allocator, void *const userData,
+                                                           ContentBuffer *const outputs,
+                                                           ConvertStatus *const statuses) {
+    if (data == nullptr || (count > 0 && (subresources == nullptr || outputs == nullptr || statuses == nullptr))
+        || !isValidPngEncodeOptions(options)) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    for (size_t i = 0; i < count; i++) {
+        outputs[i].size = 0;
+        outputs[i].content = nullptr;
+    }
+
+    //formats DirectXTex has to load are loaded once for every image
+    DDSInfo info{};
+    bool const direct = parseDDSHeader(data, size, info) && isDirectFormat(info.format);
+    DirectX::ScratchImage texture{};
+    if (!direct && count > 0) {
+        ConvertStatus status = loadDDS(data, size, texture);
+        if (status != CONVERT_OK) {
+            std::fill(statuses, statuses + count, status);
+            return status;
+        }
+    }
+
+    auto const convertImage = [&](size_t const i, [[maybe_unused]] size_t const worker) {
+        ArenaScope arena;
+        StatsScope scope(STATS_STAGE_DDS_TO_PNG, 0);
+        DirectX::ScratchImage storage{};
+        DirectX::Image image{};
+        statuses[i] = direct ? loadDirectImage(static_cast<unsigned char const *>(data), size, info, subresources[i],
+                                               storage, image)
+                             : selectLoadedImage(texture, subresources[i], storage, image);
+        if (statuses[i] == CONVERT_OK) {
+            statuses[i] = encodeImage(image, options, allocator, userData, outputs[i]);
+        }
+        scope.finish(statuses[i], outputs[i].size);
+    };
+
+    if (count == 1) {
+        convertImage(0, 0);
+    } else {
+        getThreadPool()->parallelFor(count, convertImage);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (statuses[i] != CONVERT_OK) {
+            return statuses[i];
+        }
+    }
+    return CONVERT_OK;
+}
+
+/**
+ * Find the smallest mip level with its longer side at least 'minSize' pixels, for thumbnails. Only the headers are
+ * read.
+ *
+ * @param data The DDS texture
+ * @param size The size(in bytes) of data
+ * @param minSize Minimum width or height of the level
+ * @param mip Receives the level, 0 when the first level is smaller than 'minSize'
+ * @return CONVERT_OK on success, CONVERT_ERROR_DECODE when the headers are invalid
+ */
+[[maybe_unused]] ConvertStatus findDDSThumbnailMip(void const *const data, size_t const size, uint32_t const minSize,
+                                                   uint32_t *const mip) {
+    if (data == nullptr || mip == nullptr) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    DDSInfo info{};
+    if (!parseDDSHeader(data, size, info)) {
+        return CONVERT_ERROR_DECODE;
+    }
+
+    uint32_t level = 0;
+    while (level + 1 < info.mipLevels && level + 1 < sizeof(size_t) * 8
+           && std::max(info.width >> (level + 1), info.height >> (level + 1)) >= minSize) {
+        level++;
+    }
+    *mip = level;
+    return CONVERT_OK;
+}
+
+/**
+ * Convert the first item of the smallest mip level with its longer side at least 'minSize' pixels to PNG. Only that
+ * level is decoded, a thumbnail of a large texture costs a fraction of convertDDStoPNGEx.
+ *
+ * @param data The DDS texture
+ * @param size The size(in bytes) of data
+ * @param minSize Minimum width or height of the thumbnail
+ * @param options PNG encoder settings, nullptr for PNG_PROFILE_BALANCED without content detection. Fields out of
+ *            range return CONVERT_ERROR_INVALID_ARGUMENT.
+ * @param allocator Allocator for the output buffer, when nullptr the buffer is allocated with malloc and must be released
+ *            with freeContentBuffer
+ * @param userData Passed unmodified to 'allocator'
+ * @param output Receives size and pointer to the PNG image
+ * @return CONVERT_OK on success
+ */
+[[maybe_unused]] ConvertStatus convertDDSThumbnailToPNG(void const *const data, size_t const size,
+                                                        uint32_t const minSize, PngEncodeOptions const *const options,
+                                                        ContentAllocator const allocator, void *const userData,
+                                                        ContentBuffer *const output) {
+    if (output == nullptr) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    output->size = 0;
+    output->content = nullptr;
+
+    DDSSubresource subresource{0, 0, 0};
+    ConvertStatus status = findDDSThumbnailMip(data, size, minSize, &subresource.mip);
+    if (status != CONVERT_OK) {
+        return status;
+    }
+    ConvertStatus imageStatus = CONVERT_OK;
+    return convertDDSSubresourcesToPNG(data, size, &subresource, 1, options, allocator, userData, output,
+                                       &imageStatus);
+}
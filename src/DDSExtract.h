@@ -0,0 +1,59 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstdint>
+#include "DxTexWrapper.h"
+
+/**
+ * An image of a DDS texture, same indices as DirectX::ScratchImage::GetImage
+ */
+class DDSSubresource {
+public:
+    uint32_t mip;
+    //array item, the faces of a cubemap are items: 6 * cube + face
+    uint32_t item;
+    //depth slice of a volume texture, 0 otherwise
+    uint32_t slice;
+};
+
+ConvertStatus loadDDSImage(void const *data, size_t size, DDSSubresource const &subresource,
+                           DirectX::ScratchImage &storage, DirectX::Image &image);
+
+extern "C" {
+[[maybe_unused]] LIBEXPORT ConvertStatus convertDDSSubresourcesToPNG(void const *data, size_t size,
+                                                                     DDSSubresource const *subresources, size_t count,
+                                                                     PngEncodeOptions const *options,
+                                                                     ContentAllocator allocator, void *userData,
+                                                                     ContentBuffer *outputs, ConvertStatus *statuses);
+[[maybe_unused]] LIBEXPORT ConvertStatus findDDSThumbnailMip(void const *data, size_t size, uint32_t minSize,
+                                                             uint32_t *mip);
+[[maybe_unused]] LIBEXPORT ConvertStatus convertDDSThumbnailToPNG(void const *data, size_t size, uint32_t minSize,
+                                                                  PngEncodeOptions const *options,
+                                                                  ContentAllocator allocator, void *userData,
+                                                                  ContentBuffer *output);
+}
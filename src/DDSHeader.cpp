@@ -0,0 +1,321 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "DDSHeader.h"
+
+using DirectX::DDS_HEADER;
+using DirectX::DDS_HEADER_DXT10;
+using DirectX::DDS_PIXELFORMAT;
+
+static bool isBitMask(DDS_PIXELFORMAT const &pixelFormat, uint32_t const r, uint32_t const g, uint32_t const b,
+                      uint32_t const a) {
+    return pixelFormat.RBitMask == r && pixelFormat.GBitMask == g && pixelFormat.BBitMask == b
+           && pixelFormat.ABitMask == a;
+}
+
+DXGI_FORMAT getLegacyDDSFormat(DDS_PIXELFORMAT const &pixelFormat, bool &noAlpha) {
+    noAlpha = false;
+    if (pixelFormat.flags & DDS_FOURCC) {
+        switch (pixelFormat.fourCC) {
+            case MAKEFOURCC('D', 'X', 'T', '1'):
+                return DXGI_FORMAT_BC1_UNORM;
+            case MAKEFOURCC('D', 'X', 'T', '2'):
+            case MAKEFOURCC('D', 'X', 'T', '3'):
+                return DXGI_FORMAT_BC2_UNORM;
+            case MAKEFOURCC('D', 'X', 'T', '4'):
+            case MAKEFOURCC('D', 'X', 'T', '5'):
+                return DXGI_FORMAT_BC3_UNORM;
+            case MAKEFOURCC('A', 'T', 'I', '1'):
+            case MAKEFOURCC('B', 'C', '4', 'U'):
+                return DXGI_FORMAT_BC4_UNORM;
+            case MAKEFOURCC('B', 'C', '4', 'S'):
+                return DXGI_FORMAT_BC4_SNORM;
+            case MAKEFOURCC('A', 'T', 'I', '2'):
+            case MAKEFOURCC('B', 'C', '5', 'U'):
+                return DXGI_FORMAT_BC5_UNORM;
+            case MAKEFOURCC('B', 'C', '5', 'S'):
+                return DXGI_FORMAT_BC5_SNORM;
+            case MAKEFOURCC('R', 'G', 'B', 'G'):
+                return DXGI_FORMAT_R8G8_B8G8_UNORM;
+            case MAKEFOURCC('G', 'R', 'G', 'B'):
+                return DXGI_FORMAT_G8R8_G8B8_UNORM;
+            case MAKEFOURCC('Y', 'U', 'Y', '2'):
+                return DXGI_FORMAT_YUY2;
+            //D3DFORMAT values stored as fourCC
+            case 36:
+                return DXGI_FORMAT_R16G16B16A16_UNORM;
+            case 110:
+                return DXGI_FORMAT_R16G16B16A16_SNORM;
+            case 111:
+                return DXGI_FORMAT_R16_FLOAT;
+            case 112:
+                return DXGI_FORMAT_R16G16_FLOAT;
+            case 113:
+                return DXGI_FORMAT_R16G16B16A16_FLOAT;
+            case 114:
+                return DXGI_FORMAT_R32_FLOAT;
+            case 115:
+                return DXGI_FORMAT_R32G32_FLOAT;
+            case 116:
+                return DXGI_FORMAT_R32G32B32A32_FLOAT;
+            default:
+                return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    if (pixelFormat.flags & DDS_RGB) {
+        switch (pixelFormat.RGBBitCount) {
+            case 32:
+                if (isBitMask(pixelFormat, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000)) {
+                    return DXGI_FORMAT_R8G8B8A8_UNORM;
+                }
+                //X8B8G8R8 has no DXGI equivalent, DirectXTex loads it as RGBA with the X byte set opaque
+                if (isBitMask(pixelFormat, 0x000000ff, 0x0000ff00, 0x00ff0000, 0)) {
+                    noAlpha = true;
+                    return DXGI_FORMAT_R8G8B8A8_UNORM;
+                }
+                if (isBitMask(pixelFormat, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000)) {
+                    return DXGI_FORMAT_B8G8R8A8_UNORM;
+                }
+                if (isBitMask(pixelFormat, 0x00ff0000, 0x0000ff00, 0x000000ff, 0)) {
+                    return DXGI_FORMAT_B8G8R8X8_UNORM;
+                }
+                //D3DX writes 10:10:10:2 with the masks reversed
+                if (isBitMask(pixelFormat, 0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000)
+                    || isBitMask(pixelFormat, 0x000003ff, 0x000ffc00, 0x3ff00000, 0xc0000000)) {
+                    return DXGI_FORMAT_R10G10B10A2_UNORM;
+                }
+                if (isBitMask(pixelFormat, 0x0000ffff, 0xffff0000, 0, 0)) {
+                    return DXGI_FORMAT_R16G16_UNORM;
+                }
+                if (isBitMask(pixelFormat, 0xffffffff, 0, 0, 0)) {
+                    return DXGI_FORMAT_R32_FLOAT;
+                }
+                break;
+            case 16:
+                if (isBitMask(pixelFormat, 0x7c00, 0x03e0, 0x001f, 0x8000)) {
+                    return DXGI_FORMAT_B5G5R5A1_UNORM;
+                }
+                if (isBitMask(pixelFormat, 0xf800, 0x07e0, 0x001f, 0)) {
+                    return DXGI_FORMAT_B5G6R5_UNORM;
+                }
+                if (isBitMask(pixelFormat, 0x0f00, 0x00f0, 0x000f, 0xf000)) {
+                    return DXGI_FORMAT_B4G4R4A4_UNORM;
+                }
+                if (isBitMask(pixelFormat, 0x00ff, 0, 0, 0xff00)) {
+                    return DXGI_FORMAT_R8G8_UNORM;
+                }
+                if (isBitMask(pixelFormat, 0xffff, 0, 0, 0)) {
+                    return DXGI_FORMAT_R16_UNORM;
+                }
+                break;
+            case 8:
+                if (isBitMask(pixelFormat, 0xff, 0, 0, 0)) {
+                    return DXGI_FORMAT_R8_UNORM;
+                }
+                break;
+            default:
+                break;
+        }
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    if (pixelFormat.flags & DDS_LUMINANCE) {
+        if (pixelFormat.RGBBitCount == 8 && isBitMask(pixelFormat, 0xff, 0, 0, 0)) {
+            return DXGI_FORMAT_R8_UNORM;
+        }
+        if (pixelFormat.RGBBitCount == 16 && isBitMask(pixelFormat, 0xffff, 0, 0, 0)) {
+            return DXGI_FORMAT_R16_UNORM;
+        }
+        if ((pixelFormat.RGBBitCount == 16 || pixelFormat.RGBBitCount == 8)
+            && isBitMask(pixelFormat, 0x00ff, 0, 0, 0xff00)) {
+            return DXGI_FORMAT_R8G8_UNORM;
+        }
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    if (pixelFormat.flags & DDS_ALPHA) {
+        return pixelFormat.RGBBitCount == 8 ? DXGI_FORMAT_A8_UNORM : DXGI_FORMAT_UNKNOWN;
+    }
+
+    if (pixelFormat.flags & DDS_BUMPDUDV) {
+        if (pixelFormat.RGBBitCount == 16 && isBitMask(pixelFormat, 0x00ff, 0xff00, 0, 0)) {
+            return DXGI_FORMAT_R8G8_SNORM;
+        }
+        if (pixelFormat.RGBBitCount == 32 && isBitMask(pixelFormat, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000)) {
+            return DXGI_FORMAT_R8G8B8A8_SNORM;
+        }
+        if (pixelFormat.RGBBitCount == 32 && isBitMask(pixelFormat, 0x0000ffff, 0xffff0000, 0, 0)) {
+            return DXGI_FORMAT_R16G16_SNORM;
+        }
+    }
+
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+/**
+ * Levels of a full mip chain down to 1x1x1, floor(log2(largest)) + 1
+ */
+static size_t getMaxMipLevels(size_t largest) {
+    size_t levels = 0;
+    for (; largest > 0; largest >>= 1) {
+        levels++;
+    }
+    return levels;
+}
+
+bool parseDDSHeader(void const *const data, size_t const size, DDSInfo &info) {
+    auto const *bytes = static_cast<unsigned char const *>(data);
+    if (data == nullptr || size < sizeof(uint32_t) + sizeof(DDS_HEADER)) {
+        return false;
+    }
+
+    uint32_t magic;
+    std::memcpy(&magic, bytes, sizeof(magic));
+    DDS_HEADER header{};
+    std::memcpy(&header, bytes + sizeof(uint32_t), sizeof(header));
+    if (magic != DirectX::DDS_MAGIC || header.size != sizeof(DDS_HEADER)
+        || header.ddspf.size != sizeof(DDS_PIXELFORMAT)) {
+        return false;
+    }
+
+    info = DDSInfo{};
+    info.width = header.width;
+    info.height = header.height;
+    info.mipLevels = header.mipMapCount == 0 ? 1 : header.mipMapCount;
+    info.dataOffset = sizeof(uint32_t) + sizeof(DDS_HEADER);
+
+    if ((header.ddspf.flags & DDS_FOURCC) && header.ddspf.fourCC == MAKEFOURCC('D', 'X', '1', '0')) {
+        if (size < info.dataOffset + sizeof(DDS_HEADER_DXT10)) {
+            return false;
+        }
+        DDS_HEADER_DXT10 extension{};
+        std::memcpy(&extension, bytes + info.dataOffset, sizeof(extension));
+        info.dataOffset += sizeof(DDS_HEADER_DXT10);
+        info.dx10ext = true;
+        info.format = extension.dxgiFormat;
+        info.arraySize = extension.arraySize;
+        if (info.arraySize == 0) {
+            return false;
+        }
+
+        switch (extension.resourceDimension) {
+            case DirectX::DDS_DIMENSION_TEXTURE1D:
+                info.height = 1;
+                break;
+            case DirectX::DDS_DIMENSION_TEXTURE2D:
+                if (extension.miscFlag & DirectX::DDS_RESOURCE_MISC_TEXTURECUBE) {
+                    info.cubemap = true;
+                    info.arraySize *= 6;
+                }
+                break;
+            case DirectX::DDS_DIMENSION_TEXTURE3D:
+                if (!(header.flags & DDS_HEADER_FLAGS_VOLUME) || info.arraySize > 1) {
+                    return false;
+                }
+                info.volume = true;
+                info.depth = header.depth;
+                break;
+            default:
+                return false;
+        }
+    } else {
+        info.format = getLegacyDDSFormat(header.ddspf, info.noAlpha);
+        if (header.flags & DDS_HEADER_FLAGS_VOLUME) {
+            info.volume = true;
+            info.depth = header.depth;
+        } else if (header.caps2 & DDS_CUBEMAP) {
+            //partial cubemaps are not supported
+            if ((header.caps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES) {
+                return false;
+            }
+            info.cubemap = true;
+            info.arraySize = 6;
+        }
+    }
+
+    if (info.width == 0 || info.height == 0 || info.depth == 0) {
+        return false;
+    }
+    //levels past 1x1x1 have no pixels, DirectXTex rejects such headers too
+    return info.mipLevels <= getMaxMipLevels(std::max({info.width, info.height, info.depth}));
+}
+
+/**
+ * Size of the images of a mip level: one image, or every depth slice of a volume
+ */
+static bool getMipLevelSize(DDSInfo const &info, size_t const mip, size_t &size, size_t &slicePitch,
+                            DDSImageLocation *const location) {
+    size_t const width = std::max<size_t>(info.width >> mip, 1);
+    size_t const height = std::max<size_t>(info.height >> mip, 1);
+    size_t const depth = info.volume ? std::max<size_t>(info.depth >> mip, 1) : 1;
+    size_t rowPitch = 0;
+    if (FAILED(DirectX::ComputePitch(info.format, width, height, rowPitch, slicePitch, DirectX::CP_FLAGS_NONE))
+        || slicePitch == 0 || slicePitch > SIZE_MAX / depth) {
+        return false;
+    }
+    size = slicePitch * depth;
+    if (location != nullptr) {
+        location->width = width;
+        location->height = height;
+        location->rowPitch = rowPitch;
+    }
+    return true;
+}
+
+bool getDDSImageLocation(DDSInfo const &info, size_t const mip, size_t const item, size_t const slice,
+                         DDSImageLocation &location) {
+    if (mip >= info.mipLevels || item >= info.arraySize || mip >= sizeof(size_t) * 8
+        || slice >= (info.volume ? std::max<size_t>(info.depth >> mip, 1) : 1)) {
+        return false;
+    }
+
+    //offset of the level inside an item, and size of a whole item
+    size_t levelOffset = 0;
+    size_t itemSize = 0;
+    for (size_t level = 0; level < info.mipLevels && level < sizeof(size_t) * 8; level++) {
+        size_t size = 0;
+        size_t slicePitch = 0;
+        if (!getMipLevelSize(info, level, size, slicePitch, level == mip ? &location : nullptr)
+            || size > SIZE_MAX - itemSize) {
+            return false;
+        }
+        if (level == mip) {
+            levelOffset = itemSize + slice * slicePitch;
+            location.size = slicePitch;
+        }
+        itemSize += size;
+    }
+
+    if (itemSize > (SIZE_MAX - info.dataOffset) / info.arraySize) {
+        return false;
+    }
+    location.offset = info.dataOffset + item * itemSize + levelOffset;
+    return true;
+}
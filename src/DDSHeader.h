@@ -0,0 +1,90 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+#include <DirectXTex.h>
+#include <DDS.h>
+
+/**
+ * Layout of a DDS file, read from DDS_HEADER and DDS_HEADER_DXT10 without touching the pixel data
+ */
+class DDSInfo {
+public:
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    size_t width = 0;
+    size_t height = 0;
+    size_t depth = 1;
+    size_t mipLevels = 1;
+    //number of 2D images per mip level, 6 per cube for cubemaps like TexMetadata
+    size_t arraySize = 1;
+    bool cubemap = false;
+    bool volume = false;
+    bool dx10ext = false;
+    //legacy format without alpha mapped to a format with alpha, the alpha bytes are undefined and read as opaque
+    bool noAlpha = false;
+    //offset of the first image
+    size_t dataOffset = 0;
+};
+
+/**
+ * Position of one image inside a DDS file
+ */
+class DDSImageLocation {
+public:
+    //from the start of the file
+    size_t offset = 0;
+    size_t size = 0;
+    size_t width = 0;
+    size_t height = 0;
+    size_t rowPitch = 0;
+};
+
+/**
+ * Parse the DDS headers
+ *
+ * @param data The DDS, only the first 148 bytes are read
+ * @param size The size(in bytes) of data
+ * @param info Receives the layout
+ * @return False if the headers are invalid, or the mip count is larger than the full chain of the texture
+ */
+bool parseDDSHeader(void const *data, size_t size, DDSInfo &info);
+
+/**
+ * DXGI format of a legacy (DirectX 9) DDS pixel format, DXGI_FORMAT_UNKNOWN when there is no equivalent
+ *
+ * @param noAlpha Set when the returned format has an alpha channel the pixel format does not, like X8B8G8R8
+ */
+DXGI_FORMAT getLegacyDDSFormat(DirectX::DDS_PIXELFORMAT const &pixelFormat, bool &noAlpha);
+
+/**
+ * Locate an image, same indices as DirectX::ScratchImage::GetImage. Each array item stores its mip chain, in a volume
+ * each mip level stores its depth slices. The size of the data is not checked.
+ *
+ * @return False if the indices are out of range or the format has no known pitch
+ */
+bool getDDSImageLocation(DDSInfo const &info, size_t mip, size_t item, size_t slice, DDSImageLocation &location);
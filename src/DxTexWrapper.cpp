@@ -28,16 +28,30 @@
     SOFTWARE.
  */
 
+#include <algorithm>
+#include <climits>
+#include <cstdarg>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <DirectXTex.h>
+#include "BCEncoder.h"
+#include "ConvertCache.h"
+#include "DDSExtract.h"
 #include "DxTexWrapper.h"
 #include "ImageData.h"
+#include "MipGenerator.h"
+#include "PngDecoder.h"
+#include "ScratchArena.h"
+#include "Stats.h"
+#include "StreamingDDS.h"
+#include "Swizzle.h"
 
 #ifdef DXTWRAPPER_USE_LIBSPNG
 #pragma message("building with SPNG")
 
 #include <spng.h>
+#include "ParallelPngEncoder.h"
 
 #else
 #ifdef DXTWRAPPER_USE_LIBLODEPNG
@@ -57,88 +71,625 @@
  * @return Returns the 'Data' containing size and a pointer to DDS texture
  */
 [[maybe_unused]] Content convertPNGtoDDS(unsigned int const pngSize, void *const pngData, bool const dx10ext, bool const bgra) {
-    std::vector<unsigned char> data(pngSize);
-    std::memcpy(data.data(), pngData, pngSize);
     Content ret{};
+    ContentBuffer output{};
 
-    ImageData imageData = decodePng(data);
+    if (convertPNGtoDDSEx(pngData, pngSize, dx10ext, bgra, nullptr, nullptr, &output) != CONVERT_OK) {
+        return ret;
+    }
+    if (output.size > UINT_MAX) {
+        printError("DDS texture exceeds 4GB, use convertPNGtoDDSEx\n");
+        std::free(output.content);
+        return ret;
+    }
+
+    ret.size = static_cast<unsigned int>(output.size);
+    ret.content = output.content;
+    return ret;
+}
+
+/**
+ * Convert a DDS texture to PNG image
+ * @param size The size(in bytes) of data parameter
+ * @param data The DDS texture
+ * @return Returns the 'Data' containing size and a pointer to PNG
+ */
+[[maybe_unused]] Content convertDDStoPNG(unsigned int const size, void *const data) {
+    Content ret{};
+    ret.size = 0;
+    ContentBuffer output{};
+
+    if (convertDDStoPNGEx(data, size, nullptr, nullptr, nullptr, &output) != CONVERT_OK) {
+        return ret;
+    }
+    if (output.size > UINT_MAX) {
+        printError("PNG image exceeds 4GB, use convertDDStoPNGEx\n");
+        std::free(output.content);
+        return ret;
+    }
+
+    ret.size = static_cast<unsigned int>(output.size);
+    ret.content = output.content;
+    return ret;
+}
+
+/**
+ * Convert PNG image to a DDS texture, the input is borrowed and the DDS is written once to a buffer obtained from 'allocator'.
+ *
+ * @param data The PNG image
+ * @param size The size(in bytes) of data parameter
+ * @param dx10ext Same as convertPNGtoDDS
+ * @param bgra Same as convertPNGtoDDS
+ * @param allocator Allocator for the output buffer, when nullptr the buffer is allocated with malloc and must be released
+ *            with freeContentBuffer
+ * @param userData Passed unmodified to 'allocator'
+ * @param output Receives size and pointer to the DDS texture
+ * @return CONVERT_OK on success
+ */
+[[maybe_unused]] ConvertStatus convertPNGtoDDSEx(void const *const data, size_t const size, bool const dx10ext,
+                                                 bool const bgra, ContentAllocator const allocator,
+                                                 void *const userData, ContentBuffer *const output) {
+    return convertPNGtoDDSWithScratch(data, size, dx10ext, bgra, allocator, userData, output,
+                                      getScratchArena().getImageData());
+}
+
+/**
+ * Same as convertPNGtoDDSEx, decoding into 'imageData' so its buffer can be reused between conversions
+ */
+ConvertStatus convertPNGtoDDSWithScratch(void const *const data, size_t const size, bool const dx10ext,
+                                         bool const bgra, ContentAllocator const allocator, void *const userData,
+                                         ContentBuffer *const output, ImageData &imageData) {
+    if (data == nullptr || output == nullptr) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    output->size = 0;
+    output->content = nullptr;
+
+    ArenaScope arena;
+    StatsScope scope(STATS_STAGE_PNG_TO_DDS, size);
+    std::shared_ptr<ConvertCache> const cache = getConvertCache();
+    Hash128 key{};
+    if (cache) {
+        key = getPNGtoDDSCacheKey(data, size, dx10ext, bgra);
+        if (cache->read(key, allocator, userData, output)) {
+            return scope.finish(CONVERT_OK, output->size);
+        }
+    }
+
+    MipChain mipChain;
+    ConvertStatus status = generateMipChain(static_cast<unsigned char const *>(data), size, bgra, MipOptions{},
+                                            imageData, arena.arena, mipChain);
+    if (status == CONVERT_OK) {
+        status = writeDDSContent(mipChain, dx10ext, allocator, userData, output);
+    }
+    if (cache && status == CONVERT_OK) {
+        cache->write(key, output->content, output->size);
+    }
+    return scope.finish(status, output->size);
+}
+
+/**
+ * Convert PNG image to a DDS texture in the format of 'options', block compressed formats are encoded by the in-tree BC
+ * encoder. The input is borrowed and the DDS is written once to a buffer obtained from 'allocator'.
+ *
+ * @param data The PNG image
+ * @param size The size(in bytes) of data parameter
+ * @param options Output format, quality and header
+ * @param allocator Allocator for the output buffer, when nullptr the buffer is allocated with malloc and must be released
+ *            with freeContentBuffer
+ * @param userData Passed unmodified to 'allocator'
+ * @param output Receives size and pointer to the DDS texture
+ * @return CONVERT_OK on success, CONVERT_ERROR_INVALID_ARGUMENT when the format is not supported
+ */
+[[maybe_unused]] ConvertStatus convertPNGtoDDSCompressedEx(void const *const data, size_t const size,
+                                                           DDSEncodeOptions const *const options,
+                                                           ContentAllocator const allocator, void *const userData,
+                                                           ContentBuffer *const output) {
+    return convertPNGtoDDSCompressedWithScratch(data, size, options, allocator, userData, output,
+                                                getScratchArena().getImageData());
+}
+
+/**
+ * Same as convertPNGtoDDSCompressedEx, decoding into 'imageData' so its buffer can be reused between conversions
+ */
+ConvertStatus convertPNGtoDDSCompressedWithScratch(void const *const data, size_t const size,
+                                                   DDSEncodeOptions const *const options,
+                                                   ContentAllocator const allocator, void *const userData,
+                                                   ContentBuffer *const output, ImageData &imageData) {
+    if (data == nullptr || options == nullptr || output == nullptr) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    if (!isDDSEncodeFormat(options->format)) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    output->size = 0;
+    output->content = nullptr;
+
+    ArenaScope arena;
+    StatsScope scope(STATS_STAGE_PNG_TO_DDS, size);
+    std::shared_ptr<ConvertCache> const cache = getConvertCache();
+    Hash128 key{};
+    if (cache) {
+        key = getPNGtoDDSCacheKey(data, size, *options);
+        if (cache->read(key, allocator, userData, output)) {
+            return scope.finish(CONVERT_OK, output->size);
+        }
+    }
+
+    MipChain texture;
+    ConvertStatus status = buildDDSTexture(static_cast<unsigned char const *>(data), size, *options, imageData,
+                                           arena.arena, texture);
+    if (status != CONVERT_OK) {
+        return scope.finish(status, 0);
+    }
+
+    status = writeDDSContent(texture, useDX10Header(*options), allocator, userData, output);
+    if (cache && status == CONVERT_OK) {
+        cache->write(key, output->content, output->size);
+    }
+    return scope.finish(status, output->size);
+}
+
+/**
+ * @return True if the format can be written by convertPNGtoDDSCompressedEx
+ */
+bool isDDSEncodeFormat(DXGI_FORMAT const format) {
+    return format == DXGI_FORMAT_R8G8B8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM || isBCEncodeFormat(format);
+}
+
+/**
+ * Decode a PNG and build the texture of 'options', the mip chain encoded to the BC format when it is compressed
+ */
+ConvertStatus buildDDSTexture(unsigned char const *const png, size_t const size, DDSEncodeOptions const &options,
+                              ImageData &imageData, ScratchArena &arena, MipChain &texture) {
+    MipOptions mipOptions = options.mips;
+    mipOptions.srgb = mipOptions.srgb || DirectX::IsSRGB(options.format);
+    bool const bgra = options.format == DXGI_FORMAT_B8G8R8A8_UNORM;
+    if (bgra || options.format == DXGI_FORMAT_R8G8B8A8_UNORM) {
+        return generateMipChain(png, size, bgra, mipOptions, imageData, arena, texture);
+    }
+
+    MipChain mipChain;
+    ConvertStatus const status = generateMipChain(png, size, bgra, mipOptions, imageData, arena, mipChain);
+    if (status != CONVERT_OK) {
+        return status;
+    }
+    return compressMipChain(mipChain, options.format, options.quality, arena, texture);
+}
+
+/**
+ * @return True if the texture of 'options' is written with the DX10 header extension
+ */
+bool useDX10Header(DDSEncodeOptions const &options) {
+    //the legacy header has no BC7 nor sRGB formats
+    return options.dx10ext || DirectX::IsSRGB(options.format) || options.format == DXGI_FORMAT_BC7_UNORM;
+}
+
+/**
+ * Serialize a texture as DDS to a buffer obtained from 'allocator'
+ */
+ConvertStatus writeDDSContent(MipChain const &texture, bool const dx10ext, ContentAllocator const allocator,
+                              void *const userData, ContentBuffer *const output) {
+    size_t ddsSize = 0;
+    ConvertStatus status = computeDDSSize(texture.metadata, dx10ext, ddsSize);
+    if (status != CONVERT_OK) {
+        return status;
+    }
+
+    void *content = allocateContent(allocator, userData, ddsSize);
+    if (content == nullptr) {
+        return CONVERT_ERROR_OUT_OF_MEMORY;
+    }
+
+    status = writeDDS(texture, dx10ext, content, ddsSize);
+    if (status != CONVERT_OK && allocator == nullptr) {
+        std::free(content);
+        return status;
+    }
+
+    //with a caller allocator the buffer is returned even on failure, so it can be released by the caller
+    output->content = content;
+    output->size = status == CONVERT_OK ? ddsSize : 0;
+    return status;
+}
 
-    DirectX::Blob output{};
-    DirectX::Image rawImage{};
-    DirectX::ScratchImage image{};
-    DirectX::ScratchImage mipChain{};
+/**
+ * Decode a PNG and write its DDS texture to a buffer already checked to be large enough
+ */
+static ConvertStatus writePNGtoDDS(void const *const data, size_t const size, bool const dx10ext, bool const bgra,
+                                   void *const output, size_t const capacity) {
+    ArenaScope arena;
+    MipChain mipChain;
+    ConvertStatus status = generateMipChain(static_cast<unsigned char const *>(data), size, bgra, MipOptions{},
+                                            arena.arena.getImageData(), arena.arena, mipChain);
+    if (status != CONVERT_OK) {
+        return status;
+    }
+
+    return writeDDS(mipChain, dx10ext, output, capacity);
+}
+
+/**
+ * Convert PNG image to a DDS texture written to a caller-owned buffer.
+ *
+ * @param data The PNG image
+ * @param size The size(in bytes) of data parameter
+ * @param dx10ext Same as convertPNGtoDDS
+ * @param bgra Same as convertPNGtoDDS
+ * @param output Destination buffer. When nullptr, only the PNG header is parsed and the required size is returned in
+ *            'outputSize'.
+ * @param capacity The size(in bytes) of output
+ * @param outputSize Receives the size of the DDS texture
+ * @return CONVERT_OK on success, CONVERT_ERROR_BUFFER_TOO_SMALL when 'capacity' is lower than 'outputSize'
+ */
+[[maybe_unused]] ConvertStatus convertPNGtoDDSInto(void const *const data, size_t const size, bool const dx10ext,
+                                                   bool const bgra, void *const output, size_t const capacity,
+                                                   size_t *const outputSize) {
+    if (data == nullptr || outputSize == nullptr) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    ArenaScope arena;
+    unsigned int width = 0;
+    unsigned int height = 0;
+    if (!readPngHeader(static_cast<unsigned char const *>(data), size, width, height)) {
+        return CONVERT_ERROR_DECODE;
+    }
+
+    size_t ddsSize = 0;
+    ConvertStatus status = computeDDSSize(getMipChainMetadata(width, height, bgra), dx10ext, ddsSize);
+    if (status != CONVERT_OK) {
+        return status;
+    }
+    *outputSize = ddsSize;
+
+    if (output == nullptr) {
+        return CONVERT_OK;
+    }
+    if (capacity < ddsSize) {
+        return CONVERT_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    StatsScope scope(STATS_STAGE_PNG_TO_DDS, size);
+    status = writePNGtoDDS(data, size, dx10ext, bgra, output, capacity);
+    return scope.finish(status, status == CONVERT_OK ? ddsSize : 0);
+}
+
+/**
+ * Convert PNG image to a DDS texture decoding row by row. Rows are decoded straight into the DDS buffer and reduced into
+ * the next mip levels as they arrive, so the memory used besides the output is a few rows. The mip levels are the same
+ * as the box filter of convertPNGtoDDSEx. Interlaced PNGs (and the lodepng backend) use the regular conversion.
+ *
+ * @param data The PNG image
+ * @param size The size(in bytes) of data parameter
+ * @param dx10ext Same as convertPNGtoDDS
+ * @param bgra Same as convertPNGtoDDS
+ * @param allocator Allocator for the output buffer, when nullptr the buffer is allocated with malloc and must be released
+ *            with freeContentBuffer
+ * @param userData Passed unmodified to 'allocator'
+ * @param output Receives size and pointer to the DDS texture
+ * @return CONVERT_OK on success
+ */
+[[maybe_unused]] ConvertStatus convertPNGtoDDSStreamEx(void const *const data, size_t const size, bool const dx10ext,
+                                                       bool const bgra, ContentAllocator const allocator,
+                                                       void *const userData, ContentBuffer *const output) {
+    if (data == nullptr || output == nullptr) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    output->size = 0;
+    output->content = nullptr;
+
+    size_t ddsSize = 0;
+    ConvertStatus status = convertPNGtoDDSStreamInto(data, size, dx10ext, bgra, nullptr, 0, &ddsSize);
+    if (status != CONVERT_OK) {
+        return status;
+    }
+
+    void *content = allocateContent(allocator, userData, ddsSize);
+    if (content == nullptr) {
+        return CONVERT_ERROR_OUT_OF_MEMORY;
+    }
+
+    status = convertPNGtoDDSStreamInto(data, size, dx10ext, bgra, content, ddsSize, &ddsSize);
+    if (status != CONVERT_OK && allocator == nullptr) {
+        std::free(content);
+        return status;
+    }
+
+    //with a caller allocator the buffer is returned even on failure, so it can be released by the caller
+    output->content = content;
+    output->size = status == CONVERT_OK ? ddsSize : 0;
+    return status;
+}
+
+/**
+ * Same as convertPNGtoDDSStreamEx, writing to a caller-owned buffer like convertPNGtoDDSInto
+ */
+[[maybe_unused]] ConvertStatus convertPNGtoDDSStreamInto(void const *const data, size_t const size,
+                                                         bool const dx10ext, bool const bgra, void *const output,
+                                                         size_t const capacity, size_t *const outputSize) {
+    ArenaScope arena;
+    //size query and capacity check, only the header is parsed
+    ConvertStatus status = convertPNGtoDDSInto(data, size, dx10ext, bgra, nullptr, 0, outputSize);
+    if (status != CONVERT_OK || output == nullptr) {
+        return status;
+    }
+    if (capacity < *outputSize) {
+        return CONVERT_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    StatsScope scope(STATS_STAGE_PNG_TO_DDS, size);
+    status = streamPNGtoDDS(static_cast<unsigned char const *>(data), size, dx10ext, bgra, output, capacity);
+    if (status == CONVERT_ERROR_INVALID_ARGUMENT) {
+        //the PNG can't be decoded row by row
+        status = writePNGtoDDS(data, size, dx10ext, bgra, output, capacity);
+    }
+    return scope.finish(status, status == CONVERT_OK ? *outputSize : 0);
+}
 
-    //create struct with raw image data
-    rawImage.width = imageData.getWidth();
-    rawImage.height = imageData.getHeight();
+/**
+ * Convert a DDS texture to PNG image, the input is borrowed. With the default allocator the buffer produced by the PNG
+ * encoder is handed over without copying.
+ *
+ * @param data The DDS texture
+ * @param size The size(in bytes) of data parameter
+ * @param options PNG encoder settings, nullptr for PNG_PROFILE_BALANCED without content detection. Fields out of
+ *            range return CONVERT_ERROR_INVALID_ARGUMENT.
+ * @param allocator Allocator for the output buffer, when nullptr the buffer is allocated with malloc and must be released
+ *            with freeContentBuffer
+ * @param userData Passed unmodified to 'allocator'
+ * @param output Receives size and pointer to the PNG
+ * @return CONVERT_OK on success
+ */
+[[maybe_unused]] ConvertStatus convertDDStoPNGEx(void const *const data, size_t const size,
+                                                 PngEncodeOptions const *const options,
+                                                 ContentAllocator const allocator, void *const userData,
+                                                 ContentBuffer *const output) {
+    if (data == nullptr || output == nullptr || !isValidPngEncodeOptions(options)) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    output->size = 0;
+    output->content = nullptr;
+
+    ArenaScope arena;
+    StatsScope scope(STATS_STAGE_DDS_TO_PNG, size);
+    std::shared_ptr<ConvertCache> const cache = getConvertCache();
+    Hash128 key{};
+    if (cache) {
+        key = getDDStoPNGCacheKey(data, size, options);
+        if (cache->read(key, allocator, userData, output)) {
+            return scope.finish(CONVERT_OK, output->size);
+        }
+    }
+
+    DirectX::ScratchImage storage{};
+    DirectX::Image source{};
+    ConvertStatus status = loadDDSImage(data, size, DDSSubresource{0, 0, 0}, storage, source);
+    if (status != CONVERT_OK) {
+        return scope.finish(status, 0);
+    }
+
+    PngOutput png{};
+    png.allocator = allocator;
+    png.userData = userData;
+    status = encodePng(source, resolvePngEncodeOptions(options, source), png);
+    if (status != CONVERT_OK) {
+        return scope.finish(status, 0);
+    }
+
+    output->size = png.size;
+    output->content = png.content;
+    if (cache) {
+        cache->write(key, output->content, output->size);
+    }
+    return scope.finish(CONVERT_OK, png.size);
+}
+
+/**
+ * Convert a DDS texture to PNG image written to a caller-owned buffer. The PNG size is only known after encoding, so
+ * querying with a nullptr 'output' costs a full conversion.
+ *
+ * @param data The DDS texture
+ * @param size The size(in bytes) of data parameter
+ * @param options PNG encoder settings, nullptr for PNG_PROFILE_BALANCED without content detection. Fields out of
+ *            range return CONVERT_ERROR_INVALID_ARGUMENT.
+ * @param output Destination buffer, may be nullptr to query the size
+ * @param capacity The size(in bytes) of output
+ * @param outputSize Receives the size of the PNG
+ * @return CONVERT_OK on success, CONVERT_ERROR_BUFFER_TOO_SMALL when 'capacity' is lower than 'outputSize'
+ */
+[[maybe_unused]] ConvertStatus convertDDStoPNGInto(void const *const data, size_t const size,
+                                                   PngEncodeOptions const *const options, void *const output,
+                                                   size_t const capacity, size_t *const outputSize) {
+    if (data == nullptr || outputSize == nullptr || !isValidPngEncodeOptions(options)) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    ArenaScope arena;
+    StatsScope scope(STATS_STAGE_DDS_TO_PNG, size);
+    DirectX::ScratchImage storage{};
+    DirectX::Image source{};
+    ConvertStatus status = loadDDSImage(data, size, DDSSubresource{0, 0, 0}, storage, source);
+    if (status != CONVERT_OK) {
+        return scope.finish(status, 0);
+    }
+
+    PngOutput png{};
+    png.streaming = true;
+    png.buffer = static_cast<unsigned char *>(output);
+    png.capacity = output == nullptr ? 0 : capacity;
+    status = encodePng(source, resolvePngEncodeOptions(options, source), png);
+    *outputSize = png.size;
+    if (status == CONVERT_ERROR_BUFFER_TOO_SMALL && output == nullptr) {
+        status = CONVERT_OK;
+    }
+    return scope.finish(status, png.size);
+}
 
+/**
+ * Release a buffer returned by the *Ex functions when they were called without an allocator
+ *
+ * @param content The buffer, size and pointer are reset
+ */
+[[maybe_unused]] void freeContentBuffer(ContentBuffer *const content) {
+    if (content == nullptr) {
+        return;
+    }
+    std::free(content->content);
+    content->content = nullptr;
+    content->size = 0;
+}
+
+void *allocateContent(ContentAllocator const allocator, void *const userData, size_t const size) {
+    StatsScope::countAllocation(size);
+    return allocator == nullptr ? std::malloc(size) : allocator(size, userData);
+}
+
+/**
+ * Decode a PNG and generate the full mipmap chain. The chain is sized from the PNG header and the image is decoded
+ * straight into the first level, 'imageData' is only used by the backends that can't decode into it. All levels share
+ * one allocation from 'arena', in the order of the DDS layout.
+ */
+ConvertStatus generateMipChain(unsigned char const *const png, size_t const size, bool const bgra,
+                               MipOptions const &mipOptions, ImageData &imageData, ScratchArena &arena,
+                               MipChain &mipChain) {
+    PngHeader header;
+    if (!readPngHeader(png, size, header) || header.width == 0 || header.height == 0) {
+        return CONVERT_ERROR_DECODE;
+    }
+
+    DirectX::TexMetadata const metadata = getMipChainMetadata(header.width, header.height, bgra);
+    ConvertStatus status = initMipChain(metadata, arena, mipChain);
+    if (status != CONVERT_OK) {
+        printError("Error allocating mipmaps\n");
+        return status;
+    }
+
+    //the other levels are not generated yet, the decoder may use them as scratch
+    DirectX::Image const &base = mipChain.images[0];
+    if (!decodePng(png, size, base.pixels, base.slicePitch, mipChain.pixelsSize, imageData)) {
+        return CONVERT_ERROR_DECODE;
+    }
     if (bgra) {
-        rawImage.format = DXGI_FORMAT_B8G8R8A8_UNORM;
-        //convert byte order, PNG is big endian and uses RGBA
-        std::vector<unsigned char> bgraBuffer = convertRGBAtoBGRA(imageData.getPixels());
+        //convert byte order in place, PNG is big endian and uses RGBA
+        swizzleRGBAtoBGRA(base.pixels, base.slicePitch);
+    }
 
-        rawImage.pixels = static_cast<uint8_t *>(std::malloc(bgraBuffer.size()));
-        std::memcpy(rawImage.pixels, bgraBuffer.data(), bgraBuffer.size());
-        bgraBuffer.clear();
-    } else {
-        rawImage.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    status = generateMipLevels(mipChain, mipOptions);
+    if (status != CONVERT_OK) {
+        printError("Error generating mipmaps\n");
+    }
+    return status;
+}
 
-        //PNG is already in the correct byte order for R8G8B8A8_UNORM
-        rawImage.pixels = static_cast<uint8_t *>(std::malloc(imageData.getPixelsSize()));
-        std::memcpy(rawImage.pixels, imageData.getPixelsPointer(), imageData.getPixelsSize());
+/**
+ * Encode every level of a RGBA8 mip chain to a BC format. Levels are encoded one after the other, the blocks of each
+ * level in parallel.
+ */
+ConvertStatus compressMipChain(MipChain const &mipChain, DXGI_FORMAT const format, BCQuality const quality,
+                               ScratchArena &arena, MipChain &compressed) {
+    StatsScope scope(STATS_STAGE_BC_ENCODE, mipChain.pixelsSize);
+    DirectX::TexMetadata metadata = mipChain.metadata;
+    metadata.format = format;
+    ConvertStatus status = initMipChain(metadata, arena, compressed);
+    if (status != CONVERT_OK) {
+        printError("Error allocating compressed texture\n");
+        return scope.finish(status, 0);
     }
 
-    //calculate pitch, needed to keep image in the correct position and aspect
-    DirectX::ComputePitch(rawImage.format, rawImage.width, rawImage.height, rawImage.rowPitch, rawImage.slicePitch,
-                          DirectX::CP_FLAGS_NONE);
+    for (size_t level = 0; level < metadata.mipLevels; level++) {
+        status = encodeBC(format, quality, mipChain.images[level], compressed.images[level].pixels);
+        if (status != CONVERT_OK) {
+            return scope.finish(status, 0);
+        }
+    }
+    return scope.finish(CONVERT_OK, compressed.pixelsSize);
+}
 
-    //generate all mipmaps in the ScratchImage, unlimited levels
-    HRESULT hrMipmap = DirectX::GenerateMipMaps(rawImage, DirectX::TEX_FILTER_FORCE_NON_WIC, 0, mipChain);
-    if (FAILED(hrMipmap)) {
-        std::fprintf(stderr, "Error generating mipmaps: ");
-        printErrorDescription(hrMipmap);
-        return ret;
+/**
+ * Metadata of the texture generated by generateMipChain, without decoding the image
+ */
+DirectX::TexMetadata getMipChainMetadata(size_t const width, size_t const height, bool const bgra) {
+    DirectX::TexMetadata metadata{};
+    metadata.width = width;
+    metadata.height = height;
+    metadata.depth = 1;
+    metadata.arraySize = 1;
+    metadata.mipLevels = 1;
+    for (size_t w = width, h = height; w > 1 || h > 1; w = std::max<size_t>(w / 2, 1), h = std::max<size_t>(h / 2, 1)) {
+        metadata.mipLevels++;
     }
-    std::free(rawImage.pixels);
+    metadata.format = bgra ? DXGI_FORMAT_B8G8R8A8_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+    metadata.dimension = DirectX::TEX_DIMENSION_TEXTURE2D;
+    return metadata;
+}
+
+DirectX::DDS_FLAGS getDDSFlags(bool const dx10ext) {
+    return dx10ext ? DirectX::DDS_FLAGS_FORCE_DX10_EXT : DirectX::DDS_FLAGS_FORCE_DX9_LEGACY
+                                                         | DirectX::DDS_FLAGS_FORCE_RGB;
+}
 
-    //generate a DDS from the mipchain
-    HRESULT hr = DirectX::SaveToDDSMemory(mipChain.GetImages(), mipChain.GetImageCount(), mipChain.GetMetadata(),
-                                          dx10ext ? DirectX::DDS_FLAGS_FORCE_DX10_EXT : DirectX::DDS_FLAGS_FORCE_DX9_LEGACY
-                                                                                        | DirectX::DDS_FLAGS_FORCE_RGB, output);
+/**
+ * Compute the size of a 2D texture serialized as DDS: header plus every mip level of every array item
+ */
+ConvertStatus computeDDSSize(DirectX::TexMetadata const &metadata, bool const dx10ext, size_t &size) {
+    size_t headerSize = 0;
+    HRESULT hr = DirectX::EncodeDDSHeader(metadata, getDDSFlags(dx10ext), nullptr, 0, headerSize);
     if (FAILED(hr)) {
-        std::fprintf(stderr, "Error writing DDS to buffer: ");
+        printError("Error encoding DDS header: ");
         printErrorDescription(hr);
-        return ret;
+        return CONVERT_ERROR_ENCODE;
     }
 
-    ret.size = static_cast<unsigned int>(output.GetBufferSize());
-    ret.content = std::malloc(ret.size);
-    std::memcpy(ret.content, output.GetBufferPointer(), ret.size);
-    output.Release();
-    return ret;
+    size_t levelsSize = 0;
+    size_t width = metadata.width;
+    size_t height = metadata.height;
+    for (size_t level = 0; level < metadata.mipLevels; level++) {
+        size_t rowPitch = 0;
+        size_t slicePitch = 0;
+        DirectX::ComputePitch(metadata.format, width, height, rowPitch, slicePitch, DirectX::CP_FLAGS_NONE);
+        levelsSize += slicePitch;
+        width = std::max<size_t>(width / 2, 1);
+        height = std::max<size_t>(height / 2, 1);
+    }
+
+    size = headerSize + levelsSize * metadata.arraySize;
+    return CONVERT_OK;
 }
 
 /**
- * Convert a DDS texture to PNG image
- * @param size The size(in bytes) of data parameter
- * @param data The DDS texture
- * @return Returns the 'Data' containing size and a pointer to PNG
+ * Serialize the mip chain as DDS directly into 'output', each image is written once
  */
-[[maybe_unused]] Content convertDDStoPNG(unsigned int const size, void *const data) {
-    Content ret{};
-    ret.size = 0;
+ConvertStatus writeDDS(MipChain const &mipChain, bool const dx10ext, void *const output, size_t const capacity) {
+    StatsScope scope(STATS_STAGE_DDS_WRITE, mipChain.pixelsSize);
+    size_t headerSize = 0;
+    HRESULT hr = DirectX::EncodeDDSHeader(mipChain.metadata, getDDSFlags(dx10ext), output, capacity, headerSize);
+    if (FAILED(hr)) {
+        printError("Error writing DDS to buffer: ");
+        printErrorDescription(hr);
+        return scope.finish(CONVERT_ERROR_ENCODE, 0);
+    }
 
-    DirectX::ScratchImage image{};
+    //the levels are already in the order of the DDS layout
+    if (mipChain.pixelsSize > capacity - headerSize) {
+        return scope.finish(CONVERT_ERROR_BUFFER_TOO_SMALL, 0);
+    }
+    std::memcpy(static_cast<uint8_t *>(output) + headerSize, mipChain.pixels, mipChain.pixelsSize);
+    return scope.finish(CONVERT_OK, headerSize + mipChain.pixelsSize);
+}
+
+static ConvertStatus loadDDSTexture(void const *const data, size_t const size, DirectX::ScratchImage &image) {
     DirectX::TexMetadata metadata{};
     try {
         HRESULT hr = DirectX::LoadFromDDSMemory(data, size, DirectX::DDS_FLAGS_FORCE_RGB, &metadata, image);
         if (FAILED(hr)) {
-            std::fprintf(stderr, "Error reading DDS from buffer: ");
+            printError("Error reading DDS from buffer: ");
             printErrorDescription(hr);
-            return ret;
+            return CONVERT_ERROR_DECODE;
         }
     } catch (...) {
-        std::fprintf(stderr, "Error reading DDS from buffer");
+        printError("Error reading DDS from buffer\n");
+        return CONVERT_ERROR_DECODE;
     }
 
     try {
@@ -148,79 +699,110 @@
                                                     image.GetMetadata(),
                                                     DXGI_FORMAT_UNKNOWN, uncompressed);
             if (FAILED(resultDec)) {
-                std::fprintf(stderr, "Error decompressing texture: ");
+                printError("Error decompressing texture: ");
                 printErrorDescription(resultDec);
-                return ret;
+                return CONVERT_ERROR_DECODE;
             }
             std::swap(uncompressed, image);
             uncompressed.Release();
         }
     } catch (...) {
-        std::fprintf(stderr, "Error uncompressing texture\n");
+        printError("Error uncompressing texture\n");
+        return CONVERT_ERROR_DECODE;
     }
 
-    ImageData ddsData;
-    ddsData.setWidth(static_cast<unsigned int>(image.GetMetadata().width));
-    ddsData.setHeight(static_cast<unsigned int>(image.GetMetadata().height));
-    ddsData.setPixels(image.GetImage(0, 0, 0)->pixels, image.GetImage(0, 0, 0)->slicePitch);
-    try {
-        ImageData imageData = encodePng(ddsData);
+    return CONVERT_OK;
+}
 
-        image.Release();
-        ret.size = static_cast<unsigned int>(imageData.getPixelsSize());
-        ret.content = std::malloc(ret.size);
-        std::memcpy(ret.content, imageData.getPixelsPointer(), ret.size);
-    } catch (...) {
-        std::fprintf(stderr, "Error writing to WIC buffer");
+/**
+ * Load a DDS texture, compressed formats are decompressed
+ */
+ConvertStatus loadDDS(void const *const data, size_t const size, DirectX::ScratchImage &image) {
+    StatsScope scope(STATS_STAGE_DDS_LOAD, size);
+    ConvertStatus const status = loadDDSTexture(data, size, image);
+    if (status == CONVERT_OK) {
+        StatsScope::countAllocation(image.GetPixelsSize());
     }
-    return ret;
+    return scope.finish(status, status == CONVERT_OK ? image.GetPixelsSize() : 0);
 }
 
-std::vector<unsigned char> convertRGBAtoBGRA(std::vector<unsigned char> const &rgba) {
-    std::vector<unsigned char> bgra;
+#ifdef DXTWRAPPER_USE_LIBSPNG
 
-    for (auto it = rgba.begin(); it != rgba.end(); it += 4) {
-        unsigned char r = *(it);
-        unsigned char g = *(it + 1);
-        unsigned char b = *(it + 2);
-        unsigned char a = *(it + 3);
-        bgra.emplace_back(b);
-        bgra.emplace_back(g);
-        bgra.emplace_back(r);
-        bgra.emplace_back(a);
+int writePngStream([[maybe_unused]] spng_ctx *ctx, void *user, void *src, size_t length) {
+    auto *output = static_cast<PngOutput *>(user);
+    if (output->file != nullptr) {
+        if (std::fwrite(src, 1, length, output->file) != length) {
+            return SPNG_IO_ERROR;
+        }
+    } else if (output->buffer != nullptr && output->size + length <= output->capacity) {
+        std::memcpy(output->buffer + output->size, src, length);
     }
-
-    return bgra;
+    output->size += length;
+    return 0;
 }
 
-#ifdef DXTWRAPPER_USE_LIBSPNG
-
-ImageData encodePng(ImageData const &ddsData) {
-    ImageData imageData;
+static ConvertStatus encodePngImage(DirectX::Image const &image, PngEncodeOptions const &options,
+                                    PngOutput &output) {
+    if (isParallelPngEncodeEnabled(image)) {
+        /* Large images are split in strips deflated in parallel */
+        return encodePngParallel(image, options, output);
+    }
 
     spng_ihdr ihdr{}; /* zero-initialize to set valid defaults */
 
     /* Creating an encoder context requires a flag */
-    spng_ctx *ctx = spng_ctx_new(SPNG_CTX_ENCODER);
+    spng_ctx *ctx = newSpngContext(SPNG_CTX_ENCODER);
+    if (ctx == nullptr) {
+        return CONVERT_ERROR_OUT_OF_MEMORY;
+    }
 
-    /* Encode to internal buffer managed by the library */
-    spng_set_option(ctx, SPNG_ENCODE_TO_BUFFER, 1);
+    if (output.streaming || output.file != nullptr) {
+        /* Write straight to the caller buffer or file */
+        output.size = 0;
+        spng_set_png_stream(ctx, writePngStream, &output);
+    } else {
+        /* Encode to internal buffer managed by the library */
+        spng_set_option(ctx, SPNG_ENCODE_TO_BUFFER, 1);
+    }
+
+    /* Compression settings, PngEncodeOptions uses the zlib and spng values */
+    int error = spng_set_option(ctx, SPNG_IMG_COMPRESSION_LEVEL, options.compressionLevel);
+    if (!error) {
+        error = spng_set_option(ctx, SPNG_IMG_COMPRESSION_STRATEGY, options.compressionStrategy);
+    }
+    if (!error) {
+        error = spng_set_option(ctx, SPNG_FILTER_CHOICE, options.filterChoice);
+    }
+    if (error) {
+        printError("spng_set_option() error: %s\n", spng_strerror(error));
+        spng_ctx_free(ctx);
+        return CONVERT_ERROR_ENCODE;
+    }
 
     /* Set image properties, this determines the destination image format */
-    ihdr.width = ddsData.getWidth();
-    ihdr.height = ddsData.getHeight();
+    ihdr.width = static_cast<uint32_t>(image.width);
+    ihdr.height = static_cast<uint32_t>(image.height);
     ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR_ALPHA;
     ihdr.bit_depth = 8;
 
     spng_set_ihdr(ctx, &ihdr);
 
     /* SPNG_ENCODE_FINALIZE will finalize the PNG with the end-of-file marker */
-    int error = spng_encode_image(ctx, ddsData.getPixelsPointer(), ddsData.getPixelsSize(), SPNG_FMT_PNG, SPNG_ENCODE_FINALIZE);
+    error = spng_encode_image(ctx, image.pixels, image.slicePitch, SPNG_FMT_PNG, SPNG_ENCODE_FINALIZE);
 
     if (error) {
-        std::fprintf(stderr, "spng_encode_image() error: %s\n", spng_strerror(error));
+        printError("spng_encode_image() error: %s\n", spng_strerror(error));
+        spng_ctx_free(ctx);
+        return error == SPNG_IO_ERROR ? CONVERT_ERROR_IO : CONVERT_ERROR_ENCODE;
+    }
+
+    if (output.file != nullptr) {
         spng_ctx_free(ctx);
-        return imageData;
+        return CONVERT_OK;
+    }
+    if (output.streaming) {
+        spng_ctx_free(ctx);
+        return output.size <= output.capacity ? CONVERT_OK : CONVERT_ERROR_BUFFER_TOO_SMALL;
     }
 
     size_t pngSize;
@@ -229,40 +811,80 @@ ImageData encodePng(ImageData const &ddsData) {
     int encodeError = 0;
     /* Get the internal buffer of the finished PNG */
     pngBuf = spng_get_png_buffer(ctx, &pngSize, &encodeError);
+    spng_ctx_free(ctx);
 
     if (encodeError || pngBuf == nullptr) {
-        std::fprintf(stderr, "spng_get_png_buffer() error: %s\n", spng_strerror(encodeError));
-        spng_ctx_free(ctx);
-        return imageData;
+        printError("spng_get_png_buffer() error: %s\n", spng_strerror(encodeError));
+        return CONVERT_ERROR_ENCODE;
     }
 
-    imageData.setPixels(pngBuf, pngSize);
-    spng_ctx_free(ctx);
+    ScratchArena &arena = getScratchArena();
+    if (arena.contains(pngBuf)) {
+        /* The buffer belongs to the arena, copy it out */
+        output.content = allocateContent(output.allocator, output.userData, pngSize);
+        if (output.content != nullptr) {
+            std::memcpy(output.content, pngBuf, pngSize);
+            output.size = pngSize;
+        }
+        arena.release(pngBuf);
+        return output.content != nullptr ? CONVERT_OK : CONVERT_ERROR_OUT_OF_MEMORY;
+    }
+
+    StatsScope::countAllocation(pngSize);
+    if (output.allocator == nullptr) {
+        /* The buffer was allocated with malloc by spng, hand it over */
+        output.content = pngBuf;
+        output.size = pngSize;
+        return CONVERT_OK;
+    }
+
+    output.content = output.allocator(pngSize, output.userData);
+    if (output.content == nullptr) {
+        free(pngBuf);
+        return CONVERT_ERROR_OUT_OF_MEMORY;
+    }
+    std::memcpy(output.content, pngBuf, pngSize);
+    output.size = pngSize;
     free(pngBuf);
 
-    return imageData;
+    return CONVERT_OK;
 }
 
-ImageData decodePng(std::vector<unsigned char> const &png) {
+ImageData decodePng(unsigned char const *const png, size_t const size) {
     ImageData imageData;
+    decodePng(png, size, imageData);
+    return imageData;
+}
 
-    unsigned long long outputBufferSize;
+static bool decodePngImage(unsigned char const *const png, size_t const size, ImageData &imageData) {
+    size_t outputBufferSize;
     /* Create a context */
-    spng_ctx *ctx = spng_ctx_new(0);
+    spng_ctx *ctx = newSpngDecoder();
+    if (ctx == nullptr) {
+        return false;
+    }
 
     /* Set an input buffer */
-    spng_set_png_buffer(ctx, png.data(), png.size());
+    spng_set_png_buffer(ctx, png, size);
 
     /* Determine output image size */
-    spng_decoded_image_size(ctx, SPNG_FMT_RGBA8, &outputBufferSize);
-
-    std::vector<unsigned char> outputBuffer(outputBufferSize);
+    int error = spng_decoded_image_size(ctx, SPNG_FMT_RGBA8, &outputBufferSize);
+    if (error) {
+        printError("spng_decoded_image_size() error: %s\n", spng_strerror(error));
+        spng_ctx_free(ctx);
+        imageData.getPixels().clear();
+        return false;
+    }
 
-    /* Decode to 8-bit RGBA */
-    int error = spng_decode_image(ctx, outputBuffer.data(), outputBuffer.size(), SPNG_FMT_RGBA8, 0);
+    /* Decode to 8-bit RGBA, straight into the image buffer. A reused buffer keeps its capacity */
+    std::vector<unsigned char> &outputBuffer = imageData.getPixels();
+    outputBuffer.resize(outputBufferSize);
+    error = spng_decode_image(ctx, outputBuffer.data(), outputBuffer.size(), SPNG_FMT_RGBA8, 0);
     if (error) {
-        printf("progressive spng_decode_image() error: %s\n", spng_strerror(error));
-        return imageData;
+        printError("spng_decode_image() error: %s\n", spng_strerror(error));
+        spng_ctx_free(ctx);
+        outputBuffer.clear();
+        return false;
     }
 
     spng_ihdr ihdr{};
@@ -273,45 +895,292 @@ ImageData decodePng(std::vector<unsigned char> const &png) {
     /* Free context memory */
     spng_ctx_free(ctx);
 
-    imageData.setPixels(outputBuffer);
+    return true;
+}
 
-    return imageData;
+/**
+ * Decode to 8-bit RGBA straight into a buffer of the caller, 'pixelsSize' must be the size of the decoded image
+ */
+static bool decodePngImage(unsigned char const *const png, size_t const size, unsigned char *const pixels,
+                           size_t const pixelsSize, [[maybe_unused]] ImageData &scratch) {
+    spng_ctx *ctx = newSpngDecoder();
+    if (ctx == nullptr) {
+        return false;
+    }
+
+    spng_set_png_buffer(ctx, png, size);
+
+    size_t outputBufferSize;
+    int error = spng_decoded_image_size(ctx, SPNG_FMT_RGBA8, &outputBufferSize);
+    if (!error && outputBufferSize != pixelsSize) {
+        error = SPNG_EBUFSIZ;
+    }
+    if (!error) {
+        error = spng_decode_image(ctx, pixels, pixelsSize, SPNG_FMT_RGBA8, 0);
+    }
+    spng_ctx_free(ctx);
+    if (error) {
+        printError("spng_decode_image() error: %s\n", spng_strerror(error));
+        return false;
+    }
+    return true;
+}
+
+bool readPngHeader(unsigned char const *const png, size_t const size, PngHeader &header) {
+    spng_ctx *ctx = newSpngDecoder();
+    if (ctx == nullptr) {
+        return false;
+    }
+
+    spng_set_png_buffer(ctx, png, size);
+
+    /* Only the signature and IHDR are read */
+    spng_ihdr ihdr{};
+    int error = spng_get_ihdr(ctx, &ihdr);
+    spng_ctx_free(ctx);
+    if (error) {
+        printError("spng_get_ihdr() error: %s\n", spng_strerror(error));
+        return false;
+    }
+
+    header.width = ihdr.width;
+    header.height = ihdr.height;
+    header.bitDepth = ihdr.bit_depth;
+    header.colorType = ihdr.color_type;
+    header.interlaced = ihdr.interlace_method != SPNG_INTERLACE_NONE;
+    return true;
 }
 
 #else
 #ifdef DXTWRAPPER_USE_LIBLODEPNG
 
-ImageData encodePng(ImageData const &ddsData) {
-    ImageData imageData{};
+static ConvertStatus encodePngImage(DirectX::Image const &image, PngEncodeOptions const &options,
+                                    PngOutput &output) {
+    std::vector<unsigned char> png;
     lodepng::State state;
 
-    if (lodepng::encode(imageData.getPixels(), ddsData.getPixelsPointer(), ddsData.getWidth(), ddsData.getHeight())) {
-        std::fprintf(stderr, "Error converting to PNG");
+    /* lodepng has no compression levels, the window size and lazy matching are the closest settings */
+    LodePNGCompressSettings &zlib = state.encoder.zlibsettings;
+    if (options.compressionLevel >= 0 && options.compressionLevel <= 3) {
+        zlib.windowsize = 1024;
+        zlib.lazymatching = 0;
+    } else if (options.compressionLevel >= 8) {
+        zlib.windowsize = 32768;
+        zlib.nicematch = 258;
+    }
+    if (options.compressionStrategy == PNG_STRATEGY_HUFFMAN_ONLY) {
+        zlib.use_lz77 = 0;
+    } else if (options.compressionStrategy == PNG_STRATEGY_FIXED) {
+        zlib.btype = 1;
     }
 
-    return imageData;
+    switch (options.filterChoice) {
+        case PNG_FILTER_NONE:
+            state.encoder.filter_strategy = LFS_ZERO;
+            break;
+        case PNG_FILTER_SUB:
+            state.encoder.filter_strategy = LFS_ONE;
+            break;
+        case PNG_FILTER_UP:
+            state.encoder.filter_strategy = LFS_TWO;
+            break;
+        case PNG_FILTER_AVG:
+            state.encoder.filter_strategy = LFS_THREE;
+            break;
+        case PNG_FILTER_PAETH:
+            state.encoder.filter_strategy = LFS_FOUR;
+            break;
+        default:
+            state.encoder.filter_strategy = LFS_MINSUM;
+            break;
+    }
+
+    if (lodepng::encode(png, image.pixels, static_cast<unsigned int>(image.width),
+                        static_cast<unsigned int>(image.height), state)) {
+        printError("Error converting to PNG");
+        return CONVERT_ERROR_ENCODE;
+    }
+
+    output.size = png.size();
+    if (output.file != nullptr) {
+        return std::fwrite(png.data(), 1, png.size(), output.file) == png.size() ? CONVERT_OK : CONVERT_ERROR_IO;
+    }
+    if (output.streaming) {
+        if (output.size > output.capacity) {
+            return CONVERT_ERROR_BUFFER_TOO_SMALL;
+        }
+        std::memcpy(output.buffer, png.data(), png.size());
+        return CONVERT_OK;
+    }
+
+    output.content = allocateContent(output.allocator, output.userData, png.size());
+    if (output.content == nullptr) {
+        return CONVERT_ERROR_OUT_OF_MEMORY;
+    }
+    std::memcpy(output.content, png.data(), png.size());
+
+    return CONVERT_OK;
 }
 
-ImageData decodePng(std::vector<unsigned char> const &png) {
+ImageData decodePng(unsigned char const *const png, size_t const size) {
     ImageData imageData{};
+    decodePng(png, size, imageData);
+    return imageData;
+}
+
+static bool decodePngImage(unsigned char const *const png, size_t const size, ImageData &imageData) {
     unsigned int width;
     unsigned int height;
 
     lodepng::State state;
+    if (getPngDecodeMode() == PNG_DECODE_TRUSTED) {
+        state.decoder.ignore_crc = 1;
+        state.decoder.zlibsettings.ignore_adler32 = 1;
+    }
 
-    if (lodepng::decode(imageData.getPixels(), width, height, state, png.data(), png.size())) {
-        std::fprintf(stderr, "Error decoding PNG\n");
+    imageData.getPixels().clear();
+    if (lodepng::decode(imageData.getPixels(), width, height, state, png, size)) {
+        printError("Error decoding PNG\n");
+        imageData.getPixels().clear();
+        return false;
     }
 
     imageData.setWidth(width);
     imageData.setHeight(height);
 
-    return imageData;
+    return true;
+}
+
+/**
+ * lodepng allocates the decoded image, it is decoded into 'scratch' and copied to the buffer of the caller
+ */
+static bool decodePngImage(unsigned char const *const png, size_t const size, unsigned char *const pixels,
+                           size_t const pixelsSize, ImageData &scratch) {
+    if (!decodePngImage(png, size, scratch) || scratch.getPixelsSize() != pixelsSize) {
+        return false;
+    }
+    std::memcpy(pixels, scratch.getPixelsPointer(), pixelsSize);
+    return true;
+}
+
+bool readPngHeader(unsigned char const *const png, size_t const size, PngHeader &header) {
+    lodepng::State state;
+
+    if (lodepng_inspect(&header.width, &header.height, &state, png, size)) {
+        printError("Error reading PNG header\n");
+        return false;
+    }
+
+    header.bitDepth = static_cast<unsigned char>(state.info_png.color.bitdepth);
+    header.colorType = static_cast<unsigned char>(state.info_png.color.colortype);
+    header.interlaced = state.info_png.interlace_method != 0;
+    return true;
 }
 
 #endif
 #endif
 
+/**
+ * Encode a RGBA8 image as PNG with the selected backend
+ */
+ConvertStatus encodePng(DirectX::Image const &image, PngEncodeOptions const &options, PngOutput &output) {
+    StatsScope scope(STATS_STAGE_PNG_ENCODE, image.slicePitch);
+    ConvertStatus const status = encodePngImage(image, options, output);
+    return scope.finish(status, status == CONVERT_OK ? output.size : 0);
+}
+
+/**
+ * Whether a PNG goes to the backend after decodeTrustedPng returned 'status'. The formats it doesn't decode do, an
+ * invalid PNG doesn't: the backend would fail too, or hide a bug of the trusted decoder.
+ */
+static bool isBackendDecode(ConvertStatus const status) {
+    if (status == CONVERT_ERROR_DECODE) {
+        printError("Error decoding PNG, invalid image data\n");
+        return false;
+    }
+    return status != CONVERT_OK;
+}
+
+/**
+ * Decode a PNG to RGBA8 with the selected backend, into 'imageData' which may be reused between calls. In the trusted
+ * mode the PNGs decodeTrustedPng doesn't support go to the backend.
+ */
+bool decodePng(unsigned char const *const png, size_t const size, ImageData &imageData) {
+    StatsScope scope(STATS_STAGE_PNG_DECODE, size);
+    size_t const capacity = imageData.getPixels().capacity();
+    ConvertStatus const trusted = getPngDecodeMode() == PNG_DECODE_TRUSTED ? decodeTrustedPng(png, size, imageData)
+                                                                           : CONVERT_ERROR_INVALID_ARGUMENT;
+    bool const decoded = trusted == CONVERT_OK || (isBackendDecode(trusted) && decodePngImage(png, size, imageData));
+    if (imageData.getPixels().capacity() != capacity) {
+        StatsScope::countAllocation(imageData.getPixels().capacity());
+    }
+    scope.finish(decoded ? CONVERT_OK : CONVERT_ERROR_DECODE, imageData.getPixelsSize());
+    return decoded;
+}
+
+/**
+ * Decode a PNG to RGBA8 into a buffer of the caller, sized from readPngHeader
+ *
+ * @param pixels Receives the pixels
+ * @param pixelsSize width * height * 4
+ * @param capacity Bytes writable at 'pixels', the ones after the image are scratch of the trusted decoder
+ * @param scratch Buffer of the backends that can't decode into 'pixels', may be reused between calls
+ */
+bool decodePng(unsigned char const *const png, size_t const size, unsigned char *const pixels, size_t const pixelsSize,
+               size_t const capacity, ImageData &scratch) {
+    StatsScope scope(STATS_STAGE_PNG_DECODE, size);
+    size_t const scratchCapacity = scratch.getPixels().capacity();
+    ConvertStatus const trusted = getPngDecodeMode() == PNG_DECODE_TRUSTED
+                                  ? decodeTrustedPng(png, size, pixels, pixelsSize, capacity)
+                                  : CONVERT_ERROR_INVALID_ARGUMENT;
+    bool const decoded = trusted == CONVERT_OK
+                         || (isBackendDecode(trusted) && decodePngImage(png, size, pixels, pixelsSize, scratch));
+    if (scratch.getPixels().capacity() != scratchCapacity) {
+        StatsScope::countAllocation(scratch.getPixels().capacity());
+    }
+    scope.finish(decoded ? CONVERT_OK : CONVERT_ERROR_DECODE, decoded ? pixelsSize : 0);
+    return decoded;
+}
+
+bool readPngHeader(unsigned char const *const png, size_t const size, unsigned int &width, unsigned int &height) {
+    PngHeader header;
+    if (!readPngHeader(png, size, header)) {
+        return false;
+    }
+
+    width = header.width;
+    height = header.height;
+    return true;
+}
+
+//errors are printed to stderr unless disabled for the current thread
+thread_local bool errorOutput = true;
+
+/**
+ * Enable or disable the error messages printed to stderr by the current thread
+ *
+ * @param enabled False to silence errors, used where failures are reported with status codes
+ * @return The previous setting, see ErrorOutputScope
+ */
+bool setErrorOutput(bool const enabled) {
+    bool const previous = errorOutput;
+    errorOutput = enabled;
+    return previous;
+}
+
+/**
+ * Print an error message to stderr, printf format
+ */
+void printError(char const *const format, ...) {
+    if (!errorOutput) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    std::vfprintf(stderr, format, args);
+    va_end(args);
+}
+
 #ifdef WIN32
 
 /**
@@ -320,6 +1189,9 @@ ImageData decodePng(std::vector<unsigned char> const &png) {
  * @param hr Error
  */
 void printErrorDescription(HRESULT hr) {
+    if (!errorOutput) {
+        return;
+    }
     if (FACILITY_WINDOWS == HRESULT_FACILITY(hr))
         hr = HRESULT_CODE(hr);
     TCHAR *szErrMsg;
@@ -336,6 +1208,9 @@ void printErrorDescription(HRESULT hr) {
 
 #else
 void printErrorDescription(long hr) {
+    if (!errorOutput) {
+        return;
+    }
     std::fprintf(stderr, ("Error code # %#lx.\n"), hr);
 }
 #endif
@@ -28,7 +28,14 @@
 
 #include <DirectXTex.h>
 #include "Content.h"
+#include "ConvertStatus.h"
+#include "DDSEncodeOptions.h"
 #include "ImageData.h"
+#include "PngEncodeOptions.h"
+#include "PngOutput.h"
+
+class MipChain;
+class ScratchArena;
 
 #ifdef WIN32
 #define LIBEXPORT __declspec(dllexport)
@@ -36,14 +43,100 @@
 #define LIBEXPORT __attribute__((visibility("default")))
 #endif
 
-std::vector<unsigned char> convertRGBAtoBGRA(std::vector<unsigned char> const &rgba);
-ImageData encodePng([[maybe_unused]] ImageData const &ddsData);
-ImageData decodePng(std::vector<unsigned char> const &png);
+/**
+ * Fields of the PNG IHDR chunk
+ */
+class PngHeader {
+public:
+    unsigned int width = 0;
+    unsigned int height = 0;
+    unsigned char bitDepth = 0;
+    unsigned char colorType = 0;
+    bool interlaced = false;
+};
+
+void *allocateContent(ContentAllocator allocator, void *userData, size_t size);
+DirectX::DDS_FLAGS getDDSFlags(bool dx10ext);
+ConvertStatus encodePng(DirectX::Image const &image, PngEncodeOptions const &options, PngOutput &output);
+ImageData decodePng(unsigned char const *png, size_t size);
+bool decodePng(unsigned char const *png, size_t size, ImageData &imageData);
+bool decodePng(unsigned char const *png, size_t size, unsigned char *pixels, size_t pixelsSize, size_t capacity,
+               ImageData &scratch);
+bool readPngHeader(unsigned char const *png, size_t size, unsigned int &width, unsigned int &height);
+bool readPngHeader(unsigned char const *png, size_t size, PngHeader &header);
+ConvertStatus generateMipChain(unsigned char const *png, size_t size, bool bgra, MipOptions const &mipOptions,
+                               ImageData &imageData, ScratchArena &arena, MipChain &mipChain);
+DirectX::TexMetadata getMipChainMetadata(size_t width, size_t height, bool bgra);
+ConvertStatus computeDDSSize(DirectX::TexMetadata const &metadata, bool dx10ext, size_t &size);
+ConvertStatus writeDDS(MipChain const &mipChain, bool dx10ext, void *output, size_t capacity);
+ConvertStatus loadDDS(void const *data, size_t size, DirectX::ScratchImage &image);
+ConvertStatus convertPNGtoDDSWithScratch(void const *data, size_t size, bool dx10ext, bool bgra,
+                                         ContentAllocator allocator, void *userData, ContentBuffer *output,
+                                         ImageData &imageData);
+ConvertStatus convertPNGtoDDSCompressedWithScratch(void const *data, size_t size, DDSEncodeOptions const *options,
+                                                   ContentAllocator allocator, void *userData, ContentBuffer *output,
+                                                   ImageData &imageData);
+bool isDDSEncodeFormat(DXGI_FORMAT format);
+bool useDX10Header(DDSEncodeOptions const &options);
+ConvertStatus buildDDSTexture(unsigned char const *png, size_t size, DDSEncodeOptions const &options,
+                              ImageData &imageData, ScratchArena &arena, MipChain &texture);
+ConvertStatus compressMipChain(MipChain const &mipChain, DXGI_FORMAT format, BCQuality quality, ScratchArena &arena,
+                               MipChain &compressed);
+ConvertStatus writeDDSContent(MipChain const &texture, bool dx10ext, ContentAllocator allocator, void *userData,
+                              ContentBuffer *output);
 extern "C" {
 [[maybe_unused]] LIBEXPORT Content convertDDStoPNG(unsigned int size, void * data);
 [[maybe_unused]] LIBEXPORT Content convertPNGtoDDS(unsigned int size, void * data, bool dx10ext, bool bgra);
+[[maybe_unused]] LIBEXPORT ConvertStatus convertDDStoPNGEx(void const *data, size_t size,
+                                                           PngEncodeOptions const *options, ContentAllocator allocator,
+                                                           void *userData, ContentBuffer *output);
+[[maybe_unused]] LIBEXPORT ConvertStatus convertPNGtoDDSEx(void const *data, size_t size, bool dx10ext, bool bgra,
+                                                           ContentAllocator allocator, void *userData,
+                                                           ContentBuffer *output);
+[[maybe_unused]] LIBEXPORT ConvertStatus convertPNGtoDDSCompressedEx(void const *data, size_t size,
+                                                                     DDSEncodeOptions const *options,
+                                                                     ContentAllocator allocator, void *userData,
+                                                                     ContentBuffer *output);
+[[maybe_unused]] LIBEXPORT ConvertStatus convertDDStoPNGInto(void const *data, size_t size,
+                                                             PngEncodeOptions const *options, void *output,
+                                                             size_t capacity, size_t *outputSize);
+[[maybe_unused]] LIBEXPORT ConvertStatus convertPNGtoDDSInto(void const *data, size_t size, bool dx10ext, bool bgra,
+                                                             void *output, size_t capacity, size_t *outputSize);
+[[maybe_unused]] LIBEXPORT ConvertStatus convertPNGtoDDSStreamEx(void const *data, size_t size, bool dx10ext, bool bgra,
+                                                                 ContentAllocator allocator, void *userData,
+                                                                 ContentBuffer *output);
+[[maybe_unused]] LIBEXPORT ConvertStatus convertPNGtoDDSStreamInto(void const *data, size_t size, bool dx10ext,
+                                                                   bool bgra, void *output, size_t capacity,
+                                                                   size_t *outputSize);
+[[maybe_unused]] LIBEXPORT void freeContentBuffer(ContentBuffer *content);
+[[maybe_unused]] LIBEXPORT void getPngEncodeOptions(PngEncodeProfile profile, PngEncodeOptions *options);
 }
 
+bool setErrorOutput(bool enabled);
+
+/**
+ * Enable or disable the error output of the current thread until the scope ends, then restore the previous setting. A
+ * nested scope can't turn the errors back on for the rest of the outer one.
+ */
+class ErrorOutputScope {
+public:
+    explicit ErrorOutputScope(bool const enabled) : previous(setErrorOutput(enabled)) {
+    }
+
+    ~ErrorOutputScope() {
+        setErrorOutput(previous);
+    }
+
+    ErrorOutputScope(ErrorOutputScope const &) = delete;
+
+    ErrorOutputScope &operator=(ErrorOutputScope const &) = delete;
+
+private:
+    bool previous;
+};
+
+void printError(char const *format, ...);
+
 #ifdef WIN32
 
 void printErrorDescription(HRESULT hr);
@@ -0,0 +1,230 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <DirectXTex.h>
+#include <DDS.h>
+#include "DDSExtract.h"
+#include "FileConvert.h"
+#include "FileIO.h"
+#include "MipGenerator.h"
+#include "ScratchArena.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+
+//magic, DDS_HEADER and DDS_HEADER_DXT10
+static constexpr size_t DDS_MAX_HEADER_SIZE = sizeof(uint32_t) + sizeof(DirectX::DDS_HEADER)
+                                              + sizeof(DirectX::DDS_HEADER_DXT10);
+
+/**
+ * Write a texture as a DDS file, the header and then each level in the order of the DDS layout, without assembling the
+ * file in memory
+ */
+static ConvertStatus writeDDSFile(MipChain const &texture, bool const dx10ext, char const *const path,
+                                  uint64_t &outputSize) {
+    StatsScope scope(STATS_STAGE_DDS_WRITE, texture.pixelsSize);
+    unsigned char header[DDS_MAX_HEADER_SIZE];
+    size_t headerSize = 0;
+    HRESULT hr = DirectX::EncodeDDSHeader(texture.metadata, getDDSFlags(dx10ext), header, sizeof(header), headerSize);
+    if (FAILED(hr)) {
+        printError("Error writing DDS header: ");
+        printErrorDescription(hr);
+        return scope.finish(CONVERT_ERROR_ENCODE, 0);
+    }
+
+    AtomicFile file;
+    bool written = file.open(path) && file.write(header, headerSize);
+    uint64_t size = headerSize;
+    for (size_t level = 0; written && level < texture.metadata.mipLevels; level++) {
+        DirectX::Image const &image = texture.images[level];
+        written = file.write(image.pixels, image.slicePitch);
+        size += image.slicePitch;
+    }
+    if (!written || !file.commit()) {
+        printError("Error writing %s\n", path);
+        return scope.finish(CONVERT_ERROR_IO, 0);
+    }
+
+    outputSize = size;
+    return scope.finish(CONVERT_OK, texture.pixelsSize);
+}
+
+/**
+ * Convert a PNG file to a DDS texture file. Sizes are 64-bit, the input is memory-mapped and the output written level
+ * by level to a temporary file renamed over 'outputPath' when complete, so a failed conversion never leaves a partial
+ * file. The DDS is never assembled in memory. The texture is the same as convertPNGtoDDSEx.
+ *
+ * @param inputPath The PNG image, UTF-8 encoded
+ * @param outputPath The DDS texture, UTF-8 encoded. Replaced if it exists.
+ * @param dx10ext Same as convertPNGtoDDS
+ * @param bgra Same as convertPNGtoDDS
+ * @param outputSize Receives the size of the DDS texture, may be nullptr
+ * @return CONVERT_OK on success, CONVERT_ERROR_IO when a file can't be read or written
+ */
+[[maybe_unused]] ConvertStatus convertPNGtoDDSFile(char const *const inputPath, char const *const outputPath,
+                                                   bool const dx10ext, bool const bgra, uint64_t *const outputSize) {
+    DDSEncodeOptions options{};
+    options.format = bgra ? DXGI_FORMAT_B8G8R8A8_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+    options.dx10ext = dx10ext;
+    return convertPNGtoDDSCompressedFile(inputPath, outputPath, &options, outputSize);
+}
+
+/**
+ * Same as convertPNGtoDDSFile, in the format of 'options' like convertPNGtoDDSCompressedEx
+ *
+ * @param inputPath The PNG image, UTF-8 encoded
+ * @param outputPath The DDS texture, UTF-8 encoded. Replaced if it exists.
+ * @param options Output format, quality and header
+ * @param outputSize Receives the size of the DDS texture, may be nullptr
+ * @return CONVERT_OK on success, CONVERT_ERROR_INVALID_ARGUMENT when the format is not supported
+ */
+[[maybe_unused]] ConvertStatus convertPNGtoDDSCompressedFile(char const *const inputPath, char const *const outputPath,
+                                                             DDSEncodeOptions const *const options,
+                                                             uint64_t *const outputSize) {
+    if (inputPath == nullptr || outputPath == nullptr || options == nullptr || !isDDSEncodeFormat(options->format)) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    MappedFile input;
+    if (!input.openRead(inputPath)) {
+        printError("Error reading %s\n", inputPath);
+        return CONVERT_ERROR_IO;
+    }
+
+    ArenaScope arena;
+    StatsScope scope(STATS_STAGE_PNG_TO_DDS, input.getSize());
+    MipChain texture;
+    ConvertStatus status = buildDDSTexture(input.getData(), input.getSize(), *options, arena.arena.getImageData(),
+                                           arena.arena, texture);
+    if (status != CONVERT_OK) {
+        return scope.finish(status, 0);
+    }
+
+    uint64_t size = 0;
+    status = writeDDSFile(texture, useDX10Header(*options), outputPath, size);
+    if (outputSize != nullptr) {
+        *outputSize = size;
+    }
+    return scope.finish(status, size);
+}
+
+/**
+ * Convert a DDS texture file to a PNG file. Sizes are 64-bit, the input is memory-mapped and the PNG is written to a
+ * temporary file as it is encoded, renamed over 'outputPath' when complete. The image is the same as convertDDStoPNGEx.
+ *
+ * @param inputPath The DDS texture, UTF-8 encoded
+ * @param outputPath The PNG image, UTF-8 encoded. Replaced if it exists.
+ * @param options PNG encoder settings, nullptr for PNG_PROFILE_BALANCED without content detection. Fields out of
+ *            range return CONVERT_ERROR_INVALID_ARGUMENT.
+ * @param outputSize Receives the size of the PNG, may be nullptr
+ * @return CONVERT_OK on success, CONVERT_ERROR_IO when a file can't be read or written
+ */
+[[maybe_unused]] ConvertStatus convertDDStoPNGFile(char const *const inputPath, char const *const outputPath,
+                                                   PngEncodeOptions const *const options, uint64_t *const outputSize) {
+    if (inputPath == nullptr || outputPath == nullptr || !isValidPngEncodeOptions(options)) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    MappedFile input;
+    if (!input.openRead(inputPath)) {
+        printError("Error reading %s\n", inputPath);
+        return CONVERT_ERROR_IO;
+    }
+
+    ArenaScope arena;
+    StatsScope scope(STATS_STAGE_DDS_TO_PNG, input.getSize());
+    DirectX::ScratchImage storage{};
+    DirectX::Image source{};
+    ConvertStatus status = loadDDSImage(input.getData(), input.getSize(), DDSSubresource{0, 0, 0}, storage, source);
+    if (status != CONVERT_OK) {
+        return scope.finish(status, 0);
+    }
+
+    AtomicFile file;
+    if (!file.open(outputPath)) {
+        printError("Error writing %s\n", outputPath);
+        return scope.finish(CONVERT_ERROR_IO, 0);
+    }
+    PngOutput png{};
+    png.file = file.getFile();
+    status = encodePng(source, resolvePngEncodeOptions(options, source), png);
+    if (status == CONVERT_OK && !file.commit()) {
+        printError("Error writing %s\n", outputPath);
+        status = CONVERT_ERROR_IO;
+    }
+    if (status != CONVERT_OK) {
+        return scope.finish(status, 0);
+    }
+
+    if (outputSize != nullptr) {
+        *outputSize = png.size;
+    }
+    return scope.finish(CONVERT_OK, png.size);
+}
+
+/**
+ * Convert many texture files in parallel on the shared work-stealing pool, like convertBatch. Each worker converts one
+ * file at a time with the functions above: the input is mapped and the output written to a temporary file, so neither
+ * file is copied in memory. The decoded image is still held: a PNG to DDS job holds its whole mip chain, a DDS to PNG
+ * job the image it encodes, decompressed when the texture is block compressed. Errors are not printed, each job
+ * reports its own status.
+ *
+ * @param jobs The conversions, 'outputSize' and 'status' of every job are written
+ * @param count Number of jobs
+ * @return CONVERT_OK when every job succeeded, otherwise the status of the first failed job
+ */
+[[maybe_unused]] ConvertStatus convertFiles(ConvertFileJob *const jobs, size_t const count) {
+    if (jobs == nullptr && count > 0) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    getThreadPool()->parallelFor(count, [jobs](size_t const index, [[maybe_unused]] size_t const worker) {
+        ErrorOutputScope const errors(false);
+        jobs[index].status = runConvertFileJob(jobs[index]);
+    });
+
+    for (size_t i = 0; i < count; i++) {
+        if (jobs[i].status != CONVERT_OK) {
+            return jobs[i].status;
+        }
+    }
+    return CONVERT_OK;
+}
+
+ConvertStatus runConvertFileJob(ConvertFileJob &job) {
+    job.outputSize = 0;
+
+    switch (job.direction) {
+        case CONVERT_PNG_TO_DDS:
+            if (job.ddsOptions != nullptr) {
+                return convertPNGtoDDSCompressedFile(job.inputPath, job.outputPath, job.ddsOptions, &job.outputSize);
+            }
+            return convertPNGtoDDSFile(job.inputPath, job.outputPath, job.dx10ext, job.bgra, &job.outputSize);
+        case CONVERT_DDS_TO_PNG:
+            return convertDDStoPNGFile(job.inputPath, job.outputPath, job.pngOptions, &job.outputSize);
+        default:
+            return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+}
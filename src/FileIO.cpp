@@ -0,0 +1,419 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <atomic>
+#include <cstring>
+#include <random>
+#include "FileIO.h"
+
+#ifdef _WIN32
+#include <cwchar>
+#include <io.h>
+#include <string>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef _WIN32
+
+static std::wstring toWide(char const *const text) {
+    int const length = MultiByteToWideChar(CP_UTF8, 0, text, -1, nullptr, 0);
+    if (length <= 0) {
+        return {};
+    }
+
+    std::wstring wide(static_cast<size_t>(length), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, text, -1, wide.data(), length);
+    wide.resize(static_cast<size_t>(length) - 1);
+    return wide;
+}
+
+static std::string toUtf8(wchar_t const *const text) {
+    int const length = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+    if (length <= 0) {
+        return {};
+    }
+
+    std::string utf8(static_cast<size_t>(length), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text, -1, utf8.data(), length, nullptr, nullptr);
+    utf8.resize(static_cast<size_t>(length) - 1);
+    return utf8;
+}
+
+std::FILE *openFile(char const *const path, char const *const mode) {
+    std::wstring const widePath = toWide(path);
+    std::wstring const wideMode = toWide(mode);
+    if (widePath.empty() || wideMode.empty()) {
+        return nullptr;
+    }
+
+    std::FILE *file = nullptr;
+    if (_wfopen_s(&file, widePath.c_str(), wideMode.c_str()) != 0) {
+        return nullptr;
+    }
+    return file;
+}
+
+bool syncFile(std::FILE *const file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+    auto const handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+    return handle != INVALID_HANDLE_VALUE && FlushFileBuffers(handle) != 0;
+}
+
+bool replaceFile(char const *const source, char const *const destination) {
+    std::wstring const wideSource = toWide(source);
+    std::wstring const wideDestination = toWide(destination);
+    return !wideSource.empty() && !wideDestination.empty()
+           && MoveFileExW(wideSource.c_str(), wideDestination.c_str(),
+                          MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+bool removeFile(char const *const path) {
+    std::wstring const widePath = toWide(path);
+    return !widePath.empty() && DeleteFileW(widePath.c_str()) != 0;
+}
+
+bool createDirectory(char const *const path) {
+    std::wstring const widePath = toWide(path);
+    return !widePath.empty()
+           && (CreateDirectoryW(widePath.c_str(), nullptr) != 0 || GetLastError() == ERROR_ALREADY_EXISTS);
+}
+
+bool listDirectory(char const *const path, std::vector<std::string> &names) {
+    std::wstring const widePath = toWide(path);
+    if (widePath.empty()) {
+        return false;
+    }
+    WIN32_FIND_DATAW data{};
+    HANDLE find = FindFirstFileW((widePath + L"\\*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    do {
+        if (std::wcscmp(data.cFileName, L".") != 0 && std::wcscmp(data.cFileName, L"..") != 0) {
+            names.push_back(toUtf8(data.cFileName));
+        }
+    } while (FindNextFileW(find, &data) != 0);
+    FindClose(find);
+    return true;
+}
+
+bool MappedFile::openRead(char const *const path) {
+    close();
+    std::wstring const widePath = toWide(path);
+    if (widePath.empty()) {
+        return false;
+    }
+    //shared delete, so other processes can still replace or delete the file
+    HANDLE handle = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    file = handle;
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart <= 0
+        || static_cast<unsigned long long>(fileSize.QuadPart) > SIZE_MAX) {
+        close();
+        return false;
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+    return map(false);
+}
+
+bool MappedFile::openShared(char const *const path, size_t const sharedSize) {
+    close();
+    std::wstring const widePath = toWide(path);
+    if (widePath.empty() || sharedSize == 0) {
+        return false;
+    }
+    HANDLE handle = CreateFileW(widePath.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    file = handle;
+    size = sharedSize;
+    //the mapping extends the file with zeros
+    return map(true);
+}
+
+bool MappedFile::map(bool const writable) {
+    auto const mappingSize = static_cast<unsigned long long>(size);
+    mapping = CreateFileMappingW(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                 static_cast<DWORD>(mappingSize >> 32), static_cast<DWORD>(mappingSize), nullptr);
+    if (mapping == nullptr) {
+        close();
+        return false;
+    }
+    data = static_cast<unsigned char *>(MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size));
+    if (data == nullptr) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+    }
+    if (file != nullptr) {
+        CloseHandle(file);
+    }
+    data = nullptr;
+    mapping = nullptr;
+    file = nullptr;
+    size = 0;
+}
+
+bool MappedFile::lock() {
+    OVERLAPPED overlapped{};
+    return file != nullptr && LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped) != 0;
+}
+
+void MappedFile::unlock() {
+    OVERLAPPED overlapped{};
+    UnlockFileEx(file, 0, MAXDWORD, MAXDWORD, &overlapped);
+}
+
+#else
+
+std::FILE *openFile(char const *const path, char const *const mode) {
+    return std::fopen(path, mode);
+}
+
+bool syncFile(std::FILE *const file) {
+    return std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+}
+
+bool replaceFile(char const *const source, char const *const destination) {
+    return std::rename(source, destination) == 0;
+}
+
+bool removeFile(char const *const path) {
+    return unlink(path) == 0;
+}
+
+bool createDirectory(char const *const path) {
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+bool listDirectory(char const *const path, std::vector<std::string> &names) {
+    DIR *dir = opendir(path);
+    if (dir == nullptr) {
+        return false;
+    }
+    while (dirent const *entry = readdir(dir)) {
+        if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0) {
+            names.emplace_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+    return true;
+}
+
+bool MappedFile::openRead(char const *const path) {
+    close();
+    file = open(path, O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat status{};
+    if (fstat(file, &status) != 0 || status.st_size <= 0
+        || static_cast<unsigned long long>(status.st_size) > SIZE_MAX) {
+        close();
+        return false;
+    }
+    size = static_cast<size_t>(status.st_size);
+    return map(false);
+}
+
+bool MappedFile::openShared(char const *const path, size_t const sharedSize) {
+    close();
+    file = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (file < 0 || sharedSize == 0) {
+        close();
+        return false;
+    }
+
+    //extended with zeros, only ever grows so concurrent openers agree
+    struct stat status{};
+    if (fstat(file, &status) != 0
+        || (static_cast<unsigned long long>(status.st_size) < sharedSize
+            && ftruncate(file, static_cast<off_t>(sharedSize)) != 0)) {
+        close();
+        return false;
+    }
+    size = sharedSize;
+    return map(true);
+}
+
+bool MappedFile::map(bool const writable) {
+    void *const mapped = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+    if (mapped == MAP_FAILED) {
+        close();
+        return false;
+    }
+    data = static_cast<unsigned char *>(mapped);
+    if (!writable) {
+        //same hint as FILE_FLAG_SEQUENTIAL_SCAN, larger read-ahead
+        posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (data != nullptr) {
+        munmap(data, size);
+    }
+    if (file >= 0) {
+        ::close(file);
+    }
+    data = nullptr;
+    file = -1;
+    size = 0;
+}
+
+bool MappedFile::lock() {
+    while (flock(file, LOCK_EX) != 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MappedFile::unlock() {
+    flock(file, LOCK_UN);
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool readFilePrefix(char const *const path, void *const buffer, size_t const capacity, size_t &size) {
+    size = 0;
+    std::FILE *file = openFile(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    //unbuffered, a single read of 'capacity' bytes
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    size = std::fread(buffer, 1, capacity, file);
+    bool const failed = std::ferror(file) != 0;
+    std::fclose(file);
+    return !failed;
+}
+
+//buffer of AtomicFile, large enough that the small writes of the PNG encoder are batched
+static constexpr size_t ATOMIC_FILE_BUFFER_SIZE = 1024 * 1024;
+
+AtomicFile::~AtomicFile() {
+    discard();
+}
+
+bool AtomicFile::open(char const *const destination) {
+    discard();
+
+    //unique in every process and thread
+    static uint64_t const processNonce = (static_cast<uint64_t>(std::random_device{}()) << 32)
+                                         ^ std::random_device{}();
+    static std::atomic<uint64_t> temporaryCount{0};
+    path = destination;
+    temporaryPath = path + "." + std::to_string(processNonce) + "." + std::to_string(temporaryCount.fetch_add(1))
+                    + ".tmp";
+    file = openFile(temporaryPath.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::setvbuf(file, nullptr, _IOFBF, ATOMIC_FILE_BUFFER_SIZE);
+    return true;
+}
+
+bool AtomicFile::write(void const *const data, size_t const size) {
+    if (file == nullptr || std::fwrite(data, 1, size, file) != size) {
+        failed = true;
+    }
+    return !failed;
+}
+
+bool AtomicFile::sync() {
+    if (file == nullptr) {
+        return synced;
+    }
+    //the bytes are on the disk before the rename makes them visible under 'path'
+    bool const written = !failed && std::ferror(file) == 0 && syncFile(file);
+    bool const closed = std::fclose(file) == 0;
+    file = nullptr;
+    synced = written && closed;
+    if (!synced) {
+        removeFile(temporaryPath.c_str());
+    }
+    return synced;
+}
+
+bool AtomicFile::commit() {
+    if (!sync()) {
+        return false;
+    }
+    synced = false;
+    if (!replaceFile(temporaryPath.c_str(), path.c_str())) {
+        removeFile(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void AtomicFile::discard() {
+    if (file != nullptr) {
+        std::fclose(file);
+        file = nullptr;
+        removeFile(temporaryPath.c_str());
+    } else if (synced) {
+        removeFile(temporaryPath.c_str());
+    }
+    failed = false;
+    synced = false;
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Open a file with fopen semantics
+ *
+ * @param path The path, UTF-8 encoded
+ * @param mode The fopen mode
+ * @return The file, nullptr on failure
+ */
+std::FILE *openFile(char const *path, char const *mode);
+
+/**
+ * Read the beginning of a file
+ *
+ * @param path The path, UTF-8 encoded
+ * @param buffer Receives the bytes
+ * @param capacity The size(in bytes) of buffer
+ * @param size Receives the number of bytes read, lower than capacity when the file is smaller
+ * @return False if the file can't be opened or read
+ */
+bool readFilePrefix(char const *path, void *buffer, size_t capacity, size_t &size);
+
+/**
+ * Write the buffered bytes of a file and flush them to the disk, a rename after it never replaces a file with an empty
+ * or partial one after a crash
+ *
+ * @return False if the bytes can't be written
+ */
+bool syncFile(std::FILE *file);
+
+/**
+ * Replace 'destination' with 'source' atomically, readers see either file but never a partial one
+ *
+ * @param source The new file, UTF-8 encoded
+ * @param destination The path it is renamed to, replaced if it exists
+ * @return False if the file can't be renamed
+ */
+bool replaceFile(char const *source, char const *destination);
+
+/**
+ * Delete a file
+ *
+ * @param path The path, UTF-8 encoded
+ * @return False if the file can't be deleted. On Windows a mapped file can't be deleted.
+ */
+bool removeFile(char const *path);
+
+/**
+ * Create a directory, the parent must exist
+ *
+ * @param path The path, UTF-8 encoded
+ * @return True if the directory was created or already exists
+ */
+bool createDirectory(char const *path);
+
+/**
+ * List the names of the files and directories in a directory, without "." and ".."
+ *
+ * @param path The path, UTF-8 encoded
+ * @param names Receives the names, UTF-8 encoded, in no particular order
+ * @return False if the directory can't be read
+ */
+bool listDirectory(char const *path, std::vector<std::string> &names);
+
+/**
+ * A file mapped in memory, read-only or shared read-write between processes
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    MappedFile(MappedFile const &) = delete;
+
+    MappedFile &operator=(MappedFile const &) = delete;
+
+    /**
+     * Map a whole file read-only
+     *
+     * @param path The path, UTF-8 encoded
+     * @return False if the file can't be opened or is empty
+     */
+    bool openRead(char const *path);
+
+    /**
+     * Map the first 'size' bytes of a file read-write, changes are seen by every process mapping it. The file is
+     * created or extended with zeros when smaller.
+     *
+     * @param path The path, UTF-8 encoded
+     * @param size Bytes mapped
+     * @return False if the file can't be opened or extended
+     */
+    bool openShared(char const *path, size_t size);
+
+    void close();
+
+    /**
+     * Exclusive lock of the whole file, between processes. Blocks until it is acquired. Threads of one process don't
+     * exclude each other.
+     */
+    bool lock();
+
+    void unlock();
+
+    [[nodiscard]] unsigned char *getData() const {
+        return data;
+    }
+
+    [[nodiscard]] size_t getSize() const {
+        return size;
+    }
+
+private:
+    bool map(bool writable);
+
+    unsigned char *data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#else
+    int file = -1;
+#endif
+};
+
+/**
+ * A file written under a unique temporary name next to its destination and renamed over it by commit, readers see
+ * either the previous file or the complete new one. The temporary file is deleted when the writer is discarded or
+ * destroyed without commit, a crashed process leaves it behind.
+ */
+class AtomicFile {
+public:
+    AtomicFile() = default;
+
+    ~AtomicFile();
+
+    AtomicFile(AtomicFile const &) = delete;
+
+    AtomicFile &operator=(AtomicFile const &) = delete;
+
+    /**
+     * Create the temporary file of 'path'
+     *
+     * @param path The destination, UTF-8 encoded
+     * @return False if the temporary file can't be created
+     */
+    bool open(char const *path);
+
+    /**
+     * Append to the file
+     *
+     * @return False if the bytes can't be written, commit then fails
+     */
+    bool write(void const *data, size_t size);
+
+    /**
+     * Flush the temporary file to the disk and close it, the slow part of commit. Callers that rename under a lock sync
+     * before taking it.
+     *
+     * @return False if any write failed, the temporary file is deleted and commit fails
+     */
+    bool sync();
+
+    /**
+     * Rename the temporary file to the destination, after syncing it when sync was not called
+     *
+     * @return False if any write failed or the file can't be renamed, the temporary file is deleted
+     */
+    bool commit();
+
+    /**
+     * Close and delete the temporary file
+     */
+    void discard();
+
+    /**
+     * @return The temporary file, for writers that need a FILE. Its write errors are detected by commit.
+     */
+    [[nodiscard]] std::FILE *getFile() const {
+        return file;
+    }
+
+private:
+    std::string path;
+    std::string temporaryPath;
+    std::FILE *file = nullptr;
+    bool failed = false;
+    //closed by sync, the temporary file waits for commit
+    bool synced = false;
+};
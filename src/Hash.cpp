@@ -0,0 +1,150 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstring>
+#include "CpuFeatures.h"
+#include "Hash.h"
+
+static constexpr uint64_t PRIME32_2 = 0x85EBCA77u;
+static constexpr uint64_t PRIME32_3 = 0xC2B2AE3Du;
+static constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87u;
+static constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4Fu;
+static constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9u;
+static constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63u;
+static constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5u;
+
+static inline uint64_t readWord(unsigned char const *const data) {
+    //the hash is defined on little endian words, as on every target of the library
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+static inline void accumulateStripe(uint64_t *const accumulators, unsigned char const *const data,
+                                    uint64_t const *const secret) {
+    for (size_t i = 0; i < HASH_STRIPE_WORDS; i++) {
+        uint64_t const word = readWord(data + i * 8);
+        uint64_t const keyed = word ^ secret[i];
+        accumulators[i ^ 1] += word;
+        accumulators[i] += (keyed & 0xFFFFFFFFu) * (keyed >> 32);
+    }
+}
+
+static inline void scramble(uint64_t *const accumulators) {
+    uint64_t const *const secret = HASH_SECRET.words + HASH_BLOCK_STRIPES;
+    for (size_t i = 0; i < HASH_STRIPE_WORDS; i++) {
+        uint64_t accumulator = accumulators[i];
+        accumulator ^= accumulator >> 47;
+        accumulator ^= secret[i];
+        accumulators[i] = accumulator * HASH_PRIME32_1;
+    }
+}
+
+void hashBlocksScalar(uint64_t *const accumulators, unsigned char const *const data, size_t const blocks) {
+    for (size_t block = 0; block < blocks; block++) {
+        for (size_t stripe = 0; stripe < HASH_BLOCK_STRIPES; stripe++) {
+            accumulateStripe(accumulators, data + block * HASH_BLOCK_SIZE + stripe * HASH_STRIPE_SIZE,
+                             HASH_SECRET.words + stripe);
+        }
+        scramble(accumulators);
+    }
+}
+
+static HashKernels selectHashKernels() {
+#ifdef DXTWRAPPER_X86
+    if (getCpuFeatures().avx2) {
+        return {"avx2", hashBlocksAvx2};
+    }
+#endif
+    return {"scalar", hashBlocksScalar};
+}
+
+//selected during static initialization, when the library is loaded
+static HashKernels const hashKernels = selectHashKernels();
+
+HashKernels const &getHashKernels() {
+    return hashKernels;
+}
+
+/**
+ * Fold the 128-bit product of a and b to 64 bits
+ */
+static uint64_t multiplyFold(uint64_t const a, uint64_t const b) {
+    uint64_t const aLow = a & 0xFFFFFFFFu;
+    uint64_t const aHigh = a >> 32;
+    uint64_t const bLow = b & 0xFFFFFFFFu;
+    uint64_t const bHigh = b >> 32;
+    uint64_t const lowLow = aLow * bLow;
+    uint64_t const highLow = aHigh * bLow;
+    uint64_t const lowHigh = aLow * bHigh;
+    uint64_t const highHigh = aHigh * bHigh;
+    uint64_t const cross = (lowLow >> 32) + (highLow & 0xFFFFFFFFu) + lowHigh;
+    uint64_t const high = highHigh + (highLow >> 32) + (cross >> 32);
+    uint64_t const low = (cross << 32) | (lowLow & 0xFFFFFFFFu);
+    return low ^ high;
+}
+
+static uint64_t avalanche(uint64_t hash) {
+    hash ^= hash >> 37;
+    hash *= 0x165667919E3779F9u;
+    return hash ^ (hash >> 32);
+}
+
+static uint64_t mergeAccumulators(uint64_t const *const accumulators, size_t const secretOffset, uint64_t start) {
+    for (size_t i = 0; i < HASH_STRIPE_WORDS; i += 2) {
+        start += multiplyFold(accumulators[i] ^ HASH_SECRET.words[secretOffset + i],
+                              accumulators[i + 1] ^ HASH_SECRET.words[secretOffset + i + 1]);
+    }
+    return avalanche(start);
+}
+
+Hash128 hashBytes(void const *const data, size_t const size) {
+    uint64_t accumulators[HASH_STRIPE_WORDS] = {PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3,
+                                                PRIME64_4, PRIME32_2, PRIME64_5, HASH_PRIME32_1};
+    auto const *bytes = static_cast<unsigned char const *>(data);
+    size_t const blocks = size / HASH_BLOCK_SIZE;
+    hashKernels.hashBlocks(accumulators, bytes, blocks);
+
+    //stripes of the last partial block, then the last 64 bytes of the input cover the remainder
+    size_t offset = blocks * HASH_BLOCK_SIZE;
+    size_t stripe = 0;
+    for (; offset + HASH_STRIPE_SIZE <= size; offset += HASH_STRIPE_SIZE, stripe++) {
+        accumulateStripe(accumulators, bytes + offset, HASH_SECRET.words + stripe);
+    }
+    if (offset < size) {
+        unsigned char last[HASH_STRIPE_SIZE] = {};
+        if (size >= HASH_STRIPE_SIZE) {
+            std::memcpy(last, bytes + size - HASH_STRIPE_SIZE, HASH_STRIPE_SIZE);
+        } else {
+            std::memcpy(last, bytes, size);
+        }
+        accumulateStripe(accumulators, last, HASH_SECRET.words + HASH_BLOCK_STRIPES - 1);
+    }
+
+    auto const length = static_cast<uint64_t>(size);
+    return {mergeAccumulators(accumulators, 3, length * PRIME64_1),
+            mergeAccumulators(accumulators, 11, ~(length * PRIME64_2))};
+}
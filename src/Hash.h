@@ -0,0 +1,104 @@
+#pragma once
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+//64-bit words read by each stripe, and stripes accumulated between scrambles
+constexpr size_t HASH_STRIPE_WORDS = 8;
+constexpr size_t HASH_STRIPE_SIZE = HASH_STRIPE_WORDS * 8;
+constexpr size_t HASH_BLOCK_STRIPES = 16;
+constexpr size_t HASH_BLOCK_SIZE = HASH_STRIPE_SIZE * HASH_BLOCK_STRIPES;
+//stripe s of a block is keyed with words [s, s + 8) of the secret, the scramble with the last 8 words
+constexpr size_t HASH_SECRET_WORDS = HASH_BLOCK_STRIPES + HASH_STRIPE_WORDS;
+constexpr uint64_t HASH_PRIME32_1 = 0x9E3779B1u;
+
+class HashSecret {
+public:
+    uint64_t words[HASH_SECRET_WORDS];
+};
+
+/**
+ * Secret words of the hash, from splitmix64. Part of the cache keys written to disk, never change them.
+ */
+constexpr HashSecret makeHashSecret() {
+    HashSecret secret{};
+    uint64_t state = 0x243F6A8885A308D3u;
+    for (uint64_t &word: secret.words) {
+        state += 0x9E3779B97F4A7C15u;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+        word = z ^ (z >> 31);
+    }
+    return secret;
+}
+
+inline constexpr HashSecret HASH_SECRET = makeHashSecret();
+
+class Hash128 {
+public:
+    uint64_t low;
+    uint64_t high;
+
+    bool operator==(Hash128 const &other) const {
+        return low == other.low && high == other.high;
+    }
+};
+
+/**
+ * Accumulate 'blocks' blocks of HASH_BLOCK_SIZE bytes, each followed by a scramble of the accumulators
+ *
+ * @param accumulators The 8 accumulators
+ * @param data The blocks
+ * @param blocks Number of blocks
+ */
+typedef void (*HashBlocksKernel)(uint64_t *accumulators, unsigned char const *data, size_t blocks);
+
+class HashKernels {
+public:
+    char const *name;
+    HashBlocksKernel hashBlocks;
+};
+
+/**
+ * Kernels selected for this CPU when the library was loaded
+ */
+HashKernels const &getHashKernels();
+
+/**
+ * 128-bit non-cryptographic hash, in the style of XXH3: 8 lanes of 64-bit accumulators fed by 32x32 bit products of
+ * the input keyed with a secret. Every kernel produces the same value, so hashes can be shared between machines.
+ *
+ * @param data The bytes
+ * @param size The size(in bytes) of data
+ * @return The hash
+ */
+Hash128 hashBytes(void const *data, size_t size);
+
+void hashBlocksScalar(uint64_t *accumulators, unsigned char const *data, size_t blocks);
+void hashBlocksAvx2(uint64_t *accumulators, unsigned char const *data, size_t blocks);
@@ -0,0 +1,75 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include "CpuFeatures.h"
+#include "Hash.h"
+
+#ifdef DXTWRAPPER_X86
+
+#include <immintrin.h>
+
+/**
+ * Same as the scalar kernel, 4 accumulators per register. The 64-bit words swap places inside each 128-bit lane.
+ */
+void hashBlocksAvx2(uint64_t *const accumulators, unsigned char const *const data, size_t const blocks) {
+    auto *const out = reinterpret_cast<__m256i *>(accumulators);
+    __m256i low = _mm256_loadu_si256(out);
+    __m256i high = _mm256_loadu_si256(out + 1);
+    auto const *const secret = reinterpret_cast<unsigned char const *>(HASH_SECRET.words);
+    __m256i const prime = _mm256_set1_epi64x(static_cast<long long>(HASH_PRIME32_1));
+    auto const *const scrambleKeys = reinterpret_cast<__m256i const *>(secret + HASH_BLOCK_STRIPES * 8);
+    __m256i const scrambleLow = _mm256_loadu_si256(scrambleKeys);
+    __m256i const scrambleHigh = _mm256_loadu_si256(scrambleKeys + 1);
+
+    for (size_t block = 0; block < blocks; block++) {
+        unsigned char const *const blockData = data + block * HASH_BLOCK_SIZE;
+        for (size_t stripe = 0; stripe < HASH_BLOCK_STRIPES; stripe++) {
+            auto const *const words = reinterpret_cast<__m256i const *>(blockData + stripe * HASH_STRIPE_SIZE);
+            auto const *const keys = reinterpret_cast<__m256i const *>(secret + stripe * 8);
+            __m256i const wordsLow = _mm256_loadu_si256(words);
+            __m256i const wordsHigh = _mm256_loadu_si256(words + 1);
+            __m256i const keyedLow = _mm256_xor_si256(wordsLow, _mm256_loadu_si256(keys));
+            __m256i const keyedHigh = _mm256_xor_si256(wordsHigh, _mm256_loadu_si256(keys + 1));
+            __m256i const productLow = _mm256_mul_epu32(keyedLow, _mm256_srli_epi64(keyedLow, 32));
+            __m256i const productHigh = _mm256_mul_epu32(keyedHigh, _mm256_srli_epi64(keyedHigh, 32));
+            low = _mm256_add_epi64(low, _mm256_add_epi64(_mm256_shuffle_epi32(wordsLow, 0x4E), productLow));
+            high = _mm256_add_epi64(high, _mm256_add_epi64(_mm256_shuffle_epi32(wordsHigh, 0x4E), productHigh));
+        }
+
+        //accumulator * prime, with the prime below 2^32
+        low = _mm256_xor_si256(_mm256_xor_si256(low, _mm256_srli_epi64(low, 47)), scrambleLow);
+        high = _mm256_xor_si256(_mm256_xor_si256(high, _mm256_srli_epi64(high, 47)), scrambleHigh);
+        low = _mm256_add_epi64(_mm256_mul_epu32(low, prime),
+                               _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(low, 32), prime), 32));
+        high = _mm256_add_epi64(_mm256_mul_epu32(high, prime),
+                                _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(high, 32), prime), 32));
+    }
+
+    _mm256_storeu_si256(out, low);
+    _mm256_storeu_si256(out + 1, high);
+}
+
+#endif
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstring>
 #include <vector>
 
 class ImageData {
@@ -29,6 +30,10 @@ public:
         return const_cast<std::vector<unsigned char> &>(pixels);
     }
 
+    [[nodiscard]] std::vector<unsigned char> &getPixels() {
+        return pixels;
+    }
+
     void setPixels(void *src, unsigned long long const &size) {
         pixels.resize(size);
         std::memcpy(pixels.data(), src, size);
@@ -0,0 +1,535 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include "Inflate.h"
+
+//bits indexing the first-level tables, longer codes continue in subtables
+static constexpr unsigned int LITLEN_TABLE_BITS = 11;
+static constexpr unsigned int DISTANCE_TABLE_BITS = 8;
+static constexpr unsigned int PRECODE_TABLE_BITS = 7;
+//most entries needed by a table with its subtables, for codes of up to 15 bits
+static constexpr size_t LITLEN_TABLE_SIZE = 2342;
+static constexpr size_t DISTANCE_TABLE_SIZE = 402;
+static constexpr size_t PRECODE_TABLE_SIZE = size_t{1} << PRECODE_TABLE_BITS;
+
+static constexpr unsigned int MAX_CODE_LENGTH = 15;
+static constexpr size_t LITLEN_SYMBOLS = 288;
+static constexpr size_t DISTANCE_SYMBOLS = 32;
+static constexpr size_t PRECODE_SYMBOLS = 19;
+
+static constexpr uint16_t LENGTH_BASE[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67,
+                                           83, 99, 115, 131, 163, 195, 227, 258};
+static constexpr uint8_t LENGTH_EXTRA[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5,
+                                           5, 5, 0};
+static constexpr uint16_t DISTANCE_BASE[] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+                                             769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static constexpr uint8_t DISTANCE_EXTRA[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+                                             11, 11, 12, 12, 13, 13};
+//order of the code lengths of the precode in a dynamic block header
+static constexpr uint8_t PRECODE_ORDER[] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+enum EntryKind : uint8_t {
+    //a length or distance base, or a precode symbol. The low bits are the extra bits that follow the code.
+    ENTRY_BASE = 0x00,
+    //the rest of the code is in the subtable at 'value', the low bits are the bits indexing it
+    ENTRY_SUBTABLE = 0x20,
+    ENTRY_END_OF_BLOCK = 0x40,
+    //a code not assigned to any symbol
+    ENTRY_INVALID = 0x60,
+    ENTRY_LITERAL = 0x80,
+};
+
+static constexpr uint8_t ENTRY_KIND_MASK = 0xe0;
+static constexpr uint8_t ENTRY_BITS_MASK = 0x1f;
+
+/**
+ * Entry of a decode table, indexed by the next bits of the stream
+ */
+class HuffmanEntry {
+public:
+    uint16_t value;
+    //bits of the code, consumed when the entry is found
+    uint8_t length;
+    uint8_t kind;
+};
+
+/**
+ * Reads the stream LSB first from a 64-bit buffer, refilled 8 bytes at a time. Bytes past the end of the input read
+ * as zeros and are counted, a stream that consumes them is truncated.
+ */
+class BitReader {
+public:
+    BitReader(unsigned char const *const input, size_t const size) : next(input), end(input + size) {
+    }
+
+    /**
+     * At least 56 bits are buffered after a refill, enough for a length and a distance with their extra bits
+     */
+    inline void refill() {
+        if (end - next >= 8) {
+            uint64_t word;
+            std::memcpy(&word, next, sizeof(word));
+            //the bits of the partial byte past 'count' are set again by the next refill, with the same values
+            buffer |= word << count;
+            next += (63 - count) >> 3;
+            count |= 56;
+            return;
+        }
+        while (count < 56) {
+            uint64_t byte = 0;
+            if (next < end) {
+                byte = *next++;
+            } else {
+                overrun++;
+            }
+            buffer |= byte << count;
+            count += 8;
+        }
+    }
+
+    [[nodiscard]] inline uint32_t peek(unsigned int const bits) const {
+        return static_cast<uint32_t>(buffer & ((uint64_t{1} << bits) - 1));
+    }
+
+    inline void consume(unsigned int const bits) {
+        buffer >>= bits;
+        count -= bits;
+    }
+
+    inline uint32_t take(unsigned int const bits) {
+        uint32_t const value = peek(bits);
+        consume(bits);
+        return value;
+    }
+
+    inline HuffmanEntry decode(HuffmanEntry const *const table, unsigned int const tableBits) {
+        HuffmanEntry entry = table[peek(tableBits)];
+        if ((entry.kind & ENTRY_KIND_MASK) == ENTRY_SUBTABLE) {
+            consume(tableBits);
+            entry = table[entry.value + peek(entry.kind & ENTRY_BITS_MASK)];
+        }
+        consume(entry.length);
+        return entry;
+    }
+
+    /**
+     * Drop the bits up to the next byte and return the whole buffered bytes to the input, for a stored block
+     */
+    void alignToByte() {
+        consume(count & 7);
+        size_t const buffered = count >> 3;
+        if (buffered >= overrun) {
+            next -= buffered - overrun;
+            overrun = 0;
+        } else {
+            overrun -= buffered;
+        }
+        buffer = 0;
+        count = 0;
+    }
+
+    /**
+     * True when bits past the end of the input were consumed
+     */
+    [[nodiscard]] bool isOverrun() const {
+        return overrun * 8 > count;
+    }
+
+    unsigned char const *next;
+    unsigned char const *end;
+
+private:
+    uint64_t buffer = 0;
+    unsigned int count = 0;
+    size_t overrun = 0;
+};
+
+static unsigned int reverseBits(unsigned int code, unsigned int const length) {
+    unsigned int reversed = 0;
+    for (unsigned int i = 0; i < length; i++) {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    return reversed;
+}
+
+/**
+ * Build the decode table of a canonical Huffman code. Codes longer than tableBits continue in subtables placed after
+ * the first-level table. Incomplete codes are accepted, the unassigned codes decode as ENTRY_INVALID.
+ *
+ * @param lengths Code length of each symbol, 0 for symbols not used
+ * @param symbols Entry of each symbol, without its length
+ * @return False if the code is oversubscribed or the table needs more than tableSize entries
+ */
+static bool buildTable(uint8_t const *const lengths, size_t const symbolCount, HuffmanEntry const *const symbols,
+                       unsigned int const tableBits, HuffmanEntry *const table, size_t const tableSize) {
+    unsigned int count[MAX_CODE_LENGTH + 1] = {};
+    for (size_t s = 0; s < symbolCount; s++) {
+        count[lengths[s]]++;
+    }
+    int left = 1;
+    unsigned int maxLength = 0;
+    for (unsigned int length = 1; length <= MAX_CODE_LENGTH; length++) {
+        left = (left << 1) - static_cast<int>(count[length]);
+        if (left < 0) {
+            return false;
+        }
+        if (count[length] != 0) {
+            maxLength = length;
+        }
+    }
+
+    //symbols by code length then value, the order of their canonical codes
+    uint16_t offsets[MAX_CODE_LENGTH + 1] = {};
+    for (unsigned int length = 1; length < MAX_CODE_LENGTH; length++) {
+        offsets[length + 1] = static_cast<uint16_t>(offsets[length] + count[length]);
+    }
+    uint16_t sorted[LITLEN_SYMBOLS];
+    for (size_t s = 0; s < symbolCount; s++) {
+        if (lengths[s] != 0) {
+            sorted[offsets[lengths[s]]++] = static_cast<uint16_t>(s);
+        }
+    }
+
+    HuffmanEntry const invalid{0, 0, ENTRY_INVALID};
+    size_t const mainSize = size_t{1} << tableBits;
+    std::fill(table, table + mainSize, invalid);
+    size_t next = mainSize;
+    size_t subtable = 0;
+    unsigned int subtableBits = 0;
+    unsigned int prefix = ~0u;
+    unsigned int code = 0;
+    size_t sortedIndex = 0;
+    for (unsigned int length = 1; length <= maxLength; length++, code <<= 1) {
+        for (; count[length] != 0; count[length]--, code++) {
+            HuffmanEntry entry = symbols[sorted[sortedIndex++]];
+            unsigned int const reversed = reverseBits(code, length);
+            if (length <= tableBits) {
+                entry.length = static_cast<uint8_t>(length);
+                for (size_t i = reversed; i < mainSize; i += size_t{1} << length) {
+                    table[i] = entry;
+                }
+                continue;
+            }
+
+            //codes sharing the first tableBits bits are consecutive, the first one opens their subtable. It is as
+            //large as the codes not placed yet can fill.
+            unsigned int const low = reversed & static_cast<unsigned int>(mainSize - 1);
+            if (low != prefix) {
+                subtableBits = length - tableBits;
+                int remaining = 1 << subtableBits;
+                while (tableBits + subtableBits < maxLength) {
+                    remaining -= static_cast<int>(count[tableBits + subtableBits]);
+                    if (remaining <= 0) {
+                        break;
+                    }
+                    subtableBits++;
+                    remaining <<= 1;
+                }
+                if (next + (size_t{1} << subtableBits) > tableSize) {
+                    return false;
+                }
+                subtable = next;
+                next += size_t{1} << subtableBits;
+                prefix = low;
+                std::fill(table + subtable, table + next, invalid);
+                table[low] = HuffmanEntry{static_cast<uint16_t>(subtable), static_cast<uint8_t>(tableBits),
+                                          static_cast<uint8_t>(ENTRY_SUBTABLE | subtableBits)};
+            }
+            entry.length = static_cast<uint8_t>(length - tableBits);
+            for (size_t i = reversed >> tableBits; i < size_t{1} << subtableBits; i += size_t{1} << entry.length) {
+                table[subtable + i] = entry;
+            }
+        }
+    }
+    return true;
+}
+
+class SymbolTables {
+public:
+    HuffmanEntry litlen[LITLEN_SYMBOLS];
+    HuffmanEntry distance[DISTANCE_SYMBOLS];
+    HuffmanEntry precode[PRECODE_SYMBOLS];
+    //decode tables of the blocks compressed with the fixed codes
+    HuffmanEntry fixedLitlen[LITLEN_TABLE_SIZE];
+    HuffmanEntry fixedDistance[DISTANCE_TABLE_SIZE];
+};
+
+static SymbolTables createSymbolTables() {
+    SymbolTables tables{};
+    for (size_t s = 0; s < LITLEN_SYMBOLS; s++) {
+        if (s < 256) {
+            tables.litlen[s] = HuffmanEntry{static_cast<uint16_t>(s), 0, ENTRY_LITERAL};
+        } else if (s == 256) {
+            tables.litlen[s] = HuffmanEntry{0, 0, ENTRY_END_OF_BLOCK};
+        } else if (s - 257 < std::size(LENGTH_BASE)) {
+            tables.litlen[s] = HuffmanEntry{LENGTH_BASE[s - 257], 0, LENGTH_EXTRA[s - 257]};
+        } else {
+            tables.litlen[s] = HuffmanEntry{0, 0, ENTRY_INVALID};
+        }
+    }
+    for (size_t s = 0; s < DISTANCE_SYMBOLS; s++) {
+        tables.distance[s] = s < std::size(DISTANCE_BASE) ? HuffmanEntry{DISTANCE_BASE[s], 0, DISTANCE_EXTRA[s]}
+                                                          : HuffmanEntry{0, 0, ENTRY_INVALID};
+    }
+    for (size_t s = 0; s < PRECODE_SYMBOLS; s++) {
+        tables.precode[s] = HuffmanEntry{static_cast<uint16_t>(s), 0, ENTRY_BASE};
+    }
+
+    uint8_t lengths[LITLEN_SYMBOLS];
+    std::fill(lengths, lengths + 144, 8);
+    std::fill(lengths + 144, lengths + 256, 9);
+    std::fill(lengths + 256, lengths + 280, 7);
+    std::fill(lengths + 280, lengths + LITLEN_SYMBOLS, 8);
+    buildTable(lengths, LITLEN_SYMBOLS, tables.litlen, LITLEN_TABLE_BITS, tables.fixedLitlen, LITLEN_TABLE_SIZE);
+    std::fill(lengths, lengths + DISTANCE_SYMBOLS, 5);
+    buildTable(lengths, DISTANCE_SYMBOLS, tables.distance, DISTANCE_TABLE_BITS, tables.fixedDistance,
+               DISTANCE_TABLE_SIZE);
+    return tables;
+}
+
+static SymbolTables const &getSymbolTables() {
+    static SymbolTables const tables = createSymbolTables();
+    return tables;
+}
+
+static bool readDynamicTables(BitReader &reader, HuffmanEntry *const litlen, HuffmanEntry *const distance) {
+    SymbolTables const &symbols = getSymbolTables();
+    reader.refill();
+    size_t const litlenCount = reader.take(5) + 257;
+    size_t const distanceCount = reader.take(5) + 1;
+    size_t const precodeCount = reader.take(4) + 4;
+    if (litlenCount > 286 || distanceCount > 30) {
+        return false;
+    }
+
+    uint8_t precodeLengths[PRECODE_SYMBOLS] = {};
+    for (size_t i = 0; i < precodeCount; i++) {
+        reader.refill();
+        precodeLengths[PRECODE_ORDER[i]] = static_cast<uint8_t>(reader.take(3));
+    }
+    HuffmanEntry precode[PRECODE_TABLE_SIZE];
+    if (!buildTable(precodeLengths, PRECODE_SYMBOLS, symbols.precode, PRECODE_TABLE_BITS, precode,
+                    PRECODE_TABLE_SIZE)) {
+        return false;
+    }
+
+    //the lengths of both codes are one sequence, a repeat may cross from one to the other
+    uint8_t lengths[LITLEN_SYMBOLS + DISTANCE_SYMBOLS];
+    size_t const total = litlenCount + distanceCount;
+    for (size_t i = 0; i < total;) {
+        reader.refill();
+        HuffmanEntry const entry = reader.decode(precode, PRECODE_TABLE_BITS);
+        if (entry.kind != ENTRY_BASE) {
+            return false;
+        }
+        if (entry.value < 16) {
+            lengths[i++] = static_cast<uint8_t>(entry.value);
+            continue;
+        }
+        uint8_t value = 0;
+        size_t repeat;
+        if (entry.value == 16) {
+            if (i == 0) {
+                return false;
+            }
+            value = lengths[i - 1];
+            repeat = 3 + reader.take(2);
+        } else if (entry.value == 17) {
+            repeat = 3 + reader.take(3);
+        } else {
+            repeat = 11 + reader.take(7);
+        }
+        if (repeat > total - i) {
+            return false;
+        }
+        std::memset(lengths + i, value, repeat);
+        i += repeat;
+    }
+    if (lengths[256] == 0) {
+        return false;
+    }
+
+    return buildTable(lengths, litlenCount, symbols.litlen, LITLEN_TABLE_BITS, litlen, LITLEN_TABLE_SIZE)
+           && buildTable(lengths + litlenCount, distanceCount, symbols.distance, DISTANCE_TABLE_BITS, distance,
+                         DISTANCE_TABLE_SIZE);
+}
+
+static bool copyStoredBlock(BitReader &reader, unsigned char *&out, unsigned char *const end) {
+    reader.alignToByte();
+    if (reader.isOverrun() || reader.end - reader.next < 4) {
+        return false;
+    }
+    size_t const length = reader.next[0] | (reader.next[1] << 8);
+    size_t const complement = reader.next[2] | (reader.next[3] << 8);
+    reader.next += 4;
+    if ((length ^ 0xffff) != complement || length > static_cast<size_t>(reader.end - reader.next)
+        || length > static_cast<size_t>(end - out)) {
+        return false;
+    }
+    std::memcpy(out, reader.next, length);
+    reader.next += length;
+    out += length;
+    return true;
+}
+
+/**
+ * Copy a match that fits in the output. When 16 bytes past its end are in the output too, it is copied 8 or 16 bytes
+ * at a time, the bytes written past the end are overwritten by the next symbols.
+ */
+static inline void copyMatch(unsigned char *&out, size_t const distance, size_t const length,
+                             unsigned char *const end) {
+    unsigned char *dst = out;
+    unsigned char const *src = out - distance;
+    unsigned char *const stop = out + length;
+    out = stop;
+    if (end - stop < 16) {
+        while (dst < stop) {
+            *dst++ = *src++;
+        }
+        return;
+    }
+
+    if (distance >= 16) {
+        do {
+            unsigned char chunk[16];
+            std::memcpy(chunk, src, 16);
+            std::memcpy(dst, chunk, 16);
+            dst += 16;
+            src += 16;
+        } while (dst < stop);
+        return;
+    }
+    if (distance == 1) {
+        std::memset(dst, *src, length);
+        return;
+    }
+
+    //the output repeats with the period of the distance, copied from a multiple of it of 8 bytes or more, the first
+    //bytes one at a time until that far
+    size_t period = distance;
+    while (period < 8) {
+        period <<= 1;
+    }
+    unsigned char *const wide = dst + std::min(length, period - distance);
+    while (dst < wide) {
+        *dst++ = *src++;
+    }
+    src = dst - period;
+    while (dst < stop) {
+        uint64_t chunk;
+        std::memcpy(&chunk, src, sizeof(chunk));
+        std::memcpy(dst, &chunk, sizeof(chunk));
+        dst += 8;
+        src += 8;
+    }
+}
+
+static bool decodeBlock(BitReader &reader, HuffmanEntry const *const litlen, HuffmanEntry const *const distance,
+                        unsigned char const *const start, unsigned char *&output, unsigned char *const end) {
+    unsigned char *out = output;
+    for (;;) {
+        reader.refill();
+        HuffmanEntry const entry = reader.decode(litlen, LITLEN_TABLE_BITS);
+        if (entry.kind == ENTRY_LITERAL) {
+            if (out == end) {
+                return false;
+            }
+            *out++ = static_cast<unsigned char>(entry.value);
+
+            //at least 41 bits are left, enough for another literal but not for a match
+            HuffmanEntry const next = litlen[reader.peek(LITLEN_TABLE_BITS)];
+            if (next.kind == ENTRY_LITERAL) {
+                reader.consume(next.length);
+                if (out == end) {
+                    return false;
+                }
+                *out++ = static_cast<unsigned char>(next.value);
+            }
+            continue;
+        }
+        if ((entry.kind & ENTRY_KIND_MASK) != ENTRY_BASE) {
+            output = out;
+            return entry.kind == ENTRY_END_OF_BLOCK;
+        }
+
+        size_t const length = entry.value + reader.take(entry.kind & ENTRY_BITS_MASK);
+        HuffmanEntry const distanceEntry = reader.decode(distance, DISTANCE_TABLE_BITS);
+        if ((distanceEntry.kind & ENTRY_KIND_MASK) != ENTRY_BASE) {
+            return false;
+        }
+        size_t const matchDistance = distanceEntry.value + reader.take(distanceEntry.kind & ENTRY_BITS_MASK);
+        if (matchDistance > static_cast<size_t>(out - start) || length > static_cast<size_t>(end - out)) {
+            return false;
+        }
+        copyMatch(out, matchDistance, length, end);
+    }
+}
+
+bool inflateZlib(unsigned char const *const input, size_t const inputSize, unsigned char *const output,
+                 size_t const outputSize) {
+    if (inputSize < 2) {
+        return false;
+    }
+    unsigned int const method = input[0];
+    unsigned int const flags = input[1];
+    //deflate with a window up to 32KB, no preset dictionary
+    if ((method & 0x0f) != 8 || (method >> 4) > 7 || (method * 256 + flags) % 31 != 0 || (flags & 0x20) != 0) {
+        return false;
+    }
+
+    SymbolTables const &symbols = getSymbolTables();
+    HuffmanEntry litlen[LITLEN_TABLE_SIZE];
+    HuffmanEntry distance[DISTANCE_TABLE_SIZE];
+    BitReader reader(input + 2, inputSize - 2);
+    unsigned char *out = output;
+    unsigned char *const end = output + outputSize;
+    bool last = false;
+    while (!last) {
+        reader.refill();
+        last = reader.take(1) != 0;
+        unsigned int const type = reader.take(2);
+        bool decoded;
+        if (type == 0) {
+            decoded = copyStoredBlock(reader, out, end);
+        } else if (type == 1) {
+            decoded = decodeBlock(reader, symbols.fixedLitlen, symbols.fixedDistance, output, out, end);
+        } else if (type == 2) {
+            decoded = readDynamicTables(reader, litlen, distance)
+                      && decodeBlock(reader, litlen, distance, output, out, end);
+        } else {
+            decoded = false;
+        }
+        if (!decoded || reader.isOverrun()) {
+            return false;
+        }
+    }
+    return out == end;
+}
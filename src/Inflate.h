@@ -0,0 +1,42 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+
+/**
+ * Decompress a complete zlib stream whose decompressed size is known, in one call. The output buffer is the window,
+ * so no other memory is used, and matches are copied 8 or 16 bytes at a time. The Adler-32 checksum is not verified,
+ * the stream must come from a trusted source.
+ *
+ * @param input The zlib stream
+ * @param inputSize The size(in bytes) of input
+ * @param output Receives the decompressed bytes
+ * @param outputSize The size(in bytes) of output, the exact decompressed size
+ * @return False if the stream is invalid, truncated or doesn't decompress to exactly outputSize bytes
+ */
+bool inflateZlib(unsigned char const *input, size_t inputSize, unsigned char *output, size_t outputSize);
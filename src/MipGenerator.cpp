@@ -0,0 +1,519 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <vector>
+#include "CpuFeatures.h"
+#include "MipGenerator.h"
+#include "ScratchArena.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+
+static constexpr size_t BYTES_PER_PIXEL = 4;
+//levels produced from each tile of the box filter pass, the tile is 2^BOX_TILE_LEVELS pixels wide and tall
+static constexpr size_t BOX_TILE_LEVELS = 6;
+static constexpr size_t BOX_TILE_SIZE = size_t{1} << BOX_TILE_LEVELS;
+//output pixels of each tile of the resampling filters, the source of a tile fits in the L2 cache
+static constexpr size_t FILTER_TILE_WIDTH = 64;
+static constexpr size_t FILTER_TILE_HEIGHT = 32;
+//support of the Kaiser window, in output pixels, and its shape
+static constexpr double KAISER_WIDTH = 3.0;
+static constexpr double KAISER_ALPHA = 4.0;
+
+void reduceBoxScalar(unsigned char const *const row0, unsigned char const *const row1, unsigned char *const out,
+                     size_t const count) {
+    for (size_t i = 0; i < count * BYTES_PER_PIXEL; i++) {
+        size_t const s = i + (i & ~size_t{3});
+        out[i] = static_cast<unsigned char>((row0[s] + row0[s + 4] + row1[s] + row1[s + 4] + 2) >> 2);
+    }
+}
+
+void filterColumnsScalar(float const *const source, size_t const pitch, float const *const weights, size_t const taps,
+                         float *const out, size_t const count) {
+    for (size_t i = 0; i < count; i++) {
+        float sum = 0.0f;
+        for (size_t k = 0; k < taps; k++) {
+            sum += weights[k] * source[k * pitch + i];
+        }
+        out[i] = sum;
+    }
+}
+
+void filterRowScalar(float const *const source, unsigned int const *const first, float const *const weights,
+                     size_t const taps, float *const out, size_t const count) {
+    for (size_t x = 0; x < count; x++) {
+        float const *pixels = source + first[x] * BYTES_PER_PIXEL;
+        float const *w = weights + x * taps;
+        for (size_t c = 0; c < BYTES_PER_PIXEL; c++) {
+            float sum = 0.0f;
+            for (size_t k = 0; k < taps; k++) {
+                sum += w[k] * pixels[k * BYTES_PER_PIXEL + c];
+            }
+            out[x * BYTES_PER_PIXEL + c] = sum;
+        }
+    }
+}
+
+static MipKernels selectMipKernels() {
+#ifdef DXTWRAPPER_X86
+    CpuFeatures const &cpu = getCpuFeatures();
+    if (cpu.avx2) {
+        return {"avx2", reduceBoxAvx2, filterColumnsAvx2, filterRowAvx2};
+    }
+    if (cpu.ssse3) {
+        return {"ssse3", reduceBoxSsse3, filterColumnsSsse3, filterRowSsse3};
+    }
+#endif
+    return {"scalar", reduceBoxScalar, filterColumnsScalar, filterRowScalar};
+}
+
+//selected during static initialization, when the library is loaded
+static MipKernels const mipKernels = selectMipKernels();
+
+MipKernels const &getMipKernels() {
+    return mipKernels;
+}
+
+void reduceMipBox(DirectX::Image const &source, DirectX::Image const &destination, size_t const x0, size_t const x1,
+                  size_t const y0, size_t const y1) {
+    for (size_t y = y0; y < y1; y++) {
+        size_t const firstRow = std::min(2 * y, source.height - 1);
+        size_t const lastRow = y + 1 == destination.height ? source.height : std::min(2 * y + 2, source.height);
+        unsigned char *out = destination.pixels + y * destination.rowPitch;
+
+        size_t x = x0;
+        if (lastRow - firstRow == 2 && source.width >= 2) {
+            //2x2 box for every pixel except the last one of an odd row
+            unsigned char const *row0 = source.pixels + firstRow * source.rowPitch;
+            size_t const boxEnd = source.width % 2 == 0 || x1 < destination.width ? x1 : x1 - 1;
+            if (boxEnd > x) {
+                mipKernels.reduceBox(row0 + 2 * x * BYTES_PER_PIXEL, row0 + source.rowPitch + 2 * x * BYTES_PER_PIXEL,
+                                     out + x * BYTES_PER_PIXEL, boxEnd - x);
+                x = boxEnd;
+            }
+        }
+
+        //generic average, used for the edges of odd dimensions and for 1 pixel wide or tall levels
+        for (; x < x1; x++) {
+            size_t const firstColumn = std::min(2 * x, source.width - 1);
+            size_t const lastColumn = x + 1 == destination.width ? source.width : std::min(2 * x + 2, source.width);
+            unsigned int const count = static_cast<unsigned int>((lastRow - firstRow) * (lastColumn - firstColumn));
+            for (size_t c = 0; c < BYTES_PER_PIXEL; c++) {
+                unsigned int sum = 0;
+                for (size_t row = firstRow; row < lastRow; row++) {
+                    unsigned char const *pixels = source.pixels + row * source.rowPitch;
+                    for (size_t column = firstColumn; column < lastColumn; column++) {
+                        sum += pixels[column * BYTES_PER_PIXEL + c];
+                    }
+                }
+                out[x * BYTES_PER_PIXEL + c] = static_cast<unsigned char>((sum + count / 2) / count);
+            }
+        }
+    }
+}
+
+static void runTasks(size_t const taskCount, std::function<void(size_t, size_t)> const &task) {
+    if (taskCount == 1) {
+        task(0, 0);
+    } else {
+        getThreadPool()->parallelFor(taskCount, task);
+    }
+}
+
+/**
+ * Box filter levels baseLevel + 1 to lastLevel in one pass. Each tile of the base level is reduced down to lastLevel
+ * while it is in cache, tiles start at multiples of BOX_TILE_SIZE so they never share a pixel of the lower levels. The
+ * last tile of a row or column also takes the remainder, so the odd rows and columns it folds are inside the tile.
+ */
+static void generateBoxLevels(MipChain &mipChain, size_t const baseLevel, size_t const lastLevel) {
+    DirectX::Image const &base = mipChain.images[baseLevel];
+    size_t const tilesX = std::max<size_t>(base.width / BOX_TILE_SIZE, 1);
+    size_t const tilesY = std::max<size_t>(base.height / BOX_TILE_SIZE, 1);
+
+    runTasks(tilesX * tilesY, [&](size_t const task, [[maybe_unused]] size_t const worker) {
+        size_t const tileX = task % tilesX;
+        size_t const tileY = task / tilesX;
+        bool const lastX = tileX + 1 == tilesX;
+        bool const lastY = tileY + 1 == tilesY;
+        for (size_t level = baseLevel + 1; level <= lastLevel; level++) {
+            size_t const shift = level - baseLevel;
+            DirectX::Image const &destination = mipChain.images[level];
+            size_t const x0 = (tileX * BOX_TILE_SIZE) >> shift;
+            size_t const y0 = (tileY * BOX_TILE_SIZE) >> shift;
+            size_t const x1 = lastX ? destination.width : ((tileX + 1) * BOX_TILE_SIZE) >> shift;
+            size_t const y1 = lastY ? destination.height : ((tileY + 1) * BOX_TILE_SIZE) >> shift;
+            reduceMipBox(mipChain.images[level - 1], destination, x0, x1, y0, y1);
+        }
+    });
+}
+
+static double besselI0(double const x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32 && term > sum * 1e-12; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static double getFilterSupport(MipFilter const filter) {
+    switch (filter) {
+        case MIP_FILTER_TRIANGLE:
+            return 1.0;
+        case MIP_FILTER_KAISER:
+            return KAISER_WIDTH;
+        case MIP_FILTER_BOX:
+        default:
+            return 0.5;
+    }
+}
+
+/**
+ * Weight of a source pixel at distance t from the center of the output pixel, in output pixels
+ */
+static double evaluateFilter(MipFilter const filter, double const t) {
+    double const d = std::abs(t);
+    switch (filter) {
+        case MIP_FILTER_TRIANGLE:
+            return std::max(1.0 - d, 0.0);
+        case MIP_FILTER_KAISER: {
+            if (d >= KAISER_WIDTH) {
+                return 0.0;
+            }
+            double const pi = 3.14159265358979323846;
+            double const sinc = d < 1e-9 ? 1.0 : std::sin(pi * d) / (pi * d);
+            double const r = d / KAISER_WIDTH;
+            return sinc * besselI0(KAISER_ALPHA * std::sqrt(1.0 - r * r)) / besselI0(KAISER_ALPHA);
+        }
+        case MIP_FILTER_BOX:
+        default:
+            return 1.0;
+    }
+}
+
+/**
+ * Resampling weights of one axis. Every output pixel reads 'taps' consecutive source pixels starting at 'first', pixels
+ * past the edges are clamped, their weight is added to the edge pixel.
+ */
+class FilterAxis {
+public:
+    size_t taps = 0;
+    std::vector<unsigned int> first;
+    std::vector<float> weights;
+};
+
+static FilterAxis buildFilterAxis(size_t const sourceSize, size_t const destinationSize, MipFilter const filter) {
+    double const scale = static_cast<double>(sourceSize) / static_cast<double>(destinationSize);
+    double const support = getFilterSupport(filter) * scale;
+
+    FilterAxis axis;
+    axis.taps = std::min(static_cast<size_t>(std::ceil(2.0 * support)), sourceSize);
+    axis.first.resize(destinationSize);
+    axis.weights.assign(destinationSize * axis.taps, 0.0f);
+
+    auto const maxFirst = static_cast<long long>(sourceSize - axis.taps);
+    std::vector<double> weights(axis.taps);
+    for (size_t x = 0; x < destinationSize; x++) {
+        //pixel centers are at i + 0.5, only the pixels strictly inside the support contribute
+        double const center = (static_cast<double>(x) + 0.5) * scale;
+        auto const start = static_cast<long long>(std::ceil(center - support - 0.5));
+        auto const first = std::clamp(start, 0LL, maxFirst);
+        std::fill(weights.begin(), weights.end(), 0.0);
+        double total = 0.0;
+        for (long long i = start; static_cast<double>(i) + 0.5 < center + support; i++) {
+            double const distance = static_cast<double>(i) + 0.5 - center;
+            if (std::abs(distance) >= support) {
+                continue;
+            }
+            double const w = evaluateFilter(filter, distance / scale);
+            auto const clamped = std::clamp(i, 0LL, static_cast<long long>(sourceSize) - 1);
+            weights[static_cast<size_t>(clamped - first)] += w;
+            total += w;
+        }
+        axis.first[x] = static_cast<unsigned int>(first);
+        for (size_t k = 0; k < axis.taps; k++) {
+            axis.weights[x * axis.taps + k] = static_cast<float>(weights[k] / total);
+        }
+    }
+    return axis;
+}
+
+/**
+ * Conversion between 8-bit channels and floats, the color channels of sRGB content are converted to linear light.
+ * Alpha is always linear.
+ */
+class ChannelCodec {
+public:
+    explicit ChannelCodec(bool const srgb) : srgb(srgb) {
+        for (size_t i = 0; i < 256; i++) {
+            double const v = static_cast<double>(i) / 255.0;
+            toFloat[i] = static_cast<float>(v);
+            toLinear[i] = static_cast<float>(srgb ? decodeSrgb(v) : v);
+        }
+        //the linear value of the midpoint between two sRGB codes, encoding counts the midpoints below the value
+        for (size_t i = 0; i < 255; i++) {
+            srgbThresholds[i] = static_cast<float>(decodeSrgb((static_cast<double>(i) + 0.5) / 255.0));
+        }
+        //code of the start of each bucket, buckets are narrower than the gap between two thresholds
+        for (size_t i = 0; i < SRGB_BUCKETS; i++) {
+            float const v = static_cast<float>(i) / static_cast<float>(SRGB_BUCKETS);
+            srgbBuckets[i] = static_cast<unsigned char>(
+                    std::lower_bound(srgbThresholds, srgbThresholds + 255, v) - srgbThresholds);
+        }
+    }
+
+    void decodeRow(unsigned char const *const pixels, float *const out, size_t const count) const {
+        for (size_t i = 0; i < count * BYTES_PER_PIXEL; i += BYTES_PER_PIXEL) {
+            out[i] = toLinear[pixels[i]];
+            out[i + 1] = toLinear[pixels[i + 1]];
+            out[i + 2] = toLinear[pixels[i + 2]];
+            out[i + 3] = toFloat[pixels[i + 3]];
+        }
+    }
+
+    void encodeRow(float const *const values, unsigned char *const out, size_t const count) const {
+        for (size_t i = 0; i < count * BYTES_PER_PIXEL; i++) {
+            out[i] = srgb && i % BYTES_PER_PIXEL != 3 ? encodeSrgb(values[i]) : encodeLinear(values[i]);
+        }
+    }
+
+private:
+    static double decodeSrgb(double const v) {
+        return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+    }
+
+    static unsigned char encodeLinear(float const v) {
+        return static_cast<unsigned char>(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    unsigned char encodeSrgb(float const v) const {
+        float const clamped = std::clamp(v, 0.0f, 1.0f);
+        size_t code = srgbBuckets[std::min(static_cast<size_t>(clamped * SRGB_BUCKETS), SRGB_BUCKETS - 1)];
+        while (code < 255 && srgbThresholds[code] < clamped) {
+            code++;
+        }
+        return static_cast<unsigned char>(code);
+    }
+
+    static constexpr size_t SRGB_BUCKETS = 8192;
+
+    bool srgb;
+    float toFloat[256]{};
+    float toLinear[256]{};
+    float srgbThresholds[255]{};
+    unsigned char srgbBuckets[SRGB_BUCKETS]{};
+};
+
+/**
+ * Resample 'source' into 'destination' with separable filters, tile by tile. Each tile converts the source pixels it
+ * reads to floats once, filters them vertically one output row at a time and then horizontally.
+ */
+static ConvertStatus filterLevel(DirectX::Image const &source, DirectX::Image const &destination,
+                                 MipFilter const filter, ChannelCodec const &codec) {
+    FilterAxis const columns = buildFilterAxis(source.width, destination.width, filter);
+    FilterAxis const rows = buildFilterAxis(source.height, destination.height, filter);
+    size_t const tilesX = (destination.width + FILTER_TILE_WIDTH - 1) / FILTER_TILE_WIDTH;
+    size_t const tilesY = (destination.height + FILTER_TILE_HEIGHT - 1) / FILTER_TILE_HEIGHT;
+
+    //set by the first tile that can't get its buffers, the tiles still to start are skipped
+    std::atomic<bool> outOfMemory{false};
+    runTasks(tilesX * tilesY, [&](size_t const task, [[maybe_unused]] size_t const worker) {
+        if (outOfMemory.load(std::memory_order_relaxed)) {
+            return;
+        }
+        size_t const x0 = (task % tilesX) * FILTER_TILE_WIDTH;
+        size_t const y0 = (task / tilesX) * FILTER_TILE_HEIGHT;
+        size_t const x1 = std::min(x0 + FILTER_TILE_WIDTH, destination.width);
+        size_t const y1 = std::min(y0 + FILTER_TILE_HEIGHT, destination.height);
+        size_t const c0 = columns.first[x0];
+        size_t const c1 = columns.first[x1 - 1] + columns.taps;
+        size_t const r0 = rows.first[y0];
+        size_t const r1 = rows.first[y1 - 1] + rows.taps;
+        size_t const pitch = (c1 - c0) * BYTES_PER_PIXEL;
+
+        //tile buffers from the arena of the worker, released when the tile ends
+        ArenaFrame frame;
+        auto *const pixels = frame.arena.allocateArray<float>((r1 - r0) * pitch);
+        auto *const first = frame.arena.allocateArray<unsigned int>(x1 - x0);
+        auto *const filtered = frame.arena.allocateArray<float>(pitch);
+        auto *const out = frame.arena.allocateArray<float>((x1 - x0) * BYTES_PER_PIXEL);
+        if (pixels == nullptr || first == nullptr || filtered == nullptr || out == nullptr) {
+            outOfMemory.store(true, std::memory_order_relaxed);
+            return;
+        }
+
+        for (size_t r = r0; r < r1; r++) {
+            codec.decodeRow(source.pixels + r * source.rowPitch + c0 * BYTES_PER_PIXEL, &pixels[(r - r0) * pitch],
+                            c1 - c0);
+        }
+        for (size_t x = x0; x < x1; x++) {
+            first[x - x0] = static_cast<unsigned int>(columns.first[x] - c0);
+        }
+
+        for (size_t y = y0; y < y1; y++) {
+            mipKernels.filterColumns(&pixels[(rows.first[y] - r0) * pitch], pitch, &rows.weights[y * rows.taps],
+                                     rows.taps, filtered, pitch);
+            mipKernels.filterRow(filtered, first, &columns.weights[x0 * columns.taps], columns.taps, out, x1 - x0);
+            codec.encodeRow(out, destination.pixels + y * destination.rowPitch + x0 * BYTES_PER_PIXEL, x1 - x0);
+        }
+    });
+    return outOfMemory.load() ? CONVERT_ERROR_OUT_OF_MEMORY : CONVERT_OK;
+}
+
+static void getAlphaHistogram(DirectX::Image const &image, size_t *const histogram) {
+    std::fill(histogram, histogram + 256, size_t{0});
+    for (size_t y = 0; y < image.height; y++) {
+        unsigned char const *row = image.pixels + y * image.rowPitch;
+        for (size_t x = 0; x < image.width; x++) {
+            histogram[row[x * BYTES_PER_PIXEL + 3]]++;
+        }
+    }
+}
+
+/**
+ * Scale the alpha of 'image' so the fraction of pixels with alpha >= reference is the nearest possible to 'coverage'.
+ * The scale maps the alpha threshold that gives that fraction to the reference, found on the alpha histogram.
+ */
+static void scaleAlphaCoverage(DirectX::Image const &image, unsigned char const reference, double const coverage) {
+    size_t histogram[256];
+    getAlphaHistogram(image, histogram);
+    double const target = coverage * static_cast<double>(image.width * image.height);
+
+    //pixels with alpha >= threshold, for every threshold from 255 down to 1
+    size_t threshold = reference;
+    double bestError = -1.0;
+    size_t passing = 0;
+    for (size_t t = 255; t >= 1; t--) {
+        passing += histogram[t];
+        double const error = std::abs(static_cast<double>(passing) - target);
+        if (bestError < 0.0 || error < bestError) {
+            bestError = error;
+            threshold = t;
+        }
+    }
+    if (threshold == reference) {
+        return;
+    }
+
+    //alpha rounds to >= reference exactly from the threshold up
+    double const scale = (reference - 0.5) / (static_cast<double>(threshold) - 0.5);
+    unsigned char scaled[256];
+    for (size_t a = 0; a < 256; a++) {
+        scaled[a] = static_cast<unsigned char>(std::min(static_cast<double>(a) * scale + 0.5, 255.0));
+    }
+    for (size_t y = 0; y < image.height; y++) {
+        unsigned char *row = image.pixels + y * image.rowPitch;
+        for (size_t x = 0; x < image.width; x++) {
+            row[x * BYTES_PER_PIXEL + 3] = scaled[row[x * BYTES_PER_PIXEL + 3]];
+        }
+    }
+}
+
+ConvertStatus initMipChain(DirectX::TexMetadata const &metadata, ScratchArena &arena, MipChain &chain) {
+    if (metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 || metadata.depth != 1
+        || metadata.mipLevels == 0 || metadata.mipLevels > MAX_MIP_LEVELS) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    chain = MipChain{};
+    chain.metadata = metadata;
+    size_t width = metadata.width;
+    size_t height = metadata.height;
+    for (size_t level = 0; level < metadata.mipLevels; level++) {
+        DirectX::Image &image = chain.images[level];
+        HRESULT hr = DirectX::ComputePitch(metadata.format, width, height, image.rowPitch, image.slicePitch,
+                                           DirectX::CP_FLAGS_NONE);
+        if (FAILED(hr) || image.slicePitch > SIZE_MAX - chain.pixelsSize) {
+            return CONVERT_ERROR_INVALID_ARGUMENT;
+        }
+        image.width = width;
+        image.height = height;
+        image.format = metadata.format;
+        chain.pixelsSize += image.slicePitch;
+        width = std::max<size_t>(width / 2, 1);
+        height = std::max<size_t>(height / 2, 1);
+    }
+
+    chain.pixels = static_cast<uint8_t *>(arena.allocate(chain.pixelsSize));
+    if (chain.pixels == nullptr) {
+        return CONVERT_ERROR_OUT_OF_MEMORY;
+    }
+    uint8_t *pixels = chain.pixels;
+    for (size_t level = 0; level < metadata.mipLevels; level++) {
+        chain.images[level].pixels = pixels;
+        pixels += chain.images[level].slicePitch;
+    }
+    return CONVERT_OK;
+}
+
+ConvertStatus generateMipLevels(MipChain &mipChain, MipOptions const &options) {
+    DirectX::TexMetadata const &metadata = mipChain.metadata;
+    if (metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 || metadata.depth != 1
+        || DirectX::BitsPerPixel(metadata.format) != 32 || DirectX::IsCompressed(metadata.format)
+        || (DirectX::MakeTypeless(metadata.format) != DXGI_FORMAT_R8G8B8A8_TYPELESS
+            && DirectX::MakeTypeless(metadata.format) != DXGI_FORMAT_B8G8R8A8_TYPELESS)) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    size_t const baseSize = mipChain.images[0].slicePitch;
+    StatsScope scope(STATS_STAGE_MIP_GENERATION, baseSize);
+    size_t const levels = metadata.mipLevels;
+    if (options.filter == MIP_FILTER_BOX && !options.srgb) {
+        //integer box filter, BOX_TILE_LEVELS levels per pass
+        for (size_t level = 0; level + 1 < levels; level += BOX_TILE_LEVELS) {
+            generateBoxLevels(mipChain, level, std::min(level + BOX_TILE_LEVELS, levels - 1));
+        }
+    } else {
+        ChannelCodec const codec(options.srgb);
+        for (size_t level = 1; level < levels; level++) {
+            ConvertStatus const status = filterLevel(mipChain.images[level - 1], mipChain.images[level],
+                                                     options.filter, codec);
+            if (status != CONVERT_OK) {
+                return scope.finish(status, 0);
+            }
+        }
+    }
+
+    //every level is filtered from the unscaled alpha of the level above, then scaled on its own
+    if (options.alphaCoverageReference != 0 && levels > 1) {
+        DirectX::Image const &base = mipChain.images[0];
+        size_t histogram[256];
+        getAlphaHistogram(base, histogram);
+        size_t passing = 0;
+        for (size_t a = options.alphaCoverageReference; a < 256; a++) {
+            passing += histogram[a];
+        }
+        double const coverage = static_cast<double>(passing) / static_cast<double>(base.width * base.height);
+        for (size_t level = 1; level < levels; level++) {
+            scaleAlphaCoverage(mipChain.images[level], options.alphaCoverageReference, coverage);
+        }
+    }
+    return scope.finish(CONVERT_OK, mipChain.pixelsSize - baseSize);
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+#include <DirectXTex.h>
+#include "ConvertStatus.h"
+#include "DDSEncodeOptions.h"
+
+class ScratchArena;
+
+//levels of the largest texture, 2^31 pixels on a side
+constexpr size_t MAX_MIP_LEVELS = 32;
+
+/**
+ * A 2D texture with its mip levels in one buffer, in the order of the DDS layout. The pixels belong to the arena that
+ * initialized the chain.
+ */
+class MipChain {
+public:
+    DirectX::TexMetadata metadata{};
+    DirectX::Image images[MAX_MIP_LEVELS]{};
+    uint8_t *pixels = nullptr;
+    size_t pixelsSize = 0;
+};
+
+/**
+ * 2x2 box reduction of pixel pairs of two rows, out[i] is the rounded average of pixels 2i and 2i + 1 of both rows
+ *
+ * @param row0 First row, 8-bit RGBA, 2 * count pixels
+ * @param row1 Second row
+ * @param out Receives count pixels
+ * @param count Number of output pixels
+ */
+typedef void (*MipBoxKernel)(unsigned char const *row0, unsigned char const *row1, unsigned char *out, size_t count);
+
+/**
+ * Vertical pass of the resampling filters, out[i] is the sum of weights[k] * source[k * pitch + i] for k < taps
+ *
+ * @param source First row, float RGBA
+ * @param pitch Distance between rows, in floats
+ * @param weights Weight of each row
+ * @param taps Number of rows
+ * @param out Receives count floats
+ * @param count Number of floats
+ */
+typedef void (*MipColumnKernel)(float const *source, size_t pitch, float const *weights, size_t taps, float *out,
+                                size_t count);
+
+/**
+ * Horizontal pass of the resampling filters, output pixel x is the sum of weights[x * taps + k] * pixel first[x] + k
+ * of source, for k < taps
+ *
+ * @param source The row, float RGBA
+ * @param first First source pixel of each output pixel
+ * @param weights Weights of each output pixel
+ * @param taps Number of source pixels of every output pixel
+ * @param out Receives count pixels, float RGBA
+ * @param count Number of output pixels
+ */
+typedef void (*MipRowKernel)(float const *source, unsigned int const *first, float const *weights, size_t taps,
+                             float *out, size_t count);
+
+class MipKernels {
+public:
+    char const *name;
+    MipBoxKernel reduceBox;
+    MipColumnKernel filterColumns;
+    MipRowKernel filterRow;
+};
+
+/**
+ * Kernels selected for this CPU when the library was loaded
+ */
+MipKernels const &getMipKernels();
+
+/**
+ * Allocate the levels of a 2D texture from 'arena', like ScratchImage::Initialize2D with a single item
+ *
+ * @param metadata Size, format and number of levels of the texture
+ * @param arena Arena of the conversion
+ * @param chain Receives the levels
+ * @return CONVERT_OK on success, CONVERT_ERROR_INVALID_ARGUMENT for textures that are not 2D or have more than one
+ *            item, CONVERT_ERROR_OUT_OF_MEMORY when the arena can't allocate the pixels
+ */
+ConvertStatus initMipChain(DirectX::TexMetadata const &metadata, ScratchArena &arena, MipChain &chain);
+
+/**
+ * Generate the mip levels of an 8-bit RGBA or BGRA texture. The first level must be filled, the other levels are
+ * overwritten. The box filter produces several levels from each tile of the first level in a single pass, the other
+ * filters (and sRGB) resample each level from the previous one, tile by tile. Tiles are processed in parallel on the
+ * shared thread pool.
+ *
+ * @param mipChain The texture, a single 2D image with its full mip chain
+ * @param options Filter, color space and alpha coverage
+ * @return CONVERT_OK on success, CONVERT_ERROR_INVALID_ARGUMENT if the texture is not supported,
+ *         CONVERT_ERROR_OUT_OF_MEMORY if the buffers of a filter tile can't be allocated
+ */
+ConvertStatus generateMipLevels(MipChain &mipChain, MipOptions const &options);
+
+/**
+ * 2x2 box reduction of the rectangle [x0, x1) x [y0, y1) of 'destination', the level after 'source'. The last row and
+ * column of a level also cover the odd row and column left at the end of the source level.
+ */
+void reduceMipBox(DirectX::Image const &source, DirectX::Image const &destination, size_t x0, size_t x1, size_t y0,
+                  size_t y1);
+
+void reduceBoxScalar(unsigned char const *row0, unsigned char const *row1, unsigned char *out, size_t count);
+void filterColumnsScalar(float const *source, size_t pitch, float const *weights, size_t taps, float *out,
+                         size_t count);
+void filterRowScalar(float const *source, unsigned int const *first, float const *weights, size_t taps, float *out,
+                     size_t count);
+
+void reduceBoxSsse3(unsigned char const *row0, unsigned char const *row1, unsigned char *out, size_t count);
+void filterColumnsSsse3(float const *source, size_t pitch, float const *weights, size_t taps, float *out,
+                        size_t count);
+void filterRowSsse3(float const *source, unsigned int const *first, float const *weights, size_t taps, float *out,
+                    size_t count);
+
+void reduceBoxAvx2(unsigned char const *row0, unsigned char const *row1, unsigned char *out, size_t count);
+void filterColumnsAvx2(float const *source, size_t pitch, float const *weights, size_t taps, float *out,
+                       size_t count);
+void filterRowAvx2(float const *source, unsigned int const *first, float const *weights, size_t taps, float *out,
+                   size_t count);
@@ -0,0 +1,101 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include "CpuFeatures.h"
+#include "MipGenerator.h"
+
+#ifdef DXTWRAPPER_X86
+
+#include <immintrin.h>
+
+/**
+ * Same as the SSSE3 kernel on 8 pixels, the shuffle and maddubs work inside each 128-bit lane
+ */
+static inline __m256i sumPixelPairs(__m256i const pixels) {
+    __m256i const pairs = _mm256_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15,
+                                           0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+    return _mm256_maddubs_epi16(_mm256_shuffle_epi8(pixels, pairs), _mm256_set1_epi8(1));
+}
+
+void reduceBoxAvx2(unsigned char const *const row0, unsigned char const *const row1, unsigned char *const out,
+                   size_t const count) {
+    __m256i const round = _mm256_set1_epi16(2);
+    size_t x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m256i const *a = reinterpret_cast<__m256i const *>(row0 + x * 8);
+        __m256i const *b = reinterpret_cast<__m256i const *>(row1 + x * 8);
+        __m256i low = _mm256_add_epi16(sumPixelPairs(_mm256_loadu_si256(a)), sumPixelPairs(_mm256_loadu_si256(b)));
+        __m256i high = _mm256_add_epi16(sumPixelPairs(_mm256_loadu_si256(a + 1)),
+                                        sumPixelPairs(_mm256_loadu_si256(b + 1)));
+        low = _mm256_srli_epi16(_mm256_add_epi16(low, round), 2);
+        high = _mm256_srli_epi16(_mm256_add_epi16(high, round), 2);
+        //packus works per lane and leaves the 64-bit groups of pixels in the order 0, 2, 1, 3
+        __m256i const packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x * 4), packed);
+    }
+    reduceBoxScalar(row0 + x * 8, row1 + x * 8, out + x * 4, count - x);
+}
+
+void filterColumnsAvx2(float const *const source, size_t const pitch, float const *const weights, size_t const taps,
+                       float *const out, size_t const count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        for (size_t k = 0; k < taps; k++) {
+            __m256 const w = _mm256_set1_ps(weights[k]);
+            float const *row = source + k * pitch + i;
+            sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(w, _mm256_loadu_ps(row)));
+            sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(w, _mm256_loadu_ps(row + 8)));
+        }
+        _mm256_storeu_ps(out + i, sum0);
+        _mm256_storeu_ps(out + i + 8, sum1);
+    }
+    filterColumnsScalar(source + i, pitch, weights, taps, out + i, count - i);
+}
+
+void filterRowAvx2(float const *const source, unsigned int const *const first, float const *const weights,
+                   size_t const taps, float *const out, size_t const count) {
+    //two output pixels per vector, one in each lane
+    size_t x = 0;
+    for (; x + 2 <= count; x += 2) {
+        float const *pixels0 = source + first[x] * 4;
+        float const *pixels1 = source + first[x + 1] * 4;
+        float const *w0 = weights + x * taps;
+        float const *w1 = w0 + taps;
+        __m256 sum = _mm256_setzero_ps();
+        for (size_t k = 0; k < taps; k++) {
+            __m256 const w = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(w0[k])), _mm_set1_ps(w1[k]), 1);
+            __m256 const p = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pixels0 + k * 4)),
+                                                  _mm_loadu_ps(pixels1 + k * 4), 1);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(w, p));
+        }
+        _mm256_storeu_ps(out + x * 4, sum);
+    }
+    filterRowScalar(source, first + x, weights + x * taps, taps, out + x * 4, count - x);
+}
+
+#endif
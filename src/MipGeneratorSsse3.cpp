@@ -0,0 +1,91 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include "CpuFeatures.h"
+#include "MipGenerator.h"
+
+#ifdef DXTWRAPPER_X86
+
+#include <tmmintrin.h>
+
+/**
+ * Channel sums of the two pixel pairs of 4 pixels: the shuffle puts the same channel of both pixels of a pair side
+ * by side, maddubs adds them into 16 bits
+ */
+static inline __m128i sumPixelPairs(__m128i const pixels) {
+    __m128i const pairs = _mm_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+    return _mm_maddubs_epi16(_mm_shuffle_epi8(pixels, pairs), _mm_set1_epi8(1));
+}
+
+void reduceBoxSsse3(unsigned char const *const row0, unsigned char const *const row1, unsigned char *const out,
+                    size_t const count) {
+    __m128i const round = _mm_set1_epi16(2);
+    size_t x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128i const *a = reinterpret_cast<__m128i const *>(row0 + x * 8);
+        __m128i const *b = reinterpret_cast<__m128i const *>(row1 + x * 8);
+        __m128i low = _mm_add_epi16(sumPixelPairs(_mm_loadu_si128(a)), sumPixelPairs(_mm_loadu_si128(b)));
+        __m128i high = _mm_add_epi16(sumPixelPairs(_mm_loadu_si128(a + 1)), sumPixelPairs(_mm_loadu_si128(b + 1)));
+        low = _mm_srli_epi16(_mm_add_epi16(low, round), 2);
+        high = _mm_srli_epi16(_mm_add_epi16(high, round), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x * 4), _mm_packus_epi16(low, high));
+    }
+    reduceBoxScalar(row0 + x * 8, row1 + x * 8, out + x * 4, count - x);
+}
+
+void filterColumnsSsse3(float const *const source, size_t const pitch, float const *const weights, size_t const taps,
+                        float *const out, size_t const count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        for (size_t k = 0; k < taps; k++) {
+            __m128 const w = _mm_set1_ps(weights[k]);
+            float const *row = source + k * pitch + i;
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(w, _mm_loadu_ps(row)));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(w, _mm_loadu_ps(row + 4)));
+        }
+        _mm_storeu_ps(out + i, sum0);
+        _mm_storeu_ps(out + i + 4, sum1);
+    }
+    filterColumnsScalar(source + i, pitch, weights, taps, out + i, count - i);
+}
+
+void filterRowSsse3(float const *const source, unsigned int const *const first, float const *const weights,
+                    size_t const taps, float *const out, size_t const count) {
+    //a pixel is one vector, each tap is a broadcast weight times a pixel
+    for (size_t x = 0; x < count; x++) {
+        float const *pixels = source + first[x] * 4;
+        float const *w = weights + x * taps;
+        __m128 sum = _mm_setzero_ps();
+        for (size_t k = 0; k < taps; k++) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(pixels + k * 4)));
+        }
+        _mm_storeu_ps(out + x * 4, sum);
+    }
+}
+
+#endif
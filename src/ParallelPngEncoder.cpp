@@ -0,0 +1,375 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <miniz.h>
+#include <spng.h>
+#include "DxTexWrapper.h"
+#include "ParallelPngEncoder.h"
+#include "ThreadPool.h"
+
+static constexpr size_t PNG_BYTES_PER_PIXEL = 4;
+
+class PngStrip {
+public:
+    std::vector<unsigned char> deflated;
+    uint32_t adler = 1;
+    size_t filteredSize = 0;
+    bool failed = false;
+};
+
+bool isParallelPngEncodeEnabled(DirectX::Image const &image) {
+    return image.format == DXGI_FORMAT_R8G8B8A8_UNORM && image.slicePitch >= PARALLEL_PNG_MIN_SIZE
+           && image.height > 1 && getThreadPool()->getWorkerCount() > 1;
+}
+
+uint32_t adler32Combine(uint32_t const adler1, uint32_t const adler2, size_t const length2) {
+    constexpr uint32_t base = 65521;
+    uint32_t const remainder = static_cast<uint32_t>(length2 % base);
+    uint32_t sum1 = adler1 & 0xffff;
+    uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(remainder) * sum1) % base);
+    sum1 += (adler2 & 0xffff) + base - 1;
+    sum2 += ((adler1 >> 16) & 0xffff) + ((adler2 >> 16) & 0xffff) + base - remainder;
+    if (sum1 >= base) {
+        sum1 -= base;
+    }
+    if (sum1 >= base) {
+        sum1 -= base;
+    }
+    if (sum2 >= (base << 1)) {
+        sum2 -= (base << 1);
+    }
+    if (sum2 >= base) {
+        sum2 -= base;
+    }
+    return sum1 | (sum2 << 16);
+}
+
+static inline unsigned char paethPredictor(int const a, int const b, int const c) {
+    int const p = a + b - c;
+    int const pa = std::abs(p - a);
+    int const pb = std::abs(p - b);
+    int const pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return static_cast<unsigned char>(a);
+    }
+    return static_cast<unsigned char>(pb <= pc ? b : c);
+}
+
+static void applyPngFilter(int const type, unsigned char const *const previous, unsigned char const *const row,
+                           size_t const rowSize, unsigned char *const out) {
+    size_t const bpp = std::min(PNG_BYTES_PER_PIXEL, rowSize);
+    if (type == 0 || (previous == nullptr && type == 2)) {
+        std::memcpy(out, row, rowSize);
+        return;
+    }
+    if (type == 1 || (previous == nullptr && type == 4)) {
+        //paeth without a previous row predicts from the left pixel, same as sub
+        std::memcpy(out, row, bpp);
+        for (size_t i = bpp; i < rowSize; i++) {
+            out[i] = static_cast<unsigned char>(row[i] - row[i - PNG_BYTES_PER_PIXEL]);
+        }
+        return;
+    }
+    if (previous == nullptr) {
+        //average of the left pixel and zero
+        std::memcpy(out, row, bpp);
+        for (size_t i = bpp; i < rowSize; i++) {
+            out[i] = static_cast<unsigned char>(row[i] - (row[i - PNG_BYTES_PER_PIXEL] >> 1));
+        }
+        return;
+    }
+
+    switch (type) {
+        case 2:
+            for (size_t i = 0; i < rowSize; i++) {
+                out[i] = static_cast<unsigned char>(row[i] - previous[i]);
+            }
+            break;
+        case 3:
+            for (size_t i = 0; i < bpp; i++) {
+                out[i] = static_cast<unsigned char>(row[i] - (previous[i] >> 1));
+            }
+            for (size_t i = bpp; i < rowSize; i++) {
+                out[i] = static_cast<unsigned char>(row[i] - ((row[i - PNG_BYTES_PER_PIXEL] + previous[i]) >> 1));
+            }
+            break;
+        default:
+            for (size_t i = 0; i < bpp; i++) {
+                out[i] = static_cast<unsigned char>(row[i] - previous[i]);
+            }
+            for (size_t i = bpp; i < rowSize; i++) {
+                out[i] = static_cast<unsigned char>(row[i] - paethPredictor(row[i - PNG_BYTES_PER_PIXEL], previous[i],
+                                                                            previous[i - PNG_BYTES_PER_PIXEL]));
+            }
+            break;
+    }
+}
+
+static uint64_t sumAbsolute(unsigned char const *const data, size_t const size) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; i++) {
+        sum += static_cast<uint64_t>(std::abs(static_cast<int>(static_cast<signed char>(data[i]))));
+    }
+    return sum;
+}
+
+void filterPngRow(unsigned char const *const previous, unsigned char const *const row, size_t const rowSize,
+                  int const filterChoice, unsigned char *const output, std::vector<unsigned char> &scratch) {
+    static constexpr int choices[] = {SPNG_FILTER_CHOICE_NONE, SPNG_FILTER_CHOICE_SUB, SPNG_FILTER_CHOICE_UP,
+                                      SPNG_FILTER_CHOICE_AVG, SPNG_FILTER_CHOICE_PAETH};
+    int candidates = 0;
+    int single = 0;
+    for (int type = 0; type < 5; type++) {
+        if (filterChoice & choices[type]) {
+            candidates++;
+            single = type;
+        }
+    }
+
+    if (candidates <= 1) {
+        output[0] = static_cast<unsigned char>(single);
+        applyPngFilter(single, previous, row, rowSize, output + 1);
+        return;
+    }
+
+    std::vector<unsigned char> &trial = scratch;
+    trial.resize(rowSize);
+    uint64_t best = UINT64_MAX;
+    for (int type = 0; type < 5; type++) {
+        if (!(filterChoice & choices[type])) {
+            continue;
+        }
+        applyPngFilter(type, previous, row, rowSize, trial.data());
+        uint64_t const sum = sumAbsolute(trial.data(), rowSize);
+        if (sum < best) {
+            best = sum;
+            output[0] = static_cast<unsigned char>(type);
+            std::memcpy(output + 1, trial.data(), rowSize);
+        }
+    }
+}
+
+static void encodeStrip(DirectX::Image const &image, size_t const firstRow, size_t const lastRow, bool const finish,
+                        PngEncodeOptions const &options, PngStrip &strip) {
+    size_t const rowSize = image.width * PNG_BYTES_PER_PIXEL;
+    size_t const rows = lastRow - firstRow;
+
+    std::vector<unsigned char> filtered((rowSize + 1) * rows);
+    std::vector<unsigned char> scratch;
+    for (size_t y = firstRow; y < lastRow; y++) {
+        unsigned char const *previous = y > 0 ? image.pixels + (y - 1) * image.rowPitch : nullptr;
+        filterPngRow(previous, image.pixels + y * image.rowPitch, rowSize, options.filterChoice,
+                     filtered.data() + (y - firstRow) * (rowSize + 1), scratch);
+    }
+    strip.filteredSize = filtered.size();
+    strip.adler = static_cast<uint32_t>(mz_adler32(MZ_ADLER32_INIT, filtered.data(), filtered.size()));
+
+    //raw deflate, the zlib header and the combined Adler-32 are written around the strips
+    mz_stream stream{};
+    if (mz_deflateInit2(&stream, options.compressionLevel, MZ_DEFLATED, -MZ_DEFAULT_WINDOW_BITS, 9,
+                        options.compressionStrategy) != MZ_OK) {
+        strip.failed = true;
+        return;
+    }
+
+    //sync flush adds an empty stored block, a few bytes over the bound
+    strip.deflated.resize(mz_deflateBound(&stream, static_cast<mz_ulong>(filtered.size())) + 16);
+    stream.next_in = filtered.data();
+    stream.avail_in = static_cast<unsigned int>(filtered.size());
+    stream.next_out = strip.deflated.data();
+    stream.avail_out = static_cast<unsigned int>(strip.deflated.size());
+
+    int const result = mz_deflate(&stream, finish ? MZ_FINISH : MZ_SYNC_FLUSH);
+    if ((finish && result != MZ_STREAM_END) || (!finish && result != MZ_OK) || stream.avail_in != 0) {
+        strip.failed = true;
+    }
+    strip.deflated.resize(strip.deflated.size() - stream.avail_out);
+    mz_deflateEnd(&stream);
+}
+
+static inline void writeUint32(unsigned char *const dest, uint32_t const value) {
+    dest[0] = static_cast<unsigned char>(value >> 24);
+    dest[1] = static_cast<unsigned char>(value >> 16);
+    dest[2] = static_cast<unsigned char>(value >> 8);
+    dest[3] = static_cast<unsigned char>(value);
+}
+
+/**
+ * Write a chunk whose data is the concatenation of prefix, data and suffix, returns the chunk size
+ */
+static size_t writeChunk(unsigned char *const dest, char const *const type, unsigned char const *const prefix,
+                         size_t const prefixSize, unsigned char const *const data, size_t const dataSize,
+                         unsigned char const *const suffix, size_t const suffixSize) {
+    size_t const length = prefixSize + dataSize + suffixSize;
+    writeUint32(dest, static_cast<uint32_t>(length));
+    std::memcpy(dest + 4, type, 4);
+
+    unsigned char *body = dest + 8;
+    if (prefixSize > 0) {
+        std::memcpy(body, prefix, prefixSize);
+    }
+    if (dataSize > 0) {
+        std::memcpy(body + prefixSize, data, dataSize);
+    }
+    if (suffixSize > 0) {
+        std::memcpy(body + prefixSize + dataSize, suffix, suffixSize);
+    }
+
+    //the crc covers type and data
+    mz_ulong const crc = mz_crc32(MZ_CRC32_INIT, dest + 4, length + 4);
+    writeUint32(body + length, static_cast<uint32_t>(crc));
+    return length + 12;
+}
+
+/**
+ * Same as writeChunk, appending the chunk to a file. Returns false if it can't be written.
+ */
+static bool writeChunkToFile(std::FILE *const file, char const *const type, unsigned char const *const prefix,
+                             size_t const prefixSize, unsigned char const *const data, size_t const dataSize,
+                             unsigned char const *const suffix, size_t const suffixSize) {
+    size_t const length = prefixSize + dataSize + suffixSize;
+    unsigned char header[8];
+    writeUint32(header, static_cast<uint32_t>(length));
+    std::memcpy(header + 4, type, 4);
+
+    //mz_crc32 restarts on a nullptr, empty parts are skipped
+    mz_ulong crc = mz_crc32(MZ_CRC32_INIT, header + 4, 4);
+    unsigned char const *const parts[3] = {prefix, data, suffix};
+    size_t const sizes[3] = {prefixSize, dataSize, suffixSize};
+    bool written = std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    for (size_t i = 0; i < 3 && written; i++) {
+        if (sizes[i] > 0) {
+            crc = mz_crc32(crc, parts[i], sizes[i]);
+            written = std::fwrite(parts[i], 1, sizes[i], file) == sizes[i];
+        }
+    }
+
+    unsigned char trailer[4];
+    writeUint32(trailer, static_cast<uint32_t>(crc));
+    return written && std::fwrite(trailer, 1, sizeof(trailer), file) == sizeof(trailer);
+}
+
+ConvertStatus encodePngParallel(DirectX::Image const &image, PngEncodeOptions const &options, PngOutput &output) {
+    size_t const rowSize = image.width * PNG_BYTES_PER_PIXEL;
+    size_t const stripRows = std::max<size_t>(PARALLEL_PNG_STRIP_SIZE / rowSize, 1);
+    size_t const stripCount = (image.height + stripRows - 1) / stripRows;
+
+    std::vector<PngStrip> strips(stripCount);
+    getThreadPool()->parallelFor(stripCount, [&](size_t const index, [[maybe_unused]] size_t const worker) {
+        size_t const firstRow = index * stripRows;
+        size_t const lastRow = std::min(firstRow + stripRows, image.height);
+        encodeStrip(image, firstRow, lastRow, index + 1 == stripCount, options, strips[index]);
+    });
+
+    size_t pngSize = 8 + 25 + 12;
+    uint32_t adler = 1;
+    for (auto const &strip: strips) {
+        if (strip.failed) {
+            printError("Error deflating PNG strip\n");
+            return CONVERT_ERROR_ENCODE;
+        }
+        pngSize += strip.deflated.size() + 12;
+        adler = adler32Combine(adler, strip.adler, strip.filteredSize);
+    }
+    //zlib header and trailer
+    pngSize += 2 + 4;
+
+    output.size = pngSize;
+    unsigned char *dest = nullptr;
+    if (output.file != nullptr) {
+        //each chunk is appended to the file as it is written
+    } else if (output.streaming) {
+        if (output.buffer == nullptr || pngSize > output.capacity) {
+            return CONVERT_ERROR_BUFFER_TOO_SMALL;
+        }
+        dest = output.buffer;
+    } else {
+        output.content = allocateContent(output.allocator, output.userData, pngSize);
+        if (output.content == nullptr) {
+            return CONVERT_ERROR_OUT_OF_MEMORY;
+        }
+        dest = static_cast<unsigned char *>(output.content);
+    }
+
+    size_t offset = 0;
+    bool written = true;
+    auto const chunk = [&](char const *const type, unsigned char const *const prefix, size_t const prefixSize,
+                           unsigned char const *const data, size_t const dataSize, unsigned char const *const suffix,
+                           size_t const suffixSize) {
+        if (dest == nullptr) {
+            written = written && writeChunkToFile(output.file, type, prefix, prefixSize, data, dataSize, suffix,
+                                                  suffixSize);
+            offset += prefixSize + dataSize + suffixSize + 12;
+        } else {
+            offset += writeChunk(dest + offset, type, prefix, prefixSize, data, dataSize, suffix, suffixSize);
+        }
+    };
+
+    static constexpr unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    if (dest == nullptr) {
+        written = std::fwrite(signature, 1, sizeof(signature), output.file) == sizeof(signature);
+    } else {
+        std::memcpy(dest, signature, sizeof(signature));
+    }
+    offset += sizeof(signature);
+
+    unsigned char ihdr[13];
+    writeUint32(ihdr, static_cast<uint32_t>(image.width));
+    writeUint32(ihdr + 4, static_cast<uint32_t>(image.height));
+    ihdr[8] = 8; //bit depth
+    ihdr[9] = 6; //truecolor with alpha
+    ihdr[10] = 0; //deflate
+    ihdr[11] = 0; //adaptive filtering
+    ihdr[12] = 0; //no interlace
+    chunk("IHDR", ihdr, sizeof(ihdr), nullptr, 0, nullptr, 0);
+
+    //zlib header, 32K window, FLEVEL matching the compression level
+    int const level = options.compressionLevel < 0 ? MZ_DEFAULT_LEVEL : options.compressionLevel;
+    unsigned char const zlibHeader[2] = {0x78, static_cast<unsigned char>(level < 2 ? 0x01 : level < 6 ? 0x5e
+                                                                                        : level == 6 ? 0x9c : 0xda)};
+    unsigned char adlerTrailer[4];
+    writeUint32(adlerTrailer, adler);
+
+    for (size_t i = 0; i < stripCount; i++) {
+        chunk("IDAT", zlibHeader, i == 0 ? sizeof(zlibHeader) : 0, strips[i].deflated.data(),
+              strips[i].deflated.size(), adlerTrailer, i + 1 == stripCount ? sizeof(adlerTrailer) : 0);
+        strips[i].deflated = std::vector<unsigned char>();
+    }
+
+    chunk("IEND", nullptr, 0, nullptr, 0, nullptr, 0);
+    output.size = offset;
+    if (!written) {
+        printError("Error writing PNG\n");
+        return CONVERT_ERROR_IO;
+    }
+
+    return CONVERT_OK;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstdint>
+#include <vector>
+#include <DirectXTex.h>
+#include "ConvertStatus.h"
+#include "PngEncodeOptions.h"
+#include "PngOutput.h"
+
+//images smaller than this (in bytes of RGBA) are encoded by a single deflate stream
+constexpr size_t PARALLEL_PNG_MIN_SIZE = 4 * 1024 * 1024;
+//uncompressed bytes of each strip, large enough that the independent deflate dictionaries cost little
+constexpr size_t PARALLEL_PNG_STRIP_SIZE = 2 * 1024 * 1024;
+
+/**
+ * @return True if the image is large enough to be split in strips and there is more than one worker to encode them
+ */
+bool isParallelPngEncodeEnabled(DirectX::Image const &image);
+
+/**
+ * Encode a RGBA8 image as PNG splitting it in horizontal strips, each strip is filtered and deflated on a separate
+ * thread, ending with a sync flush. The strips are joined in one zlib stream stored as one IDAT chunk per strip, with
+ * the Adler-32 combined from the strips.
+ *
+ * @param image The image, DXGI_FORMAT_R8G8B8A8_UNORM
+ * @param options Compression level, strategy and filters
+ * @param output Destination of the PNG
+ * @return CONVERT_OK on success
+ */
+ConvertStatus encodePngParallel(DirectX::Image const &image, PngEncodeOptions const &options, PngOutput &output);
+
+uint32_t adler32Combine(uint32_t adler1, uint32_t adler2, size_t length2);
+
+/**
+ * Filter a row of RGBA8 pixels, choosing among the filters in 'filterChoice' the one with the lowest sum of absolute
+ * values, the same heuristic used by spng
+ *
+ * @param previous The previous unfiltered row, nullptr for the first row of the image
+ * @param row The unfiltered row
+ * @param rowSize The size(in bytes) of the row
+ * @param filterChoice SPNG_FILTER_CHOICE flags
+ * @param output Receives the filter type byte followed by the filtered row, rowSize + 1 bytes
+ * @param scratch Buffer reused between rows to try the filters
+ */
+void filterPngRow(unsigned char const *previous, unsigned char const *row, size_t rowSize, int filterChoice,
+                  unsigned char *output, std::vector<unsigned char> &scratch);
@@ -0,0 +1,262 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Inflate.h"
+#include "PngDecoder.h"
+#include "PngUnfilter.h"
+#include "ScratchArena.h"
+#include "Swizzle.h"
+
+static constexpr unsigned char PNG_SIGNATURE[] = {137, 80, 78, 71, 13, 10, 26, 10};
+//length, type and CRC
+static constexpr size_t CHUNK_OVERHEAD = 12;
+static constexpr size_t IHDR_SIZE = 13;
+//RGBA8, the decoded format
+static constexpr size_t BYTES_PER_PIXEL = 4;
+
+static std::atomic<int> pngDecodeMode{PNG_DECODE_STRICT};
+
+PngDecodeMode getPngDecodeMode() {
+    return static_cast<PngDecodeMode>(pngDecodeMode.load(std::memory_order_relaxed));
+}
+
+static uint32_t readBigEndian(unsigned char const *const p) {
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8
+           | static_cast<uint32_t>(p[3]);
+}
+
+/**
+ * Where the image data of a PNG is, found by parseTrustedPng
+ */
+class TrustedPng {
+public:
+    uint32_t width = 0;
+    uint32_t height = 0;
+    //bytes per pixel, 3 for RGB and 4 for RGBA
+    size_t bpp = 0;
+    size_t firstData = 0;
+    size_t dataChunks = 0;
+    size_t dataSize = 0;
+
+    [[nodiscard]] uint64_t getPixelsSize() const {
+        return uint64_t{width} * height * BYTES_PER_PIXEL;
+    }
+
+    /**
+     * Bytes written by inflateTrustedPng, the filtered rows don't fit in the pixels of RGBA images
+     */
+    [[nodiscard]] uint64_t getBufferSize() const {
+        return std::max((uint64_t{width} * bpp + 1) * height, getPixelsSize());
+    }
+};
+
+static ConvertStatus parseTrustedPng(unsigned char const *const png, size_t const size, TrustedPng &image) {
+    if (size < sizeof(PNG_SIGNATURE) + CHUNK_OVERHEAD + IHDR_SIZE
+        || std::memcmp(png, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0) {
+        return CONVERT_ERROR_DECODE;
+    }
+    unsigned char const *const ihdr = png + sizeof(PNG_SIGNATURE);
+    if (readBigEndian(ihdr) != IHDR_SIZE || std::memcmp(ihdr + 4, "IHDR", 4) != 0) {
+        return CONVERT_ERROR_DECODE;
+    }
+    image.width = readBigEndian(ihdr + 8);
+    image.height = readBigEndian(ihdr + 12);
+    unsigned int const bitDepth = ihdr[16];
+    unsigned int const colorType = ihdr[17];
+    if (image.width == 0 || image.height == 0 || image.width > INT32_MAX || image.height > INT32_MAX || ihdr[18] != 0
+        || ihdr[19] != 0 || ihdr[20] > 1) {
+        return CONVERT_ERROR_DECODE;
+    }
+    if (bitDepth != 8 || (colorType != 2 && colorType != 6) || ihdr[20] != 0) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    image.bpp = colorType == 6 ? 4 : 3;
+
+    //the IDAT chunks are consecutive, their data is one zlib stream. Nothing after them changes the pixels.
+    size_t offset = sizeof(PNG_SIGNATURE) + CHUNK_OVERHEAD + IHDR_SIZE;
+    for (;;) {
+        if (size - offset < CHUNK_OVERHEAD) {
+            return CONVERT_ERROR_DECODE;
+        }
+        size_t const length = readBigEndian(png + offset);
+        unsigned char const *const type = png + offset + 4;
+        if (length > size - offset - CHUNK_OVERHEAD) {
+            return CONVERT_ERROR_DECODE;
+        }
+        if (std::memcmp(type, "IDAT", 4) == 0) {
+            if (image.dataChunks++ == 0) {
+                image.firstData = offset;
+            }
+            image.dataSize += length;
+        } else if (image.dataChunks != 0 || std::memcmp(type, "IEND", 4) == 0) {
+            break;
+        } else if (std::memcmp(type, "tRNS", 4) == 0 || ((type[0] & 0x20) == 0 && std::memcmp(type, "PLTE", 4) != 0)) {
+            //a transparent color, or an unknown critical chunk
+            return CONVERT_ERROR_INVALID_ARGUMENT;
+        }
+        offset += CHUNK_OVERHEAD + length;
+    }
+    if (image.dataChunks == 0) {
+        return CONVERT_ERROR_DECODE;
+    }
+    if (image.getBufferSize() > SIZE_MAX) {
+        return CONVERT_ERROR_OUT_OF_MEMORY;
+    }
+    return CONVERT_OK;
+}
+
+/**
+ * Inflate and unfilter the image data found by parseTrustedPng, 'buffer' holds getBufferSize() bytes and receives the
+ * RGBA8 pixels
+ */
+static ConvertStatus inflateTrustedPng(unsigned char const *const png, TrustedPng const &image,
+                                       unsigned char *const buffer) {
+    ArenaFrame frame;
+    unsigned char const *stream = png + image.firstData + 8;
+    if (image.dataChunks > 1) {
+        auto *const joined = frame.arena.allocateArray<unsigned char>(image.dataSize);
+        if (joined == nullptr) {
+            return CONVERT_ERROR_OUT_OF_MEMORY;
+        }
+        size_t copied = 0;
+        for (size_t chunk = image.firstData; copied < image.dataSize;) {
+            size_t const length = readBigEndian(png + chunk);
+            std::memcpy(joined + copied, png + chunk + 8, length);
+            copied += length;
+            chunk += CHUNK_OVERHEAD + length;
+        }
+        stream = joined;
+    }
+
+    //each filtered row starts with its filter type. RGBA rows are reconstructed in place, each one moved back over
+    //the filter types before it. RGB rows are inflated at the end of the buffer and expanded ahead of them.
+    size_t const bpp = image.bpp;
+    auto const stride = static_cast<size_t>(image.width) * bpp;
+    size_t const filteredSize = (stride + 1) * image.height;
+    auto *const rows = frame.arena.allocateArray<unsigned char>(stride * (bpp == 3 ? 3 : 1));
+    if (rows == nullptr) {
+        return CONVERT_ERROR_OUT_OF_MEMORY;
+    }
+    //the row above the first one
+    unsigned char const *const zeros = rows;
+    std::memset(rows, 0, stride);
+
+    unsigned char *const filtered = buffer + (static_cast<size_t>(image.getBufferSize()) - filteredSize);
+    if (!inflateZlib(stream, image.dataSize, filtered, filteredSize)) {
+        return CONVERT_ERROR_DECODE;
+    }
+
+    for (size_t y = 0; y < image.height; y++) {
+        unsigned char const *const src = filtered + y * (stride + 1);
+        unsigned char *dst;
+        unsigned char const *previous;
+        if (bpp == 4) {
+            dst = buffer + y * stride;
+            previous = y == 0 ? zeros : dst - stride;
+        } else {
+            dst = rows + stride * (1 + (y & 1));
+            previous = y == 0 ? zeros : rows + stride * (2 - (y & 1));
+        }
+        if (!unfilterPngRow(src[0], src + 1, previous, dst, stride, bpp)) {
+            return CONVERT_ERROR_DECODE;
+        }
+        if (bpp == 3) {
+            expandRGBtoRGBA(dst, buffer + y * image.width * BYTES_PER_PIXEL, image.width);
+        }
+    }
+    return CONVERT_OK;
+}
+
+ConvertStatus decodeTrustedPng(unsigned char const *const png, size_t const size, ImageData &imageData) {
+    TrustedPng image;
+    ConvertStatus status = parseTrustedPng(png, size, image);
+    if (status != CONVERT_OK) {
+        return status;
+    }
+
+    std::vector<unsigned char> &pixels = imageData.getPixels();
+    pixels.resize(static_cast<size_t>(image.getBufferSize()));
+    status = inflateTrustedPng(png, image, pixels.data());
+    if (status != CONVERT_OK) {
+        pixels.clear();
+        return status;
+    }
+
+    pixels.resize(static_cast<size_t>(image.getPixelsSize()));
+    imageData.setWidth(image.width);
+    imageData.setHeight(image.height);
+    return CONVERT_OK;
+}
+
+ConvertStatus decodeTrustedPng(unsigned char const *const png, size_t const size, unsigned char *const pixels,
+                               size_t const pixelsSize, size_t const capacity) {
+    TrustedPng image;
+    ConvertStatus const status = parseTrustedPng(png, size, image);
+    if (status != CONVERT_OK) {
+        return status;
+    }
+    if (image.getPixelsSize() != pixelsSize) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    if (image.getBufferSize() > capacity) {
+        return CONVERT_ERROR_BUFFER_TOO_SMALL;
+    }
+    return inflateTrustedPng(png, image, pixels);
+}
+
+#ifdef DXTWRAPPER_USE_LIBSPNG
+
+spng_ctx *newSpngDecoder() {
+    if (getPngDecodeMode() != PNG_DECODE_TRUSTED) {
+        return newSpngContext(0);
+    }
+    //the Adler-32 flag needs zlib, with miniz only the CRCs are skipped
+    spng_ctx *const ctx = newSpngContext(SPNG_CTX_IGNORE_ADLER32);
+    if (ctx != nullptr) {
+        spng_set_crc_action(ctx, SPNG_CRC_USE, SPNG_CRC_USE);
+    }
+    return ctx;
+}
+
+#endif
+
+/**
+ * Select how PNGs are decoded, for every thread. Strict by default.
+ *
+ * @param mode PNG_DECODE_TRUSTED skips the checksums and uses the faster decoder, only for PNGs known to be intact
+ */
+[[maybe_unused]] ConvertStatus setPngDecodeMode(PngDecodeMode const mode) {
+    if (mode != PNG_DECODE_STRICT && mode != PNG_DECODE_TRUSTED) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+    pngDecodeMode.store(mode, std::memory_order_relaxed);
+    return CONVERT_OK;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+#include "DxTexWrapper.h"
+#include "ImageData.h"
+
+#ifdef DXTWRAPPER_USE_LIBSPNG
+#include <spng.h>
+#endif
+
+enum PngDecodeMode : int {
+    //the checksums of the chunks and of the compressed data are verified, the PNG library decodes every image
+    PNG_DECODE_STRICT = 0,
+    //for PNGs already verified, like our build outputs: checksums are skipped and the 8-bit RGB and RGBA images are
+    //decoded by decodeTrustedPng
+    PNG_DECODE_TRUSTED = 1,
+};
+
+PngDecodeMode getPngDecodeMode();
+
+/**
+ * Decode a non-interlaced PNG of 8-bit RGB or RGBA to RGBA8, without verifying checksums. The image data is inflated
+ * by inflateZlib straight into the pixels of 'imageData' and unfiltered in place.
+ *
+ * @return CONVERT_ERROR_INVALID_ARGUMENT for the PNGs it doesn't decode: other formats, interlaced images and RGB with
+ * a transparent color. CONVERT_ERROR_DECODE if the PNG is invalid.
+ */
+ConvertStatus decodeTrustedPng(unsigned char const *png, size_t size, ImageData &imageData);
+
+/**
+ * Same as decodeTrustedPng into an ImageData, into a buffer of the caller
+ *
+ * @param pixels Receives the RGBA8 pixels, pixelsSize bytes
+ * @param pixelsSize The size of the image, width * height * 4
+ * @param capacity Bytes writable at 'pixels', RGBA images are inflated in place and need one more byte per row
+ * @return CONVERT_ERROR_BUFFER_TOO_SMALL when 'capacity' is not enough, the errors of decodeTrustedPng
+ */
+ConvertStatus decodeTrustedPng(unsigned char const *png, size_t size, unsigned char *pixels, size_t pixelsSize,
+                               size_t capacity);
+
+#ifdef DXTWRAPPER_USE_LIBSPNG
+
+/**
+ * Create a spng context for decoding with the checks of the current PngDecodeMode, see newSpngContext
+ */
+spng_ctx *newSpngDecoder();
+
+#endif
+
+extern "C" {
+[[maybe_unused]] LIBEXPORT ConvertStatus setPngDecodeMode(PngDecodeMode mode);
+}
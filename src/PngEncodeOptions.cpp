@@ -0,0 +1,131 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstring>
+#include "DxTexWrapper.h"
+#include "PngEncodeOptions.h"
+
+/**
+ * Fill the encoder settings of a profile
+ *
+ * @param profile The profile
+ * @param options Receives the settings
+ */
+[[maybe_unused]] void getPngEncodeOptions(PngEncodeProfile const profile, PngEncodeOptions *const options) {
+    if (options == nullptr) {
+        return;
+    }
+
+    options->profile = profile;
+    options->detectContent = true;
+    switch (profile) {
+        case PNG_PROFILE_FAST:
+            options->compressionLevel = 1;
+            options->compressionStrategy = PNG_STRATEGY_FILTERED;
+            options->filterChoice = PNG_FILTER_UP;
+            break;
+        case PNG_PROFILE_MAX:
+            options->compressionLevel = 9;
+            options->compressionStrategy = PNG_STRATEGY_FILTERED;
+            options->filterChoice = PNG_FILTER_ALL;
+            break;
+        case PNG_PROFILE_BALANCED:
+        default:
+            options->profile = PNG_PROFILE_BALANCED;
+            options->compressionLevel = -1;
+            options->compressionStrategy = PNG_STRATEGY_FILTERED;
+            options->filterChoice = PNG_FILTER_ALL;
+            break;
+    }
+}
+
+PngImageContent detectPngImageContent(DirectX::Image const &image) {
+    if (image.width == 0 || image.height == 0) {
+        return PNG_CONTENT_GENERIC;
+    }
+
+    unsigned char const *first = image.pixels;
+    bool alphaVaries = false;
+    for (size_t y = 0; y < image.height; y++) {
+        unsigned char const *row = image.pixels + y * image.rowPitch;
+        for (size_t x = 0; x < image.width; x++) {
+            unsigned char const *pixel = row + x * 4;
+            if (pixel[0] != first[0] || pixel[1] != first[1] || pixel[2] != first[2]) {
+                return PNG_CONTENT_GENERIC;
+            }
+            alphaVaries = alphaVaries || pixel[3] != first[3];
+        }
+    }
+
+    return alphaVaries ? PNG_CONTENT_ALPHA_ONLY : PNG_CONTENT_FLAT;
+}
+
+bool isValidPngEncodeOptions(PngEncodeOptions const *const options) {
+    if (options == nullptr) {
+        return true;
+    }
+    //both encoders take the values as is, the zlib header of the parallel encoder is written from the level
+    return options->compressionLevel >= -1 && options->compressionLevel <= 9
+           && options->compressionStrategy >= PNG_STRATEGY_DEFAULT && options->compressionStrategy <= PNG_STRATEGY_FIXED
+           && (options->filterChoice & ~PNG_FILTER_ALL) == 0;
+}
+
+PngEncodeOptions getPngEncodeOptionsOrDefault(PngEncodeOptions const *const options) {
+    PngEncodeOptions resolved{};
+    if (options != nullptr) {
+        return *options;
+    }
+    //the encoder settings from before the profiles, the output of the conversions without options doesn't change
+    getPngEncodeOptions(PNG_PROFILE_BALANCED, &resolved);
+    resolved.detectContent = false;
+    return resolved;
+}
+
+PngEncodeOptions resolvePngEncodeOptions(PngEncodeOptions const *const options, DirectX::Image const &image) {
+    PngEncodeOptions resolved = getPngEncodeOptionsOrDefault(options);
+
+    if (!resolved.detectContent) {
+        return resolved;
+    }
+
+    switch (detectPngImageContent(image)) {
+        case PNG_CONTENT_FLAT:
+            //after SUB every byte but the first pixel is zero, run-length matches are enough
+            resolved.compressionLevel = 1;
+            resolved.compressionStrategy = PNG_STRATEGY_RLE;
+            resolved.filterChoice = PNG_FILTER_SUB;
+            break;
+        case PNG_CONTENT_ALPHA_ONLY:
+            //color channels are zero after UP, skip the per-row filter search
+            resolved.filterChoice = PNG_FILTER_UP;
+            break;
+        case PNG_CONTENT_GENERIC:
+        default:
+            break;
+    }
+
+    return resolved;
+}
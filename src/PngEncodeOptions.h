@@ -0,0 +1,102 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <DirectXTex.h>
+
+enum PngEncodeProfile : int {
+    //the encoder defaults: level 6, filtered strategy, adaptive filter among all five
+    PNG_PROFILE_BALANCED = 0,
+    //level 1 with every row filtered as UP, for previews where speed matters more than size
+    PNG_PROFILE_FAST = 1,
+    //level 9 with adaptive filter among all five
+    PNG_PROFILE_MAX = 2,
+};
+
+//deflate strategies, same values as zlib
+enum PngCompressionStrategy : int {
+    PNG_STRATEGY_DEFAULT = 0,
+    PNG_STRATEGY_FILTERED = 1,
+    PNG_STRATEGY_HUFFMAN_ONLY = 2,
+    PNG_STRATEGY_RLE = 3,
+    PNG_STRATEGY_FIXED = 4,
+};
+
+//filters tried for each row, same values as SPNG_FILTER_CHOICE
+enum PngFilterChoice : int {
+    PNG_FILTER_NONE = 8,
+    PNG_FILTER_SUB = 16,
+    PNG_FILTER_UP = 32,
+    PNG_FILTER_AVG = 64,
+    PNG_FILTER_PAETH = 128,
+    PNG_FILTER_ALL = 8 | 16 | 32 | 64 | 128,
+};
+
+/**
+ * PNG encoder settings. Start from getPngEncodeOptions to fill every field from a profile.
+ */
+class PngEncodeOptions {
+public:
+    PngEncodeProfile profile;
+    //deflate level 0-9, -1 for the default
+    int compressionLevel;
+    PngCompressionStrategy compressionStrategy;
+    //PngFilterChoice flags
+    int filterChoice;
+    //look for flat or alpha-only images and use a cheaper strategy for them
+    bool detectContent;
+};
+
+/**
+ * Settings used for images where every pixel is the same, or only alpha varies
+ */
+enum PngImageContent : int {
+    PNG_CONTENT_GENERIC = 0,
+    PNG_CONTENT_FLAT = 1,
+    PNG_CONTENT_ALPHA_ONLY = 2,
+};
+
+/**
+ * Classify a RGBA8 image, stops reading at the first pixel that makes it generic
+ */
+PngImageContent detectPngImageContent(DirectX::Image const &image);
+
+/**
+ * Check the fields of the options: level -1 to 9, a PngCompressionStrategy and PngFilterChoice flags. nullptr is valid.
+ */
+bool isValidPngEncodeOptions(PngEncodeOptions const *options);
+
+/**
+ * The options given, or the balanced profile without content detection when 'options' is nullptr
+ */
+PngEncodeOptions getPngEncodeOptionsOrDefault(PngEncodeOptions const *options);
+
+/**
+ * Options to encode 'image': getPngEncodeOptionsOrDefault, adjusted to the image content when
+ * detectContent is set
+ */
+PngEncodeOptions resolvePngEncodeOptions(PngEncodeOptions const *options, DirectX::Image const &image);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include "Content.h"
+
+/**
+ * Destination of an encoded PNG. When 'streaming' is set the PNG is written to the caller-owned 'buffer', 'size' receives
+ * the full PNG size even when it doesn't fit in 'capacity'. Otherwise the PNG is returned in 'content', allocated with
+ * 'allocator' (malloc when nullptr).
+ */
+class PngOutput {
+public:
+    bool streaming = false;
+    unsigned char *buffer = nullptr;
+    size_t capacity = 0;
+    //when set, the PNG is written to the file as it is encoded and 'size' counts the bytes written
+    std::FILE *file = nullptr;
+
+    ContentAllocator allocator = nullptr;
+    void *userData = nullptr;
+    void *content = nullptr;
+
+    size_t size = 0;
+};
@@ -0,0 +1,114 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstring>
+#include "CpuFeatures.h"
+#include "PngUnfilter.h"
+
+//the rows may overlap as described in unfilterPngRow, every byte of src is read before dst is written at its offset
+
+void unfilterSubScalar(unsigned char const *const src, unsigned char *const dst, size_t const size,
+                       size_t const bpp) {
+    for (size_t i = 0; i < size; i++) {
+        dst[i] = static_cast<unsigned char>(src[i] + (i >= bpp ? dst[i - bpp] : 0));
+    }
+}
+
+void unfilterUpScalar(unsigned char const *const src, unsigned char const *const previous, unsigned char *const dst,
+                      size_t const size) {
+    for (size_t i = 0; i < size; i++) {
+        dst[i] = static_cast<unsigned char>(src[i] + previous[i]);
+    }
+}
+
+void unfilterAverageScalar(unsigned char const *const src, unsigned char const *const previous,
+                           unsigned char *const dst, size_t const size, size_t const bpp) {
+    for (size_t i = 0; i < size; i++) {
+        unsigned int const left = i >= bpp ? dst[i - bpp] : 0;
+        dst[i] = static_cast<unsigned char>(src[i] + ((left + previous[i]) >> 1));
+    }
+}
+
+static inline unsigned int predictPaeth(int const a, int const b, int const c) {
+    int const pa = b > c ? b - c : c - b;
+    int const pb = a > c ? a - c : c - a;
+    int const pc = a + b > 2 * c ? a + b - 2 * c : 2 * c - a - b;
+    if (pa <= pb && pa <= pc) {
+        return static_cast<unsigned int>(a);
+    }
+    return static_cast<unsigned int>(pb <= pc ? b : c);
+}
+
+void unfilterPaethScalar(unsigned char const *const src, unsigned char const *const previous,
+                         unsigned char *const dst, size_t const size, size_t const bpp) {
+    for (size_t i = 0; i < size; i++) {
+        //without a pixel on the left the predictor is the pixel above
+        unsigned int const predicted = i >= bpp ? predictPaeth(dst[i - bpp], previous[i], previous[i - bpp])
+                                                : previous[i];
+        dst[i] = static_cast<unsigned char>(src[i] + predicted);
+    }
+}
+
+static PngUnfilterKernels selectPngUnfilterKernels() {
+#ifdef DXTWRAPPER_X86
+    CpuFeatures const &cpu = getCpuFeatures();
+    //the filters depend on the pixel on the left, wider vectors don't help
+    if (cpu.ssse3) {
+        return {"ssse3", unfilterSubSsse3, unfilterUpSsse3, unfilterAverageSsse3, unfilterPaethSsse3};
+    }
+#endif
+    return {"scalar", unfilterSubScalar, unfilterUpScalar, unfilterAverageScalar, unfilterPaethScalar};
+}
+
+//selected during static initialization, when the library is loaded
+static PngUnfilterKernels const pngUnfilterKernels = selectPngUnfilterKernels();
+
+PngUnfilterKernels const &getPngUnfilterKernels() {
+    return pngUnfilterKernels;
+}
+
+bool unfilterPngRow(unsigned int const filter, unsigned char const *const src, unsigned char const *const previous,
+                    unsigned char *const dst, size_t const size, size_t const bpp) {
+    switch (filter) {
+        case PNG_ROW_FILTER_NONE:
+            std::memmove(dst, src, size);
+            return true;
+        case PNG_ROW_FILTER_SUB:
+            pngUnfilterKernels.sub(src, dst, size, bpp);
+            return true;
+        case PNG_ROW_FILTER_UP:
+            pngUnfilterKernels.up(src, previous, dst, size);
+            return true;
+        case PNG_ROW_FILTER_AVERAGE:
+            pngUnfilterKernels.average(src, previous, dst, size, bpp);
+            return true;
+        case PNG_ROW_FILTER_PAETH:
+            pngUnfilterKernels.paeth(src, previous, dst, size, bpp);
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+
+//filter types of PNG rows, the first byte of each filtered row
+enum PngRowFilter : unsigned int {
+    PNG_ROW_FILTER_NONE = 0,
+    PNG_ROW_FILTER_SUB = 1,
+    PNG_ROW_FILTER_UP = 2,
+    PNG_ROW_FILTER_AVERAGE = 3,
+    PNG_ROW_FILTER_PAETH = 4,
+};
+
+/**
+ * Reconstruct a filtered PNG row of 8-bit samples
+ *
+ * @param filter The PngRowFilter of the row
+ * @param src The filtered row, without the filter type byte
+ * @param previous The previous reconstructed row, zeros for the first row
+ * @param dst Receives the reconstructed row. It must not overlap src, or be src moved back by one byte or more, which
+ * reconstructs the image in place.
+ * @param size The size(in bytes) of the row, a multiple of bpp
+ * @param bpp Bytes per pixel
+ * @return False if the filter type is invalid
+ */
+bool unfilterPngRow(unsigned int filter, unsigned char const *src, unsigned char const *previous, unsigned char *dst,
+                    size_t size, size_t bpp);
+
+class PngUnfilterKernels {
+public:
+    char const *name;
+    void (*sub)(unsigned char const *src, unsigned char *dst, size_t size, size_t bpp);
+    void (*up)(unsigned char const *src, unsigned char const *previous, unsigned char *dst, size_t size);
+    void (*average)(unsigned char const *src, unsigned char const *previous, unsigned char *dst, size_t size,
+                    size_t bpp);
+    void (*paeth)(unsigned char const *src, unsigned char const *previous, unsigned char *dst, size_t size,
+                  size_t bpp);
+};
+
+/**
+ * Kernels selected for this CPU when the library was loaded
+ */
+PngUnfilterKernels const &getPngUnfilterKernels();
+
+void unfilterSubScalar(unsigned char const *src, unsigned char *dst, size_t size, size_t bpp);
+void unfilterUpScalar(unsigned char const *src, unsigned char const *previous, unsigned char *dst, size_t size);
+void unfilterAverageScalar(unsigned char const *src, unsigned char const *previous, unsigned char *dst, size_t size,
+                           size_t bpp);
+void unfilterPaethScalar(unsigned char const *src, unsigned char const *previous, unsigned char *dst, size_t size,
+                         size_t bpp);
+
+//3 and 4 bytes per pixel, the scalar kernels handle the others
+void unfilterSubSsse3(unsigned char const *src, unsigned char *dst, size_t size, size_t bpp);
+void unfilterUpSsse3(unsigned char const *src, unsigned char const *previous, unsigned char *dst, size_t size);
+void unfilterAverageSsse3(unsigned char const *src, unsigned char const *previous, unsigned char *dst, size_t size,
+                          size_t bpp);
+void unfilterPaethSsse3(unsigned char const *src, unsigned char const *previous, unsigned char *dst, size_t size,
+                        size_t bpp);
@@ -0,0 +1,212 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include "CpuFeatures.h"
+#include "PngUnfilter.h"
+
+#ifdef DXTWRAPPER_X86
+
+#include <cstdint>
+#include <cstring>
+#include <tmmintrin.h>
+
+//each vector of src is loaded before the result is stored, so dst may be src moved back as for the scalar kernels.
+//The kernels working on one pixel at a time move 4 bytes per pixel while they fit in the row, with 3 bytes per pixel
+//the 4th belongs to the next pixel, which overwrites it. Only the last pixel is moved with 3 bytes.
+
+template<size_t BPP>
+static inline __m128i loadPixel(unsigned char const *const p) {
+    uint32_t pixel = 0;
+    std::memcpy(&pixel, p, BPP);
+    return _mm_cvtsi32_si128(static_cast<int>(pixel));
+}
+
+template<size_t BPP>
+static inline void storePixel(unsigned char *const p, __m128i const v) {
+    auto const pixel = static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+    std::memcpy(p, &pixel, BPP);
+}
+
+/**
+ * The bytes of a vector of pixels added to the pixels on their left, the 4 pixels of each vector as a prefix sum plus
+ * the last pixel of the previous vector
+ */
+static void unfilterSub4(unsigned char const *const src, unsigned char *const dst, size_t const size) {
+    __m128i last = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i));
+        v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi8(v, last);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+        last = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    for (; i < size; i++) {
+        dst[i] = static_cast<unsigned char>(src[i] + (i >= 4 ? dst[i - 4] : 0));
+    }
+}
+
+/**
+ * As unfilterSub4 with 4 pixels of 3 bytes in the low 12 bytes of each vector
+ */
+static void unfilterSub3(unsigned char const *const src, unsigned char *const dst, size_t const size) {
+    __m128i const lastPixel = _mm_setr_epi8(9, 10, 11, 9, 10, 11, 9, 10, 11, 9, 10, 11, -1, -1, -1, -1);
+    __m128i last = _mm_setzero_si128();
+    size_t i = 0;
+    //each load reads 16 bytes but consumes 12, stop while 16 bytes are still readable
+    for (; i + 16 <= size; i += 12) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i));
+        v = _mm_add_epi8(v, _mm_slli_si128(v, 3));
+        v = _mm_add_epi8(v, _mm_slli_si128(v, 6));
+        v = _mm_add_epi8(v, last);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), v);
+        storePixel<4>(dst + i + 8, _mm_srli_si128(v, 8));
+        last = _mm_shuffle_epi8(v, lastPixel);
+    }
+    for (; i < size; i++) {
+        dst[i] = static_cast<unsigned char>(src[i] + (i >= 3 ? dst[i - 3] : 0));
+    }
+}
+
+void unfilterSubSsse3(unsigned char const *const src, unsigned char *const dst, size_t const size,
+                      size_t const bpp) {
+    if (bpp == 4) {
+        unfilterSub4(src, dst, size);
+    } else if (bpp == 3) {
+        unfilterSub3(src, dst, size);
+    } else {
+        unfilterSubScalar(src, dst, size, bpp);
+    }
+}
+
+void unfilterUpSsse3(unsigned char const *const src, unsigned char const *const previous, unsigned char *const dst,
+                     size_t const size) {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i));
+        __m128i const up = _mm_loadu_si128(reinterpret_cast<__m128i const *>(previous + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_add_epi8(v, up));
+    }
+    unfilterUpScalar(src + i, previous + i, dst + i, size - i);
+}
+
+/**
+ * The average rounds down, _mm_avg_epu8 rounds up when the low bits of the operands differ
+ */
+template<size_t BYTES>
+static inline __m128i unfilterAveragePixel(unsigned char const *const src, unsigned char const *const previous,
+                                           unsigned char *const dst, __m128i const left) {
+    __m128i const up = loadPixel<BYTES>(previous);
+    __m128i const roundedUp = _mm_and_si128(_mm_xor_si128(left, up), _mm_set1_epi8(1));
+    __m128i const average = _mm_sub_epi8(_mm_avg_epu8(left, up), roundedUp);
+    __m128i const pixel = _mm_add_epi8(loadPixel<BYTES>(src), average);
+    storePixel<BYTES>(dst, pixel);
+    return pixel;
+}
+
+/**
+ * One pixel at a time, the channels in parallel
+ */
+template<size_t BPP>
+static void unfilterAverage(unsigned char const *const src, unsigned char const *const previous,
+                            unsigned char *const dst, size_t const size) {
+    __m128i left = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= size; i += BPP) {
+        left = unfilterAveragePixel<4>(src + i, previous + i, dst + i, left);
+    }
+    for (; i < size; i += BPP) {
+        left = unfilterAveragePixel<BPP>(src + i, previous + i, dst + i, left);
+    }
+}
+
+void unfilterAverageSsse3(unsigned char const *const src, unsigned char const *const previous,
+                          unsigned char *const dst, size_t const size, size_t const bpp) {
+    if (bpp == 4) {
+        unfilterAverage<4>(src, previous, dst, size);
+    } else if (bpp == 3) {
+        unfilterAverage<3>(src, previous, dst, size);
+    } else {
+        unfilterAverageScalar(src, previous, dst, size, bpp);
+    }
+}
+
+static inline __m128i select(__m128i const mask, __m128i const a, __m128i const b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/**
+ * With a the pixel on the left, b above and c above the left one, as 16-bit lanes, the distances are |b - c|,
+ * |a - c| and |a + b - 2c|, ties prefer a, then b. Returns the pixel as 16-bit lanes, 'c' becomes b.
+ */
+template<size_t BYTES>
+static inline __m128i unfilterPaethPixel(unsigned char const *const src, unsigned char const *const previous,
+                                         unsigned char *const dst, __m128i const a, __m128i &c) {
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const b = _mm_unpacklo_epi8(loadPixel<BYTES>(previous), zero);
+    __m128i const bc = _mm_sub_epi16(b, c);
+    __m128i const ac = _mm_sub_epi16(a, c);
+    __m128i const pa = _mm_abs_epi16(bc);
+    __m128i const pb = _mm_abs_epi16(ac);
+    __m128i const pc = _mm_abs_epi16(_mm_add_epi16(bc, ac));
+    __m128i const smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+    __m128i const predicted = select(_mm_cmpeq_epi16(smallest, pa), a, select(_mm_cmpeq_epi16(smallest, pb), b, c));
+    __m128i const pixel = _mm_add_epi8(loadPixel<BYTES>(src), _mm_packus_epi16(predicted, predicted));
+    storePixel<BYTES>(dst, pixel);
+    c = b;
+    return _mm_unpacklo_epi8(pixel, zero);
+}
+
+/**
+ * One pixel at a time, the channels in parallel
+ */
+template<size_t BPP>
+static void unfilterPaeth(unsigned char const *const src, unsigned char const *const previous,
+                          unsigned char *const dst, size_t const size) {
+    __m128i a = _mm_setzero_si128();
+    __m128i c = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= size; i += BPP) {
+        a = unfilterPaethPixel<4>(src + i, previous + i, dst + i, a, c);
+    }
+    for (; i < size; i += BPP) {
+        a = unfilterPaethPixel<BPP>(src + i, previous + i, dst + i, a, c);
+    }
+}
+
+void unfilterPaethSsse3(unsigned char const *const src, unsigned char const *const previous,
+                        unsigned char *const dst, size_t const size, size_t const bpp) {
+    if (bpp == 4) {
+        unfilterPaeth<4>(src, previous, dst, size);
+    } else if (bpp == 3) {
+        unfilterPaeth<3>(src, previous, dst, size);
+    } else {
+        unfilterPaethScalar(src, previous, dst, size, bpp);
+    }
+}
+
+#endif
@@ -0,0 +1,177 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "DDSHeader.h"
+#include "FileIO.h"
+#include "Probe.h"
+#include "ThreadPool.h"
+
+//textures probed by each task of the batches, a probe from memory is too cheap to be a task
+static constexpr size_t PROBE_BATCH_SIZE = 1024;
+static constexpr size_t PROBE_FILE_BATCH_SIZE = 16;
+
+static constexpr unsigned char PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+static ConvertStatus probeDDS(void const *const data, size_t const size, TextureInfo &info) {
+    DDSInfo dds;
+    if (!parseDDSHeader(data, size, dds)) {
+        return CONVERT_ERROR_DECODE;
+    }
+    if (dds.width > UINT32_MAX || dds.height > UINT32_MAX || dds.depth > UINT32_MAX || dds.mipLevels > UINT32_MAX
+        || dds.arraySize > UINT32_MAX) {
+        return CONVERT_ERROR_DECODE;
+    }
+
+    info.container = TEXTURE_CONTAINER_DDS;
+    info.width = static_cast<uint32_t>(dds.width);
+    info.height = static_cast<uint32_t>(dds.height);
+    info.depth = static_cast<uint32_t>(dds.depth);
+    info.mipLevels = static_cast<uint32_t>(dds.mipLevels);
+    info.arraySize = static_cast<uint32_t>(dds.arraySize);
+    info.format = dds.format;
+    info.cubemap = dds.cubemap;
+    info.volume = dds.volume;
+    info.dx10ext = dds.dx10ext;
+    return CONVERT_OK;
+}
+
+static ConvertStatus probePNG(void const *const data, size_t const size, TextureInfo &info) {
+    PngHeader header;
+    if (!readPngHeader(static_cast<unsigned char const *>(data), size, header)) {
+        return CONVERT_ERROR_DECODE;
+    }
+
+    info.container = TEXTURE_CONTAINER_PNG;
+    info.width = header.width;
+    info.height = header.height;
+    info.depth = 1;
+    info.mipLevels = 1;
+    info.arraySize = 1;
+    info.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    info.bitDepth = header.bitDepth;
+    info.colorType = header.colorType;
+    return CONVERT_OK;
+}
+
+/**
+ * Read the metadata of a DDS or PNG texture. Only the headers are parsed, the pixel data is not touched.
+ *
+ * @param data The texture, PROBE_HEADER_SIZE bytes are enough for any container
+ * @param size The size(in bytes) of data
+ * @param info Receives the metadata
+ * @return CONVERT_OK on success, CONVERT_ERROR_DECODE when the headers are invalid or the container is unknown
+ */
+[[maybe_unused]] ConvertStatus probeTexture(void const *const data, size_t const size, TextureInfo *const info) {
+    if (data == nullptr || info == nullptr) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::memset(info, 0, sizeof(TextureInfo));
+    if (size >= sizeof(uint32_t) && std::memcmp(data, "DDS ", sizeof(uint32_t)) == 0) {
+        return probeDDS(data, size, *info);
+    }
+    if (size >= sizeof(PNG_SIGNATURE) && std::memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0) {
+        return probePNG(data, size, *info);
+    }
+    return CONVERT_ERROR_DECODE;
+}
+
+static ConvertStatus getFirstError(ConvertStatus const *const statuses, size_t const count) {
+    for (size_t i = 0; i < count; i++) {
+        if (statuses[i] != CONVERT_OK) {
+            return statuses[i];
+        }
+    }
+    return CONVERT_OK;
+}
+
+/**
+ * Probe many textures in parallel on the shared work-stealing pool. Errors are not printed.
+ *
+ * @param data The textures, each one can be a memory-mapped file
+ * @param sizes The size(in bytes) of each texture
+ * @param count Number of textures
+ * @param infos Receives the metadata of each texture
+ * @param statuses Receives the status of each texture
+ * @return CONVERT_OK when every texture was probed, otherwise the status of the first failure
+ */
+[[maybe_unused]] ConvertStatus probeTextures(void const *const *const data, size_t const *const sizes,
+                                             size_t const count, TextureInfo *const infos,
+                                             ConvertStatus *const statuses) {
+    if (count > 0 && (data == nullptr || sizes == nullptr || infos == nullptr || statuses == nullptr)) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    size_t const batches = (count + PROBE_BATCH_SIZE - 1) / PROBE_BATCH_SIZE;
+    getThreadPool()->parallelFor(batches, [=](size_t const batch, [[maybe_unused]] size_t const worker) {
+        size_t const end = std::min(count, (batch + 1) * PROBE_BATCH_SIZE);
+
+        ErrorOutputScope const errors(false);
+        for (size_t i = batch * PROBE_BATCH_SIZE; i < end; i++) {
+            statuses[i] = probeTexture(data[i], sizes[i], &infos[i]);
+        }
+    });
+
+    return getFirstError(statuses, count);
+}
+
+/**
+ * Probe many texture files in parallel on the shared work-stealing pool. Only the first PROBE_HEADER_SIZE bytes of
+ * each file are read. Errors are not printed.
+ *
+ * @param paths The files, UTF-8 encoded
+ * @param count Number of files
+ * @param infos Receives the metadata of each file
+ * @param statuses Receives the status of each file, CONVERT_ERROR_IO when it can't be read
+ * @return CONVERT_OK when every file was probed, otherwise the status of the first failure
+ */
+[[maybe_unused]] ConvertStatus probeTextureFiles(char const *const *const paths, size_t const count,
+                                                 TextureInfo *const infos, ConvertStatus *const statuses) {
+    if (count > 0 && (paths == nullptr || infos == nullptr || statuses == nullptr)) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    size_t const batches = (count + PROBE_FILE_BATCH_SIZE - 1) / PROBE_FILE_BATCH_SIZE;
+    getThreadPool()->parallelFor(batches, [=](size_t const batch, [[maybe_unused]] size_t const worker) {
+        size_t const end = std::min(count, (batch + 1) * PROBE_FILE_BATCH_SIZE);
+        unsigned char header[PROBE_HEADER_SIZE];
+
+        ErrorOutputScope const errors(false);
+        for (size_t i = batch * PROBE_FILE_BATCH_SIZE; i < end; i++) {
+            size_t size = 0;
+            if (paths[i] == nullptr || !readFilePrefix(paths[i], header, sizeof(header), size)) {
+                std::memset(&infos[i], 0, sizeof(TextureInfo));
+                statuses[i] = CONVERT_ERROR_IO;
+                continue;
+            }
+            statuses[i] = probeTexture(header, size, &infos[i]);
+        }
+    });
+
+    return getFirstError(statuses, count);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstdint>
+#include "DxTexWrapper.h"
+
+enum TextureContainer : int {
+    TEXTURE_CONTAINER_UNKNOWN = 0,
+    TEXTURE_CONTAINER_DDS = 1,
+    TEXTURE_CONTAINER_PNG = 2,
+};
+
+/**
+ * Metadata of a texture, read from the DDS headers or the PNG IHDR
+ */
+class TextureInfo {
+public:
+    TextureContainer container;
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t mipLevels;
+    //number of 2D images per mip level, 6 per cube for cubemaps
+    uint32_t arraySize;
+    //format of the DDS, for a PNG the format written by convertPNGtoDDS without bgra
+    DXGI_FORMAT format;
+    bool cubemap;
+    bool volume;
+    bool dx10ext;
+    //IHDR bit depth and color type of a PNG, 0 for DDS
+    uint8_t bitDepth;
+    uint8_t colorType;
+};
+
+//bytes needed to probe any supported container: DDS magic, DDS_HEADER and DDS_HEADER_DXT10
+constexpr size_t PROBE_HEADER_SIZE = 148;
+
+extern "C" {
+[[maybe_unused]] LIBEXPORT ConvertStatus probeTexture(void const *data, size_t size, TextureInfo *info);
+[[maybe_unused]] LIBEXPORT ConvertStatus probeTextures(void const *const *data, size_t const *sizes, size_t count,
+                                                       TextureInfo *infos, ConvertStatus *statuses);
+[[maybe_unused]] LIBEXPORT ConvertStatus probeTextureFiles(char const *const *paths, size_t count, TextureInfo *infos,
+                                                           ConvertStatus *statuses);
+}
@@ -0,0 +1,249 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include "ScratchArena.h"
+#include "Stats.h"
+
+//smallest block, the spng buffers of small images share one block
+static constexpr size_t MIN_BLOCK_SIZE = size_t{1} << 20;
+//memory a thread keeps after a conversion, larger conversions allocate every time
+static std::atomic<size_t> arenaTrim{size_t{64} << 20};
+
+/**
+ * Stored before every allocation, for reallocate and release
+ */
+class AllocationHeader {
+public:
+    size_t size;
+    //'used' of the block before the allocation
+    size_t previousUsed;
+};
+
+static size_t alignUp(size_t const value, size_t const alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static AllocationHeader &getHeader(void *const pointer) {
+    return *reinterpret_cast<AllocationHeader *>(static_cast<unsigned char *>(pointer) - sizeof(AllocationHeader));
+}
+
+ScratchArena::~ScratchArena() {
+    for (Block const &block: blocks) {
+        ::operator delete(block.memory, std::align_val_t(ARENA_ALIGNMENT));
+    }
+}
+
+bool ScratchArena::addBlock(size_t const minimum) {
+    //blocks grow with the arena, a conversion needs few of them
+    size_t const size = alignUp(std::max({minimum, MIN_BLOCK_SIZE, getCapacity()}), ARENA_ALIGNMENT);
+    auto *memory = static_cast<unsigned char *>(::operator new(size, std::align_val_t(ARENA_ALIGNMENT),
+                                                                std::nothrow));
+    if (memory == nullptr) {
+        return false;
+    }
+    StatsScope::countAllocation(size);
+    blocks.push_back({memory, size, 0});
+    return true;
+}
+
+void *ScratchArena::allocate(size_t const size) {
+    if (size > SIZE_MAX / 2) {
+        return nullptr;
+    }
+    for (;; current++) {
+        //a block added for a large buffer also fits the small ones that follow it, like the PNG decoder after the mip
+        //chain it decodes into
+        size_t const spare = size >= MIN_BLOCK_SIZE ? MIN_BLOCK_SIZE : 0;
+        if (current == blocks.size() && !addBlock(size + spare + sizeof(AllocationHeader) + ARENA_ALIGNMENT)) {
+            //the blocks before stay where they are, 'current' points to the last one again
+            current = blocks.empty() ? 0 : blocks.size() - 1;
+            return nullptr;
+        }
+        Block &block = blocks[current];
+        size_t const start = alignUp(block.used + sizeof(AllocationHeader), ARENA_ALIGNMENT);
+        if (start <= block.size && size <= block.size - start) {
+            unsigned char *const pointer = block.memory + start;
+            getHeader(pointer) = {size, block.used};
+            block.used = start + size;
+            peak = std::max(peak, committed + block.used);
+            return pointer;
+        }
+        committed += block.used;
+    }
+}
+
+bool ScratchArena::isLast(void const *const pointer) const {
+    if (current >= blocks.size()) {
+        return false;
+    }
+    Block const &block = blocks[current];
+    auto const *const bytes = static_cast<unsigned char const *>(pointer);
+    if (bytes < block.memory || bytes >= block.memory + block.size) {
+        return false;
+    }
+    return static_cast<size_t>(bytes - block.memory) + getHeader(const_cast<void *>(pointer)).size == block.used;
+}
+
+void *ScratchArena::reallocate(void *const pointer, size_t const size) {
+    if (pointer == nullptr) {
+        return allocate(size);
+    }
+    AllocationHeader &header = getHeader(pointer);
+    if (isLast(pointer)) {
+        Block &block = blocks[current];
+        size_t const offset = static_cast<size_t>(static_cast<unsigned char *>(pointer) - block.memory);
+        if (size <= block.size - offset) {
+            header.size = size;
+            block.used = offset + size;
+            peak = std::max(peak, committed + block.used);
+            return pointer;
+        }
+    }
+
+    void *const moved = allocate(size);
+    if (moved != nullptr) {
+        std::memcpy(moved, pointer, std::min(header.size, size));
+    }
+    return moved;
+}
+
+void ScratchArena::release(void *const pointer) {
+    if (pointer != nullptr && isLast(pointer)) {
+        blocks[current].used = getHeader(pointer).previousUsed;
+    }
+}
+
+bool ScratchArena::contains(void const *const pointer) const {
+    auto const *const bytes = static_cast<unsigned char const *>(pointer);
+    return std::any_of(blocks.begin(), blocks.end(), [bytes](Block const &block) {
+        return bytes >= block.memory && bytes < block.memory + block.size;
+    });
+}
+
+size_t ScratchArena::getCapacity() const {
+    size_t capacity = 0;
+    for (Block const &block: blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+void ScratchArena::reset() {
+    size_t const trim = arenaTrim.load(std::memory_order_relaxed);
+    //a single block large enough for the conversions so far, or nothing when over the trim size
+    if (blocks.size() > 1 || getCapacity() > trim) {
+        //the padding lost at the end of each block is not part of the peak
+        size_t const required = peak + blocks.size() * (sizeof(AllocationHeader) + ARENA_ALIGNMENT);
+        for (Block const &block: blocks) {
+            ::operator delete(block.memory, std::align_val_t(ARENA_ALIGNMENT));
+        }
+        blocks.clear();
+        if (peak > 0 && required <= trim) {
+            addBlock(required);
+        }
+    }
+    for (Block &block: blocks) {
+        block.used = 0;
+    }
+    current = 0;
+    committed = 0;
+    peak = 0;
+
+    if (imageData.getPixels().capacity() > trim) {
+        std::vector<unsigned char>().swap(imageData.getPixels());
+    }
+}
+
+void ScratchArena::rewind(size_t const block, size_t const used) {
+    if (blocks.empty()) {
+        return;
+    }
+    current = block;
+    blocks[current].used = used;
+    committed = 0;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (i < current) {
+            committed += blocks[i].used;
+        } else if (i > current) {
+            blocks[i].used = 0;
+        }
+    }
+}
+
+ScratchArena &getScratchArena() {
+    static thread_local ScratchArena arena;
+    return arena;
+}
+
+#ifdef DXTWRAPPER_USE_LIBSPNG
+
+static void *SPNG_CDECL arenaMalloc(size_t const size) {
+    return getScratchArena().allocate(size);
+}
+
+static void *SPNG_CDECL arenaRealloc(void *const pointer, size_t const size) {
+    return getScratchArena().reallocate(pointer, size);
+}
+
+static void *SPNG_CDECL arenaCalloc(size_t const count, size_t const size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return nullptr;
+    }
+    void *const pointer = getScratchArena().allocate(count * size);
+    if (pointer != nullptr) {
+        std::memset(pointer, 0, count * size);
+    }
+    return pointer;
+}
+
+static void SPNG_CDECL arenaFree(void *const pointer) {
+    getScratchArena().release(pointer);
+}
+
+spng_ctx *newSpngContext(int const flags) {
+    if (!getScratchArena().isActive()) {
+        return spng_ctx_new(flags);
+    }
+    spng_alloc alloc{arenaMalloc, arenaRealloc, arenaCalloc, arenaFree};
+    return spng_ctx_new2(&alloc, flags);
+}
+
+#endif
+
+/**
+ * Set the memory each thread keeps for the next conversions. The scratch memory of a conversion that needs more is
+ * released when it ends.
+ *
+ * @param bytes Memory kept per thread, 0 to release everything after each conversion. The default is 64MB.
+ */
+[[maybe_unused]] void setScratchArenaTrim(size_t const bytes) {
+    arenaTrim.store(bytes, std::memory_order_relaxed);
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "DxTexWrapper.h"
+
+#ifdef DXTWRAPPER_USE_LIBSPNG
+#include <spng.h>
+#endif
+
+//alignment of every allocation, enough for the widest SIMD loads and a cache line
+constexpr size_t ARENA_ALIGNMENT = 64;
+
+/**
+ * Bump allocator for the intermediate buffers of the conversions, one per thread. Memory is taken from blocks kept
+ * between conversions, so after the first conversions of a given size a thread converts without allocating. Buffers
+ * are not freed one by one: the arena is reset when the outermost ArenaScope of the thread ends, or rewound when an
+ * ArenaFrame ends. A frame that started on an empty arena outside of any scope resets it too. On reset the blocks are
+ * merged into one block of the memory used by the conversion, unless it exceeds the trim size set with
+ * setScratchArenaTrim.
+ */
+class ScratchArena {
+public:
+    ScratchArena() = default;
+
+    ~ScratchArena();
+
+    ScratchArena(ScratchArena const &) = delete;
+
+    ScratchArena &operator=(ScratchArena const &) = delete;
+
+    /**
+     * Allocate 'size' bytes aligned to ARENA_ALIGNMENT, nullptr when out of memory
+     */
+    void *allocate(size_t size);
+
+    /**
+     * Resize an allocation like realloc, the last allocation grows in place when its block has room
+     */
+    void *reallocate(void *pointer, size_t size);
+
+    /**
+     * Free an allocation. The memory is reused right away only for the last allocation, otherwise on reset.
+     */
+    void release(void *pointer);
+
+    template<typename T>
+    T *allocateArray(size_t const count) {
+        return count > SIZE_MAX / sizeof(T) ? nullptr : static_cast<T *>(allocate(count * sizeof(T)));
+    }
+
+    /**
+     * True when 'pointer' was allocated from this arena
+     */
+    [[nodiscard]] bool contains(void const *pointer) const;
+
+    /**
+     * True inside an ArenaScope, where allocations are released by the reset
+     */
+    [[nodiscard]] bool isActive() const {
+        return depth > 0;
+    }
+
+    /**
+     * Decode buffer of the PNG conversions of this thread, released on reset when larger than the trim size
+     */
+    ImageData &getImageData() {
+        return imageData;
+    }
+
+    [[nodiscard]] size_t getCapacity() const;
+
+private:
+    friend class ArenaScope;
+
+    friend class ArenaFrame;
+
+    class Block {
+    public:
+        unsigned char *memory;
+        size_t size;
+        size_t used;
+    };
+
+    bool addBlock(size_t minimum);
+
+    //true for the allocation at the end of the current block
+    [[nodiscard]] bool isLast(void const *pointer) const;
+
+    void reset();
+
+    void rewind(size_t block, size_t used);
+
+    std::vector<Block> blocks;
+    //block allocations are taken from, the blocks after it are unused
+    size_t current = 0;
+    //bytes used in the blocks before 'current'
+    size_t committed = 0;
+    //most bytes used at once since the last reset
+    size_t peak = 0;
+    size_t depth = 0;
+    ImageData imageData;
+};
+
+/**
+ * Arena of the current thread
+ */
+ScratchArena &getScratchArena();
+
+/**
+ * A conversion on the current thread, the arena is reset when the outermost scope ends. Nothing allocated from the
+ * arena may outlive the scope.
+ */
+class ArenaScope {
+public:
+    ArenaScope() : arena(getScratchArena()) {
+        arena.depth++;
+    }
+
+    ~ArenaScope() {
+        if (--arena.depth == 0) {
+            arena.reset();
+        }
+    }
+
+    ArenaScope(ArenaScope const &) = delete;
+
+    ArenaScope &operator=(ArenaScope const &) = delete;
+
+    ScratchArena &arena;
+};
+
+/**
+ * Temporary buffers of the current thread, everything allocated from the arena after the frame started is released when
+ * it ends. Used by tasks of the thread pool, which may run on threads outside of any conversion: there the outermost
+ * frame resets the arena like an ArenaScope, so the workers keep no more than the trim size between tasks.
+ */
+class ArenaFrame {
+public:
+    ArenaFrame() : arena(getScratchArena()), block(arena.current),
+                   used(arena.blocks.empty() ? 0 : arena.blocks[arena.current].used) {
+    }
+
+    ~ArenaFrame() {
+        //nothing was allocated before the frame, the reset releases only its buffers
+        if (arena.depth == 0 && block == 0 && used == 0) {
+            arena.reset();
+        } else {
+            arena.rewind(block, used);
+        }
+    }
+
+    ArenaFrame(ArenaFrame const &) = delete;
+
+    ArenaFrame &operator=(ArenaFrame const &) = delete;
+
+    ScratchArena &arena;
+
+private:
+    size_t block;
+    size_t used;
+};
+
+#ifdef DXTWRAPPER_USE_LIBSPNG
+
+/**
+ * Create a spng context, its buffers come from the arena of the current thread inside an ArenaScope. The context must
+ * be used and freed by the same thread, in the same scope.
+ */
+spng_ctx *newSpngContext(int flags);
+
+#endif
+
+extern "C" {
+[[maybe_unused]] LIBEXPORT void setScratchArenaTrim(size_t bytes);
+}
@@ -0,0 +1,334 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include "Stats.h"
+
+std::atomic<unsigned int> statsFlags{0};
+
+//fields of StageStats, in the order of the class
+enum StatsField : size_t {
+    FIELD_COUNT = 0,
+    FIELD_FAILURES = 1,
+    FIELD_TOTAL_NANOSECONDS = 2,
+    FIELD_MAX_NANOSECONDS = 3,
+    FIELD_BYTES_IN = 4,
+    FIELD_BYTES_OUT = 5,
+    FIELD_ALLOCATIONS = 6,
+    FIELD_ALLOCATED_BYTES = 7,
+    FIELD_HISTOGRAM = 8,
+};
+constexpr size_t STATS_FIELDS = FIELD_HISTOGRAM + STATS_HISTOGRAM_BUCKETS;
+
+/**
+ * Counters of one thread. Only the owner writes them and getStats reads them concurrently, so they are atomics updated
+ * with relaxed loads and stores instead of locked read-modify-write operations.
+ */
+class ThreadStats {
+public:
+    ThreadStats();
+
+    ~ThreadStats();
+
+    ThreadStats(ThreadStats const &) = delete;
+
+    ThreadStats &operator=(ThreadStats const &) = delete;
+
+    void add(StatsStage const stage, size_t const field, uint64_t const value) {
+        std::atomic<uint64_t> &counter = counters[stage][field];
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void setMax(StatsStage const stage, size_t const field, uint64_t const value) {
+        std::atomic<uint64_t> &counter = counters[stage][field];
+        if (value > counter.load(std::memory_order_relaxed)) {
+            counter.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<uint64_t> counters[STATS_STAGE_COUNT][STATS_FIELDS]{};
+    //resetStats increments the global epoch, counters of an older epoch are treated as zero
+    std::atomic<uint64_t> epoch{0};
+};
+
+class StatsRegistry {
+public:
+    std::mutex mutex;
+    std::vector<ThreadStats *> threads;
+    //counters of the threads that exited
+    uint64_t retired[STATS_STAGE_COUNT][STATS_FIELDS]{};
+    std::atomic<uint64_t> epoch{0};
+};
+
+class TraceCallbacks {
+public:
+    TraceBeginCallback begin;
+    TraceEndCallback end;
+    void *userData;
+};
+
+//never destroyed, the workers of the shared pool can exit after the static destructors
+static StatsRegistry &getStatsRegistry() {
+    static auto *registry = new StatsRegistry();
+    return *registry;
+}
+
+static std::mutex traceMutex;
+static TraceCallbacks traceCallbacks{};
+
+//innermost active scope of the current thread, allocations are counted there
+static thread_local StatsScope *currentScope = nullptr;
+
+static void mergeCounter(uint64_t (&total)[STATS_STAGE_COUNT][STATS_FIELDS], size_t const stage, size_t const field,
+                         uint64_t const value) {
+    if (field == FIELD_MAX_NANOSECONDS) {
+        total[stage][field] = std::max(total[stage][field], value);
+    } else {
+        total[stage][field] += value;
+    }
+}
+
+ThreadStats::ThreadStats() {
+    StatsRegistry &registry = getStatsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    epoch.store(registry.epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    registry.threads.push_back(this);
+}
+
+ThreadStats::~ThreadStats() {
+    StatsRegistry &registry = getStatsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (epoch.load(std::memory_order_relaxed) == registry.epoch.load(std::memory_order_relaxed)) {
+        for (size_t stage = 0; stage < STATS_STAGE_COUNT; stage++) {
+            for (size_t field = 0; field < STATS_FIELDS; field++) {
+                mergeCounter(registry.retired, stage, field, counters[stage][field].load(std::memory_order_relaxed));
+            }
+        }
+    }
+    registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+}
+
+static ThreadStats &getThreadStats() {
+    static thread_local ThreadStats threadStats;
+    return threadStats;
+}
+
+static size_t getHistogramBucket(uint64_t const nanoseconds) {
+    uint64_t microseconds = nanoseconds / 1000;
+    size_t bucket = 0;
+    while (microseconds != 0 && bucket + 1 < STATS_HISTOGRAM_BUCKETS) {
+        microseconds >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void StatsScope::begin(unsigned int const activeFlags, StatsStage const activeStage, size_t const bytes) {
+    flags = activeFlags;
+    stage = activeStage;
+    bytesIn = bytes;
+    parent = currentScope;
+    currentScope = this;
+
+    if ((flags & STATS_TRACING) != 0) {
+        TraceCallbacks callbacks{};
+        {
+            std::lock_guard<std::mutex> lock(traceMutex);
+            callbacks = traceCallbacks;
+        }
+        //the span ends with the callbacks it started with
+        endCallback = callbacks.end;
+        userData = callbacks.userData;
+        if (callbacks.begin != nullptr) {
+            span = callbacks.begin(stage, userData);
+        }
+    }
+    start = std::chrono::steady_clock::now();
+}
+
+void StatsScope::end() {
+    auto const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    auto const nanoseconds = static_cast<uint64_t>(elapsed.count());
+    currentScope = parent;
+    if (parent != nullptr) {
+        parent->allocations += allocations;
+        parent->allocatedBytes += allocatedBytes;
+    }
+
+    if ((flags & STATS_ENABLED) != 0) {
+        ThreadStats &thread = getThreadStats();
+        uint64_t const epoch = getStatsRegistry().epoch.load(std::memory_order_acquire);
+        if (thread.epoch.load(std::memory_order_relaxed) != epoch) {
+            for (auto &counters: thread.counters) {
+                for (auto &counter: counters) {
+                    counter.store(0, std::memory_order_relaxed);
+                }
+            }
+            thread.epoch.store(epoch, std::memory_order_release);
+        }
+        thread.add(stage, FIELD_COUNT, 1);
+        thread.add(stage, FIELD_FAILURES, status != CONVERT_OK ? 1 : 0);
+        thread.add(stage, FIELD_TOTAL_NANOSECONDS, nanoseconds);
+        thread.setMax(stage, FIELD_MAX_NANOSECONDS, nanoseconds);
+        thread.add(stage, FIELD_BYTES_IN, bytesIn);
+        thread.add(stage, FIELD_BYTES_OUT, bytesOut);
+        thread.add(stage, FIELD_ALLOCATIONS, allocations);
+        thread.add(stage, FIELD_ALLOCATED_BYTES, allocatedBytes);
+        thread.add(stage, FIELD_HISTOGRAM + getHistogramBucket(nanoseconds), 1);
+    }
+
+    if ((flags & STATS_TRACING) != 0 && endCallback != nullptr) {
+        TraceSpan const info{stage, status, nanoseconds, bytesIn, bytesOut};
+        endCallback(span, &info, userData);
+    }
+}
+
+void StatsScope::countAllocation(size_t const bytes) {
+    StatsScope *const scope = currentScope;
+    if (scope != nullptr) {
+        scope->allocations++;
+        scope->allocatedBytes += bytes;
+    }
+}
+
+/**
+ * Enable or disable the counters read by getStats, disabled by default. Counters already recorded are kept.
+ *
+ * @param enabled True to record every stage of the conversions
+ */
+[[maybe_unused]] void setStatsEnabled(bool const enabled) {
+    if (enabled) {
+        statsFlags.fetch_or(STATS_ENABLED);
+    } else {
+        statsFlags.fetch_and(~STATS_ENABLED);
+    }
+}
+
+/**
+ * Read the counters of every stage, summed over all threads since the last resetStats
+ *
+ * @param stats Receives the counters
+ * @return CONVERT_OK on success
+ */
+[[maybe_unused]] ConvertStatus getStats(ConvertStats *const stats) {
+    if (stats == nullptr) {
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    uint64_t total[STATS_STAGE_COUNT][STATS_FIELDS]{};
+    {
+        StatsRegistry &registry = getStatsRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        std::copy(&registry.retired[0][0], &registry.retired[0][0] + STATS_STAGE_COUNT * STATS_FIELDS, &total[0][0]);
+        uint64_t const epoch = registry.epoch.load(std::memory_order_relaxed);
+        for (ThreadStats const *thread: registry.threads) {
+            if (thread->epoch.load(std::memory_order_acquire) != epoch) {
+                continue;
+            }
+            for (size_t stage = 0; stage < STATS_STAGE_COUNT; stage++) {
+                for (size_t field = 0; field < STATS_FIELDS; field++) {
+                    mergeCounter(total, stage, field, thread->counters[stage][field].load(std::memory_order_relaxed));
+                }
+            }
+        }
+    }
+
+    for (size_t stage = 0; stage < STATS_STAGE_COUNT; stage++) {
+        StageStats &s = stats->stages[stage];
+        s.count = total[stage][FIELD_COUNT];
+        s.failures = total[stage][FIELD_FAILURES];
+        s.totalNanoseconds = total[stage][FIELD_TOTAL_NANOSECONDS];
+        s.maxNanoseconds = total[stage][FIELD_MAX_NANOSECONDS];
+        s.bytesIn = total[stage][FIELD_BYTES_IN];
+        s.bytesOut = total[stage][FIELD_BYTES_OUT];
+        s.allocations = total[stage][FIELD_ALLOCATIONS];
+        s.allocatedBytes = total[stage][FIELD_ALLOCATED_BYTES];
+        for (size_t bucket = 0; bucket < STATS_HISTOGRAM_BUCKETS; bucket++) {
+            s.histogram[bucket] = total[stage][FIELD_HISTOGRAM + bucket];
+        }
+    }
+    return CONVERT_OK;
+}
+
+/**
+ * Reset the counters of every thread. Spans running while resetting may be lost.
+ */
+[[maybe_unused]] void resetStats() {
+    StatsRegistry &registry = getStatsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::fill(&registry.retired[0][0], &registry.retired[0][0] + STATS_STAGE_COUNT * STATS_FIELDS, 0);
+    //the threads zero their counters on their next span
+    registry.epoch.fetch_add(1, std::memory_order_release);
+}
+
+/**
+ * Set the callbacks called when each stage begins and ends, on the thread running it. Tracing is disabled when both are
+ * nullptr.
+ *
+ * @param begin Called when a stage starts, may be nullptr
+ * @param end Called when a stage ends, may be nullptr
+ * @param userData Passed unmodified to the callbacks, which must be thread-safe
+ */
+[[maybe_unused]] void setTraceCallbacks(TraceBeginCallback const begin, TraceEndCallback const end,
+                                        void *const userData) {
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        traceCallbacks = {begin, end, userData};
+    }
+    if (begin != nullptr || end != nullptr) {
+        statsFlags.fetch_or(STATS_TRACING);
+    } else {
+        statsFlags.fetch_and(~STATS_TRACING);
+    }
+}
+
+/**
+ * Name of a stage, for logs and metrics
+ */
+[[maybe_unused]] char const *getStatsStageName(StatsStage const stage) {
+    switch (stage) {
+        case STATS_STAGE_PNG_TO_DDS:
+            return "png-to-dds";
+        case STATS_STAGE_DDS_TO_PNG:
+            return "dds-to-png";
+        case STATS_STAGE_PNG_DECODE:
+            return "png-decode";
+        case STATS_STAGE_PNG_ENCODE:
+            return "png-encode";
+        case STATS_STAGE_MIP_GENERATION:
+            return "mip-generation";
+        case STATS_STAGE_BC_ENCODE:
+            return "bc-encode";
+        case STATS_STAGE_DDS_LOAD:
+            return "dds-load";
+        case STATS_STAGE_DDS_WRITE:
+            return "dds-write";
+        default:
+            return "unknown";
+    }
+}
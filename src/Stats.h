@@ -0,0 +1,169 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "DxTexWrapper.h"
+
+//stages recorded by the counters and the trace callbacks
+enum StatsStage : int {
+    //whole conversions, their time includes the stages below
+    STATS_STAGE_PNG_TO_DDS = 0,
+    STATS_STAGE_DDS_TO_PNG = 1,
+    STATS_STAGE_PNG_DECODE = 2,
+    STATS_STAGE_PNG_ENCODE = 3,
+    STATS_STAGE_MIP_GENERATION = 4,
+    STATS_STAGE_BC_ENCODE = 5,
+    //reading an image from a DDS, BC decoding included
+    STATS_STAGE_DDS_LOAD = 6,
+    STATS_STAGE_DDS_WRITE = 7,
+    STATS_STAGE_COUNT = 8,
+};
+
+//bucket 0 counts spans under 1us, bucket i spans of [2^(i-1), 2^i) us, the last bucket everything longer
+constexpr size_t STATS_HISTOGRAM_BUCKETS = 32;
+
+/**
+ * Counters of one stage, summed over every thread since the last resetStats
+ */
+class StageStats {
+public:
+    uint64_t count;
+    //spans that returned an error
+    uint64_t failures;
+    uint64_t totalNanoseconds;
+    uint64_t maxNanoseconds;
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+    //buffers allocated for images and outputs, including the stages nested in this one
+    uint64_t allocations;
+    uint64_t allocatedBytes;
+    uint64_t histogram[STATS_HISTOGRAM_BUCKETS];
+};
+
+class ConvertStats {
+public:
+    StageStats stages[STATS_STAGE_COUNT];
+};
+
+/**
+ * A finished span, passed to the end callback
+ */
+class TraceSpan {
+public:
+    StatsStage stage;
+    ConvertStatus status;
+    uint64_t durationNanoseconds;
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+};
+
+/**
+ * Called on the converting thread when a stage starts
+ *
+ * @return Handle of the span in the host tracer, passed to the end callback
+ */
+typedef void *(*TraceBeginCallback)(StatsStage stage, void *userData);
+
+/**
+ * Called on the converting thread when a stage ends, with the handle returned by the begin callback
+ */
+typedef void (*TraceEndCallback)(void *span, TraceSpan const *info, void *userData);
+
+//STATS_ENABLED and STATS_TRACING flags, a single load decides if a span does anything
+extern std::atomic<unsigned int> statsFlags;
+constexpr unsigned int STATS_ENABLED = 1;
+constexpr unsigned int STATS_TRACING = 2;
+
+/**
+ * Records a stage from construction to destruction. With stats and tracing disabled it costs one relaxed load.
+ */
+class StatsScope {
+public:
+    StatsScope(StatsStage const stage, size_t const bytesIn) {
+        unsigned int const flags = statsFlags.load(std::memory_order_relaxed);
+        if (flags != 0) {
+            begin(flags, stage, bytesIn);
+        }
+    }
+
+    ~StatsScope() {
+        if (flags != 0) {
+            end();
+        }
+    }
+
+    StatsScope(StatsScope const &) = delete;
+
+    StatsScope &operator=(StatsScope const &) = delete;
+
+    void setBytesIn(size_t const bytes) {
+        bytesIn = bytes;
+    }
+
+    /**
+     * Set the result of the stage, returns 'result'
+     */
+    ConvertStatus finish(ConvertStatus const result, size_t const bytes) {
+        status = result;
+        bytesOut = bytes;
+        return result;
+    }
+
+    /**
+     * Count an allocation of the current thread in its innermost stage
+     */
+    static void countAllocation(size_t bytes);
+
+private:
+    void begin(unsigned int flags, StatsStage stage, size_t bytesIn);
+
+    void end();
+
+    unsigned int flags = 0;
+    StatsStage stage = STATS_STAGE_PNG_TO_DDS;
+    ConvertStatus status = CONVERT_OK;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+    std::chrono::steady_clock::time_point start;
+    StatsScope *parent = nullptr;
+    void *span = nullptr;
+    TraceEndCallback endCallback = nullptr;
+    void *userData = nullptr;
+};
+
+extern "C" {
+[[maybe_unused]] LIBEXPORT void setStatsEnabled(bool enabled);
+[[maybe_unused]] LIBEXPORT ConvertStatus getStats(ConvertStats *stats);
+[[maybe_unused]] LIBEXPORT void resetStats();
+[[maybe_unused]] LIBEXPORT void setTraceCallbacks(TraceBeginCallback begin, TraceEndCallback end, void *userData);
+[[maybe_unused]] LIBEXPORT char const *getStatsStageName(StatsStage stage);
+}
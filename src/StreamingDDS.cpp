@@ -0,0 +1,181 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <DirectXTex.h>
+#include "DxTexWrapper.h"
+#include "MipGenerator.h"
+#include "PngDecoder.h"
+#include "ScratchArena.h"
+#include "StreamingDDS.h"
+#include "Swizzle.h"
+
+#ifdef DXTWRAPPER_USE_LIBSPNG
+#include <spng.h>
+#endif
+
+static constexpr size_t BYTES_PER_PIXEL = 4;
+
+MipRowStreamer::MipRowStreamer(unsigned char *pixels, size_t width, size_t height, size_t const mipLevels) {
+    for (size_t i = 0; i < mipLevels; i++) {
+        levels.push_back({pixels, width, height, 0});
+        pixels += width * height * BYTES_PER_PIXEL;
+        width = std::max<size_t>(width / 2, 1);
+        height = std::max<size_t>(height / 2, 1);
+    }
+}
+
+unsigned char *MipRowStreamer::getNextRow() const {
+    Level const &base = levels.front();
+    return base.pixels + base.rowsDone * base.width * BYTES_PER_PIXEL;
+}
+
+bool MipRowStreamer::isComplete() const {
+    return levels.back().rowsDone == levels.back().height;
+}
+
+void MipRowStreamer::pushRow() {
+    levels.front().rowsDone++;
+
+    for (size_t i = 0; i + 1 < levels.size(); i++) {
+        Level const &source = levels[i];
+        Level &destination = levels[i + 1];
+        if (destination.rowsDone == destination.height) {
+            return;
+        }
+
+        //the last row of the next level also covers the odd row left at the end of this level
+        size_t const y = destination.rowsDone;
+        size_t const lastSourceRow = y + 1 == destination.height ? source.height : std::min(2 * y + 2, source.height);
+        if (source.rowsDone < lastSourceRow) {
+            return;
+        }
+
+        reduceRow(source, destination, y);
+        destination.rowsDone++;
+    }
+}
+
+void MipRowStreamer::reduceRow(Level const &source, Level &destination, size_t const y) const {
+    DirectX::Image sourceImage{};
+    sourceImage.width = source.width;
+    sourceImage.height = source.height;
+    sourceImage.rowPitch = source.width * BYTES_PER_PIXEL;
+    sourceImage.pixels = source.pixels;
+    DirectX::Image destinationImage{};
+    destinationImage.width = destination.width;
+    destinationImage.height = destination.height;
+    destinationImage.rowPitch = destination.width * BYTES_PER_PIXEL;
+    destinationImage.pixels = destination.pixels;
+    reduceMipBox(sourceImage, destinationImage, 0, destination.width, y, y + 1);
+}
+
+size_t getMipChainPixelsSize(size_t width, size_t height, size_t const mipLevels) {
+    size_t size = 0;
+    for (size_t i = 0; i < mipLevels; i++) {
+        size += width * height * BYTES_PER_PIXEL;
+        width = std::max<size_t>(width / 2, 1);
+        height = std::max<size_t>(height / 2, 1);
+    }
+    return size;
+}
+
+#ifdef DXTWRAPPER_USE_LIBSPNG
+
+ConvertStatus streamPNGtoDDS(unsigned char const *const png, size_t const size, bool const dx10ext, bool const bgra,
+                             void *const output, size_t const capacity) {
+    spng_ctx *ctx = newSpngDecoder();
+    if (ctx == nullptr) {
+        return CONVERT_ERROR_OUT_OF_MEMORY;
+    }
+    spng_set_png_buffer(ctx, png, size);
+
+    spng_ihdr ihdr{};
+    int error = spng_get_ihdr(ctx, &ihdr);
+    if (error) {
+        printError("spng_get_ihdr() error: %s\n", spng_strerror(error));
+        spng_ctx_free(ctx);
+        return CONVERT_ERROR_DECODE;
+    }
+    if (ihdr.interlace_method != SPNG_INTERLACE_NONE) {
+        //interlaced rows arrive out of order
+        spng_ctx_free(ctx);
+        return CONVERT_ERROR_INVALID_ARGUMENT;
+    }
+
+    DirectX::TexMetadata const metadata = getMipChainMetadata(ihdr.width, ihdr.height, bgra);
+    size_t headerSize = 0;
+    HRESULT hr = DirectX::EncodeDDSHeader(metadata, getDDSFlags(dx10ext), output, capacity, headerSize);
+    if (FAILED(hr)) {
+        printError("Error writing DDS header: ");
+        printErrorDescription(hr);
+        spng_ctx_free(ctx);
+        return CONVERT_ERROR_ENCODE;
+    }
+    if (capacity - headerSize < getMipChainPixelsSize(metadata.width, metadata.height, metadata.mipLevels)) {
+        spng_ctx_free(ctx);
+        return CONVERT_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    error = spng_decode_image(ctx, nullptr, 0, SPNG_FMT_RGBA8, SPNG_DECODE_PROGRESSIVE);
+    if (error) {
+        printError("spng_decode_image() error: %s\n", spng_strerror(error));
+        spng_ctx_free(ctx);
+        return CONVERT_ERROR_DECODE;
+    }
+
+    /* Every row is decoded straight into the first level and reduced into the next levels */
+    MipRowStreamer streamer(static_cast<unsigned char *>(output) + headerSize, metadata.width, metadata.height,
+                            metadata.mipLevels);
+    size_t const rowSize = metadata.width * BYTES_PER_PIXEL;
+    do {
+        unsigned char *row = streamer.getNextRow();
+        error = spng_decode_row(ctx, row, rowSize);
+        if (error && error != SPNG_EOI) {
+            printError("spng_decode_row() error: %s\n", spng_strerror(error));
+            spng_ctx_free(ctx);
+            return CONVERT_ERROR_DECODE;
+        }
+        if (bgra) {
+            swizzleRGBAtoBGRA(row, rowSize);
+        }
+        streamer.pushRow();
+    } while (error != SPNG_EOI);
+
+    spng_ctx_free(ctx);
+    return streamer.isComplete() ? CONVERT_OK : CONVERT_ERROR_DECODE;
+}
+
+#else
+
+ConvertStatus streamPNGtoDDS([[maybe_unused]] unsigned char const *const png, [[maybe_unused]] size_t const size,
+                             [[maybe_unused]] bool const dx10ext, [[maybe_unused]] bool const bgra,
+                             [[maybe_unused]] void *const output, [[maybe_unused]] size_t const capacity) {
+    //lodepng has no progressive decoder
+    return CONVERT_ERROR_INVALID_ARGUMENT;
+}
+
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+#include <vector>
+#include "ConvertStatus.h"
+
+/**
+ * Builds the mip chain of a RGBA8/BGRA8 texture row by row, inside the DDS buffer. Each row written to a level is reduced
+ * into the next level as soon as the rows it covers are available, reading them back from the buffer, so no extra memory
+ * is needed. Even dimensions use a 2x2 box filter, the last row and column of odd dimensions are folded into the last
+ * pixel of the next level.
+ */
+class MipRowStreamer {
+public:
+    /**
+     * @param levels Pointer to the first level inside the DDS buffer, the other levels follow contiguously
+     * @param width Width of the first level
+     * @param height Height of the first level
+     * @param mipLevels Number of levels
+     */
+    MipRowStreamer(unsigned char *levels, size_t width, size_t height, size_t mipLevels);
+
+    /**
+     * Destination of the next row of the first level
+     */
+    [[nodiscard]] unsigned char *getNextRow() const;
+
+    /**
+     * Signal that the row returned by getNextRow was written, generates the rows of the next levels it completes
+     */
+    void pushRow();
+
+    [[nodiscard]] bool isComplete() const;
+
+private:
+    class Level {
+    public:
+        unsigned char *pixels;
+        size_t width;
+        size_t height;
+        size_t rowsDone;
+    };
+
+    void reduceRow(Level const &source, Level &destination, size_t y) const;
+
+    std::vector<Level> levels;
+};
+
+/**
+ * Size of every mip level of a RGBA8 texture, in the order of the DDS layout
+ */
+size_t getMipChainPixelsSize(size_t width, size_t height, size_t mipLevels);
+
+/**
+ * Decode a PNG row by row directly into the DDS layout in 'output', generating the mip levels on the fly
+ *
+ * @return CONVERT_OK on success, CONVERT_ERROR_INVALID_ARGUMENT when the PNG can't be streamed (interlaced)
+ */
+ConvertStatus streamPNGtoDDS(unsigned char const *png, size_t size, bool dx10ext, bool bgra, void *output,
+                             size_t capacity);
@@ -0,0 +1,94 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include "CpuFeatures.h"
+#include "Swizzle.h"
+
+void swizzleRGBAtoBGRAScalar(unsigned char *const pixels, size_t const size) {
+    for (size_t i = 0; i + 3 < size; i += 4) {
+        unsigned char const r = pixels[i];
+        pixels[i] = pixels[i + 2];
+        pixels[i + 2] = r;
+    }
+}
+
+void expandRGBtoRGBAScalar(unsigned char const *const src, unsigned char *const dst, size_t const pixelCount) {
+    for (size_t i = 0; i < pixelCount; i++) {
+        dst[i * 4] = src[i * 3];
+        dst[i * 4 + 1] = src[i * 3 + 1];
+        dst[i * 4 + 2] = src[i * 3 + 2];
+        dst[i * 4 + 3] = 0xff;
+    }
+}
+
+/**
+ * c * a / 255 rounded to nearest, the SIMD kernels use the same integer sequence
+ */
+static inline unsigned char multiplyAlpha(unsigned int const c, unsigned int const a) {
+    unsigned int const t = c * a + 128;
+    return static_cast<unsigned char>((t + (t >> 8)) >> 8);
+}
+
+void premultiplyAlphaScalar(unsigned char *const pixels, size_t const size) {
+    for (size_t i = 0; i + 3 < size; i += 4) {
+        unsigned int const a = pixels[i + 3];
+        pixels[i] = multiplyAlpha(pixels[i], a);
+        pixels[i + 1] = multiplyAlpha(pixels[i + 1], a);
+        pixels[i + 2] = multiplyAlpha(pixels[i + 2], a);
+    }
+}
+
+static SwizzleKernels selectSwizzleKernels() {
+#ifdef DXTWRAPPER_X86
+    CpuFeatures const &cpu = getCpuFeatures();
+    if (cpu.avx2) {
+        return {"avx2", swizzleRGBAtoBGRAAvx2, expandRGBtoRGBAAvx2, premultiplyAlphaAvx2};
+    }
+    if (cpu.ssse3) {
+        return {"ssse3", swizzleRGBAtoBGRASsse3, expandRGBtoRGBASsse3, premultiplyAlphaSsse3};
+    }
+#endif
+    return {"scalar", swizzleRGBAtoBGRAScalar, expandRGBtoRGBAScalar, premultiplyAlphaScalar};
+}
+
+//selected during static initialization, when the library is loaded
+static SwizzleKernels const swizzleKernels = selectSwizzleKernels();
+
+SwizzleKernels const &getSwizzleKernels() {
+    return swizzleKernels;
+}
+
+void swizzleRGBAtoBGRA(unsigned char *const pixels, size_t const size) {
+    swizzleKernels.swizzleRGBAtoBGRA(pixels, size);
+}
+
+void expandRGBtoRGBA(unsigned char const *const src, unsigned char *const dst, size_t const pixelCount) {
+    swizzleKernels.expandRGBtoRGBA(src, dst, pixelCount);
+}
+
+void premultiplyAlpha(unsigned char *const pixels, size_t const size) {
+    swizzleKernels.premultiplyAlpha(pixels, size);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+
+/**
+ * Swap the R and B channels of 8-bit RGBA pixels, converts RGBA to BGRA and BGRA to RGBA
+ *
+ * @param pixels The pixels, modified in place
+ * @param size The size(in bytes) of pixels, a multiple of 4
+ */
+void swizzleRGBAtoBGRA(unsigned char *pixels, size_t size);
+
+/**
+ * Expand 8-bit RGB pixels to RGBA with opaque alpha
+ *
+ * @param src The RGB pixels, 3 * pixelCount bytes
+ * @param dst The RGBA pixels, 4 * pixelCount bytes, must not overlap src
+ * @param pixelCount Number of pixels
+ */
+void expandRGBtoRGBA(unsigned char const *src, unsigned char *dst, size_t pixelCount);
+
+/**
+ * Multiply the color channels of 8-bit RGBA (or BGRA) pixels by alpha, rounded to nearest
+ *
+ * @param pixels The pixels, modified in place
+ * @param size The size(in bytes) of pixels, a multiple of 4
+ */
+void premultiplyAlpha(unsigned char *pixels, size_t size);
+
+class SwizzleKernels {
+public:
+    char const *name;
+    void (*swizzleRGBAtoBGRA)(unsigned char *pixels, size_t size);
+    void (*expandRGBtoRGBA)(unsigned char const *src, unsigned char *dst, size_t pixelCount);
+    void (*premultiplyAlpha)(unsigned char *pixels, size_t size);
+};
+
+/**
+ * Kernels selected for this CPU when the library was loaded
+ */
+SwizzleKernels const &getSwizzleKernels();
+
+void swizzleRGBAtoBGRAScalar(unsigned char *pixels, size_t size);
+void expandRGBtoRGBAScalar(unsigned char const *src, unsigned char *dst, size_t pixelCount);
+void premultiplyAlphaScalar(unsigned char *pixels, size_t size);
+
+void swizzleRGBAtoBGRASsse3(unsigned char *pixels, size_t size);
+void expandRGBtoRGBASsse3(unsigned char const *src, unsigned char *dst, size_t pixelCount);
+void premultiplyAlphaSsse3(unsigned char *pixels, size_t size);
+
+void swizzleRGBAtoBGRAAvx2(unsigned char *pixels, size_t size);
+void expandRGBtoRGBAAvx2(unsigned char const *src, unsigned char *dst, size_t pixelCount);
+void premultiplyAlphaAvx2(unsigned char *pixels, size_t size);
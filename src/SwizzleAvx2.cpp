@@ -0,0 +1,97 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include "CpuFeatures.h"
+#include "Swizzle.h"
+
+#ifdef DXTWRAPPER_X86
+
+#include <immintrin.h>
+
+void swizzleRGBAtoBGRAAvx2(unsigned char *const pixels, size_t const size) {
+    __m256i const mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                          2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        auto *p = reinterpret_cast<__m256i *>(pixels + i);
+        __m256i const a = _mm256_loadu_si256(p);
+        __m256i const b = _mm256_loadu_si256(p + 1);
+        _mm256_storeu_si256(p, _mm256_shuffle_epi8(a, mask));
+        _mm256_storeu_si256(p + 1, _mm256_shuffle_epi8(b, mask));
+    }
+    for (; i + 32 <= size; i += 32) {
+        auto *p = reinterpret_cast<__m256i *>(pixels + i);
+        _mm256_storeu_si256(p, _mm256_shuffle_epi8(_mm256_loadu_si256(p), mask));
+    }
+    swizzleRGBAtoBGRAScalar(pixels + i, size - i);
+}
+
+void expandRGBtoRGBAAvx2(unsigned char const *const src, unsigned char *const dst, size_t const pixelCount) {
+    //move pixels 0-3 to the low lane and pixels 4-7 to the high lane, then expand each lane
+    __m256i const spread = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+    __m256i const mask = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                          0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m256i const alpha = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+    size_t i = 0;
+    //each load reads 32 bytes but consumes 24, stop while 32 bytes are still readable
+    for (; i + 11 <= pixelCount; i += 8) {
+        __m256i const rgb = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i * 3));
+        __m256i const rgba = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(rgb, spread), mask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), _mm256_or_si256(rgba, alpha));
+    }
+    expandRGBtoRGBAScalar(src + i * 3, dst + i * 4, pixelCount - i);
+}
+
+void premultiplyAlphaAvx2(unsigned char *const pixels, size_t const size) {
+    __m256i const alphaLow = _mm256_setr_epi8(3, -1, 3, -1, 3, -1, -1, -1, 7, -1, 7, -1, 7, -1, -1, -1,
+                                              3, -1, 3, -1, 3, -1, -1, -1, 7, -1, 7, -1, 7, -1, -1, -1);
+    __m256i const alphaHigh = _mm256_setr_epi8(11, -1, 11, -1, 11, -1, -1, -1, 15, -1, 15, -1, 15, -1, -1, -1,
+                                               11, -1, 11, -1, 11, -1, -1, -1, 15, -1, 15, -1, 15, -1, -1, -1);
+    //alpha is multiplied by 255, which leaves it unchanged
+    __m256i const keepAlpha = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+    __m256i const round = _mm256_set1_epi16(128);
+    __m256i const zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        auto *p = reinterpret_cast<__m256i *>(pixels + i);
+        __m256i const v = _mm256_loadu_si256(p);
+
+        //unpack and pack operate per 128-bit lane, so the pixel order is preserved
+        __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(v, zero),
+                                        _mm256_or_si256(_mm256_shuffle_epi8(v, alphaLow), keepAlpha));
+        __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(v, zero),
+                                        _mm256_or_si256(_mm256_shuffle_epi8(v, alphaHigh), keepAlpha));
+        lo = _mm256_add_epi16(lo, round);
+        hi = _mm256_add_epi16(hi, round);
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+
+        _mm256_storeu_si256(p, _mm256_packus_epi16(lo, hi));
+    }
+    premultiplyAlphaScalar(pixels + i, size - i);
+}
+
+#endif
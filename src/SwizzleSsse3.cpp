@@ -0,0 +1,80 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include "CpuFeatures.h"
+#include "Swizzle.h"
+
+#ifdef DXTWRAPPER_X86
+
+#include <tmmintrin.h>
+
+void swizzleRGBAtoBGRASsse3(unsigned char *const pixels, size_t const size) {
+    __m128i const mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        auto *p = reinterpret_cast<__m128i *>(pixels + i);
+        _mm_storeu_si128(p, _mm_shuffle_epi8(_mm_loadu_si128(p), mask));
+    }
+    swizzleRGBAtoBGRAScalar(pixels + i, size - i);
+}
+
+void expandRGBtoRGBASsse3(unsigned char const *const src, unsigned char *const dst, size_t const pixelCount) {
+    __m128i const mask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m128i const alpha = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    size_t i = 0;
+    //each load reads 16 bytes but consumes 12, stop while 16 bytes are still readable
+    for (; i + 6 <= pixelCount; i += 4) {
+        __m128i const rgb = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, mask), alpha));
+    }
+    expandRGBtoRGBAScalar(src + i * 3, dst + i * 4, pixelCount - i);
+}
+
+void premultiplyAlphaSsse3(unsigned char *const pixels, size_t const size) {
+    __m128i const alphaLow = _mm_setr_epi8(3, -1, 3, -1, 3, -1, -1, -1, 7, -1, 7, -1, 7, -1, -1, -1);
+    __m128i const alphaHigh = _mm_setr_epi8(11, -1, 11, -1, 11, -1, -1, -1, 15, -1, 15, -1, 15, -1, -1, -1);
+    //alpha is multiplied by 255, which leaves it unchanged
+    __m128i const keepAlpha = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+    __m128i const round = _mm_set1_epi16(128);
+    __m128i const zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        auto *p = reinterpret_cast<__m128i *>(pixels + i);
+        __m128i const v = _mm_loadu_si128(p);
+
+        __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), _mm_or_si128(_mm_shuffle_epi8(v, alphaLow), keepAlpha));
+        __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), _mm_or_si128(_mm_shuffle_epi8(v, alphaHigh), keepAlpha));
+        lo = _mm_add_epi16(lo, round);
+        hi = _mm_add_epi16(hi, round);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+        _mm_storeu_si128(p, _mm_packus_epi16(lo, hi));
+    }
+    premultiplyAlphaScalar(pixels + i, size - i);
+}
+
+#endif
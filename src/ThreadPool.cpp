@@ -0,0 +1,204 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include "ThreadPool.h"
+
+//pool and worker index of the current thread, set for the lifetime of each worker
+static thread_local ThreadPool const *currentPool = nullptr;
+static thread_local size_t currentWorker = SIZE_MAX;
+
+static size_t resolveWorkerCount(size_t const workerCount) {
+    return workerCount == 0 ? std::max<size_t>(std::thread::hardware_concurrency(), 1) : workerCount;
+}
+
+ThreadPool::ThreadPool(size_t workerCount) {
+    workerCount = resolveWorkerCount(workerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+        queues.emplace_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < workerCount; i++) {
+        threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto &thread: threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    //tasks submitted by a worker stay on its own deque, where they are found first
+    size_t const worker = getCurrentWorker();
+    size_t const target = worker != SIZE_MAX ? worker : nextQueue.fetch_add(1) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.emplace_back(std::move(task));
+    }
+    queued.fetch_add(1);
+
+    std::lock_guard<std::mutex> lock(stateMutex);
+    workAvailable.notify_one();
+}
+
+/**
+ * A parallelFor call, shared with its tasks. The tasks claim indices from 'next', a task that starts after every index
+ * was claimed returns without calling the function, which may be gone with the caller.
+ */
+class ParallelForState {
+public:
+    explicit ParallelForState(size_t const count) : count(count), remaining(count) {
+    }
+
+    /**
+     * Run the indices left, until every one is claimed
+     */
+    void runIndices(std::function<void(size_t index, size_t worker)> const &fn, size_t const worker) {
+        for (size_t index = next.fetch_add(1); index < count; index = next.fetch_add(1)) {
+            fn(index, worker);
+            if (remaining.fetch_sub(1) == 1) {
+                //the waiter checks 'remaining' under the lock, it is either before its check or already waiting
+                std::lock_guard<std::mutex> lock(doneMutex);
+                doneCondition.notify_all();
+            }
+        }
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneCondition.wait(lock, [this] { return remaining.load() == 0; });
+    }
+
+private:
+    size_t const count;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> remaining;
+    std::mutex doneMutex;
+    std::condition_variable doneCondition;
+};
+
+void ThreadPool::parallelFor(size_t const count, std::function<void(size_t index, size_t worker)> const &fn) {
+    if (count == 0) {
+        return;
+    }
+
+    auto const state = std::make_shared<ParallelForState>(count);
+    size_t const worker = getCurrentWorker();
+    //a worker runs indices of the call itself, one task less is enough
+    size_t const helpers = std::min(count, queues.size()) - (worker != SIZE_MAX ? 1 : 0);
+    for (size_t i = 0; i < helpers; i++) {
+        submit([state, &fn](size_t const helper) { state->runIndices(fn, helper); });
+    }
+
+    if (worker != SIZE_MAX) {
+        //only indices of this call, never other tasks of the pool: they could be unrelated conversions, run on top of
+        //this one's stack and thread-local state, and waiting inside them would nest without bound
+        state->runIndices(fn, worker);
+    }
+    //the indices claimed by the other workers are running, waiting for them can't deadlock
+    state->wait();
+}
+
+size_t ThreadPool::getCurrentWorker() const {
+    return currentPool == this ? currentWorker : SIZE_MAX;
+}
+
+bool ThreadPool::popTask(size_t const worker, Task &task) {
+    {
+        WorkerQueue &own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < queues.size(); i++) {
+        WorkerQueue &victim = *queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::run(size_t const worker) {
+    currentPool = this;
+    currentWorker = worker;
+
+    Task task;
+    while (true) {
+        if (popTask(worker, task)) {
+            task(worker);
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        workAvailable.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) {
+            return;
+        }
+    }
+}
+
+static std::mutex threadPoolMutex;
+static std::shared_ptr<ThreadPool> threadPool;
+static size_t threadPoolWorkers = 0;
+
+std::shared_ptr<ThreadPool> getThreadPool() {
+    std::lock_guard<std::mutex> lock(threadPoolMutex);
+    if (!threadPool) {
+        threadPool = std::make_shared<ThreadPool>(threadPoolWorkers);
+    }
+    return threadPool;
+}
+
+void setThreadPoolWorkers(size_t const workerCount) {
+    std::shared_ptr<ThreadPool> previous;
+    {
+        std::lock_guard<std::mutex> lock(threadPoolMutex);
+        threadPoolWorkers = workerCount;
+        if (threadPool && threadPool->getWorkerCount() != resolveWorkerCount(workerCount)) {
+            previous = std::move(threadPool);
+        }
+    }
+    //the previous pool is destroyed here, or by the last conversion still using it
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Work-stealing thread pool. Every worker owns a deque, tasks are pushed round-robin, a worker pops from the back of its
+ * own deque and steals from the front of the others when it runs out of work.
+ */
+class ThreadPool {
+public:
+    /**
+     * Task executed by a worker, receives the index of the worker running it
+     */
+    using Task = std::function<void(size_t worker)>;
+
+    /**
+     * @param workerCount Number of worker threads, 0 to use one worker per hardware thread
+     */
+    explicit ThreadPool(size_t workerCount);
+
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const &) = delete;
+
+    ThreadPool &operator=(ThreadPool const &) = delete;
+
+    [[nodiscard]] size_t getWorkerCount() const {
+        return threads.size();
+    }
+
+    /**
+     * Queue a task, returns immediately
+     */
+    void submit(Task task);
+
+    /**
+     * Run fn(index, worker) for every index in [0, count) and wait for all of them. When called from a worker of this
+     * pool the caller runs indices of this call too, so nested calls don't deadlock. It doesn't run other tasks while
+     * waiting.
+     */
+    void parallelFor(size_t count, std::function<void(size_t index, size_t worker)> const &fn);
+
+    /**
+     * Index of the worker running the current thread in this pool, or SIZE_MAX if it isn't a worker of this pool
+     */
+    [[nodiscard]] size_t getCurrentWorker() const;
+
+private:
+    class WorkerQueue {
+    public:
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(size_t worker);
+
+    bool popTask(size_t worker, Task &task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> nextQueue{0};
+    bool stopping = false;
+};
+
+/**
+ * The pool shared by the conversion APIs, created on first use
+ */
+std::shared_ptr<ThreadPool> getThreadPool();
+
+/**
+ * Replace the shared pool. Work already running keeps the previous pool alive until it finishes.
+ *
+ * @param workerCount Number of worker threads, 0 to use one worker per hardware thread
+ */
+void setThreadPoolWorkers(size_t workerCount);
@@ -0,0 +1,1311 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+/*
+ * dxtexwrapper-bench: times every stage of the conversions on a deterministic synthetic corpus. Each stage runs
+ * 'warmup' untimed and 'iterations' timed runs on every image, the report has percentiles, throughput and the peak RSS
+ * of each stage where the platform can reset it (Linux), and of the whole run. The JSON output is stable so runs can be diffed. Every stage reports the heap allocations per
+ * run, counted by replacing operator new and malloc, and the conversion stages also the buffers counted by the library
+ * stats once the scratch arena is warm. The PNG stages also run on the files of --png-dir, to compare the decode modes
+ * on real images.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <DirectXTex.h>
+#include "BCDecoder.h"
+#include "AsyncConvert.h"
+#include "BCEncoder.h"
+#include "ConvertCache.h"
+#include "Corpus.h"
+#include "DxTexWrapper.h"
+#include "FileConvert.h"
+#include "FileIO.h"
+#include "MipGenerator.h"
+#include "PngDecoder.h"
+#include "PngOutput.h"
+#include "PngUnfilter.h"
+#include "ScratchArena.h"
+#include "Stats.h"
+#include "Swizzle.h"
+#include "ThreadPool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#if defined(DXTWRAPPER_USE_LIBSPNG)
+static constexpr char const *PNG_BACKEND = "spng";
+#else
+static constexpr char const *PNG_BACKEND = "lodepng";
+#endif
+
+class BenchOptions {
+public:
+    size_t iterations = 10;
+    size_t warmup = 1;
+    size_t minSize = 64;
+    size_t maxSize = 4096;
+    BCQuality bcQuality = BC_QUALITY_NORMAL;
+    //empty for every stage and pattern
+    std::vector<std::string> stages;
+    std::vector<CorpusPattern> patterns;
+    //"-" for stdout, empty for no JSON
+    std::string jsonPath;
+    //write the corpus as PNG files to this directory and exit
+    std::string corpusDir;
+    unsigned int workers = 0;
+    //memory kept by the scratch arena of each thread, SIZE_MAX for the library default
+    size_t arenaTrim = SIZE_MAX;
+    //conversion cache of the convert-*-cached stages, they are skipped without it
+    std::string cacheDir;
+    //scratch directory of the convert-*-file stages, they are skipped without it
+    std::string fileDir;
+    //PNG files run through the decode and conversion stages after the corpus
+    std::string pngDir;
+};
+
+class StageResult {
+public:
+    std::string stage;
+    std::string image;
+    size_t width = 0;
+    size_t height = 0;
+    //input of the stage
+    size_t bytes = 0;
+    //images converted by each run, the throughput counts all of them
+    size_t images = 1;
+    bool failed = false;
+    //output of the PNG encode stages, 0 when not measured
+    size_t outputBytes = 0;
+    //quality of the BC compress stages, negative when not measured
+    double psnr = -1.0;
+    //highest resident set during the stage, 0 when the platform can't measure it per stage
+    size_t peakRss = 0;
+    //heap allocations of the timed runs divided by the runs, negative when not measured
+    double allocationsPerRun = -1.0;
+    //buffers counted by the library stats during the timed runs divided by the runs, negative when not measured
+    double bufferAllocationsPerRun = -1.0;
+    std::vector<double> seconds;
+};
+
+static size_t getPeakRss() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+/**
+ * Reset the high-water mark of the resident set to the current RSS, so getStagePeakRss measures what follows. Only Linux
+ * can, through /proc/self/clear_refs. The peak of getrusage is reset too.
+ *
+ * @return False when the platform can't reset it
+ */
+static bool resetStagePeakRss() {
+#ifdef __linux__
+    std::FILE *const file = std::fopen("/proc/self/clear_refs", "w");
+    if (file == nullptr) {
+        return false;
+    }
+    bool const written = std::fputs("5", file) >= 0;
+    return std::fclose(file) == 0 && written;
+#else
+    return false;
+#endif
+}
+
+/**
+ * High-water mark of the resident set since resetStagePeakRss, VmHWM of /proc/self/status. 0 when it can't be read.
+ */
+static size_t getStagePeakRss() {
+#ifdef __linux__
+    std::FILE *const file = std::fopen("/proc/self/status", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    size_t kilobytes = 0;
+    char line[256];
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+        if (std::sscanf(line, "VmHWM: %zu kB", &kilobytes) == 1) {
+            break;
+        }
+    }
+    std::fclose(file);
+    return kilobytes * 1024;
+#else
+    return 0;
+#endif
+}
+
+/*
+ * Every heap allocation of the process is counted, so the stages report the allocations of the library, of DirectXTex
+ * and of the PNG codecs, including the worker threads. With glibc malloc is replaced too, forwarding to the allocator
+ * of glibc; elsewhere only operator new is counted. Builds with a sanitizer keep its malloc.
+ */
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define DXTWRAPPER_BENCH_COUNT_MALLOC
+#endif
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#undef DXTWRAPPER_BENCH_COUNT_MALLOC
+#endif
+#endif
+
+static std::atomic<uint64_t> heapAllocations{0};
+
+static uint64_t getHeapAllocations() {
+    return heapAllocations.load(std::memory_order_relaxed);
+}
+
+#ifdef DXTWRAPPER_BENCH_COUNT_MALLOC
+static constexpr char const *ALLOCATION_COUNTER = "malloc";
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *pointer);
+
+void *malloc(size_t const size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t const count, size_t const size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *const pointer, size_t const size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+void *memalign(size_t const alignment, size_t const size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t const alignment, size_t const size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **const pointer, size_t const alignment, size_t const size) {
+    //a power of two multiple of sizeof(void *)
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0 || alignment % sizeof(void *) != 0) {
+        return EINVAL;
+    }
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    void *const allocated = __libc_memalign(alignment, size);
+    if (allocated == nullptr) {
+        return ENOMEM;
+    }
+    *pointer = allocated;
+    return 0;
+}
+
+void free(void *const pointer) {
+    __libc_free(pointer);
+}
+}
+
+//operator new goes straight to glibc, each allocation is counted once
+static void *allocateHeap(size_t const size) {
+    return __libc_malloc(size);
+}
+
+static void *allocateAlignedHeap(size_t const size, size_t const alignment) {
+    return __libc_memalign(alignment, size);
+}
+
+static void freeHeap(void *const pointer) {
+    __libc_free(pointer);
+}
+
+static void freeAlignedHeap(void *const pointer) {
+    __libc_free(pointer);
+}
+#else
+static constexpr char const *ALLOCATION_COUNTER = "new";
+
+static void *allocateHeap(size_t const size) {
+    return std::malloc(size);
+}
+
+static void *allocateAlignedHeap(size_t const size, size_t const alignment) {
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    void *pointer = nullptr;
+    return posix_memalign(&pointer, alignment, size) == 0 ? pointer : nullptr;
+#endif
+}
+
+static void freeHeap(void *const pointer) {
+    std::free(pointer);
+}
+
+static void freeAlignedHeap(void *const pointer) {
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+#endif
+
+static void *allocateCounted(size_t const size, std::nothrow_t const &) noexcept {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    //a zero-size new still returns a distinct pointer
+    return allocateHeap(size == 0 ? 1 : size);
+}
+
+static void *allocateCounted(size_t const size) {
+    void *const pointer = allocateCounted(size, std::nothrow);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+static void *allocateAlignedCounted(size_t const size, std::align_val_t const alignment,
+                                    std::nothrow_t const &) noexcept {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return allocateAlignedHeap(size == 0 ? 1 : size, static_cast<size_t>(alignment));
+}
+
+static void *allocateAlignedCounted(size_t const size, std::align_val_t const alignment) {
+    void *const pointer = allocateAlignedCounted(size, alignment, std::nothrow);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new(size_t const size) {
+    return allocateCounted(size);
+}
+
+void *operator new[](size_t const size) {
+    return allocateCounted(size);
+}
+
+void *operator new(size_t const size, std::nothrow_t const &tag) noexcept {
+    return allocateCounted(size, tag);
+}
+
+void *operator new[](size_t const size, std::nothrow_t const &tag) noexcept {
+    return allocateCounted(size, tag);
+}
+
+void *operator new(size_t const size, std::align_val_t const alignment) {
+    return allocateAlignedCounted(size, alignment);
+}
+
+void *operator new[](size_t const size, std::align_val_t const alignment) {
+    return allocateAlignedCounted(size, alignment);
+}
+
+void *operator new(size_t const size, std::align_val_t const alignment, std::nothrow_t const &tag) noexcept {
+    return allocateAlignedCounted(size, alignment, tag);
+}
+
+void *operator new[](size_t const size, std::align_val_t const alignment, std::nothrow_t const &tag) noexcept {
+    return allocateAlignedCounted(size, alignment, tag);
+}
+
+void operator delete(void *const pointer) noexcept {
+    freeHeap(pointer);
+}
+
+void operator delete[](void *const pointer) noexcept {
+    freeHeap(pointer);
+}
+
+void operator delete(void *const pointer, size_t) noexcept {
+    freeHeap(pointer);
+}
+
+void operator delete[](void *const pointer, size_t) noexcept {
+    freeHeap(pointer);
+}
+
+void operator delete(void *const pointer, std::nothrow_t const &) noexcept {
+    freeHeap(pointer);
+}
+
+void operator delete[](void *const pointer, std::nothrow_t const &) noexcept {
+    freeHeap(pointer);
+}
+
+void operator delete(void *const pointer, std::align_val_t) noexcept {
+    freeAlignedHeap(pointer);
+}
+
+void operator delete[](void *const pointer, std::align_val_t) noexcept {
+    freeAlignedHeap(pointer);
+}
+
+void operator delete(void *const pointer, size_t, std::align_val_t) noexcept {
+    freeAlignedHeap(pointer);
+}
+
+void operator delete[](void *const pointer, size_t, std::align_val_t) noexcept {
+    freeAlignedHeap(pointer);
+}
+
+void operator delete(void *const pointer, std::align_val_t, std::nothrow_t const &) noexcept {
+    freeAlignedHeap(pointer);
+}
+
+void operator delete[](void *const pointer, std::align_val_t, std::nothrow_t const &) noexcept {
+    freeAlignedHeap(pointer);
+}
+
+/**
+ * Nearest-rank percentile of sorted samples
+ */
+static double getPercentile(std::vector<double> const &sorted, double const percentile) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    auto const rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+static double getMean(std::vector<double> const &samples) {
+    double sum = 0.0;
+    for (double const s: samples) {
+        sum += s;
+    }
+    return samples.empty() ? 0.0 : sum / static_cast<double>(samples.size());
+}
+
+/**
+ * Channels stored by a BC format: red for BC4, red and green for BC5, the color for BC1
+ */
+static size_t getBCChannels(DXGI_FORMAT const format) {
+    switch (format) {
+        case DXGI_FORMAT_BC4_UNORM:
+            return 1;
+        case DXGI_FORMAT_BC5_UNORM:
+            return 2;
+        case DXGI_FORMAT_BC1_UNORM:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+/**
+ * PSNR of the channels stored by a BC format, BC1 skips the pixels it makes transparent
+ */
+static double getPsnr(DXGI_FORMAT const format, std::vector<unsigned char> const &original,
+                      std::vector<unsigned char> const &decoded) {
+    size_t const channels = getBCChannels(format);
+    double error = 0.0;
+    size_t count = 0;
+    for (size_t i = 0; i < original.size(); i += 4) {
+        if (format == DXGI_FORMAT_BC1_UNORM && original[i + 3] < 128) {
+            continue;
+        }
+        for (size_t c = 0; c < channels; c++) {
+            double const d = static_cast<double>(original[i + c]) - static_cast<double>(decoded[i + c]);
+            error += d * d;
+            count++;
+        }
+    }
+    if (count == 0 || error == 0.0) {
+        return 99.0;
+    }
+    return 10.0 * std::log10(255.0 * 255.0 / (error / static_cast<double>(count)));
+}
+
+/**
+ * Blocks for the decompress stages of the formats the bench doesn't compress. BC6H blocks cycle through the 14 modes,
+ * a random mode is often reserved and decodes to black without reading the block.
+ */
+static void getRandomBlocks(DXGI_FORMAT const format, std::vector<unsigned char> &blocks) {
+    static constexpr unsigned char BC6H_MODES[14] = {0x00, 0x01, 0x02, 0x06, 0x0a, 0x0e, 0x12, 0x16, 0x1a, 0x1e,
+                                                     0x03, 0x07, 0x0b, 0x0f};
+    std::mt19937 random(static_cast<uint32_t>(format));
+    for (unsigned char &byte: blocks) {
+        byte = static_cast<unsigned char>(random());
+    }
+    if (format == DXGI_FORMAT_BC6H_UF16 || format == DXGI_FORMAT_BC6H_SF16) {
+        for (size_t i = 0; i < blocks.size(); i += 16) {
+            unsigned char const mode = BC6H_MODES[(i / 16) % 14];
+            //modes 1 and 2 have 2 mode bits, the others 5
+            blocks[i] = static_cast<unsigned char>((blocks[i] & (mode < 0x02 ? 0xfc : 0xe0)) | mode);
+        }
+    }
+}
+
+static bool encodeCorpusPng(DirectX::Image const &image, PngEncodeProfile const profile,
+                            std::vector<unsigned char> &png, bool const detectContent = true) {
+    PngEncodeOptions options{};
+    getPngEncodeOptions(profile, &options);
+    options.detectContent = detectContent;
+    PngOutput output{};
+    if (encodePng(image, resolvePngEncodeOptions(&options, image), output) != CONVERT_OK) {
+        return false;
+    }
+    auto const *content = static_cast<unsigned char const *>(output.content);
+    png.assign(content, content + output.size);
+    std::free(output.content);
+    return true;
+}
+
+class Bench {
+public:
+    explicit Bench(BenchOptions options) : options(std::move(options)) {
+    }
+
+    void run(CorpusImage const &corpus);
+
+    /**
+     * The PNG decode and conversion stages on a PNG file, 'name' identifies it in the results
+     */
+    void runPngFile(std::string const &name, std::vector<unsigned char> &png);
+
+    [[nodiscard]] std::vector<StageResult> const &getResults() const {
+        return results;
+    }
+
+private:
+    [[nodiscard]] bool isEnabled(char const *stage) const;
+
+    /**
+     * Time 'fn', which returns false on failure. Every run must do the same work. The heap allocations of the timed
+     * runs are reported, and when 'counted' is a stage the buffers it records in the library stats.
+     */
+    void time(char const *stage, CorpusImage const &corpus, size_t bytes, std::function<bool()> const &fn,
+              double psnr = -1.0, StatsStage counted = STATS_STAGE_COUNT);
+
+    void runDecodeStages(CorpusImage const &corpus, std::vector<unsigned char> const &png);
+
+    void runConversionStages(CorpusImage const &corpus, DirectX::Image const &base, std::vector<unsigned char> &png);
+
+    void runFileStages(CorpusImage const &corpus, std::vector<unsigned char> const &png);
+
+    void runMipStages(CorpusImage const &corpus, DirectX::Image const &base);
+
+    /**
+     * Compress and decompress stages of a BC format. Without 'compress' only the decoders run, on random blocks.
+     */
+    void runBCStages(CorpusImage const &corpus, DirectX::Image const &base, DXGI_FORMAT format, char const *name,
+                     bool compress = true);
+
+    BenchOptions options;
+    std::vector<StageResult> results;
+};
+
+bool Bench::isEnabled(char const *const stage) const {
+    if (options.stages.empty()) {
+        return true;
+    }
+    return std::any_of(options.stages.begin(), options.stages.end(), [stage](std::string const &name) {
+        //a name ending with '*' selects every stage starting with it
+        if (!name.empty() && name.back() == '*') {
+            return std::strncmp(stage, name.c_str(), name.size() - 1) == 0;
+        }
+        return name == stage;
+    });
+}
+
+void Bench::time(char const *const stage, CorpusImage const &corpus, size_t const bytes,
+                 std::function<bool()> const &fn, double const psnr, StatsStage const counted) {
+    StageResult result;
+    result.stage = stage;
+    result.image = corpus.name;
+    result.width = corpus.width;
+    result.height = corpus.height;
+    result.bytes = bytes;
+    result.psnr = psnr;
+
+    //the process peak would repeat the largest stage so far, each stage measures its own
+    bool const measurePeak = resetStagePeakRss();
+    for (size_t i = 0; i < options.warmup && !result.failed; i++) {
+        result.failed = !fn();
+    }
+    if (counted != STATS_STAGE_COUNT) {
+        resetStats();
+        setStatsEnabled(true);
+    }
+    //the samples are reserved so the timed runs only count the allocations of 'fn'
+    result.seconds.reserve(options.iterations);
+    uint64_t const allocations = getHeapAllocations();
+    for (size_t i = 0; i < options.iterations && !result.failed; i++) {
+        auto const start = std::chrono::steady_clock::now();
+        result.failed = !fn();
+        result.seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    if (!result.seconds.empty()) {
+        result.allocationsPerRun = static_cast<double>(getHeapAllocations() - allocations)
+                                   / static_cast<double>(result.seconds.size());
+    }
+    if (counted != STATS_STAGE_COUNT) {
+        setStatsEnabled(false);
+        ConvertStats stats{};
+        if (getStats(&stats) == CONVERT_OK && !result.seconds.empty()) {
+            result.bufferAllocationsPerRun = static_cast<double>(stats.stages[counted].allocations)
+                                             / static_cast<double>(result.seconds.size());
+        }
+    }
+    std::sort(result.seconds.begin(), result.seconds.end());
+    if (measurePeak) {
+        result.peakRss = getStagePeakRss();
+    }
+    results.push_back(std::move(result));
+}
+
+void Bench::run(CorpusImage const &corpus) {
+    DirectX::Image base{};
+    base.width = corpus.width;
+    base.height = corpus.height;
+    base.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    base.rowPitch = corpus.width * 4;
+    base.slicePitch = corpus.pixels.size();
+    base.pixels = const_cast<uint8_t *>(corpus.pixels.data());
+    size_t const rawSize = corpus.pixels.size();
+
+    class PngEncodeStage {
+    public:
+        char const *name;
+        PngEncodeProfile profile;
+        bool detectContent;
+    };
+    //the -nodetect stages skip detectPngImageContent, on the flat and alpha patterns they show what the cheaper
+    //settings save in time and output size
+    PngEncodeStage const pngStages[] = {
+            {"png-encode-fast", PNG_PROFILE_FAST, true},
+            {"png-encode-fast-nodetect", PNG_PROFILE_FAST, false},
+            {"png-encode-nodetect", PNG_PROFILE_BALANCED, false},
+            {"png-encode", PNG_PROFILE_BALANCED, true},
+    };
+    std::vector<unsigned char> png;
+    for (PngEncodeStage const &stage: pngStages) {
+        if (isEnabled(stage.name)) {
+            time(stage.name, corpus, rawSize, [&]() {
+                return encodeCorpusPng(base, stage.profile, png, stage.detectContent);
+            });
+            results.back().outputBytes = png.size();
+        }
+    }
+
+    if (isEnabled("png-decode") || isEnabled("png-decode-trusted")) {
+        if (png.empty() && !encodeCorpusPng(base, PNG_PROFILE_BALANCED, png)) {
+            std::fprintf(stderr, "%s: PNG encoding failed\n", corpus.name.c_str());
+            return;
+        }
+        runDecodeStages(corpus, png);
+    }
+
+    if (isEnabled("swizzle")) {
+        std::vector<unsigned char> pixels = corpus.pixels;
+        time("swizzle", corpus, rawSize, [&]() {
+            swizzleRGBAtoBGRA(pixels.data(), pixels.size());
+            return true;
+        });
+    }
+
+    runConversionStages(corpus, base, png);
+    runMipStages(corpus, base);
+    runBCStages(corpus, base, DXGI_FORMAT_BC1_UNORM, "bc1");
+    runBCStages(corpus, base, DXGI_FORMAT_BC2_UNORM, "bc2", false);
+    runBCStages(corpus, base, DXGI_FORMAT_BC3_UNORM, "bc3");
+    runBCStages(corpus, base, DXGI_FORMAT_BC4_UNORM, "bc4");
+    runBCStages(corpus, base, DXGI_FORMAT_BC5_UNORM, "bc5");
+    runBCStages(corpus, base, DXGI_FORMAT_BC6H_UF16, "bc6h", false);
+    runBCStages(corpus, base, DXGI_FORMAT_BC7_UNORM, "bc7");
+}
+
+void Bench::runPngFile(std::string const &name, std::vector<unsigned char> &png) {
+    PngHeader header;
+    if (!readPngHeader(png.data(), png.size(), header)) {
+        std::fprintf(stderr, "%s: invalid PNG\n", name.c_str());
+        return;
+    }
+    CorpusImage image;
+    image.name = name;
+    image.width = header.width;
+    image.height = header.height;
+    runDecodeStages(image, png);
+    runConversionStages(image, DirectX::Image{}, png);
+}
+
+/**
+ * The PNG decoder in both modes, the trusted one must decode the same pixels
+ */
+void Bench::runDecodeStages(CorpusImage const &corpus, std::vector<unsigned char> const &png) {
+    size_t const rawSize = corpus.width * corpus.height * 4;
+    ImageData strict;
+    if (isEnabled("png-decode")) {
+        time("png-decode", corpus, png.size(), [&]() {
+            return decodePng(png.data(), png.size(), strict) && strict.getPixelsSize() == rawSize;
+        });
+    }
+
+    if (isEnabled("png-decode-trusted")) {
+        ImageData trusted;
+        setPngDecodeMode(PNG_DECODE_TRUSTED);
+        time("png-decode-trusted", corpus, png.size(), [&]() {
+            return decodePng(png.data(), png.size(), trusted) && trusted.getPixelsSize() == rawSize;
+        });
+        setPngDecodeMode(PNG_DECODE_STRICT);
+        if ((strict.getPixelsSize() != 0 || decodePng(png.data(), png.size(), strict))
+            && strict.getPixels() != trusted.getPixels()) {
+            std::fprintf(stderr, "%s: the trusted decode differs\n", corpus.name.c_str());
+            results.back().failed = true;
+        }
+    }
+}
+
+/**
+ * Whole conversions through the public API, as the host application calls them
+ */
+void Bench::runConversionStages(CorpusImage const &corpus, DirectX::Image const &base,
+                                std::vector<unsigned char> &png) {
+    if (!isEnabled("convert-png-to-dds") && !isEnabled("convert-png-to-dds-trusted")
+        && !isEnabled("convert-png-to-dds-bc1") && !isEnabled("convert-dds-to-png")
+        && !isEnabled("convert-png-to-dds-cached") && !isEnabled("convert-png-to-dds-file")
+        && !isEnabled("convert-dds-to-png-file") && !isEnabled("convert-png-to-dds-async")) {
+        return;
+    }
+    if (png.empty() && !encodeCorpusPng(base, PNG_PROFILE_BALANCED, png)) {
+        std::fprintf(stderr, "%s: PNG encoding failed\n", corpus.name.c_str());
+        return;
+    }
+
+    ContentBuffer dds{};
+    auto const convertToDDS = [&]() {
+        freeContentBuffer(&dds);
+        return convertPNGtoDDSEx(png.data(), png.size(), true, false, nullptr, nullptr, &dds) == CONVERT_OK;
+    };
+    if (isEnabled("convert-png-to-dds")) {
+        time("convert-png-to-dds", corpus, png.size(), convertToDDS, -1.0, STATS_STAGE_PNG_TO_DDS);
+    }
+    if (isEnabled("convert-png-to-dds-trusted")) {
+        setPngDecodeMode(PNG_DECODE_TRUSTED);
+        time("convert-png-to-dds-trusted", corpus, png.size(), convertToDDS, -1.0, STATS_STAGE_PNG_TO_DDS);
+        setPngDecodeMode(PNG_DECODE_STRICT);
+    }
+
+    //the warmup stores the output, the timed runs hash the PNG and read the stored DDS
+    if (isEnabled("convert-png-to-dds-cached") && !options.cacheDir.empty()) {
+        if (setConvertCache(options.cacheDir.c_str(), uint64_t{1} << 32) != CONVERT_OK) {
+            std::fprintf(stderr, "error opening cache %s\n", options.cacheDir.c_str());
+        } else {
+            time("convert-png-to-dds-cached", corpus, png.size(), convertToDDS, -1.0, STATS_STAGE_PNG_TO_DDS);
+            setConvertCache(nullptr, 0);
+        }
+    }
+
+    //one job per hardware thread submitted from this thread, compared with convert-png-to-dds it shows the scaling
+    if (isEnabled("convert-png-to-dds-async")) {
+        size_t const jobCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        std::vector<ConvertJob> jobs(jobCount);
+        std::vector<ConvertTicket> tickets(jobCount);
+        time("convert-png-to-dds-async", corpus, png.size() * jobCount, [&]() {
+            bool submitted = true;
+            for (size_t i = 0; i < jobCount && submitted; i++) {
+                jobs[i] = ConvertJob{png.data(), png.size(), CONVERT_PNG_TO_DDS, true, false, false, nullptr, nullptr,
+                                     ContentBuffer{}, CONVERT_OK};
+                submitted = submitConvertJob(&jobs[i], nullptr, nullptr, &tickets[i]) == CONVERT_OK;
+            }
+            bool converted = submitted;
+            for (size_t i = 0; i < jobCount && tickets[i] != 0; i++) {
+                converted = waitConvertJob(tickets[i], UINT32_MAX) == CONVERT_OK && converted;
+                freeContentBuffer(&jobs[i].output);
+            }
+            return converted;
+        }, -1.0, STATS_STAGE_PNG_TO_DDS);
+        results.back().images = jobCount;
+    }
+
+    if (isEnabled("convert-png-to-dds-bc1")) {
+        DDSEncodeOptions ddsOptions{};
+        ddsOptions.format = DXGI_FORMAT_BC1_UNORM;
+        ddsOptions.quality = options.bcQuality;
+        ddsOptions.dx10ext = true;
+        ContentBuffer compressed{};
+        time("convert-png-to-dds-bc1", corpus, png.size(), [&]() {
+            freeContentBuffer(&compressed);
+            return convertPNGtoDDSCompressedEx(png.data(), png.size(), &ddsOptions, nullptr, nullptr, &compressed)
+                   == CONVERT_OK;
+        }, -1.0, STATS_STAGE_PNG_TO_DDS);
+        freeContentBuffer(&compressed);
+    }
+
+    if (isEnabled("convert-dds-to-png")) {
+        if (dds.content == nullptr && !convertToDDS()) {
+            std::fprintf(stderr, "%s: DDS conversion failed\n", corpus.name.c_str());
+            return;
+        }
+        ContentBuffer output{};
+        time("convert-dds-to-png", corpus, dds.size, [&]() {
+            freeContentBuffer(&output);
+            return convertDDStoPNGEx(dds.content, dds.size, nullptr, nullptr, nullptr, &output) == CONVERT_OK;
+        }, -1.0, STATS_STAGE_DDS_TO_PNG);
+        freeContentBuffer(&output);
+    }
+    freeContentBuffer(&dds);
+
+    if (!options.fileDir.empty()
+        && (isEnabled("convert-png-to-dds-file") || isEnabled("convert-dds-to-png-file"))) {
+        runFileStages(corpus, png);
+    }
+}
+
+/**
+ * Path-based conversions, the input is read from and the output written to the scratch directory
+ */
+void Bench::runFileStages(CorpusImage const &corpus, std::vector<unsigned char> const &png) {
+    std::string const pngPath = options.fileDir + "/" + corpus.name + ".png";
+    std::string const ddsPath = options.fileDir + "/" + corpus.name + ".dds";
+    std::string const outputPath = options.fileDir + "/" + corpus.name + ".out.png";
+    AtomicFile input;
+    if (!input.open(pngPath.c_str()) || !input.write(png.data(), png.size()) || !input.commit()) {
+        std::fprintf(stderr, "error writing %s\n", pngPath.c_str());
+        return;
+    }
+
+    uint64_t ddsSize = 0;
+    auto const convertToDDS = [&]() {
+        return convertPNGtoDDSFile(pngPath.c_str(), ddsPath.c_str(), true, false, &ddsSize) == CONVERT_OK;
+    };
+    if (isEnabled("convert-png-to-dds-file")) {
+        time("convert-png-to-dds-file", corpus, png.size(), convertToDDS, -1.0, STATS_STAGE_PNG_TO_DDS);
+    }
+
+    if (isEnabled("convert-dds-to-png-file")) {
+        if (ddsSize == 0 && !convertToDDS()) {
+            std::fprintf(stderr, "%s: DDS conversion failed\n", corpus.name.c_str());
+        } else {
+            time("convert-dds-to-png-file", corpus, static_cast<size_t>(ddsSize), [&]() {
+                return convertDDStoPNGFile(ddsPath.c_str(), outputPath.c_str(), nullptr, nullptr) == CONVERT_OK;
+            }, -1.0, STATS_STAGE_DDS_TO_PNG);
+        }
+    }
+
+    removeFile(pngPath.c_str());
+    removeFile(ddsPath.c_str());
+    removeFile(outputPath.c_str());
+}
+
+void Bench::runMipStages(CorpusImage const &corpus, DirectX::Image const &base) {
+    ArenaScope arena;
+    DirectX::TexMetadata const metadata = getMipChainMetadata(corpus.width, corpus.height, false);
+    MipChain mipChain;
+    if (initMipChain(metadata, arena.arena, mipChain) != CONVERT_OK) {
+        std::fprintf(stderr, "%s: allocation failed\n", corpus.name.c_str());
+        return;
+    }
+    std::memcpy(mipChain.pixels, corpus.pixels.data(), corpus.pixels.size());
+
+    class MipStage {
+    public:
+        char const *name;
+        MipOptions options;
+    };
+    MipStage const stages[] = {
+            {"mip-box", {MIP_FILTER_BOX, false, 0}},
+            {"mip-triangle", {MIP_FILTER_TRIANGLE, false, 0}},
+            {"mip-kaiser", {MIP_FILTER_KAISER, false, 0}},
+            {"mip-box-srgb", {MIP_FILTER_BOX, true, 0}},
+            {"mip-box-coverage", {MIP_FILTER_BOX, false, 128}},
+    };
+    for (MipStage const &stage: stages) {
+        if (isEnabled(stage.name)) {
+            time(stage.name, corpus, corpus.pixels.size(), [&]() {
+                return generateMipLevels(mipChain, stage.options) == CONVERT_OK;
+            });
+        }
+    }
+
+    //the mip chain generated before the in-tree generator
+    if (isEnabled("mip-directxtex")) {
+        time("mip-directxtex", corpus, corpus.pixels.size(), [&]() {
+            DirectX::ScratchImage chain{};
+            return SUCCEEDED(DirectX::GenerateMipMaps(base, DirectX::TEX_FILTER_FORCE_NON_WIC, 0, chain));
+        });
+    }
+
+    if (isEnabled("dds-serialize")) {
+        if (generateMipLevels(mipChain, MipOptions{}) != CONVERT_OK) {
+            return;
+        }
+        size_t ddsSize = 0;
+        if (computeDDSSize(mipChain.metadata, true, ddsSize) != CONVERT_OK) {
+            return;
+        }
+        std::vector<unsigned char> dds(ddsSize);
+        time("dds-serialize", corpus, ddsSize, [&]() {
+            return writeDDS(mipChain, true, dds.data(), dds.size()) == CONVERT_OK;
+        });
+    }
+}
+
+void Bench::runBCStages(CorpusImage const &corpus, DirectX::Image const &base, DXGI_FORMAT const format,
+                        char const *const name, bool const compress) {
+    std::string const compressStage = std::string(name) + "-compress";
+    std::string const decompressStage = std::string(name) + "-decompress";
+    std::string const directXTexStage = decompressStage + "-directxtex";
+    if (!(compress && isEnabled(compressStage.c_str())) && !isEnabled(decompressStage.c_str())
+        && !isEnabled(directXTexStage.c_str())) {
+        return;
+    }
+
+    size_t const blocksWide = (corpus.width + 3) / 4;
+    size_t const blocksHigh = (corpus.height + 3) / 4;
+    std::vector<unsigned char> blocks(blocksWide * blocksHigh * getBCBlockSize(format));
+    if (!compress) {
+        getRandomBlocks(format, blocks);
+    } else if (encodeBC(format, options.bcQuality, base, blocks.data()) != CONVERT_OK) {
+        std::fprintf(stderr, "%s: %s encoding failed\n", corpus.name.c_str(), name);
+        return;
+    }
+    std::vector<unsigned char> decoded(corpus.pixels.size());
+    if (decodeBC(format, blocks.data(), blocks.size(), corpus.width, corpus.height, decoded.data()) != CONVERT_OK) {
+        std::fprintf(stderr, "%s: %s decoding failed\n", corpus.name.c_str(), name);
+        return;
+    }
+
+    if (compress && isEnabled(compressStage.c_str())) {
+        time(compressStage.c_str(), corpus, corpus.pixels.size(), [&]() {
+            return encodeBC(format, options.bcQuality, base, blocks.data()) == CONVERT_OK;
+        }, getPsnr(format, corpus.pixels, decoded));
+    }
+
+    if (isEnabled(decompressStage.c_str())) {
+        time(decompressStage.c_str(), corpus, blocks.size(), [&]() {
+            return decodeBC(format, blocks.data(), blocks.size(), corpus.width, corpus.height, decoded.data())
+                   == CONVERT_OK;
+        });
+    }
+
+    //the decoder used before the in-tree decoder
+    if (isEnabled(directXTexStage.c_str())) {
+        DirectX::Image compressed{};
+        compressed.width = corpus.width;
+        compressed.height = corpus.height;
+        compressed.format = format;
+        compressed.rowPitch = blocksWide * getBCBlockSize(format);
+        compressed.slicePitch = blocks.size();
+        compressed.pixels = blocks.data();
+        time(directXTexStage.c_str(), corpus, blocks.size(), [&]() {
+            DirectX::ScratchImage image{};
+            return SUCCEEDED(DirectX::Decompress(compressed, DXGI_FORMAT_R8G8B8A8_UNORM, image));
+        });
+    }
+}
+
+static void printTable(std::FILE *const out, std::vector<StageResult> const &results) {
+    std::fprintf(out, "%-28s %-16s %10s %10s %10s %10s %10s %10s %8s %8s %8s %10s\n", "stage", "image", "p50 ms",
+                 "p90 ms", "p99 ms", "MP/s", "MB/s", "out KB", "PSNR", "allocs", "buffers", "RSS MB");
+    for (StageResult const &r: results) {
+        if (r.failed) {
+            std::fprintf(out, "%-28s %-16s failed\n", r.stage.c_str(), r.image.c_str());
+            continue;
+        }
+        double const p50 = getPercentile(r.seconds, 50.0);
+        double const pixels = static_cast<double>(r.width * r.height * r.images);
+        std::fprintf(out, "%-28s %-16s %10.3f %10.3f %10.3f %10.1f %10.1f ", r.stage.c_str(), r.image.c_str(),
+                     p50 * 1e3, getPercentile(r.seconds, 90.0) * 1e3, getPercentile(r.seconds, 99.0) * 1e3,
+                     pixels / p50 / 1e6, static_cast<double>(r.bytes) / p50 / 1e6);
+        if (r.outputBytes > 0) {
+            std::fprintf(out, "%10.1f ", static_cast<double>(r.outputBytes) / 1024.0);
+        } else {
+            std::fprintf(out, "%10s ", "-");
+        }
+        if (r.psnr >= 0.0) {
+            std::fprintf(out, "%8.2f ", r.psnr);
+        } else {
+            std::fprintf(out, "%8s ", "-");
+        }
+        if (r.allocationsPerRun >= 0.0) {
+            std::fprintf(out, "%8.2f ", r.allocationsPerRun);
+        } else {
+            std::fprintf(out, "%8s ", "-");
+        }
+        if (r.bufferAllocationsPerRun >= 0.0) {
+            std::fprintf(out, "%8.2f ", r.bufferAllocationsPerRun);
+        } else {
+            std::fprintf(out, "%8s ", "-");
+        }
+        if (r.peakRss > 0) {
+            std::fprintf(out, "%10.1f\n", static_cast<double>(r.peakRss) / (1024.0 * 1024.0));
+        } else {
+            std::fprintf(out, "%10s\n", "-");
+        }
+    }
+}
+
+/**
+ * Escape a string for a JSON string literal, the image names come from the file names of --png-dir
+ */
+static std::string escapeJson(std::string const &text) {
+    std::string escaped;
+    for (char const c: text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned int>(c));
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static void writeJson(std::FILE *const out, BenchOptions const &options, std::vector<StageResult> const &results) {
+    std::fprintf(out, "{\n");
+    std::fprintf(out, "  \"version\": 1,\n");
+    std::fprintf(out, "  \"pngBackend\": \"%s\",\n", PNG_BACKEND);
+    std::fprintf(out, "  \"allocationCounter\": \"%s\",\n", ALLOCATION_COUNTER);
+    std::fprintf(out, "  \"kernels\": {\"swizzle\": \"%s\", \"bcDecode\": \"%s\", \"bcEncode\": \"%s\", "
+                      "\"mip\": \"%s\", \"hash\": \"%s\", \"pngUnfilter\": \"%s\"},\n", getSwizzleKernels().name,
+                 getBCDecodeKernels().name, getBCEncodeKernels().name, getMipKernels().name, getHashKernels().name,
+                 getPngUnfilterKernels().name);
+    std::fprintf(out, "  \"workers\": %zu,\n", getThreadPool()->getWorkerCount());
+    std::fprintf(out, "  \"iterations\": %zu,\n", options.iterations);
+    std::fprintf(out, "  \"warmup\": %zu,\n", options.warmup);
+    std::fprintf(out, "  \"bcQuality\": %d,\n", static_cast<int>(options.bcQuality));
+    std::fprintf(out, "  \"results\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+        StageResult const &r = results[i];
+        double const p50 = getPercentile(r.seconds, 50.0);
+        std::fprintf(out, "%s\n    {\"stage\": \"%s\", \"image\": \"%s\", \"width\": %zu, \"height\": %zu, "
+                          "\"bytes\": %zu, \"iterations\": %zu, \"failed\": %s,\n", i == 0 ? "" : ",",
+                     escapeJson(r.stage).c_str(), escapeJson(r.image).c_str(), r.width, r.height, r.bytes,
+                     r.seconds.size(), r.failed ? "true" : "false");
+        std::fprintf(out, "     \"seconds\": {\"min\": %.9f, \"mean\": %.9f, \"p50\": %.9f, \"p90\": %.9f, "
+                          "\"p99\": %.9f, \"max\": %.9f},\n", r.seconds.empty() ? 0.0 : r.seconds.front(),
+                     getMean(r.seconds), p50, getPercentile(r.seconds, 90.0), getPercentile(r.seconds, 99.0),
+                     r.seconds.empty() ? 0.0 : r.seconds.back());
+        double const megapixels = p50 > 0.0 ? static_cast<double>(r.width * r.height * r.images) / p50 / 1e6 : 0.0;
+        double const megabytes = p50 > 0.0 ? static_cast<double>(r.bytes) / p50 / 1e6 : 0.0;
+        std::fprintf(out, "     \"megapixelsPerSecond\": %.3f, \"megabytesPerSecond\": %.3f", megapixels, megabytes);
+        if (r.outputBytes > 0) {
+            std::fprintf(out, ", \"outputBytes\": %zu", r.outputBytes);
+        }
+        if (r.psnr >= 0.0) {
+            std::fprintf(out, ", \"psnr\": %.3f", r.psnr);
+        }
+        if (r.allocationsPerRun >= 0.0) {
+            std::fprintf(out, ", \"allocationsPerRun\": %.3f", r.allocationsPerRun);
+        }
+        if (r.bufferAllocationsPerRun >= 0.0) {
+            std::fprintf(out, ", \"bufferAllocationsPerRun\": %.3f", r.bufferAllocationsPerRun);
+        }
+        //only where the platform measures each stage
+        if (r.peakRss > 0) {
+            std::fprintf(out, ", \"peakRssBytes\": %zu", r.peakRss);
+        }
+        std::fprintf(out, "}");
+    }
+    std::fprintf(out, "\n  ],\n");
+    //the stages reset the peak of the process, the highest of them is part of it
+    size_t peakRss = getPeakRss();
+    for (StageResult const &r: results) {
+        peakRss = std::max(peakRss, r.peakRss);
+    }
+    std::fprintf(out, "  \"peakRssBytes\": %zu\n", peakRss);
+    std::fprintf(out, "}\n");
+}
+
+static void printUsage() {
+    std::fprintf(stderr,
+                 "usage: dxtexwrapper-bench [options]\n"
+                 "  --iterations N     timed runs of every stage (10)\n"
+                 "  --warmup N         untimed runs before timing (1)\n"
+                 "  --min-size N       smallest corpus size (64)\n"
+                 "  --max-size N       largest corpus size, up to 16384 (4096)\n"
+                 "  --patterns LIST    comma separated: gradient,noise,flat,alpha (all)\n"
+                 "  --stages LIST      comma separated stage names, 'prefix*' selects a group (all)\n"
+                 "  --bc-quality Q     fast, normal or high (normal)\n"
+                 "  --workers N        threads of the shared pool, 0 for one per hardware thread (0)\n"
+                 "  --arena-trim N     bytes of scratch memory kept by each thread between conversions (64MB)\n"
+                 "  --cache-dir DIR    conversion cache of the convert-png-to-dds-cached stage\n"
+                 "  --file-dir DIR     scratch directory of the convert-*-file stages\n"
+                 "  --png-dir DIR      run the png-decode* and convert-* stages on the PNG files of DIR too\n"
+                 "  --json PATH        write the results as JSON, '-' for stdout\n"
+                 "  --corpus-dir DIR   write the corpus as PNG files and exit\n");
+}
+
+static std::vector<std::string> splitList(char const *const list) {
+    std::vector<std::string> items;
+    std::string item;
+    for (char const *c = list;; c++) {
+        if (*c == ',' || *c == '\0') {
+            if (!item.empty()) {
+                items.push_back(item);
+            }
+            item.clear();
+            if (*c == '\0') {
+                return items;
+            }
+        } else {
+            item += *c;
+        }
+    }
+}
+
+static bool parseSize(char const *const text, size_t &value) {
+    char *end = nullptr;
+    unsigned long long const parsed = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+static bool parseOptions(int const argc, char **const argv, BenchOptions &options) {
+    for (int i = 1; i < argc; i++) {
+        std::string const option = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        char const *value = argv[++i];
+        size_t number = 0;
+        if (option == "--iterations" && parseSize(value, number) && number > 0) {
+            options.iterations = number;
+        } else if (option == "--warmup" && parseSize(value, number)) {
+            options.warmup = number;
+        } else if (option == "--min-size" && parseSize(value, number)) {
+            options.minSize = number;
+        } else if (option == "--max-size" && parseSize(value, number)) {
+            options.maxSize = number;
+        } else if (option == "--workers" && parseSize(value, number)) {
+            options.workers = static_cast<unsigned int>(number);
+        } else if (option == "--arena-trim" && parseSize(value, number)) {
+            options.arenaTrim = number;
+        } else if (option == "--stages") {
+            options.stages = splitList(value);
+        } else if (option == "--patterns") {
+            for (std::string const &name: splitList(value)) {
+                CorpusPattern pattern{};
+                if (!findCorpusPattern(name.c_str(), pattern)) {
+                    return false;
+                }
+                options.patterns.push_back(pattern);
+            }
+        } else if (option == "--bc-quality") {
+            std::string const quality = value;
+            if (quality == "fast") {
+                options.bcQuality = BC_QUALITY_FAST;
+            } else if (quality == "normal") {
+                options.bcQuality = BC_QUALITY_NORMAL;
+            } else if (quality == "high") {
+                options.bcQuality = BC_QUALITY_HIGH;
+            } else {
+                return false;
+            }
+        } else if (option == "--json") {
+            options.jsonPath = value;
+        } else if (option == "--cache-dir") {
+            options.cacheDir = value;
+        } else if (option == "--file-dir") {
+            options.fileDir = value;
+        } else if (option == "--png-dir") {
+            options.pngDir = value;
+        } else if (option == "--corpus-dir") {
+            options.corpusDir = value;
+        } else {
+            return false;
+        }
+    }
+    if (options.patterns.empty()) {
+        options.patterns.assign(std::begin(CORPUS_PATTERNS), std::end(CORPUS_PATTERNS));
+    }
+    return true;
+}
+
+static bool readPngFile(std::filesystem::path const &path, std::vector<unsigned char> &png) {
+    std::FILE *file = openFile(path.u8string().c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    png.clear();
+    unsigned char buffer[65536];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) != 0) {
+        png.insert(png.end(), buffer, buffer + read);
+    }
+    bool const failed = std::ferror(file) != 0;
+    std::fclose(file);
+    return !failed;
+}
+
+/**
+ * Run the PNG stages on every .png file of 'dir', in name order
+ */
+static bool runPngDirectory(Bench &bench, std::string const &dir) {
+    std::error_code error;
+    std::vector<std::filesystem::path> paths;
+    for (std::filesystem::directory_entry const &entry: std::filesystem::directory_iterator(dir, error)) {
+        if (entry.path().extension() == ".png") {
+            paths.push_back(entry.path());
+        }
+    }
+    if (error) {
+        return false;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<unsigned char> png;
+    for (std::filesystem::path const &path: paths) {
+        std::string const name = path.stem().u8string();
+        if (!readPngFile(path, png)) {
+            std::fprintf(stderr, "error reading %s\n", path.u8string().c_str());
+            return false;
+        }
+        std::fprintf(stderr, "%s\n", name.c_str());
+        bench.runPngFile(name, png);
+    }
+    return true;
+}
+
+static bool writeCorpusFile(std::string const &dir, CorpusImage const &corpus) {
+    DirectX::Image image{};
+    image.width = corpus.width;
+    image.height = corpus.height;
+    image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    image.rowPitch = corpus.width * 4;
+    image.slicePitch = corpus.pixels.size();
+    image.pixels = const_cast<uint8_t *>(corpus.pixels.data());
+    std::vector<unsigned char> png;
+    if (!encodeCorpusPng(image, PNG_PROFILE_BALANCED, png)) {
+        return false;
+    }
+
+    std::string const path = dir + "/" + corpus.name + ".png";
+    std::FILE *file = openFile(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool const written = std::fwrite(png.data(), 1, png.size(), file) == png.size();
+    return std::fclose(file) == 0 && written;
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+    if (options.workers != 0) {
+        setThreadPoolWorkers(options.workers);
+        AsyncConvertOptions asyncOptions{};
+        asyncOptions.workers = options.workers;
+        setAsyncConvertOptions(&asyncOptions);
+    }
+    if (options.arenaTrim != SIZE_MAX) {
+        setScratchArenaTrim(options.arenaTrim);
+    }
+
+    Bench bench(options);
+    //largest images first in each pattern would inflate the RSS of the small ones, so sizes are the outer loop
+    for (size_t const size: CORPUS_SIZES) {
+        if (size < options.minSize || size > options.maxSize) {
+            continue;
+        }
+        for (CorpusPattern const pattern: options.patterns) {
+            CorpusImage corpus;
+            generateCorpusImage(pattern, size, corpus);
+            if (!options.corpusDir.empty()) {
+                if (!writeCorpusFile(options.corpusDir, corpus)) {
+                    std::fprintf(stderr, "error writing %s\n", corpus.name.c_str());
+                    return 1;
+                }
+                continue;
+            }
+            std::fprintf(stderr, "%s\n", corpus.name.c_str());
+            bench.run(corpus);
+        }
+    }
+    if (!options.corpusDir.empty()) {
+        return 0;
+    }
+    if (!options.pngDir.empty() && !runPngDirectory(bench, options.pngDir)) {
+        std::fprintf(stderr, "error reading %s\n", options.pngDir.c_str());
+        return 1;
+    }
+
+    bool const jsonToStdout = options.jsonPath == "-";
+    printTable(jsonToStdout ? stderr : stdout, bench.getResults());
+    if (options.jsonPath.empty()) {
+        return 0;
+    }
+
+    std::FILE *json = jsonToStdout ? stdout : openFile(options.jsonPath.c_str(), "wb");
+    if (json == nullptr) {
+        std::fprintf(stderr, "error writing %s\n", options.jsonPath.c_str());
+        return 1;
+    }
+    writeJson(json, options, bench.getResults());
+    if (!jsonToStdout && std::fclose(json) != 0) {
+        std::fprintf(stderr, "error writing %s\n", options.jsonPath.c_str());
+        return 1;
+    }
+    return 0;
+}
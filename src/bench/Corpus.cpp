@@ -0,0 +1,167 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "Corpus.h"
+
+//cells of the value noise of CORPUS_ALPHA, in pixels
+static constexpr size_t ALPHA_CELL_SIZE = 32;
+
+char const *getCorpusPatternName(CorpusPattern const pattern) {
+    switch (pattern) {
+        case CORPUS_NOISE:
+            return "noise";
+        case CORPUS_FLAT:
+            return "flat";
+        case CORPUS_ALPHA:
+            return "alpha";
+        case CORPUS_GRADIENT:
+        default:
+            return "gradient";
+    }
+}
+
+bool findCorpusPattern(char const *const name, CorpusPattern &pattern) {
+    for (CorpusPattern const candidate: CORPUS_PATTERNS) {
+        if (std::strcmp(name, getCorpusPatternName(candidate)) == 0) {
+            pattern = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * xorshift64*, the corpus must be the same on every platform so std random engines and distributions are not used
+ */
+static uint64_t nextRandom(uint64_t &state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+static uint64_t getSeed(CorpusPattern const pattern, size_t const size) {
+    uint64_t const state = ((static_cast<uint64_t>(pattern) + 1) * 0x9e3779b97f4a7c15ULL) ^ static_cast<uint64_t>(size);
+    return state == 0 ? 1 : state;
+}
+
+static unsigned char toByte(size_t const value, size_t const range) {
+    return static_cast<unsigned char>(range <= 1 ? 0 : value * 255 / (range - 1));
+}
+
+static void generateGradient(CorpusImage &image) {
+    for (size_t y = 0; y < image.height; y++) {
+        unsigned char *row = image.pixels.data() + y * image.width * 4;
+        for (size_t x = 0; x < image.width; x++) {
+            row[x * 4] = toByte(x, image.width);
+            row[x * 4 + 1] = toByte(y, image.height);
+            row[x * 4 + 2] = toByte(x + y, image.width + image.height - 1);
+            row[x * 4 + 3] = 0xff;
+        }
+    }
+}
+
+static void generateNoise(CorpusImage &image) {
+    uint64_t state = getSeed(image.pattern, image.width);
+    size_t const size = image.pixels.size();
+    for (size_t i = 0; i < size; i += 8) {
+        uint64_t const bits = nextRandom(state);
+        for (size_t b = 0; b < 8 && i + b < size; b++) {
+            image.pixels[i + b] = static_cast<unsigned char>(bits >> (b * 8));
+        }
+    }
+    for (size_t i = 3; i < size; i += 4) {
+        image.pixels[i] = 0xff;
+    }
+}
+
+static void generateFlat(CorpusImage &image) {
+    unsigned char const color[4] = {96, 128, 160, 255};
+    for (size_t i = 0; i < image.pixels.size(); i += 4) {
+        std::memcpy(&image.pixels[i], color, sizeof(color));
+    }
+}
+
+/**
+ * Value noise thresholded into a cutout: random values on a grid of ALPHA_CELL_SIZE pixels, interpolated, mapped to
+ * alpha with a steep ramp so about 40% of the pixels are opaque. Transparent pixels are black.
+ */
+static void generateAlpha(CorpusImage &image) {
+    size_t const cellsX = image.width / ALPHA_CELL_SIZE + 2;
+    size_t const cellsY = image.height / ALPHA_CELL_SIZE + 2;
+    std::vector<float> grid(cellsX * cellsY);
+    uint64_t state = getSeed(image.pattern, image.width);
+    for (float &value: grid) {
+        value = static_cast<float>(nextRandom(state) >> 40) / static_cast<float>(1 << 24);
+    }
+
+    for (size_t y = 0; y < image.height; y++) {
+        size_t const cellY = y / ALPHA_CELL_SIZE;
+        float const fy = static_cast<float>(y % ALPHA_CELL_SIZE) / static_cast<float>(ALPHA_CELL_SIZE);
+        unsigned char *row = image.pixels.data() + y * image.width * 4;
+        for (size_t x = 0; x < image.width; x++) {
+            size_t const cellX = x / ALPHA_CELL_SIZE;
+            float const fx = static_cast<float>(x % ALPHA_CELL_SIZE) / static_cast<float>(ALPHA_CELL_SIZE);
+            float const *cell = &grid[cellY * cellsX + cellX];
+            float const top = cell[0] + (cell[1] - cell[0]) * fx;
+            float const bottom = cell[cellsX] + (cell[cellsX + 1] - cell[cellsX]) * fx;
+            float const value = top + (bottom - top) * fy;
+            auto const alpha = static_cast<unsigned char>(std::clamp((value - 0.55f) * 8.0f, 0.0f, 1.0f) * 255.0f);
+
+            row[x * 4] = alpha == 0 ? 0 : toByte(x, image.width);
+            row[x * 4 + 1] = alpha == 0 ? 0 : static_cast<unsigned char>(96 + toByte(y, image.height) / 2);
+            row[x * 4 + 2] = alpha == 0 ? 0 : 32;
+            row[x * 4 + 3] = alpha;
+        }
+    }
+}
+
+void generateCorpusImage(CorpusPattern const pattern, size_t const size, CorpusImage &image) {
+    image.name = std::string(getCorpusPatternName(pattern)) + "-" + std::to_string(size);
+    image.pattern = pattern;
+    image.width = size;
+    image.height = size;
+    image.pixels.assign(size * size * 4, 0);
+
+    switch (pattern) {
+        case CORPUS_NOISE:
+            generateNoise(image);
+            break;
+        case CORPUS_FLAT:
+            generateFlat(image);
+            break;
+        case CORPUS_ALPHA:
+            generateAlpha(image);
+            break;
+        case CORPUS_GRADIENT:
+        default:
+            generateGradient(image);
+            break;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+enum CorpusPattern : int {
+    //smooth color ramps, opaque
+    CORPUS_GRADIENT = 0,
+    //uniform random bytes, opaque, incompressible
+    CORPUS_NOISE = 1,
+    //a single color
+    CORPUS_FLAT = 2,
+    //mostly transparent cutout with soft edges, like foliage
+    CORPUS_ALPHA = 3,
+};
+
+constexpr CorpusPattern CORPUS_PATTERNS[] = {CORPUS_GRADIENT, CORPUS_NOISE, CORPUS_FLAT, CORPUS_ALPHA};
+
+//square sizes of the corpus, from 64x64 to 16384x16384
+constexpr size_t CORPUS_SIZES[] = {64, 256, 1024, 4096, 16384};
+
+/**
+ * A synthetic 8-bit RGBA image, the pixels depend only on the pattern and the size
+ */
+class CorpusImage {
+public:
+    std::string name;
+    CorpusPattern pattern = CORPUS_GRADIENT;
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<unsigned char> pixels;
+};
+
+char const *getCorpusPatternName(CorpusPattern pattern);
+
+/**
+ * @return False if 'name' is not a pattern name
+ */
+bool findCorpusPattern(char const *name, CorpusPattern &pattern);
+
+/**
+ * Generate a square image of the corpus, named "<pattern>-<size>"
+ */
+void generateCorpusImage(CorpusPattern pattern, size_t size, CorpusImage &image);
@@ -0,0 +1,374 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "AsyncConvert.h"
+#include "Stats.h"
+#include "Test.h"
+
+//not a DDS, a job fails with CONVERT_ERROR_DECODE right after its DDS_TO_PNG stage begins
+static unsigned char const INVALID_DDS[] = {'n', 'o', 't', ' ', 'd', 'd', 's', '!'};
+
+static ConvertJob getInvalidJob() {
+    ConvertJob job{};
+    job.data = INVALID_DDS;
+    job.size = sizeof(INVALID_DDS);
+    job.direction = CONVERT_DDS_TO_PNG;
+    return job;
+}
+
+/**
+ * Holds the jobs in their DDS_TO_PNG stage through the trace callbacks until opened, so a job can be kept running.
+ * Declared after the converter, it is opened before the converter joins its threads.
+ */
+class StageGate {
+public:
+    StageGate() {
+        setTraceCallbacks(hold, nullptr, this);
+    }
+
+    ~StageGate() {
+        open();
+        setTraceCallbacks(nullptr, nullptr, nullptr);
+    }
+
+    StageGate(StageGate const &) = delete;
+
+    StageGate &operator=(StageGate const &) = delete;
+
+    void open() {
+        std::lock_guard<std::mutex> lock(mutex);
+        opened = true;
+        condition.notify_all();
+    }
+
+    /**
+     * Wait until 'count' jobs reached the gate
+     */
+    void waitEntered(int const count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] { return entered >= count; });
+    }
+
+private:
+    static void *hold(StatsStage const stage, void *const userData) {
+        auto *const gate = static_cast<StageGate *>(userData);
+        if (stage == STATS_STAGE_DDS_TO_PNG) {
+            std::unique_lock<std::mutex> lock(gate->mutex);
+            gate->entered++;
+            gate->condition.notify_all();
+            gate->condition.wait(lock, [gate] { return gate->opened; });
+        }
+        return nullptr;
+    }
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    int entered = 0;
+    bool opened = false;
+};
+
+/**
+ * Completions seen by a callback, and what it submitted itself
+ */
+class CallbackRecord {
+public:
+    AsyncConverter *converter = nullptr;
+    std::mutex mutex;
+    std::condition_variable condition;
+    int calls = 0;
+    ConvertStatus status = CONVERT_PENDING;
+    std::thread::id thread;
+    ConvertJob nestedJob = getInvalidJob();
+    ConvertTicket nestedTicket = 0;
+    ConvertStatus nestedSubmit = CONVERT_PENDING;
+
+    void waitCalls(int const count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] { return calls >= count; });
+    }
+};
+
+static void recordCompletion(ConvertTicket, ConvertJob *const job, void *const userData) {
+    auto *const record = static_cast<CallbackRecord *>(userData);
+    if (record->converter != nullptr) {
+        record->nestedSubmit = record->converter->submit(&record->nestedJob, nullptr, nullptr, record->nestedTicket);
+    }
+    std::lock_guard<std::mutex> lock(record->mutex);
+    record->calls++;
+    record->status = job->status;
+    record->thread = std::this_thread::get_id();
+    record->condition.notify_all();
+}
+
+TEST(asyncRejectReturnsQueueFull) {
+    AsyncConverter converter({1, 2, ASYNC_BACKPRESSURE_REJECT});
+    StageGate gate;
+    ConvertJob jobs[3] = {getInvalidJob(), getInvalidJob(), getInvalidJob()};
+    ConvertTicket tickets[3]{};
+    CHECK(converter.submit(&jobs[0], nullptr, nullptr, tickets[0]) == CONVERT_OK);
+    gate.waitEntered(1);
+    CHECK(converter.submit(&jobs[1], nullptr, nullptr, tickets[1]) == CONVERT_OK);
+    CHECK(converter.submit(&jobs[2], nullptr, nullptr, tickets[2]) == CONVERT_ERROR_QUEUE_FULL);
+    CHECK(tickets[2] == 0);
+
+    gate.open();
+    CHECK(converter.wait(tickets[0], UINT32_MAX) == CONVERT_ERROR_DECODE);
+    //a slot is free again once its status is collected
+    CHECK(converter.submit(&jobs[2], nullptr, nullptr, tickets[2]) == CONVERT_OK);
+    CHECK(converter.wait(tickets[1], UINT32_MAX) == CONVERT_ERROR_DECODE);
+    CHECK(converter.wait(tickets[2], UINT32_MAX) == CONVERT_ERROR_DECODE);
+    CHECK(jobs[2].status == CONVERT_ERROR_DECODE && jobs[2].output.content == nullptr);
+}
+
+TEST(asyncBlockWaitsForFreeSlot) {
+    AsyncConverter converter({1, 1, ASYNC_BACKPRESSURE_BLOCK});
+    StageGate gate;
+    ConvertJob first = getInvalidJob();
+    ConvertJob second = getInvalidJob();
+    ConvertTicket firstTicket = 0;
+    ConvertTicket secondTicket = 0;
+    CHECK(converter.submit(&first, nullptr, nullptr, firstTicket) == CONVERT_OK);
+    gate.waitEntered(1);
+
+    std::atomic<bool> submitted{false};
+    ConvertStatus secondSubmit = CONVERT_PENDING;
+    std::thread submitter([&] {
+        secondSubmit = converter.submit(&second, nullptr, nullptr, secondTicket);
+        submitted = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!submitted.load());
+    //completed but not collected, its slot is still taken
+    gate.open();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!submitted.load());
+
+    CHECK(converter.wait(firstTicket, UINT32_MAX) == CONVERT_ERROR_DECODE);
+    submitter.join();
+    CHECK(secondSubmit == CONVERT_OK && secondTicket != 0 && secondTicket != firstTicket);
+    CHECK(converter.wait(secondTicket, UINT32_MAX) == CONVERT_ERROR_DECODE);
+}
+
+TEST(asyncCancelQueuedAndRunningJobs) {
+    AsyncConverter converter({1, 4, ASYNC_BACKPRESSURE_REJECT});
+    StageGate gate;
+    ConvertJob running = getInvalidJob();
+    ConvertJob withCallback = getInvalidJob();
+    ConvertJob queued = getInvalidJob();
+    ConvertTicket runningTicket = 0;
+    ConvertTicket callbackTicket = 0;
+    ConvertTicket queuedTicket = 0;
+    CallbackRecord record;
+    CHECK(converter.submit(&running, nullptr, nullptr, runningTicket) == CONVERT_OK);
+    gate.waitEntered(1);
+    CHECK(converter.submit(&withCallback, recordCompletion, &record, callbackTicket) == CONVERT_OK);
+    CHECK(converter.submit(&queued, nullptr, nullptr, queuedTicket) == CONVERT_OK);
+
+    CHECK(converter.cancel(runningTicket) == CONVERT_PENDING);
+    //the callback of a cancelled job is called on the cancelling thread, before cancel returns
+    CHECK(converter.cancel(callbackTicket) == CONVERT_OK);
+    CHECK(record.calls == 1 && record.status == CONVERT_CANCELLED && record.thread == std::this_thread::get_id());
+    CHECK(converter.cancel(callbackTicket) == CONVERT_ERROR_INVALID_ARGUMENT);
+    CHECK(converter.cancel(queuedTicket) == CONVERT_OK);
+    CHECK(converter.cancel(queuedTicket) == CONVERT_PENDING);
+    CHECK(converter.wait(queuedTicket, 0) == CONVERT_CANCELLED);
+    CHECK(converter.cancel(queuedTicket) == CONVERT_ERROR_INVALID_ARGUMENT);
+
+    gate.open();
+    CHECK(converter.wait(runningTicket, UINT32_MAX) == CONVERT_ERROR_DECODE);
+    CHECK(record.calls == 1);
+
+    //one worker runs the tickets in order, once this one is collected the cancelled ones were dropped from the queue
+    ConvertJob last = getInvalidJob();
+    ConvertTicket lastTicket = 0;
+    CHECK(converter.submit(&last, nullptr, nullptr, lastTicket) == CONVERT_OK);
+    CHECK(converter.wait(lastTicket, UINT32_MAX) == CONVERT_ERROR_DECODE);
+    //every slot is free
+    ConvertJob jobs[4] = {getInvalidJob(), getInvalidJob(), getInvalidJob(), getInvalidJob()};
+    ConvertTicket tickets[4]{};
+    for (size_t i = 0; i < 4; i++) {
+        CHECK_MESSAGE(converter.submit(&jobs[i], nullptr, nullptr, tickets[i]) == CONVERT_OK, "job %zu", i);
+    }
+    for (ConvertTicket const ticket: tickets) {
+        CHECK(converter.wait(ticket, UINT32_MAX) == CONVERT_ERROR_DECODE);
+    }
+}
+
+TEST(asyncPollAndWaitTimeOut) {
+    AsyncConverter converter({1, 2, ASYNC_BACKPRESSURE_BLOCK});
+    StageGate gate;
+    ConvertJob job = getInvalidJob();
+    ConvertTicket ticket = 0;
+    CHECK(converter.submit(&job, nullptr, nullptr, ticket) == CONVERT_OK);
+    gate.waitEntered(1);
+
+    CHECK(converter.wait(ticket, 0) == CONVERT_PENDING);
+    auto const start = std::chrono::steady_clock::now();
+    CHECK(converter.wait(ticket, 50) == CONVERT_PENDING);
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    CHECK(elapsed >= std::chrono::milliseconds(45));
+    CHECK(job.status == CONVERT_PENDING);
+
+    gate.open();
+    CHECK(converter.wait(ticket, UINT32_MAX) == CONVERT_ERROR_DECODE);
+}
+
+TEST(asyncReleasedTicketsAreInvalid) {
+    AsyncConverter converter({1, 1, ASYNC_BACKPRESSURE_BLOCK});
+    CHECK(converter.wait(0, 0) == CONVERT_ERROR_INVALID_ARGUMENT);
+    CHECK(converter.cancel(0) == CONVERT_ERROR_INVALID_ARGUMENT);
+    //slot index past the capacity
+    CHECK(converter.wait((uint64_t{1} << 32) | 1, 0) == CONVERT_ERROR_INVALID_ARGUMENT);
+
+    ConvertJob first = getInvalidJob();
+    ConvertTicket firstTicket = 0;
+    CHECK(converter.submit(&first, nullptr, nullptr, firstTicket) == CONVERT_OK);
+    CHECK(converter.wait(firstTicket, UINT32_MAX) == CONVERT_ERROR_DECODE);
+    CHECK(converter.wait(firstTicket, UINT32_MAX) == CONVERT_ERROR_INVALID_ARGUMENT);
+    CHECK(converter.cancel(firstTicket) == CONVERT_ERROR_INVALID_ARGUMENT);
+
+    //the same slot with the next generation
+    ConvertJob second = getInvalidJob();
+    ConvertTicket secondTicket = 0;
+    CHECK(converter.submit(&second, nullptr, nullptr, secondTicket) == CONVERT_OK);
+    CHECK(secondTicket != firstTicket && (secondTicket & 0xffffffffu) == (firstTicket & 0xffffffffu));
+    CHECK(converter.wait(firstTicket, 0) == CONVERT_ERROR_INVALID_ARGUMENT);
+    CHECK(converter.cancel(firstTicket) == CONVERT_ERROR_INVALID_ARGUMENT);
+    CHECK(converter.wait(secondTicket, UINT32_MAX) == CONVERT_ERROR_DECODE);
+
+    //released by its callback
+    CallbackRecord record;
+    ConvertJob third = getInvalidJob();
+    ConvertTicket thirdTicket = 0;
+    CHECK(converter.submit(&third, recordCompletion, &record, thirdTicket) == CONVERT_OK);
+    record.waitCalls(1);
+    CHECK(record.status == CONVERT_ERROR_DECODE);
+    CHECK(converter.wait(thirdTicket, UINT32_MAX) == CONVERT_ERROR_INVALID_ARGUMENT);
+}
+
+/**
+ * A callback runs on a worker, waiting there for a slot could wait for itself: it is rejected even with
+ * ASYNC_BACKPRESSURE_BLOCK
+ */
+TEST(asyncSubmitFromCallback) {
+    for (uint32_t const capacity: {1u, 2u}) {
+        AsyncConverter converter({1, capacity, ASYNC_BACKPRESSURE_BLOCK});
+        CallbackRecord record;
+        record.converter = &converter;
+        ConvertJob job = getInvalidJob();
+        ConvertTicket ticket = 0;
+        CHECK(converter.submit(&job, recordCompletion, &record, ticket) == CONVERT_OK);
+        record.waitCalls(1);
+        if (capacity == 1) {
+            CHECK(record.nestedSubmit == CONVERT_ERROR_QUEUE_FULL && record.nestedTicket == 0);
+        } else {
+            CHECK(record.nestedSubmit == CONVERT_OK);
+            CHECK(converter.wait(record.nestedTicket, UINT32_MAX) == CONVERT_ERROR_DECODE);
+        }
+    }
+}
+
+/**
+ * Many producers submitting, cancelling and collecting through a small queue, for the thread sanitizer: every job
+ * completes once, with the status matching what cancel returned
+ */
+TEST(asyncManyProducers) {
+    constexpr int PRODUCERS = 8;
+    constexpr int ROUNDS = 300;
+    for (AsyncBackpressure const backpressure: {ASYNC_BACKPRESSURE_BLOCK, ASYNC_BACKPRESSURE_REJECT}) {
+        AsyncConverter converter({4, 16, backpressure});
+        std::atomic<int> callbacks{0};
+        std::atomic<int> errors{0};
+        std::vector<std::thread> producers;
+        for (int p = 0; p < PRODUCERS; p++) {
+            producers.emplace_back([&, p] {
+                //outlive their tickets, a callback job may complete after its round
+                std::vector<ConvertJob> callbackJobs(ROUNDS, getInvalidJob());
+                auto const submit = [&](ConvertJob &job, ConvertCallback const callback, ConvertTicket &ticket) {
+                    ConvertStatus status;
+                    while ((status = converter.submit(&job, callback, &callbacks, ticket)) == CONVERT_ERROR_QUEUE_FULL
+                           && backpressure == ASYNC_BACKPRESSURE_REJECT) {
+                        std::this_thread::yield();
+                    }
+                    return status;
+                };
+                for (int round = 0; round < ROUNDS; round++) {
+                    ConvertTicket callbackTicket = 0;
+                    if (submit(callbackJobs[static_cast<size_t>(round)],
+                               [](ConvertTicket, ConvertJob *const job, void *const userData) {
+                                   if (job->status == CONVERT_ERROR_DECODE || job->status == CONVERT_CANCELLED) {
+                                       static_cast<std::atomic<int> *>(userData)->fetch_add(1);
+                                   }
+                               }, callbackTicket) != CONVERT_OK) {
+                        errors++;
+                    }
+
+                    ConvertJob job = getInvalidJob();
+                    ConvertTicket ticket = 0;
+                    if (submit(job, nullptr, ticket) != CONVERT_OK) {
+                        errors++;
+                        continue;
+                    }
+                    ConvertStatus expected = CONVERT_ERROR_DECODE;
+                    if ((round + p) % 3 == 0) {
+                        ConvertStatus const cancelled = converter.cancel(ticket);
+                        if (cancelled == CONVERT_OK) {
+                            expected = CONVERT_CANCELLED;
+                        } else if (cancelled != CONVERT_PENDING) {
+                            errors++;
+                        }
+                    }
+                    if (round % 2 == 0) {
+                        while (converter.wait(ticket, 0) == CONVERT_PENDING) {
+                            std::this_thread::yield();
+                        }
+                        if (job.status != expected) {
+                            errors++;
+                        }
+                    } else if (converter.wait(ticket, UINT32_MAX) != expected) {
+                        errors++;
+                    }
+                }
+                //the jobs of the callbacks must outlive them
+                while (callbacks.load() < PRODUCERS * ROUNDS && errors.load() == 0) {
+                    std::this_thread::yield();
+                }
+            });
+        }
+        for (std::thread &producer: producers) {
+            producer.join();
+        }
+        CHECK_MESSAGE(errors.load() == 0, "backpressure %d, %d errors", static_cast<int>(backpressure), errors.load());
+        CHECK_MESSAGE(callbacks.load() == PRODUCERS * ROUNDS, "backpressure %d, %d callbacks",
+                      static_cast<int>(backpressure), callbacks.load());
+    }
+}
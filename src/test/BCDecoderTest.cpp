@@ -0,0 +1,348 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "BCDecoder.h"
+#include "CpuFeatures.h"
+#include "Test.h"
+
+/**
+ * A block and its pixels, row by row
+ */
+class ReferenceBlock {
+public:
+    char const *name;
+    DXGI_FORMAT format;
+    char const *block;
+    char const *pixels;
+};
+
+//BC1 to BC5 are checked against the DirectXTex rounding, the float interpolation rounded half up. BC7 was checked
+//against the decoder of Pillow. The BC6H pixels are regression values, the output of this decoder when the vectors were
+//written: Pillow truncates BC6H to 8 bits where this decoder rounds the half floats like DirectXTex, so they are not an
+//independent reference and only catch changes of the decoder. The BC6H and BC7 payloads after the header are random.
+static ReferenceBlock const REFERENCE_BLOCKS[] = {
+        {"bc1, four colors", DXGI_FORMAT_BC1_UNORM, "00f81f00e4e4e4e4",
+         "ff0000ff 0000ffff aa0055ff 5500aaff ff0000ff 0000ffff aa0055ff 5500aaff "
+         "ff0000ff 0000ffff aa0055ff 5500aaff ff0000ff 0000ffff aa0055ff 5500aaff"},
+        {"bc1, three colors and transparent", DXGI_FORMAT_BC1_UNORM, "1f0000f8e4e4e4e4",
+         "0000ffff ff0000ff 800080ff 00000000 0000ffff ff0000ff 800080ff 00000000 "
+         "0000ffff ff0000ff 800080ff 00000000 0000ffff ff0000ff 800080ff 00000000"},
+        {"bc1, equal endpoints", DXGI_FORMAT_BC1_UNORM, "555555550055aaff",
+         "52aaadff 52aaadff 52aaadff 52aaadff 52aaadff 52aaadff 52aaadff 52aaadff "
+         "52aaadff 52aaadff 52aaadff 52aaadff 00000000 00000000 00000000 00000000"},
+        {"bc1, odd endpoints", DXGI_FORMAT_BC1_UNORM, "528a86313365093a",
+         "503952ff 8c4994ff 503952ff 8c4994ff 313131ff 313131ff 6e4173ff 313131ff "
+         "313131ff 6e4173ff 8c4994ff 8c4994ff 6e4173ff 6e4173ff 503952ff 8c4994ff"},
+        {"bc2, every alpha", DXGI_FORMAT_BC2_UNORM, "1032547698badcfe1f0000f8e4e4e4e4",
+         "0000ff00 ff000011 5500aa22 aa005533 0000ff44 ff000055 5500aa66 aa005577 "
+         "0000ff88 ff000099 5500aaaa aa0055bb 0000ffcc ff0000dd 5500aaee aa0055ff"},
+        {"bc3, eight alphas", DXGI_FORMAT_BC3_UNORM, "f01088c6fa88c6fa00f8e0073365093a",
+         "55aa00f0 ff000010 55aa00d0 ff0000b0 00ff0090 00ff0070 aa550050 00ff0030 "
+         "00ff00f0 aa550010 ff0000d0 ff0000b0 aa550090 aa550070 55aa0050 ff000030"},
+        {"bc3, six alphas", DXGI_FORMAT_BC3_UNORM, "10f088c6fa88c6fa1f00ffffe4e4e4e4",
+         "0000ff10 fffffff0 5555ff3d aaaaff6a 0000ff96 ffffffc3 5555ff00 aaaaffff "
+         "0000ff10 fffffff0 5555ff3d aaaaff6a 0000ff96 ffffffc3 5555ff00 aaaaffff"},
+        {"bc4, eight values", DXGI_FORMAT_BC4_UNORM, "f01088c6fa88c6fa",
+         "f0f0f0ff 101010ff d0d0d0ff b0b0b0ff 909090ff 707070ff 505050ff 303030ff "
+         "f0f0f0ff 101010ff d0d0d0ff b0b0b0ff 909090ff 707070ff 505050ff 303030ff"},
+        {"bc4, six values", DXGI_FORMAT_BC4_UNORM, "10f088c6fa88c6fa",
+         "101010ff f0f0f0ff 3d3d3dff 6a6a6aff 969696ff c3c3c3ff 000000ff ffffffff "
+         "101010ff f0f0f0ff 3d3d3dff 6a6a6aff 969696ff c3c3c3ff 000000ff ffffffff"},
+        {"bc4, equal endpoints", DXGI_FORMAT_BC4_UNORM, "8080e54fd35e58f6",
+         "808080ff 808080ff ffffffff ffffffff 808080ff 000000ff 808080ff 000000ff "
+         "000000ff 808080ff 808080ff 808080ff 808080ff 808080ff 808080ff ffffffff"},
+        {"bc4 snorm, eight values", DXGI_FORMAT_BC4_SNORM, "7f8188c6fa88c6fa",
+         "ffffffff 000000ff dbdbdbff b6b6b6ff 929292ff 6d6d6dff 494949ff 242424ff "
+         "ffffffff 000000ff dbdbdbff b6b6b6ff 929292ff 6d6d6dff 494949ff 242424ff"},
+        {"bc4 snorm, six values and -128", DXGI_FORMAT_BC4_SNORM, "804088c6fa88c6fa",
+         "000000ff c0c0c0ff 262626ff 4d4d4dff 737373ff 999999ff 000000ff ffffffff "
+         "000000ff c0c0c0ff 262626ff 4d4d4dff 737373ff 999999ff 000000ff ffffffff"},
+        {"bc4 snorm, zero", DXGI_FORMAT_BC4_SNORM, "0000e54fd35e58f6",
+         "808080ff 808080ff ffffffff ffffffff 808080ff 000000ff 808080ff 000000ff "
+         "000000ff 808080ff 808080ff 808080ff 808080ff 808080ff 808080ff ffffffff"},
+        {"bc5, eight and six values", DXGI_FORMAT_BC5_UNORM, "f01088c6fa88c6fa20e0e54fd35e58f6",
+         "f0ba00ff 109300ff d0ff00ff b0ff00ff 909300ff 700000ff 509300ff 300000ff "
+         "f00000ff 106d00ff d0e000ff b09300ff 90ba00ff 709300ff 50ba00ff 30ff00ff"},
+        {"bc5 snorm, eight and six values", DXGI_FORMAT_BC5_SNORM, "64a688c6fa88c6fa807fe54fd35e58f6",
+         "e4cc80ff 259980ff c9ff80ff adff80ff 929980ff 770080ff 5c9980ff 400080ff "
+         "e40080ff 256680ff c9ff80ff ad9980ff 92cc80ff 779980ff 5ccc80ff 40ff80ff"},
+        {"bc6h, mode 1, two regions", DXGI_FORMAT_BC6H_UF16, "a8b7e1e2da6a49862083ab7c833df25e",
+         "5c7015ff 5c7015ff 5d6d14ff 6a7c13ff 5b7315ff 527710ff 40740fff 647b12ff "
+         "4c760fff 6a7c13ff 40740fff 5d6d14ff 6a7c13ff 587a17ff 558019ff 5c7015ff"},
+        {"bc6h, mode 2", DXGI_FORMAT_BC6H_UF16, "5d855b62fcd8c05123f796dd480e952b",
+         "156910ff 4e0402ff 0f070cff 0018ffff ffd700ff 0a5c20ff 4e0402ff 4e0402ff "
+         "fff200ff 0a5c20ff 210605ff 030d51ff d0a302ff 5d8604ff ffbd01ff b40301ff"},
+        {"bc6h, mode 3", DXGI_FORMAT_BC6H_UF16, "82ebcba33f6c5575af2f5f0609848ba8",
+         "4478e0ff 4677ddff 4577deff 427ae3ff 3c81dbff 427ae3ff 427ae3ff 417ae5ff "
+         "3d7de0ff 417ae5ff 4776dbff 4677ddff 3c81dbff 3d7edeff 4379e2ff 4677ddff"},
+        {"bc6h, mode 6", DXGI_FORMAT_BC6H_UF16, "0e1e6cd99d74fade0bdec2c86d269e2f",
+         "c747a8ff 8d359bff b940a5ff ab3ca2ff 782e94ff 7f3198ff 7f3198ff b940a5ff "
+         "d052d3ff 8d359bff c747a8ff 712a91ff e43dffff a8827dff 9d399eff b940a5ff"},
+        {"bc6h, mode 10, untransformed", DXGI_FORMAT_BC6H_UF16, "3e790d0b9525ba3e9bacb49bdf25c976",
+         "012701ff 3f108dff 2b1654ff 18114bff ff0affff 2b1654ff 040838ff 2b1654ff "
+         "091a0aff 020734ff 020734ff 020734ff 18114bff 18114bff 18114bff 01052fff"},
+        {"bc6h, mode 11, one region", DXGI_FORMAT_BC6H_UF16, "e32b05b9d96d39d2786f075b3c06083d",
+         "16ff03ff 1ff506ff 5b7a37ff 1cff05ff 1ff506ff 0dff01ff 36b512ff 19ff03ff "
+         "3ba518ff 13ff02ff 1cff05ff 0dff01ff 24e608ff 0dff01ff 42961eff 13ff02ff"},
+        {"bc6h, mode 12", DXGI_FORMAT_BC6H_UF16, "27f5bc4de60eb5da9817edf1e6b6c5c6",
+         "85471eff 773518ff 7b3b1bff 935824ff 6e2a14ff 6b2712ff 935824ff 692411ff "
+         "7e3d1cff 6b2712ff 7e3d1cff 722f16ff 81411dff 702d15ff 7e3d1cff 702d15ff"},
+        {"bc6h, mode 13", DXGI_FORMAT_BC6H_UF16, "cbba5287dd93d12eed7d1994a6e5b683",
+         "1b3059ff 262270ff 23246dff 1c2f5bff 1e2b61ff 163a49ff 193452ff 1e2b61ff "
+         "1b3059ff 1f2965ff 1a3355ff 262270ff 1b3059ff 202767ff 183650ff 1d2d5eff"},
+        {"bc6h, mode 14, 16-bit base", DXGI_FORMAT_BC6H_UF16, "4f7bd30555d5dcd57d0da6f61c440887",
+         "0dbe17ff 0dbe17ff 0dbe17ff 0dbe17ff 0dbe17ff 0dbe17ff 0dbe17ff 0dbe17ff "
+         "0dbe17ff 0dbe17ff 0dbe17ff 0dbe17ff 0dbe17ff 0dbe17ff 0dbe17ff 0dbe17ff"},
+        {"bc6h signed, mode 1", DXGI_FORMAT_BC6H_SF16, "889c6e6a295a0c06c7e7ce0e597a5477",
+         "7d5d15ff b77110ff c46b11ff a9790fff 755a10ff 785b11ff a9790fff 8f8c0dff "
+         "866018ff 91621bff 82990cff c46b11ff 7a5c13ff 91621bff 8c611aff 8f8c0dff"},
+        {"bc6h signed, mode 10", DXGI_FORMAT_BC6H_SF16, "9e320022d9b869c4a5518bd70337cae8",
+         "ff00bfff ff2385ff 00303aff ff0051ff ff060dff 004512ff ff2385ff ff00ffff "
+         "ff4502ff 003e19ff ff2385ff ff060dff ff021eff 162868ff 002c4eff ff4502ff"},
+        {"bc6h signed, mode 11", DXGI_FORMAT_BC6H_SF16, "c39a6c4cb13e18994cb3a05bc2a5afb1",
+         "013261ff 04392aff 073c1dff 0023ffff 3f4b09ff 0026ffff 0023ffff 02363bff "
+         "0e3f14ff 0020ffff 02363bff 0026ffff 001bffff 0026ffff 20450dff 0023ffff"},
+        {"bc6h signed, mode 14", DXGI_FORMAT_BC6H_SF16, "8ffb03c901bca8e399ef811d5cb3ba59",
+         "0209dfff 0209dfff 0209dfff 0209dfff 0209dfff 0209dfff 0209dfff 0209dfff "
+         "0209dfff 0209dfff 0209dfff 0209dfff 0209dfff 0209dfff 0209dfff 0209dfff"},
+        {"bc6h, reserved mode", DXGI_FORMAT_BC6H_UF16, "13ead67824c43342e9d43f11968bf403",
+         "000000ff 000000ff 000000ff 000000ff 000000ff 000000ff 000000ff 000000ff "
+         "000000ff 000000ff 000000ff 000000ff 000000ff 000000ff 000000ff 000000ff"},
+        {"bc7, mode 0, partition 5", DXGI_FORMAT_BC7_UNORM, "4b1f7a75b3ec909e7fddd735c4b0e98d",
+         "beae77ff f2a0e4ff a266f1ff 445fdcff b2b15dff d9a7afff 085aceff 6261e3ff "
+         "a5b542ff cbaa92ff b682d2ff b980cbff ff9cffff e6a3caff bb7dc4ff b980cbff"},
+        {"bc7, mode 0, partition 13", DXGI_FORMAT_BC7_UNORM, "7b9c9e285c3ae0c7e5d8cc06e1505653",
+         "4c2fdcff dfbe3eff 4909c1ff 421073ff 9f9189ff 4a29efff 470ba8ff 450d99ff "
+         "3110f7ff c6a55bff 470ba8ff 480ab4ff 664fc2ff 937298ff 440e8dff 430f80ff"},
+        {"bc7, mode 1, partition 13", DXGI_FORMAT_BC7_UNORM, "36c5d6bbd5f3a2fa13c90d6b4d9a7386",
+         "3b4ca2ff 1656ebff 624156ff 2f4fbaff 3b4ca2ff 55456fff 2253d3ff 2253d3ff "
+         "caa9a4ff edb957ff b9a1c9ff d2ad91ff dcb17cff c1a5b6ff f5bd44ff e4b569ff"},
+        {"bc7, mode 1, partition 34", DXGI_FORMAT_BC7_UNORM, "8a750bbd7812759ae5c1c922f983e31f",
+         "ceae66ff 8860a2ff c05b5fff 404478ff 524b82ff d3c868ff 755897ff b7265aff "
+         "ca9363ff 404478ff bc415cff 524b82ff ab6db7ff b7265aff bd74c1ff d7e36aff"},
+        {"bc7, mode 2, partition 37", DXGI_FORMAT_BC7_UNORM, "2c8b37b1e718f6614084afec9bdad3b8",
+         "6d610dff 4fa8c6ff d9208eff b3330bff 6e6f8bff e443a2ff f70808ff 8c3952ff "
+         "ef63b5ff b3330bff 31deffff ce007bff 298c10ff 6e6f8bff ce007bff b3330bff"},
+        {"bc7, mode 2, partition 63", DXGI_FORMAT_BC7_UNORM, "fc7f20dcb2655ec4a7a7753f6ca929f5",
+         "ae4db9ff a6869dff 62817aff 62817aff b5c6ffff ae4db9ff 62817aff e78cbdff "
+         "b5c6ffff 7e67acff 593e80ff 217b5aff 9a98d7ff 9a98d7ff 633984ff 08314aff"},
+        {"bc7, mode 3, partition 60", DXGI_FORMAT_BC7_UNORM, "c8bb8219d99aae1d0a9c9af0c543e17e",
+         "69dd37ff 5dd705ff 77e36bff 83e99dff 43a663ff 33b535ff 549594ff 549594ff "
+         "5dd705ff 5dd705ff 6486c2ff 43a663ff 83e99dff 83e99dff 6486c2ff 33b535ff"},
+        {"bc7, mode 4", DXGI_FORMAT_BC7_UNORM, "10be879505684029ec795289719e1705",
+         "f708ce73 f708ce64 f23f4e36 f23f4e45 f708ce82 f4239055 f4239045 f708ce55 "
+         "f23f4e27 f4239055 ef5a1027 ef5a1055 f708ce73 ef5a1064 ef5a1073 f708ce82"},
+        {"bc7, mode 4, rotation 1 and index selection", DXGI_FORMAT_BC7_UNORM, "b08e84542fbff23aed82357f0addf9a4",
+         "f31bb25c c541bb2d ae2eb644 dc4abd21 dc4abd21 ae2eb644 dc1bb25c c508ad73 "
+         "c537b938 dc24b450 ae4abd21 dc2eb644 dc4abd21 f311af67 f311af67 ae37b938"},
+        {"bc7, mode 5, rotation 2", DXGI_FORMAT_BC7_UNORM, "a0a49337103b2ae6c14afeb5112284b6",
+         "488a62bd 488a62bd 4c84803f 4a8a7180 4a7f7180 4a8a7180 4c7f803f 488a62bd "
+         "4e8a8f02 4e848f02 4e8a8f02 4e7f8f02 4c7f803f 4c84803f 4a797180 4e7f8f02"},
+        {"bc7, mode 5, rotation 3", DXGI_FORMAT_BC7_UNORM, "e0d3cc569360b5247ce3869a4b3b9aa9",
+         "818c2129 32341558 32342d58 585f2141 818c0929 a7b71512 32340958 818c2d29 "
+         "32341558 a7b71512 a7b72112 818c1529 818c2129 32341558 a7b71512 32341558"},
+        {"bc7, mode 6", DXGI_FORMAT_BC7_UNORM, "c069cae90eff919f655bf1e8c394a76b",
+         "9ba6cb85 85b7db70 69ccef55 8bb2d776 a2a1c78c 53ddff3f 7abfe365 58d9fb44 "
+         "96aacf80 64d0f350 91aed37b 75c3e760 80bbdf6b 6fc8eb5a 69ccef55 85b7db70"},
+        {"bc7, mode 7, partition 20", DXGI_FORMAT_BC7_UNORM, "80d483f08c4845d89d3f8c34eb24aedf",
+         "79180879 7c3d4d91 6e76ec75 3c14e7d7 79180879 7c3d4d91 7f6596ab 86a6ef45 "
+         "7f6596ab 828adbc3 7f6596ab 7f6596ab 828adbc3 828adbc3 7c3d4d91 828adbc3"},
+        {"bc7, invalid mode", DXGI_FORMAT_BC7_UNORM, "00000000000000000000000000000000",
+         "00000000 00000000 00000000 00000000 00000000 00000000 00000000 00000000 "
+         "00000000 00000000 00000000 00000000 00000000 00000000 00000000 00000000"},
+};
+
+static std::vector<unsigned char> parseHex(char const *text) {
+    std::vector<unsigned char> bytes;
+    for (; *text != '\0'; text++) {
+        if (*text == ' ') {
+            continue;
+        }
+        char const digits[3] = {text[0], text[1], '\0'};
+        bytes.push_back(static_cast<unsigned char>(std::strtoul(digits, nullptr, 16)));
+        text++;
+    }
+    return bytes;
+}
+
+/**
+ * Every kernel set this CPU can run, the scalar one first
+ */
+static std::vector<BCDecodeKernels> getRunnableBCDecodeKernels() {
+    std::vector<BCDecodeKernels> kernels{{"scalar", decodeBC1RowScalar, decodeBC2RowScalar, decodeBC3RowScalar,
+                                          decodeBC4RowScalar, decodeBC4SnormRowScalar, decodeBC5RowScalar,
+                                          decodeBC5SnormRowScalar}};
+#ifdef DXTWRAPPER_X86
+    if (getCpuFeatures().sse41) {
+        kernels.push_back({"sse41", decodeBC1RowSse41, decodeBC2RowSse41, decodeBC3RowSse41, decodeBC4RowSse41,
+                           decodeBC4SnormRowSse41, decodeBC5RowSse41, decodeBC5SnormRowSse41});
+    }
+    if (getCpuFeatures().avx2) {
+        kernels.push_back({"avx2", decodeBC1RowAvx2, decodeBC2RowAvx2, decodeBC3RowAvx2, decodeBC4RowAvx2,
+                           decodeBC4SnormRowAvx2, decodeBC5RowAvx2, decodeBC5SnormRowAvx2});
+    }
+#endif
+    return kernels;
+}
+
+/**
+ * The kernel of a format with a decoder in every kernel set
+ */
+class KernelFormat {
+public:
+    DXGI_FORMAT format;
+    BCRowDecoder BCDecodeKernels::*decoder;
+};
+
+static KernelFormat const KERNEL_FORMATS[] = {
+        {DXGI_FORMAT_BC1_UNORM, &BCDecodeKernels::bc1},
+        {DXGI_FORMAT_BC2_UNORM, &BCDecodeKernels::bc2},
+        {DXGI_FORMAT_BC3_UNORM, &BCDecodeKernels::bc3},
+        {DXGI_FORMAT_BC4_UNORM, &BCDecodeKernels::bc4},
+        {DXGI_FORMAT_BC4_SNORM, &BCDecodeKernels::bc4Snorm},
+        {DXGI_FORMAT_BC5_UNORM, &BCDecodeKernels::bc5},
+        {DXGI_FORMAT_BC5_SNORM, &BCDecodeKernels::bc5Snorm},
+};
+
+/**
+ * Random blocks, every third one made of 0x00, 0x7f, 0x80 and 0xff only: equal endpoints, the extremes and the -128
+ * and -127 of the signed formats
+ */
+static std::vector<unsigned char> getRandomBlocks(size_t const count, size_t const blockSize, std::mt19937 &random) {
+    static constexpr unsigned char EDGES[] = {0x00, 0x7f, 0x80, 0xff};
+    std::vector<unsigned char> blocks(count * blockSize);
+    for (size_t i = 0; i < blocks.size(); i++) {
+        auto const value = static_cast<unsigned char>(random());
+        blocks[i] = (i / blockSize) % 3 == 0 ? EDGES[value & 3u] : value;
+    }
+    return blocks;
+}
+
+TEST(bcDecodeKernelsMatchCpuFeatures) {
+    char const *expected = "scalar";
+#ifdef DXTWRAPPER_X86
+    if (getCpuFeatures().avx2) {
+        expected = "avx2";
+    } else if (getCpuFeatures().sse41) {
+        expected = "sse41";
+    }
+#endif
+    CHECK_MESSAGE(std::strcmp(getBCDecodeKernels().name, expected) == 0, "selected %s", getBCDecodeKernels().name);
+}
+
+TEST(referenceBlocksDecodeToExpectedPixels) {
+    std::vector<BCDecodeKernels> const kernels = getRunnableBCDecodeKernels();
+    for (ReferenceBlock const &reference: REFERENCE_BLOCKS) {
+        std::vector<unsigned char> const block = parseHex(reference.block);
+        std::vector<unsigned char> const expected = parseHex(reference.pixels);
+        CHECK_MESSAGE(block.size() == getBCBlockSize(reference.format) && expected.size() == 64, "%s",
+                      reference.name);
+
+        std::vector<unsigned char> pixels(64);
+        CHECK_MESSAGE(decodeBC(reference.format, block.data(), block.size(), 4, 4, pixels.data()) == CONVERT_OK,
+                      "%s", reference.name);
+        CHECK_MESSAGE(pixels == expected, "%s", reference.name);
+
+        //decodeBC runs the selected kernels, the others must decode the same
+        for (KernelFormat const &format: KERNEL_FORMATS) {
+            if (format.format != reference.format) {
+                continue;
+            }
+            for (BCDecodeKernels const &set: kernels) {
+                std::fill(pixels.begin(), pixels.end(), 0);
+                (set.*format.decoder)(block.data(), 1, pixels.data(), 16);
+                CHECK_MESSAGE(pixels == expected, "%s, %s", reference.name, set.name);
+            }
+        }
+    }
+}
+
+TEST(bcRowDecodersMatchScalar) {
+    std::mt19937 random(8);
+    std::vector<BCDecodeKernels> const kernels = getRunnableBCDecodeKernels();
+    for (KernelFormat const &format: KERNEL_FORMATS) {
+        for (size_t const count: getKernelCounts()) {
+            //exactly sized, so reads past the last block are caught by the address sanitizer
+            std::vector<unsigned char> const blocks = getRandomBlocks(count, getBCBlockSize(format.format), random);
+            size_t const rowPitch = count * 16 + GUARD_SIZE;
+            std::vector<unsigned char> expected(rowPitch * 4, GUARD);
+            (kernels[0].*format.decoder)(blocks.data(), count, expected.data(), rowPitch);
+
+            for (size_t k = 1; k < kernels.size(); k++) {
+                std::vector<unsigned char> output(rowPitch * 4, GUARD);
+                (kernels[k].*format.decoder)(blocks.data(), count, output.data(), rowPitch);
+                //the guard bytes of the scalar output are intact, compared with them
+                CHECK_MESSAGE(output == expected, "%s, format %d, %zu blocks", kernels[k].name,
+                              static_cast<int>(format.format), count);
+            }
+        }
+    }
+}
+
+/**
+ * Images with partial blocks on the right and bottom edges, the output must be the image cropped from the decoded
+ * blocks, without writing past width * height pixels
+ */
+TEST(decodeBCClipsPartialBlocks) {
+    std::mt19937 random(9);
+    for (DXGI_FORMAT const format: {DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC7_UNORM}) {
+        for (size_t const width: {1, 3, 4, 5, 13}) {
+            for (size_t const height: {1, 2, 4, 7}) {
+                size_t const blocksWide = (width + 3) / 4;
+                size_t const blocksHigh = (height + 3) / 4;
+                std::vector<unsigned char> const blocks = getRandomBlocks(blocksWide * blocksHigh,
+                                                                          getBCBlockSize(format), random);
+                std::vector<unsigned char> full(blocksWide * 4 * blocksHigh * 4 * 4);
+                CHECK(decodeBC(format, blocks.data(), blocks.size(), blocksWide * 4, blocksHigh * 4, full.data())
+                      == CONVERT_OK);
+
+                std::vector<unsigned char> pixels(width * height * 4);
+                CHECK(decodeBC(format, blocks.data(), blocks.size(), width, height, pixels.data()) == CONVERT_OK);
+                bool matches = true;
+                for (size_t y = 0; y < height; y++) {
+                    unsigned char const *row = pixels.data() + y * width * 4;
+                    matches = matches && std::equal(row, row + width * 4, full.data() + y * blocksWide * 16);
+                }
+                CHECK_MESSAGE(matches, "format %d, %zux%zu", static_cast<int>(format), width, height);
+            }
+        }
+    }
+}
+
+TEST(decodeBCRejectsInvalidInput) {
+    std::vector<unsigned char> blocks(4 * 16);
+    std::vector<unsigned char> pixels(8 * 8 * 4);
+    CHECK(decodeBC(DXGI_FORMAT_BC7_UNORM, blocks.data(), blocks.size() - 1, 8, 8, pixels.data())
+          == CONVERT_ERROR_DECODE);
+    CHECK(decodeBC(DXGI_FORMAT_BC1_UNORM, blocks.data(), 3 * 8, 8, 8, pixels.data()) == CONVERT_ERROR_DECODE);
+    CHECK(decodeBC(DXGI_FORMAT_R8G8B8A8_UNORM, blocks.data(), blocks.size(), 8, 8, pixels.data())
+          == CONVERT_ERROR_DECODE);
+    CHECK(decodeBC(DXGI_FORMAT_BC1_UNORM, blocks.data(), blocks.size(), 0, 8, pixels.data()) == CONVERT_ERROR_DECODE);
+}
@@ -0,0 +1,280 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "BCDecoder.h"
+#include "BCEncoder.h"
+#include "CpuFeatures.h"
+#include "Test.h"
+
+/**
+ * Every kernel set this CPU can run, the scalar one first
+ */
+static std::vector<BCEncodeKernels> getRunnableBCEncodeKernels() {
+    std::vector<BCEncodeKernels> kernels{{"scalar", findBCIndicesScalar}};
+#ifdef DXTWRAPPER_X86
+    if (getCpuFeatures().sse41) {
+        kernels.push_back({"sse41", findBCIndicesSse41});
+    }
+    if (getCpuFeatures().avx2) {
+        kernels.push_back({"avx2", findBCIndicesAvx2});
+    }
+#endif
+    return kernels;
+}
+
+/**
+ * Random bytes, or bytes from a few close values and the extremes: equal palette entries, pixels halfway between two
+ * entries and the largest errors
+ */
+static std::vector<unsigned char> getIndexSearchBytes(size_t const size, bool const ties, std::mt19937 &random) {
+    static constexpr unsigned char VALUES[] = {0, 1, 2, 3, 4, 128, 254, 255};
+    std::vector<unsigned char> bytes = getRandomBytes(size, random);
+    if (ties) {
+        for (unsigned char &byte: bytes) {
+            byte = VALUES[byte % sizeof(VALUES)];
+        }
+    }
+    return bytes;
+}
+
+/**
+ * A test image: gradients with some noise, alpha varying across the image and a hard edge in the middle
+ */
+static std::vector<unsigned char> getGradientImage(size_t const width, size_t const height, std::mt19937 &random) {
+    std::uniform_int_distribution<int> noise(-3, 3);
+    std::vector<unsigned char> pixels(width * height * 4);
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            unsigned char *const pixel = &pixels[(y * width + x) * 4];
+            int const edge = x > width / 2 && y > height / 2 ? 96 : 0;
+            int const values[4] = {static_cast<int>(x * 255 / width) + noise(random),
+                                   static_cast<int>(y * 255 / height) + noise(random) - edge,
+                                   static_cast<int>((x + y) * 127 / (width + height)) + 64 + edge,
+                                   255 - static_cast<int>(x * 191 / width) + noise(random)};
+            for (size_t ch = 0; ch < 4; ch++) {
+                pixel[ch] = static_cast<unsigned char>(std::clamp(values[ch], 0, 255));
+            }
+        }
+    }
+    return pixels;
+}
+
+static DirectX::Image getImage(std::vector<unsigned char> &pixels, size_t const width, size_t const height) {
+    return {width, height, DXGI_FORMAT_R8G8B8A8_UNORM, width * 4, width * height * 4, pixels.data()};
+}
+
+/**
+ * Encode and decode 'pixels', the output of encodeBC is followed by a guard it must not write
+ */
+static std::vector<unsigned char> roundTrip(DXGI_FORMAT const format, BCQuality const quality,
+                                            std::vector<unsigned char> &pixels, size_t const width,
+                                            size_t const height) {
+    size_t const size = ((width + 3) / 4) * ((height + 3) / 4) * getBCBlockSize(format);
+    std::vector<unsigned char> blocks(size + GUARD_SIZE, GUARD);
+    CHECK_MESSAGE(encodeBC(format, quality, getImage(pixels, width, height), blocks.data()) == CONVERT_OK,
+                  "format %d", static_cast<int>(format));
+    CHECK_MESSAGE(isGuardIntact(blocks, size), "format %d, %zux%zu", static_cast<int>(format), width, height);
+    std::vector<unsigned char> decoded(width * height * 4);
+    CHECK_MESSAGE(decodeBC(format, blocks.data(), size, width, height, decoded.data()) == CONVERT_OK, "format %d",
+                  static_cast<int>(format));
+    return decoded;
+}
+
+/**
+ * Peak signal to noise ratio of the channels [first, first + channels)
+ */
+static double getPsnr(std::vector<unsigned char> const &expected, std::vector<unsigned char> const &actual,
+                      size_t const first, size_t const channels) {
+    double sum = 0;
+    for (size_t i = 0; i < expected.size(); i += 4) {
+        for (size_t ch = first; ch < first + channels; ch++) {
+            double const diff = static_cast<double>(expected[i + ch]) - static_cast<double>(actual[i + ch]);
+            sum += diff * diff;
+        }
+    }
+    double const mse = sum / static_cast<double>(expected.size() / 4 * channels);
+    return mse == 0 ? 100.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+TEST(bcEncodeKernelsMatchCpuFeatures) {
+    char const *expected = "scalar";
+#ifdef DXTWRAPPER_X86
+    if (getCpuFeatures().avx2) {
+        expected = "avx2";
+    } else if (getCpuFeatures().sse41) {
+        expected = "sse41";
+    }
+#endif
+    CHECK_MESSAGE(std::strcmp(getBCEncodeKernels().name, expected) == 0, "selected %s", getBCEncodeKernels().name);
+}
+
+TEST(findBCIndicesMatchesScalar) {
+    std::mt19937 random(11);
+    std::vector<BCEncodeKernels> const kernels = getRunnableBCEncodeKernels();
+    for (size_t count = 1; count <= 16; count++) {
+        for (int round = 0; round < 200; round++) {
+            bool const ties = round % 2 == 0;
+            //exactly sized, so reads past the last palette entry are caught by the address sanitizer
+            std::vector<unsigned char> const pixels = getIndexSearchBytes(64, ties, random);
+            std::vector<unsigned char> const palette = getIndexSearchBytes(count * 4, ties, random);
+            std::vector<unsigned char> expected(16 + GUARD_SIZE, GUARD);
+            uint32_t const expectedError = findBCIndicesScalar(pixels.data(), palette.data(), count, expected.data());
+
+            for (size_t k = 1; k < kernels.size(); k++) {
+                std::vector<unsigned char> indices(16 + GUARD_SIZE, GUARD);
+                uint32_t const error = kernels[k].findIndices(pixels.data(), palette.data(), count, indices.data());
+                CHECK_MESSAGE(error == expectedError && indices == expected, "%s, %zu entries, round %d",
+                              kernels[k].name, count, round);
+            }
+        }
+    }
+}
+
+/**
+ * Round trip through encodeBC and decodeBC, each quality at least as good as the floor of its format, about 2 dB below
+ * what the encoder reaches. BC4 is compared on red, decoded as gray, BC5 on red and green.
+ */
+TEST(encodeBCRoundTripsAboveQualityFloor) {
+    class Case {
+    public:
+        DXGI_FORMAT format;
+        size_t firstChannel;
+        size_t channels;
+        double minimumPsnr;
+    };
+    static constexpr Case CASES[] = {
+            {DXGI_FORMAT_BC1_UNORM, 0, 3, 35.0},
+            {DXGI_FORMAT_BC3_UNORM, 0, 4, 36.0},
+            {DXGI_FORMAT_BC4_UNORM, 0, 1, 48.0},
+            {DXGI_FORMAT_BC5_UNORM, 0, 2, 46.0},
+            {DXGI_FORMAT_BC7_UNORM, 0, 4, 36.0},
+            {DXGI_FORMAT_BC7_UNORM_SRGB, 0, 4, 36.0},
+    };
+    std::mt19937 random(12);
+    size_t const width = 64;
+    size_t const height = 48;
+    std::vector<unsigned char> pixels = getGradientImage(width, height, random);
+    //BC1 without transparency
+    std::vector<unsigned char> opaque = pixels;
+    for (size_t i = 3; i < opaque.size(); i += 4) {
+        opaque[i] = 0xff;
+    }
+
+    for (Case const &test: CASES) {
+        double previous = 0;
+        for (BCQuality const quality: {BC_QUALITY_FAST, BC_QUALITY_NORMAL, BC_QUALITY_HIGH}) {
+            std::vector<unsigned char> &source = test.format == DXGI_FORMAT_BC1_UNORM ? opaque : pixels;
+            std::vector<unsigned char> const decoded = roundTrip(test.format, quality, source, width, height);
+            double const psnr = getPsnr(source, decoded, test.firstChannel, test.channels);
+            CHECK_MESSAGE(psnr >= test.minimumPsnr, "format %d, quality %d, %.2f dB", static_cast<int>(test.format),
+                          static_cast<int>(quality), psnr);
+            //a higher quality may be slightly worse on a few blocks, not on the image
+            CHECK_MESSAGE(psnr >= previous - 0.1, "format %d, quality %d, %.2f dB after %.2f dB",
+                          static_cast<int>(test.format), static_cast<int>(quality), psnr, previous);
+            previous = psnr;
+        }
+    }
+}
+
+TEST(encodeBC1MakesLowAlphaTransparent) {
+    std::mt19937 random(13);
+    size_t const width = 16;
+    size_t const height = 8;
+    std::vector<unsigned char> pixels = getGradientImage(width, height, random);
+    for (size_t i = 0; i < width * height; i++) {
+        //the left 4x4 blocks fully transparent, the others checkered around the threshold
+        size_t const x = i % width;
+        bool const transparent = x < 4 || (x + i / width) % 2 == 0;
+        pixels[i * 4 + 3] = static_cast<unsigned char>(transparent ? random() % 128 : 128 + random() % 128);
+    }
+
+    for (BCQuality const quality: {BC_QUALITY_FAST, BC_QUALITY_NORMAL, BC_QUALITY_HIGH}) {
+        std::vector<unsigned char> const decoded = roundTrip(DXGI_FORMAT_BC1_UNORM, quality, pixels, width, height);
+        for (size_t i = 0; i < width * height; i++) {
+            unsigned char const *const pixel = &decoded[i * 4];
+            if (pixels[i * 4 + 3] < 128) {
+                CHECK_MESSAGE(pixel[0] == 0 && pixel[1] == 0 && pixel[2] == 0 && pixel[3] == 0,
+                              "quality %d, pixel %zu", static_cast<int>(quality), i);
+            } else {
+                CHECK_MESSAGE(pixel[3] == 0xff, "quality %d, pixel %zu", static_cast<int>(quality), i);
+            }
+        }
+    }
+}
+
+/**
+ * Images with partial blocks on the right and bottom edges: the blocks are those of the image padded by repeating its
+ * last column and row, and nothing is read past width * height pixels
+ */
+TEST(encodeBCPadsPartialBlocks) {
+    std::mt19937 random(14);
+    for (DXGI_FORMAT const format: {DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC4_UNORM,
+                                    DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC7_UNORM}) {
+        for (size_t const width: {1, 2, 3, 5, 6, 13}) {
+            for (size_t const height: {1, 3, 4, 7}) {
+                std::vector<unsigned char> pixels = getGradientImage(width, height, random);
+                size_t const paddedWidth = (width + 3) / 4 * 4;
+                size_t const paddedHeight = (height + 3) / 4 * 4;
+                std::vector<unsigned char> padded(paddedWidth * paddedHeight * 4);
+                for (size_t y = 0; y < paddedHeight; y++) {
+                    for (size_t x = 0; x < paddedWidth; x++) {
+                        std::memcpy(&padded[(y * paddedWidth + x) * 4],
+                                    &pixels[(std::min(y, height - 1) * width + std::min(x, width - 1)) * 4], 4);
+                    }
+                }
+
+                size_t const size = paddedWidth / 4 * paddedHeight / 4 * getBCBlockSize(format);
+                std::vector<unsigned char> expected(size);
+                CHECK(encodeBC(format, BC_QUALITY_NORMAL, getImage(padded, paddedWidth, paddedHeight),
+                               expected.data()) == CONVERT_OK);
+                std::vector<unsigned char> blocks(size + GUARD_SIZE, GUARD);
+                CHECK(encodeBC(format, BC_QUALITY_NORMAL, getImage(pixels, width, height), blocks.data())
+                      == CONVERT_OK);
+                CHECK_MESSAGE(std::equal(expected.begin(), expected.end(), blocks.begin()), "format %d, %zux%zu",
+                              static_cast<int>(format), width, height);
+                CHECK_MESSAGE(isGuardIntact(blocks, size), "format %d, %zux%zu", static_cast<int>(format), width,
+                              height);
+            }
+        }
+    }
+}
+
+TEST(encodeBCRejectsUnsupportedInput) {
+    std::vector<unsigned char> pixels(16 * 4);
+    std::vector<unsigned char> blocks(16);
+    DirectX::Image image = getImage(pixels, 4, 4);
+    CHECK(encodeBC(DXGI_FORMAT_BC2_UNORM, BC_QUALITY_NORMAL, image, blocks.data()) == CONVERT_ERROR_INVALID_ARGUMENT);
+    CHECK(encodeBC(DXGI_FORMAT_BC6H_UF16, BC_QUALITY_NORMAL, image, blocks.data())
+          == CONVERT_ERROR_INVALID_ARGUMENT);
+    CHECK(encodeBC(DXGI_FORMAT_BC1_UNORM, BC_QUALITY_NORMAL, image, nullptr) == CONVERT_ERROR_INVALID_ARGUMENT);
+    image.format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    CHECK(encodeBC(DXGI_FORMAT_BC1_UNORM, BC_QUALITY_NORMAL, image, blocks.data()) == CONVERT_ERROR_INVALID_ARGUMENT);
+}
@@ -0,0 +1,368 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "ConvertCache.h"
+#include "Test.h"
+
+static std::filesystem::path getTestDirectory() {
+    return std::filesystem::temp_directory_path()
+           / ("dxtexwrapper-cache-test-" + std::to_string(std::random_device{}()));
+}
+
+static void createFile(std::filesystem::path const &path, char const *const content = "output") {
+    std::FILE *const file = std::fopen(path.string().c_str(), "wb");
+    CHECK_MESSAGE(file != nullptr, "%s", path.string().c_str());
+    if (file != nullptr) {
+        std::fputs(content, file);
+        std::fclose(file);
+    }
+}
+
+static void setIndexVersion(std::filesystem::path const &index, uint32_t const version) {
+    std::FILE *const file = std::fopen(index.string().c_str(), "r+b");
+    CHECK(file != nullptr);
+    if (file != nullptr) {
+        //after the magic of the header
+        std::fseek(file, 4, SEEK_SET);
+        std::fwrite(&version, sizeof(version), 1, file);
+        std::fclose(file);
+    }
+}
+
+/**
+ * A new or incompatible index forgets every entry, their files and the temporary files of unfinished stores are
+ * deleted, other files are kept
+ */
+TEST(openRemovesEntryFilesOfIncompatibleIndex) {
+    std::filesystem::path const directory = getTestDirectory();
+    std::filesystem::create_directory(directory);
+    std::string const key = "0123456789abcdef0123456789abcdef";
+    char const *const kept[] = {"notes.txt", "0123456789ABCDEF0123456789ABCDEF", "0123456789abcdef0123456789abcde",
+                                "0123456789abcdef0123456789abcdef0"};
+    for (char const *name: kept) {
+        createFile(directory / name);
+    }
+
+    //no index yet
+    createFile(directory / key);
+    createFile(directory / (key + ".4242.7.tmp"));
+    CHECK(setConvertCache(directory.string().c_str(), uint64_t{1} << 20) == CONVERT_OK);
+    setConvertCache(nullptr, 0);
+    CHECK(!std::filesystem::exists(directory / key));
+    CHECK(!std::filesystem::exists(directory / (key + ".4242.7.tmp")));
+
+    //the index is compatible now, its entries stay
+    createFile(directory / key);
+    CHECK(setConvertCache(directory.string().c_str(), uint64_t{1} << 20) == CONVERT_OK);
+    setConvertCache(nullptr, 0);
+    CHECK(std::filesystem::exists(directory / key));
+
+    //written by another version
+    setIndexVersion(directory / "index", 0xffff);
+    CHECK(setConvertCache(directory.string().c_str(), uint64_t{1} << 20) == CONVERT_OK);
+    setConvertCache(nullptr, 0);
+    CHECK(!std::filesystem::exists(directory / key));
+
+    for (char const *name: kept) {
+        CHECK_MESSAGE(std::filesystem::exists(directory / name), "%s", name);
+    }
+    std::filesystem::remove_all(directory);
+}
+
+static bool isStored(ConvertCache &cache, Hash128 const &key, std::string const &expected) {
+    ContentBuffer output{};
+    if (!cache.read(key, nullptr, nullptr, &output)) {
+        return false;
+    }
+    bool const same = output.size == expected.size() && std::memcmp(output.content, expected.data(), output.size) == 0;
+    std::free(output.content);
+    return same;
+}
+
+static void store(ConvertCache &cache, Hash128 const &key, std::string const &content) {
+    cache.write(key, content.data(), content.size());
+}
+
+static std::string getEntryName(Hash128 const &key) {
+    char name[40];
+    std::snprintf(name, sizeof(name), "%016llx%016llx", static_cast<unsigned long long>(key.high),
+                  static_cast<unsigned long long>(key.low));
+    return name;
+}
+
+TEST(storedOutputIsReadBack) {
+    std::filesystem::path const directory = getTestDirectory();
+    {
+        ConvertCache cache(directory.string(), uint64_t{1} << 20);
+        CHECK(cache.open() == CONVERT_OK);
+        Hash128 const key{1, 2};
+        CHECK(!isStored(cache, key, "output"));
+        store(cache, key, "output");
+        CHECK(isStored(cache, key, "output"));
+
+        //another process sharing the directory
+        ConvertCache other(directory.string(), uint64_t{1} << 20);
+        CHECK(other.open() == CONVERT_OK);
+        CHECK(isStored(other, key, "output"));
+        //stored meanwhile, the second store only refreshes the entry and its temporary file is deleted
+        store(other, key, "output");
+
+        ConvertCacheStats stats{};
+        cache.getStats(stats);
+        CHECK(stats.hits == 1 && stats.misses == 1 && stats.stores == 1 && stats.evictions == 0);
+        CHECK(stats.entries == 1 && stats.totalBytes == 6);
+        //empty outputs and outputs larger than the cache are not stored
+        store(cache, {3, 4}, "");
+        store(cache, {5, 6}, std::string((size_t{1} << 20) + 1, 'x'));
+        cache.getStats(stats);
+        CHECK(stats.entries == 1 && stats.stores == 1);
+    }
+
+    std::vector<std::string> names;
+    for (auto const &entry: std::filesystem::directory_iterator(directory)) {
+        names.push_back(entry.path().filename().string());
+    }
+    CHECK_MESSAGE(names.size() == 2, "%zu files", names.size());
+    std::filesystem::remove_all(directory);
+}
+
+TEST(leastRecentlyUsedOutputIsEvicted) {
+    std::filesystem::path const directory = getTestDirectory();
+    {
+        ConvertCache cache(directory.string(), 300);
+        CHECK(cache.open() == CONVERT_OK);
+        std::string const content(100, 'x');
+        Hash128 const keys[] = {{1, 0}, {2, 0}, {3, 0}, {4, 0}};
+        store(cache, keys[0], content);
+        store(cache, keys[1], content);
+        store(cache, keys[2], content);
+        //the first one is used again, the second one is the least recently used now
+        CHECK(isStored(cache, keys[0], content));
+        store(cache, keys[3], content);
+
+        CHECK(!std::filesystem::exists(directory / getEntryName(keys[1])));
+        CHECK(!isStored(cache, keys[1], content));
+        CHECK(isStored(cache, keys[0], content));
+        CHECK(isStored(cache, keys[2], content));
+        CHECK(isStored(cache, keys[3], content));
+
+        //an output that needs the room of two entries, the first and third are the oldest now
+        store(cache, {5, 0}, std::string(200, 'y'));
+        CHECK(!isStored(cache, keys[0], content));
+        CHECK(!isStored(cache, keys[2], content));
+        CHECK(isStored(cache, keys[3], content));
+        CHECK(isStored(cache, {5, 0}, std::string(200, 'y')));
+
+        ConvertCacheStats stats{};
+        cache.getStats(stats);
+        CHECK(stats.evictions == 3 && stats.entries == 2 && stats.totalBytes == 300);
+    }
+    std::filesystem::remove_all(directory);
+}
+
+//layout of the index, CacheIndexHeader and the CacheIndexSlot table after it
+static constexpr uint64_t INDEX_SLOTS = 65536;
+static constexpr uint64_t INDEX_MAX_ENTRIES = INDEX_SLOTS / 4 * 3;
+static constexpr size_t INDEX_HEADER_WORDS = 5;
+static constexpr size_t INDEX_SLOT_WORDS = 4;
+
+/**
+ * An index with the counts of the header given and empty slots
+ */
+static std::vector<uint64_t> getIndex(uint64_t const entries, uint64_t const totalBytes) {
+    std::vector<uint64_t> index(INDEX_HEADER_WORDS + INDEX_SLOTS * INDEX_SLOT_WORDS, 0);
+    uint32_t const magic[2] = {0x43545844, 1};
+    std::memcpy(&index[0], magic, sizeof(magic));
+    index[1] = INDEX_SLOTS;
+    index[2] = entries;
+    index[3] = totalBytes;
+    index[4] = entries;
+    return index;
+}
+
+static void setSlot(std::vector<uint64_t> &index, uint64_t const slot, Hash128 const &key, uint64_t const size,
+                    uint64_t const lastUse) {
+    uint64_t *const words = &index[INDEX_HEADER_WORDS + slot * INDEX_SLOT_WORDS];
+    words[0] = key.low;
+    words[1] = key.high;
+    words[2] = size;
+    words[3] = lastUse;
+}
+
+static bool writeIndex(std::filesystem::path const &directory, std::vector<uint64_t> const &index) {
+    std::filesystem::create_directories(directory);
+    std::FILE *const file = std::fopen((directory / "index").string().c_str(), "wb");
+    CHECK(file != nullptr);
+    if (file == nullptr) {
+        return false;
+    }
+    bool const written = std::fwrite(index.data(), sizeof(uint64_t), index.size(), file) == index.size();
+    return std::fclose(file) == 0 && written;
+}
+
+/**
+ * The entry limit is reached without a file per entry: the index is written with the slots of entries that have no
+ * file, except the two oldest
+ */
+TEST(entryLimitEvictsLeastRecentlyUsed) {
+    std::filesystem::path const directory = getTestDirectory();
+    std::vector<uint64_t> index = getIndex(INDEX_MAX_ENTRIES, INDEX_MAX_ENTRIES);
+    for (uint64_t i = 0; i < INDEX_MAX_ENTRIES; i++) {
+        //key {i, 7} in its home slot, 1 byte, used in the order of the keys
+        setSlot(index, i, {i, 7}, 1, i + 1);
+    }
+    if (!writeIndex(directory, index)) {
+        return;
+    }
+    createFile(directory / getEntryName({0, 7}), "x");
+    createFile(directory / getEntryName({1, 7}), "x");
+
+    {
+        ConvertCache cache(directory.string(), uint64_t{1} << 30);
+        CHECK(cache.open() == CONVERT_OK);
+        store(cache, {60000, 8}, "z");
+        ConvertCacheStats stats{};
+        cache.getStats(stats);
+        CHECK(stats.evictions == 1 && stats.entries == INDEX_MAX_ENTRIES && stats.totalBytes == INDEX_MAX_ENTRIES);
+        CHECK(!std::filesystem::exists(directory / getEntryName({0, 7})));
+        CHECK(isStored(cache, {1, 7}, "x"));
+        CHECK(isStored(cache, {60000, 8}, "z"));
+    }
+    std::filesystem::remove_all(directory);
+}
+
+/**
+ * Removing an entry moves back the entries that probed past its slot, including those that wrapped around the end of
+ * the table, and leaves the ones in their home slot
+ */
+TEST(removedEntryKeepsProbedEntriesReachable) {
+    std::filesystem::path const directory = getTestDirectory();
+    {
+        ConvertCache cache(directory.string(), uint64_t{1} << 20);
+        CHECK(cache.open() == CONVERT_OK);
+        //three keys with the home slot 65534, in slots 65534, 65535 and 0, then one at home in 65535 placed in slot 1,
+        //and one at home in slot 0 placed in slot 2
+        Hash128 const keys[] = {{65534, 1}, {65534 + INDEX_SLOTS, 2}, {65534 + 2 * INDEX_SLOTS, 3}, {65535, 4},
+                                {0, 5}, {3, 6}};
+        for (Hash128 const &key: keys) {
+            store(cache, key, getEntryName(key));
+        }
+
+        //an entry whose file is gone is removed from the index by the read that misses it
+        for (size_t const removed: {size_t{0}, size_t{2}}) {
+            std::filesystem::remove(directory / getEntryName(keys[removed]));
+            CHECK(!isStored(cache, keys[removed], getEntryName(keys[removed])));
+            for (size_t i = 0; i < std::size(keys); i++) {
+                bool const gone = i == 0 || (removed == 2 && i == 2);
+                CHECK_MESSAGE(gone || isStored(cache, keys[i], getEntryName(keys[i])), "entry %zu after removing %zu",
+                              i, removed);
+            }
+        }
+        ConvertCacheStats stats{};
+        cache.getStats(stats);
+        CHECK(stats.entries == 4);
+    }
+    std::filesystem::remove_all(directory);
+}
+
+/**
+ * The header of an index shared with other processes may not match its slots, after a crash or a corrupt file. The
+ * cache must not loop over the table or wrap the counts around, and counts them again from the slots.
+ */
+TEST(inconsistentIndexHeaderIsRecounted) {
+    //more entries and bytes than the slots have: the eviction finds no entry to remove
+    std::filesystem::path directory = getTestDirectory();
+    if (writeIndex(directory, getIndex(1000, uint64_t{1} << 40))) {
+        ConvertCache cache(directory.string(), 1000);
+        CHECK(cache.open() == CONVERT_OK);
+        store(cache, {1, 0}, "abc");
+        CHECK(isStored(cache, {1, 0}, "abc"));
+        ConvertCacheStats stats{};
+        cache.getStats(stats);
+        CHECK(stats.stores == 1 && stats.evictions == 0 && stats.entries == 1 && stats.totalBytes == 3);
+    }
+    std::filesystem::remove_all(directory);
+
+    //less: removing entries stops at 0
+    directory = getTestDirectory();
+    std::vector<uint64_t> index = getIndex(1, 10);
+    for (uint64_t i = 0; i < 3; i++) {
+        setSlot(index, i, {i, 7}, 100, i + 1);
+    }
+    if (writeIndex(directory, index)) {
+        ConvertCache cache(directory.string(), 1000);
+        CHECK(cache.open() == CONVERT_OK);
+        //the entries have no file, the reads remove them
+        for (uint64_t i = 0; i < 3; i++) {
+            CHECK(!isStored(cache, {i, 7}, "x"));
+        }
+        ConvertCacheStats stats{};
+        cache.getStats(stats);
+        CHECK(stats.entries == 0 && stats.totalBytes == 0);
+    }
+    std::filesystem::remove_all(directory);
+
+    //every slot used and a single entry counted: the probes stop after the whole table
+    directory = getTestDirectory();
+    index = getIndex(1, 1);
+    for (uint64_t i = 0; i < INDEX_SLOTS; i++) {
+        setSlot(index, i, {i, 7}, 1, i + 1);
+    }
+    if (writeIndex(directory, index)) {
+        ConvertCache cache(directory.string(), uint64_t{1} << 30);
+        CHECK(cache.open() == CONVERT_OK);
+        CHECK(!isStored(cache, {2 * INDEX_SLOTS + 5, 9}, "x"));
+
+        //no slot for the new entry, it isn't stored and the counts are those of the slots
+        store(cache, {5, 9}, "y");
+        ConvertCacheStats stats{};
+        cache.getStats(stats);
+        CHECK(stats.stores == 0 && stats.entries == INDEX_SLOTS && stats.totalBytes == INDEX_SLOTS);
+        CHECK(!std::filesystem::exists(directory / getEntryName({5, 9})));
+
+        //the backward shift of a removal stops after the whole table too
+        CHECK(!isStored(cache, {3, 7}, "x"));
+        cache.getStats(stats);
+        CHECK(stats.entries == INDEX_SLOTS - 1);
+        CHECK(!isStored(cache, {4, 7}, "x"));
+        CHECK(!isStored(cache, {5, 9}, "y"));
+    }
+    std::vector<std::string> names;
+    for (auto const &entry: std::filesystem::directory_iterator(directory)) {
+        names.push_back(entry.path().filename().string());
+    }
+    CHECK_MESSAGE(names.size() == 1, "%zu files", names.size());
+    std::filesystem::remove_all(directory);
+}
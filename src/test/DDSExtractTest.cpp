@@ -0,0 +1,293 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <vector>
+#include <DirectXTex.h>
+#include <DDS.h>
+#include "DDSExtract.h"
+#include "ScratchArena.h"
+#include "Test.h"
+
+using DirectX::DDS_HEADER;
+using DirectX::DDS_HEADER_DXT10;
+using DirectX::DDS_PIXELFORMAT;
+
+/**
+ * A DDS file of 4 bytes per pixel in memory: the headers, then the mip chain of each item filled with random bytes
+ */
+class DDSFile {
+public:
+    DDSFile(DXGI_FORMAT const format, uint32_t const width, uint32_t const height, uint32_t const mipLevels,
+            uint32_t const arraySize = 1) : width(width), height(height), mipLevels(mipLevels), arraySize(arraySize) {
+        DDS_HEADER header{};
+        header.size = sizeof(DDS_HEADER);
+        header.width = width;
+        header.height = height;
+        header.mipMapCount = mipLevels;
+        switch (format) {
+            case DXGI_FORMAT_R8G8B8A8_UNORM:
+                header.ddspf = {sizeof(DDS_PIXELFORMAT), DDS_RGBA, 0, 32, 0x000000ff, 0x0000ff00, 0x00ff0000,
+                                0xff000000};
+                break;
+            case DXGI_FORMAT_B8G8R8A8_UNORM:
+                header.ddspf = {sizeof(DDS_PIXELFORMAT), DDS_RGBA, 0, 32, 0x00ff0000, 0x0000ff00, 0x000000ff,
+                                0xff000000};
+                break;
+            case DXGI_FORMAT_B8G8R8X8_UNORM:
+                header.ddspf = {sizeof(DDS_PIXELFORMAT), DDS_RGB, 0, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0};
+                break;
+            default:
+                break;
+        }
+
+        bytes.resize(sizeof(uint32_t) + sizeof(DDS_HEADER));
+        std::memcpy(bytes.data(), &DirectX::DDS_MAGIC, sizeof(uint32_t));
+        //arrays need the DX10 extension
+        if (arraySize > 1) {
+            header.ddspf = {sizeof(DDS_PIXELFORMAT), DDS_FOURCC, MAKEFOURCC('D', 'X', '1', '0'), 0, 0, 0, 0, 0};
+            DDS_HEADER_DXT10 extension{format, DirectX::DDS_DIMENSION_TEXTURE2D, 0, arraySize, 0};
+            auto const *const extensionBytes = reinterpret_cast<unsigned char const *>(&extension);
+            bytes.insert(bytes.end(), extensionBytes, extensionBytes + sizeof(extension));
+        }
+        std::memcpy(bytes.data() + sizeof(uint32_t), &header, sizeof(header));
+
+        std::mt19937 random(width * 7 + height + mipLevels);
+        std::vector<unsigned char> const pixels = getRandomBytes(getItemSize() * arraySize, random);
+        bytes.insert(bytes.end(), pixels.begin(), pixels.end());
+    }
+
+    /**
+     * Replace the legacy pixel format of the header
+     */
+    void setPixelFormat(DDS_PIXELFORMAT const &pixelFormat) {
+        std::memcpy(bytes.data() + sizeof(uint32_t) + offsetof(DDS_HEADER, ddspf), &pixelFormat, sizeof(pixelFormat));
+    }
+
+    [[nodiscard]] size_t getItemSize() const {
+        size_t size = 0;
+        for (uint32_t mip = 0; mip < mipLevels; mip++) {
+            size += getWidth(mip) * getHeight(mip) * 4;
+        }
+        return size;
+    }
+
+    [[nodiscard]] size_t getWidth(uint32_t const mip) const {
+        return std::max<size_t>(width >> mip, 1);
+    }
+
+    [[nodiscard]] size_t getHeight(uint32_t const mip) const {
+        return std::max<size_t>(height >> mip, 1);
+    }
+
+    /**
+     * Pixels of an image inside 'bytes'
+     */
+    [[nodiscard]] unsigned char const *getPixels(uint32_t const mip, uint32_t const item) const {
+        size_t offset = bytes.size() - getItemSize() * (arraySize - item);
+        for (uint32_t level = 0; level < mip; level++) {
+            offset += getWidth(level) * getHeight(level) * 4;
+        }
+        return bytes.data() + offset;
+    }
+
+    std::vector<unsigned char> bytes;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipLevels;
+    uint32_t arraySize;
+};
+
+TEST(thumbnailMipIsSmallestLevelAboveMinSize) {
+    struct Case {
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipLevels;
+        uint32_t minSize;
+        uint32_t mip;
+    };
+    Case const cases[] = {
+            {256, 64, 9, 64, 2},
+            {256, 64, 9, 65, 1},
+            {256, 64, 9, 128, 1},
+            {256, 64, 9, 1, 8},
+            {256, 64, 9, 0, 8},
+            //the first level when it is smaller than the minimum
+            {256, 64, 9, 1000, 0},
+            //the last level the texture has
+            {256, 64, 3, 1, 2},
+            {64, 256, 9, 32, 3},
+            {300, 100, 9, 37, 3},
+            {300, 100, 9, 38, 2},
+            {1, 1, 1, 16, 0},
+    };
+    for (Case const &c: cases) {
+        DDSFile const dds(DXGI_FORMAT_R8G8B8A8_UNORM, c.width, c.height, c.mipLevels);
+        uint32_t mip = 99;
+        CHECK_MESSAGE(findDDSThumbnailMip(dds.bytes.data(), dds.bytes.size(), c.minSize, &mip) == CONVERT_OK
+                      && mip == c.mip, "%ux%u %u levels, min %u: %u", c.width, c.height, c.mipLevels, c.minSize, mip);
+    }
+
+    //only the headers are read
+    DDSFile const dds(DXGI_FORMAT_R8G8B8A8_UNORM, 256, 64, 9);
+    uint32_t mip = 0;
+    CHECK(findDDSThumbnailMip(dds.bytes.data(), 128, 64, &mip) == CONVERT_OK && mip == 2);
+    CHECK(findDDSThumbnailMip(dds.bytes.data(), 127, 64, &mip) == CONVERT_ERROR_DECODE);
+    CHECK(findDDSThumbnailMip(nullptr, 0, 64, &mip) == CONVERT_ERROR_INVALID_ARGUMENT);
+}
+
+TEST(ddsImageOfRgbaIsNotCopied) {
+    DDSFile const dds(DXGI_FORMAT_R8G8B8A8_UNORM, 37, 20, 4, 3);
+    for (bool const inArena: {false, true}) {
+        std::optional<ArenaScope> arena;
+        if (inArena) {
+            arena.emplace();
+        }
+        for (uint32_t const mip: {0u, 2u, 3u}) {
+            for (uint32_t const item: {0u, 2u}) {
+                DirectX::ScratchImage storage{};
+                DirectX::Image image{};
+                CHECK(loadDDSImage(dds.bytes.data(), dds.bytes.size(), {mip, item, 0}, storage, image)
+                      == CONVERT_OK);
+                //the pixels of the DDS buffer
+                CHECK_MESSAGE(image.pixels == dds.getPixels(mip, item) && image.width == dds.getWidth(mip)
+                              && image.height == dds.getHeight(mip) && image.rowPitch == dds.getWidth(mip) * 4
+                              && image.format == DXGI_FORMAT_R8G8B8A8_UNORM && storage.GetPixels() == nullptr,
+                              "mip %u item %u arena %d", mip, item, inArena);
+            }
+        }
+    }
+}
+
+TEST(ddsImageOfBgrxHasOpaqueAlpha) {
+    for (DXGI_FORMAT const format: {DXGI_FORMAT_B8G8R8X8_UNORM, DXGI_FORMAT_B8G8R8A8_UNORM}) {
+        DDSFile const dds(format, 13, 9, 2);
+        //the copy goes to the scratch arena inside a conversion, otherwise to 'storage'
+        for (bool const inArena: {false, true}) {
+            std::optional<ArenaScope> arena;
+            if (inArena) {
+                arena.emplace();
+            }
+            for (uint32_t const mip: {0u, 1u}) {
+                DirectX::ScratchImage storage{};
+                DirectX::Image image{};
+                CHECK(loadDDSImage(dds.bytes.data(), dds.bytes.size(), {mip, 0, 0}, storage, image) == CONVERT_OK);
+                unsigned char const *const source = dds.getPixels(mip, 0);
+                size_t const pixels = dds.getWidth(mip) * dds.getHeight(mip);
+                bool same = image.pixels != source && image.format == DXGI_FORMAT_R8G8B8A8_UNORM
+                            && image.width == dds.getWidth(mip) && image.rowPitch == dds.getWidth(mip) * 4;
+                for (size_t i = 0; same && i < pixels; i++) {
+                    unsigned char const *const bgra = source + i * 4;
+                    unsigned char const *const rgba = image.pixels + i * 4;
+                    unsigned char const alpha = format == DXGI_FORMAT_B8G8R8X8_UNORM ? 0xff : bgra[3];
+                    same = rgba[0] == bgra[2] && rgba[1] == bgra[1] && rgba[2] == bgra[0] && rgba[3] == alpha;
+                }
+                CHECK_MESSAGE(same, "format %d mip %u arena %d", format, mip, inArena);
+                CHECK_MESSAGE(getScratchArena().contains(image.pixels) == inArena, "format %d mip %u arena %d",
+                              format, mip, inArena);
+            }
+        }
+    }
+}
+
+TEST(ddsImageOfXbgrHasOpaqueAlpha) {
+    //X8B8G8R8, loaded as RGBA with whatever the X byte holds
+    DDSFile dds(DXGI_FORMAT_R8G8B8A8_UNORM, 13, 9, 2);
+    dds.setPixelFormat({sizeof(DDS_PIXELFORMAT), DDS_RGB, 0, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0});
+    for (bool const inArena: {false, true}) {
+        std::optional<ArenaScope> arena;
+        if (inArena) {
+            arena.emplace();
+        }
+        for (uint32_t const mip: {0u, 1u}) {
+            DirectX::ScratchImage storage{};
+            DirectX::Image image{};
+            CHECK(loadDDSImage(dds.bytes.data(), dds.bytes.size(), {mip, 0, 0}, storage, image) == CONVERT_OK);
+            unsigned char const *const source = dds.getPixels(mip, 0);
+            size_t const pixels = dds.getWidth(mip) * dds.getHeight(mip);
+            bool transparent = false;
+            bool same = image.pixels != source && image.format == DXGI_FORMAT_R8G8B8A8_UNORM
+                        && image.width == dds.getWidth(mip) && image.rowPitch == dds.getWidth(mip) * 4;
+            for (size_t i = 0; same && i < pixels; i++) {
+                unsigned char const *const xbgr = source + i * 4;
+                unsigned char const *const rgba = image.pixels + i * 4;
+                transparent = transparent || xbgr[3] != 0xff;
+                same = std::memcmp(rgba, xbgr, 3) == 0 && rgba[3] == 0xff;
+            }
+            CHECK_MESSAGE(same && transparent, "mip %u arena %d", mip, inArena);
+            CHECK_MESSAGE(getScratchArena().contains(image.pixels) == inArena, "mip %u arena %d", mip, inArena);
+        }
+    }
+}
+
+TEST(ddsSubresourcesReportStatusOfEachImage) {
+    ErrorOutputScope const errors(false);
+    DDSFile const dds(DXGI_FORMAT_R8G8B8A8_UNORM, 8, 4, 4, 2);
+    //valid, mip out of range, item out of range, valid, slice of a 2D texture, valid
+    DDSSubresource const subresources[] = {{0, 0, 0}, {4, 0, 0}, {0, 2, 0}, {3, 1, 0}, {0, 0, 1}, {1, 1, 0}};
+    ConvertStatus const expected[] = {CONVERT_OK, CONVERT_ERROR_INVALID_ARGUMENT, CONVERT_ERROR_INVALID_ARGUMENT,
+                                      CONVERT_OK, CONVERT_ERROR_INVALID_ARGUMENT, CONVERT_OK};
+    constexpr size_t count = std::size(subresources);
+    ContentBuffer outputs[count];
+    ConvertStatus statuses[count];
+    CHECK(convertDDSSubresourcesToPNG(dds.bytes.data(), dds.bytes.size(), subresources, count, nullptr, nullptr,
+                                      nullptr, outputs, statuses) == CONVERT_ERROR_INVALID_ARGUMENT);
+    for (size_t i = 0; i < count; i++) {
+        CHECK_MESSAGE(statuses[i] == expected[i], "subresource %zu: %d", i, statuses[i]);
+        if (statuses[i] != CONVERT_OK) {
+            CHECK_MESSAGE(outputs[i].content == nullptr && outputs[i].size == 0, "subresource %zu", i);
+            continue;
+        }
+        //the PNG has the pixels of the image
+        DDSSubresource const &subresource = subresources[i];
+        ImageData decoded;
+        size_t const size = dds.getWidth(subresource.mip) * dds.getHeight(subresource.mip) * 4;
+        CHECK_MESSAGE(decodePng(static_cast<unsigned char const *>(outputs[i].content), outputs[i].size, decoded)
+                      && decoded.getWidth() == dds.getWidth(subresource.mip)
+                      && decoded.getPixels().size() == size
+                      && std::memcmp(decoded.getPixels().data(), dds.getPixels(subresource.mip, subresource.item),
+                                     size) == 0, "subresource %zu", i);
+        freeContentBuffer(&outputs[i]);
+    }
+
+    //the last levels are cut: only the images inside the data are converted
+    size_t const truncated = static_cast<size_t>(dds.getPixels(2, 1) - dds.bytes.data());
+    DDSSubresource const levels[] = {{1, 1, 0}, {2, 1, 0}, {0, 0, 0}};
+    CHECK(convertDDSSubresourcesToPNG(dds.bytes.data(), truncated, levels, 3, nullptr, nullptr, nullptr, outputs,
+                                      statuses) == CONVERT_ERROR_DECODE);
+    CHECK(statuses[0] == CONVERT_OK && statuses[1] == CONVERT_ERROR_DECODE && statuses[2] == CONVERT_OK);
+    CHECK(outputs[1].content == nullptr);
+    freeContentBuffer(&outputs[0]);
+    freeContentBuffer(&outputs[2]);
+
+    //nothing to convert
+    CHECK(convertDDSSubresourcesToPNG(dds.bytes.data(), dds.bytes.size(), nullptr, 0, nullptr, nullptr, nullptr,
+                                      nullptr, nullptr) == CONVERT_OK);
+}
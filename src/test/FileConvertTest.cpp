@@ -0,0 +1,231 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include "DxTexWrapper.h"
+#include "FileConvert.h"
+#include "FileIO.h"
+#include "Test.h"
+
+static std::filesystem::path getTestDirectory() {
+    std::filesystem::path const directory = std::filesystem::temp_directory_path()
+                                            / ("dxtexwrapper-file-test-" + std::to_string(std::random_device{}()));
+    std::filesystem::create_directory(directory);
+    return directory;
+}
+
+static std::vector<unsigned char> readFile(std::filesystem::path const &path) {
+    std::vector<unsigned char> content;
+    std::FILE *const file = std::fopen(path.string().c_str(), "rb");
+    if (file == nullptr) {
+        return content;
+    }
+    unsigned char buffer[4096];
+    size_t size = 0;
+    while ((size = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        content.insert(content.end(), buffer, buffer + size);
+    }
+    std::fclose(file);
+    return content;
+}
+
+static bool writeFile(std::filesystem::path const &path, std::vector<unsigned char> const &content) {
+    std::FILE *const file = std::fopen(path.string().c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool const written = std::fwrite(content.data(), 1, content.size(), file) == content.size();
+    return std::fclose(file) == 0 && written;
+}
+
+/**
+ * Names of the temporary files AtomicFile left in 'directory'
+ */
+static size_t countTemporaryFiles(std::filesystem::path const &directory) {
+    size_t count = 0;
+    for (auto const &entry: std::filesystem::directory_iterator(directory)) {
+        count += entry.path().extension() == ".tmp";
+    }
+    return count;
+}
+
+TEST(fileConversionsMatchMemoryConversions) {
+    std::filesystem::path const directory = getTestDirectory();
+    std::filesystem::path const pngPath = directory / "input.png";
+    std::filesystem::path const ddsPath = directory / "output.dds";
+    std::filesystem::path const outputPngPath = directory / "output.png";
+    std::vector<unsigned char> const png = getPng(37, 23);
+    CHECK(!png.empty() && writeFile(pngPath, png));
+
+    for (bool const dx10ext: {false, true}) {
+        for (bool const bgra: {false, true}) {
+            ContentBuffer content{};
+            CHECK(convertPNGtoDDSEx(png.data(), png.size(), dx10ext, bgra, nullptr, nullptr, &content) == CONVERT_OK);
+            std::vector<unsigned char> const expected = takeContent(content);
+            uint64_t size = 0;
+            CHECK(convertPNGtoDDSFile(pngPath.string().c_str(), ddsPath.string().c_str(), dx10ext, bgra, &size)
+                  == CONVERT_OK);
+            CHECK_MESSAGE(size == expected.size() && readFile(ddsPath) == expected, "dx10 %d bgra %d", dx10ext, bgra);
+        }
+    }
+
+    DDSEncodeOptions ddsOptions{};
+    ddsOptions.format = DXGI_FORMAT_BC1_UNORM;
+    ddsOptions.quality = BC_QUALITY_FAST;
+    ContentBuffer compressed{};
+    CHECK(convertPNGtoDDSCompressedEx(png.data(), png.size(), &ddsOptions, nullptr, nullptr, &compressed)
+          == CONVERT_OK);
+    std::vector<unsigned char> const expectedCompressed = takeContent(compressed);
+    CHECK(convertPNGtoDDSCompressedFile(pngPath.string().c_str(), ddsPath.string().c_str(), &ddsOptions, nullptr)
+          == CONVERT_OK);
+    CHECK(readFile(ddsPath) == expectedCompressed);
+
+    //the PNG encoded from an uncompressed DDS, with the default settings and a profile
+    CHECK(convertPNGtoDDSFile(pngPath.string().c_str(), ddsPath.string().c_str(), false, false, nullptr)
+          == CONVERT_OK);
+    std::vector<unsigned char> const uncompressed = readFile(ddsPath);
+    PngEncodeOptions pngOptions{};
+    getPngEncodeOptions(PNG_PROFILE_FAST, &pngOptions);
+    PngEncodeOptions const *const optionSets[] = {nullptr, &pngOptions};
+    for (PngEncodeOptions const *const options: optionSets) {
+        ContentBuffer content{};
+        CHECK(convertDDStoPNGEx(uncompressed.data(), uncompressed.size(), options, nullptr, nullptr, &content)
+              == CONVERT_OK);
+        std::vector<unsigned char> const expected = takeContent(content);
+        uint64_t size = 0;
+        CHECK(convertDDStoPNGFile(ddsPath.string().c_str(), outputPngPath.string().c_str(), options, &size)
+              == CONVERT_OK);
+        CHECK_MESSAGE(size == expected.size() && readFile(outputPngPath) == expected, "options %d",
+                      options != nullptr);
+    }
+
+    //the same conversions as jobs of convertFiles
+    std::filesystem::path const jobPaths[] = {directory / "job0.dds", directory / "job1.dds", directory / "job2.png"};
+    std::string const names[] = {pngPath.string(), ddsPath.string(), jobPaths[0].string(), jobPaths[1].string(),
+                                 jobPaths[2].string()};
+    ConvertFileJob jobs[3]{};
+    jobs[0] = {names[0].c_str(), names[2].c_str(), CONVERT_PNG_TO_DDS, false, false, nullptr, nullptr, 0,
+               CONVERT_ERROR_INVALID_ARGUMENT};
+    jobs[1] = {names[0].c_str(), names[3].c_str(), CONVERT_PNG_TO_DDS, false, false, nullptr, &ddsOptions, 0,
+               CONVERT_ERROR_INVALID_ARGUMENT};
+    jobs[2] = {names[1].c_str(), names[4].c_str(), CONVERT_DDS_TO_PNG, false, false, &pngOptions, nullptr, 0,
+               CONVERT_ERROR_INVALID_ARGUMENT};
+    CHECK(convertFiles(jobs, 3) == CONVERT_OK);
+    CHECK(jobs[0].status == CONVERT_OK && readFile(jobPaths[0]) == uncompressed
+          && jobs[0].outputSize == uncompressed.size());
+    CHECK(jobs[1].status == CONVERT_OK && readFile(jobPaths[1]) == expectedCompressed);
+    CHECK(jobs[2].status == CONVERT_OK && readFile(jobPaths[2]) == readFile(outputPngPath));
+    CHECK(countTemporaryFiles(directory) == 0);
+    std::filesystem::remove_all(directory);
+}
+
+TEST(failedFileConversionLeavesNoTemporaryFile) {
+    //the failures are expected
+    ErrorOutputScope const errors(false);
+    std::filesystem::path const directory = getTestDirectory();
+    std::filesystem::path const invalidPath = directory / "invalid";
+    std::filesystem::path const pngPath = directory / "input.png";
+    std::filesystem::path const outputPath = directory / "output";
+    std::vector<unsigned char> const garbage(1000, 0x5a);
+    std::vector<unsigned char> const previous = {'o', 'l', 'd'};
+    CHECK(writeFile(invalidPath, garbage) && writeFile(pngPath, getPng(16, 16)));
+
+    //the inputs can't be decoded, an existing output is kept
+    CHECK(writeFile(outputPath, previous));
+    uint64_t size = 1;
+    CHECK(convertPNGtoDDSFile(invalidPath.string().c_str(), outputPath.string().c_str(), false, false, &size)
+          != CONVERT_OK);
+    CHECK(convertDDStoPNGFile(invalidPath.string().c_str(), outputPath.string().c_str(), nullptr, &size)
+          != CONVERT_OK);
+    CHECK(readFile(outputPath) == previous);
+
+    //missing input
+    std::string const missing = (directory / "missing.png").string();
+    CHECK(convertPNGtoDDSFile(missing.c_str(), outputPath.string().c_str(), false, false, nullptr)
+          == CONVERT_ERROR_IO);
+
+    //the output can't be created
+    std::string const unwritable = (directory / "missing" / "output.dds").string();
+    CHECK(convertPNGtoDDSFile(pngPath.string().c_str(), unwritable.c_str(), false, false, nullptr)
+          == CONVERT_ERROR_IO);
+
+    //the status of the first failed job, the others are converted
+    std::string const input = pngPath.string();
+    std::string const invalid = invalidPath.string();
+    std::string const outputs[] = {(directory / "job0.dds").string(), (directory / "job1.dds").string(),
+                                   (directory / "job2.png").string()};
+    ConvertFileJob jobs[3]{};
+    jobs[0] = {invalid.c_str(), outputs[0].c_str(), CONVERT_PNG_TO_DDS, false, false, nullptr, nullptr, 0, CONVERT_OK};
+    jobs[1] = {input.c_str(), outputs[1].c_str(), CONVERT_PNG_TO_DDS, false, false, nullptr, nullptr, 0, CONVERT_OK};
+    jobs[2] = {invalid.c_str(), outputs[2].c_str(), CONVERT_DDS_TO_PNG, false, false, nullptr, nullptr, 0, CONVERT_OK};
+    CHECK(convertFiles(jobs, 3) == jobs[0].status && jobs[0].status != CONVERT_OK);
+    CHECK(jobs[1].status == CONVERT_OK && jobs[2].status != CONVERT_OK);
+    CHECK(!std::filesystem::exists(outputs[0]) && std::filesystem::exists(outputs[1])
+          && !std::filesystem::exists(outputs[2]));
+
+    CHECK(countTemporaryFiles(directory) == 0);
+    std::filesystem::remove_all(directory);
+}
+
+TEST(atomicFileIsRenamedOnlyByCommit) {
+    std::filesystem::path const directory = getTestDirectory();
+    std::filesystem::path const path = directory / "entry";
+    std::string const destination = path.string();
+    std::vector<unsigned char> const content = {'n', 'e', 'w'};
+
+    //synced and closed, but not visible until commit
+    {
+        AtomicFile file;
+        CHECK(file.open(destination.c_str()) && file.write(content.data(), content.size()) && file.sync());
+        CHECK(file.getFile() == nullptr && !std::filesystem::exists(path) && countTemporaryFiles(directory) == 1);
+        CHECK(file.sync() && file.commit());
+        CHECK(readFile(path) == content && countTemporaryFiles(directory) == 0);
+        CHECK(!file.commit());
+    }
+
+    //a synced file that is discarded or destroyed is deleted, the destination is kept
+    std::vector<unsigned char> const discarded = {'x'};
+    {
+        AtomicFile file;
+        CHECK(file.open(destination.c_str()) && file.write(discarded.data(), discarded.size()) && file.sync());
+        file.discard();
+        CHECK(countTemporaryFiles(directory) == 0 && !file.commit());
+        CHECK(file.open(destination.c_str()) && file.write(discarded.data(), discarded.size()) && file.sync());
+    }
+    CHECK(readFile(path) == content && countTemporaryFiles(directory) == 0);
+
+    //commit syncs when sync was not called
+    {
+        AtomicFile file;
+        CHECK(file.open(destination.c_str()) && file.write(discarded.data(), discarded.size()) && file.commit());
+    }
+    CHECK(readFile(path) == discarded && countTemporaryFiles(directory) == 0);
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,213 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include <miniz.h>
+#include "Inflate.h"
+#include "Test.h"
+
+static std::vector<unsigned char> compress(std::vector<unsigned char> const &data, int const level,
+                                           int const strategy) {
+    mz_stream stream{};
+    std::vector<unsigned char> compressed(mz_compressBound(static_cast<mz_ulong>(data.size())) + 64);
+    if (mz_deflateInit2(&stream, level, MZ_DEFLATED, MZ_DEFAULT_WINDOW_BITS, 9, strategy) != MZ_OK) {
+        return {};
+    }
+    stream.next_in = data.data();
+    stream.avail_in = static_cast<unsigned int>(data.size());
+    stream.next_out = compressed.data();
+    stream.avail_out = static_cast<unsigned int>(compressed.size());
+    int const result = mz_deflate(&stream, MZ_FINISH);
+    compressed.resize(stream.total_out);
+    mz_deflateEnd(&stream);
+    return result == MZ_STREAM_END ? compressed : std::vector<unsigned char>{};
+}
+
+/**
+ * Inflate into a buffer of 'outputSize' bytes followed by a guard, the input is copied to a buffer of its exact size
+ */
+static bool inflate(unsigned char const *const input, size_t const inputSize, size_t const outputSize,
+                    std::vector<unsigned char> &output) {
+    std::vector<unsigned char> const exact(input, input + inputSize);
+    output.assign(outputSize + GUARD_SIZE, GUARD);
+    bool const inflated = inflateZlib(exact.data(), exact.size(), output.data(), outputSize);
+    CHECK_MESSAGE(isGuardIntact(output, outputSize), "write past %zu bytes", outputSize);
+    output.resize(outputSize);
+    return inflated;
+}
+
+//words from a small vocabulary with some random bytes, matches of every length and distances up to the window
+static std::vector<unsigned char> getText(size_t const size, std::mt19937 &random) {
+    static char const *const words[] = {"texture", "mip", "level", "block", "pixel", "the", "a", "compressed",
+                                        "\n", "  ", "0123456789", "alpha"};
+    std::vector<unsigned char> text;
+    while (text.size() < size) {
+        if (random() % 16 == 0) {
+            text.push_back(static_cast<unsigned char>(random()));
+        }
+        std::string const word = words[random() % (sizeof(words) / sizeof(words[0]))];
+        text.insert(text.end(), word.begin(), word.end());
+        text.push_back(' ');
+    }
+    text.resize(size);
+    return text;
+}
+
+/**
+ * Inputs for the round trips: literals only, short and long matches, runs that copy overlapping bytes, and stored
+ * blocks longer than 65535 bytes
+ */
+static std::vector<std::vector<unsigned char>> getInputs() {
+    std::mt19937 random(1);
+    std::vector<std::vector<unsigned char>> inputs{{}, {42}, {1, 2}};
+    for (size_t const size: {size_t{3}, size_t{100}, size_t{258}, size_t{259}, size_t{70000}}) {
+        inputs.push_back(getRandomBytes(size, random));
+    }
+    for (size_t const size: {size_t{1000}, size_t{40000}, size_t{200000}}) {
+        inputs.push_back(getText(size, random));
+    }
+    inputs.emplace_back(100000, 0);
+    //short periods, the matches overlap the bytes they copy
+    for (size_t const period: {size_t{2}, size_t{3}, size_t{7}, size_t{9}, size_t{15}, size_t{17}, size_t{31}}) {
+        std::vector<unsigned char> const pattern = getRandomBytes(period, random);
+        std::vector<unsigned char> input;
+        while (input.size() < 5000) {
+            input.insert(input.end(), pattern.begin(), pattern.end());
+        }
+        inputs.push_back(input);
+    }
+    return inputs;
+}
+
+TEST(inflateRoundTripsMinizLevels) {
+    for (std::vector<unsigned char> const &input: getInputs()) {
+        for (int level = 0; level <= 9; level++) {
+            std::vector<unsigned char> const compressed = compress(input, level, MZ_DEFAULT_STRATEGY);
+            std::vector<unsigned char> output;
+            CHECK_MESSAGE(inflate(compressed.data(), compressed.size(), input.size(), output) && output == input,
+                          "%zu bytes, level %d", input.size(), level);
+        }
+    }
+}
+
+TEST(inflateRoundTripsMinizStrategies) {
+    //fixed Huffman codes, runs only and literals only
+    for (std::vector<unsigned char> const &input: getInputs()) {
+        for (int const strategy: {MZ_FILTERED, MZ_HUFFMAN_ONLY, MZ_RLE, MZ_FIXED}) {
+            std::vector<unsigned char> const compressed = compress(input, 6, strategy);
+            std::vector<unsigned char> output;
+            CHECK_MESSAGE(inflate(compressed.data(), compressed.size(), input.size(), output) && output == input,
+                          "%zu bytes, strategy %d", input.size(), strategy);
+        }
+    }
+}
+
+TEST(inflateRejectsWrongOutputSize) {
+    std::mt19937 random(2);
+    std::vector<unsigned char> const input = getText(10000, random);
+    for (int const level: {0, 1, 9}) {
+        std::vector<unsigned char> const compressed = compress(input, level, MZ_DEFAULT_STRATEGY);
+        std::vector<unsigned char> output;
+        CHECK_MESSAGE(!inflate(compressed.data(), compressed.size(), input.size() - 1, output), "level %d", level);
+        CHECK_MESSAGE(!inflate(compressed.data(), compressed.size(), input.size() + 1, output), "level %d", level);
+    }
+}
+
+TEST(inflateRejectsTruncatedStreams) {
+    std::mt19937 random(3);
+    std::vector<unsigned char> input = getText(3000, random);
+    std::vector<unsigned char> const bytes = getRandomBytes(1000, random);
+    input.insert(input.end(), bytes.begin(), bytes.end());
+    //the end of block code of the fixed codes is all zeros, like the bits read past the end of the input
+    for (int const strategy: {MZ_DEFAULT_STRATEGY, MZ_FIXED}) {
+        for (int const level: {0, 1, 6, 9}) {
+            std::vector<unsigned char> const compressed = compress(input, level, strategy);
+            //the Adler-32 checksum at the end is not read
+            for (size_t size = 0; size + 4 < compressed.size(); size++) {
+                std::vector<unsigned char> output;
+                CHECK_MESSAGE(!inflate(compressed.data(), size, input.size(), output),
+                              "level %d, strategy %d, %zu of %zu bytes", level, strategy, size, compressed.size());
+            }
+        }
+    }
+}
+
+TEST(inflateRejectsInvalidStreams) {
+    //a stored block of "abc", valid as it is
+    std::vector<unsigned char> const stored{0x78, 0x01, 0x01, 0x03, 0x00, 0xfc, 0xff, 'a', 'b', 'c'};
+    std::vector<unsigned char> output;
+    CHECK(inflate(stored.data(), stored.size(), 3, output) && output == std::vector<unsigned char>({'a', 'b', 'c'}));
+
+    auto const isRejected = [](std::vector<unsigned char> const &stream) {
+        std::vector<unsigned char> out;
+        return !inflate(stream.data(), stream.size(), 3, out);
+    };
+    auto const withHeader = [&stored](unsigned int const method, unsigned int flags) {
+        flags += (31 - (method * 256 + flags) % 31) % 31;
+        std::vector<unsigned char> stream = stored;
+        stream[0] = static_cast<unsigned char>(method);
+        stream[1] = static_cast<unsigned char>(flags);
+        return stream;
+    };
+    CHECK(!isRejected(withHeader(0x78, 0xc0)));
+    //compression method 9, a 64KB window, a preset dictionary and a wrong header check
+    CHECK(isRejected(withHeader(0x79, 0x00)));
+    CHECK(isRejected(withHeader(0x88, 0x00)));
+    CHECK(isRejected(withHeader(0x78, 0x20)));
+    CHECK(isRejected({0x78, 0x02, 0x01, 0x03, 0x00, 0xfc, 0xff, 'a', 'b', 'c'}));
+    //the one's complement of the stored length is wrong
+    CHECK(isRejected({0x78, 0x01, 0x01, 0x03, 0x00, 0x00, 0x00, 'a', 'b', 'c'}));
+    //block type 3
+    CHECK(isRejected({0x78, 0x01, 0x07, 0x00, 0x00, 0x00}));
+    //fixed codes, a match of 3 bytes at distance 1 before any output
+    CHECK(isRejected({0x78, 0x01, 0x03, 0x02, 0x00, 0x00}));
+    CHECK(isRejected({0x78}));
+    CHECK(isRejected({}));
+}
+
+TEST(inflateSurvivesCorruptedStreams) {
+    std::mt19937 random(4);
+    std::vector<unsigned char> const input = getText(20000, random);
+    for (int const level: {1, 6, 9}) {
+        for (int const strategy: {MZ_DEFAULT_STRATEGY, MZ_FIXED}) {
+            std::vector<unsigned char> const compressed = compress(input, level, strategy);
+            for (size_t i = 0; i < 300; i++) {
+                //a few flipped bits, the stream may still be valid, but nothing may be written past the output
+                std::vector<unsigned char> corrupted = compressed;
+                for (size_t flips = 1 + random() % 3; flips > 0; flips--) {
+                    size_t const offset = 2 + random() % (corrupted.size() - 2);
+                    corrupted[offset] ^= static_cast<unsigned char>(1u << (random() % 8));
+                }
+                std::vector<unsigned char> output;
+                inflate(corrupted.data(), corrupted.size(), input.size(), output);
+            }
+        }
+    }
+}
@@ -0,0 +1,164 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "CpuFeatures.h"
+#include "MipGenerator.h"
+#include "Test.h"
+
+/**
+ * Every kernel set this CPU can run, the scalar one first
+ */
+static std::vector<MipKernels> getRunnableMipKernels() {
+    std::vector<MipKernels> kernels{{"scalar", reduceBoxScalar, filterColumnsScalar, filterRowScalar}};
+#ifdef DXTWRAPPER_X86
+    if (getCpuFeatures().ssse3) {
+        kernels.push_back({"ssse3", reduceBoxSsse3, filterColumnsSsse3, filterRowSsse3});
+    }
+    if (getCpuFeatures().avx2) {
+        kernels.push_back({"avx2", reduceBoxAvx2, filterColumnsAvx2, filterRowAvx2});
+    }
+#endif
+    return kernels;
+}
+
+static std::vector<float> getRandomFloats(size_t const size, float const minimum, float const maximum,
+                                          std::mt19937 &random) {
+    std::uniform_real_distribution<float> distribution(minimum, maximum);
+    std::vector<float> values(size);
+    for (float &value: values) {
+        value = distribution(random);
+    }
+    return values;
+}
+
+//GUARD for the float outputs
+static constexpr float FLOAT_GUARD = -1234.5f;
+
+//the vector kernels add the taps in the same order as the scalar ones, but the compiler may fuse the multiplies
+static constexpr float TOLERANCE = 1e-5f;
+
+static bool isNear(std::vector<float> const &expected, std::vector<float> const &actual) {
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (std::fabs(expected[i] - actual[i]) > TOLERANCE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(mipKernelsMatchCpuFeatures) {
+    char const *expected = "scalar";
+#ifdef DXTWRAPPER_X86
+    if (getCpuFeatures().avx2) {
+        expected = "avx2";
+    } else if (getCpuFeatures().ssse3) {
+        expected = "ssse3";
+    }
+#endif
+    CHECK_MESSAGE(std::strcmp(getMipKernels().name, expected) == 0, "selected %s", getMipKernels().name);
+}
+
+TEST(reduceBoxMatchesScalar) {
+    std::mt19937 random(1);
+    for (MipKernels const &kernels: getRunnableMipKernels()) {
+        for (size_t const count: getKernelCounts()) {
+            //exactly sized, so reads past the last pixel are caught by the address sanitizer
+            std::vector<unsigned char> row0(count * 8);
+            std::vector<unsigned char> row1(count * 8);
+            for (size_t i = 0; i < row0.size(); i++) {
+                row0[i] = static_cast<unsigned char>(random());
+                row1[i] = static_cast<unsigned char>(random());
+            }
+            //every channel at its maximum, the sums of 4 pixels must not overflow
+            if (count % 2 == 1) {
+                std::fill(row0.begin(), row0.end(), 0xff);
+                std::fill(row1.begin(), row1.end(), 0xff);
+            }
+            std::vector<unsigned char> expected(count * 4);
+            reduceBoxScalar(row0.data(), row1.data(), expected.data(), count);
+
+            std::vector<unsigned char> out(count * 4 + GUARD_SIZE, GUARD);
+            kernels.reduceBox(row0.data(), row1.data(), out.data(), count);
+            CHECK_MESSAGE(std::equal(expected.begin(), expected.end(), out.begin()), "%s, %zu pixels", kernels.name,
+                          count);
+            CHECK_MESSAGE(isGuardIntact(out, count * 4, GUARD), "%s, %zu pixels", kernels.name, count);
+        }
+    }
+}
+
+TEST(filterColumnsMatchesScalar) {
+    std::mt19937 random(2);
+    for (MipKernels const &kernels: getRunnableMipKernels()) {
+        for (size_t const count: getKernelCounts()) {
+            for (size_t taps = 1; taps <= 8; taps++) {
+                //rows wider than the floats filtered, like the tiles of filterLevel
+                size_t const pitch = count + taps % 3;
+                std::vector<float> const source = getRandomFloats((taps - 1) * pitch + count, 0.0f, 1.0f, random);
+                std::vector<float> const weights = getRandomFloats(taps, -0.25f, 1.0f, random);
+                std::vector<float> expected(count);
+                filterColumnsScalar(source.data(), pitch, weights.data(), taps, expected.data(), count);
+
+                std::vector<float> out(count + GUARD_SIZE, FLOAT_GUARD);
+                kernels.filterColumns(source.data(), pitch, weights.data(), taps, out.data(), count);
+                CHECK_MESSAGE(isNear(expected, out), "%s, %zu floats, %zu taps", kernels.name, count, taps);
+                CHECK_MESSAGE(isGuardIntact(out, count, FLOAT_GUARD), "%s, %zu floats, %zu taps", kernels.name,
+                              count, taps);
+            }
+        }
+    }
+}
+
+TEST(filterRowMatchesScalar) {
+    std::mt19937 random(3);
+    for (MipKernels const &kernels: getRunnableMipKernels()) {
+        for (size_t const count: getKernelCounts()) {
+            for (size_t taps = 1; taps <= 8; taps++) {
+                //a downscale by about 2, the first source pixel of the last output pixel ends the row
+                size_t const width = count * 2 + taps;
+                std::vector<float> const source = getRandomFloats(width * 4, 0.0f, 1.0f, random);
+                std::vector<unsigned int> first(count);
+                for (size_t x = 0; x < count; x++) {
+                    first[x] = static_cast<unsigned int>(x + 1 == count ? width - taps : random() % (width - taps));
+                }
+                std::vector<float> const weights = getRandomFloats(count * taps, -0.25f, 1.0f, random);
+                std::vector<float> expected(count * 4);
+                filterRowScalar(source.data(), first.data(), weights.data(), taps, expected.data(), count);
+
+                std::vector<float> out(count * 4 + GUARD_SIZE, FLOAT_GUARD);
+                kernels.filterRow(source.data(), first.data(), weights.data(), taps, out.data(), count);
+                CHECK_MESSAGE(isNear(expected, out), "%s, %zu pixels, %zu taps", kernels.name, count, taps);
+                CHECK_MESSAGE(isGuardIntact(out, count * 4, FLOAT_GUARD), "%s, %zu pixels, %zu taps", kernels.name,
+                              count, taps);
+            }
+        }
+    }
+}
@@ -0,0 +1,181 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <lodepng.h>
+#include <miniz.h>
+#include "DxTexWrapper.h"
+#include "ParallelPngEncoder.h"
+#include "Test.h"
+
+static uint32_t getAdler32(unsigned char const *const data, size_t const size) {
+    return static_cast<uint32_t>(mz_adler32(MZ_ADLER32_INIT, data, size));
+}
+
+TEST(adler32CombineMatchesSinglePass) {
+    std::mt19937 random(4);
+    std::vector<unsigned char> data(300000);
+    for (unsigned char &byte: data) {
+        byte = static_cast<unsigned char>(random());
+    }
+
+    //empty parts, single bytes, and parts around multiples of the modulus 65521
+    for (size_t const size: {size_t{0}, size_t{1}, size_t{2}, size_t{1000}, size_t{65520}, size_t{65521},
+                             size_t{65522}, size_t{131042}, size_t{131043}, data.size()}) {
+        for (size_t const split: {size_t{0}, size_t{1}, size / 2, size - std::min<size_t>(size, 1), size,
+                                  size - std::min<size_t>(size, 65521)}) {
+            if (split > size) {
+                continue;
+            }
+            uint32_t const first = getAdler32(data.data(), split);
+            uint32_t const second = getAdler32(data.data() + split, size - split);
+            uint32_t const expected = getAdler32(data.data(), size);
+            CHECK_MESSAGE(adler32Combine(first, second, size - split) == expected, "%zu bytes split at %zu", size,
+                          split);
+        }
+    }
+
+    //many parts, like the strips of an image
+    uint32_t adler = 1;
+    size_t offset = 0;
+    while (offset < data.size()) {
+        size_t const size = std::min<size_t>(random() % 70000, data.size() - offset);
+        adler = adler32Combine(adler, getAdler32(data.data() + offset, size), size);
+        offset += size;
+    }
+    CHECK(adler == getAdler32(data.data(), data.size()));
+
+    //all bytes 0xff reach the largest sums before the modulus
+    std::vector<unsigned char> const ones(200000, 0xff);
+    CHECK(adler32Combine(getAdler32(ones.data(), 70000), getAdler32(ones.data(), 130000), 130000)
+          == getAdler32(ones.data(), ones.size()));
+}
+
+/**
+ * Noise over a gradient, with alpha, so every filter is chosen by some rows
+ */
+static std::vector<unsigned char> getTestImage(size_t const width, size_t const height, unsigned int const seed) {
+    std::mt19937 random(seed);
+    std::vector<unsigned char> pixels(width * height * 4);
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            unsigned char *const pixel = &pixels[(y * width + x) * 4];
+            bool const noisy = (y / 7 + x / 64) % 3 == 0;
+            pixel[0] = static_cast<unsigned char>(x + (noisy ? random() % 32 : 0));
+            pixel[1] = static_cast<unsigned char>(y * 3);
+            pixel[2] = static_cast<unsigned char>(noisy ? random() : x ^ y);
+            pixel[3] = static_cast<unsigned char>(255 - (x + y) / 4);
+        }
+    }
+    return pixels;
+}
+
+static bool decodeWithSpng(std::vector<unsigned char> const &png, size_t const width, size_t const height,
+                           std::vector<unsigned char> &pixels) {
+    ImageData imageData;
+    if (!decodePng(png.data(), png.size(), imageData) || imageData.getWidth() != width
+        || imageData.getHeight() != height) {
+        return false;
+    }
+    pixels = imageData.getPixels();
+    return true;
+}
+
+static bool decodeWithLodepng(std::vector<unsigned char> const &png, size_t const width, size_t const height,
+                              std::vector<unsigned char> &pixels) {
+    unsigned int decodedWidth = 0;
+    unsigned int decodedHeight = 0;
+    pixels.clear();
+    return lodepng::decode(pixels, decodedWidth, decodedHeight, png) == 0 && decodedWidth == width
+           && decodedHeight == height;
+}
+
+static void checkRoundTrip(size_t const width, size_t const height, PngEncodeProfile const profile) {
+    std::vector<unsigned char> pixels = getTestImage(width, height, static_cast<unsigned int>(width * 31 + height));
+    DirectX::Image image{};
+    image.width = width;
+    image.height = height;
+    image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    image.rowPitch = width * 4;
+    image.slicePitch = pixels.size();
+    image.pixels = pixels.data();
+    PngEncodeOptions options{};
+    getPngEncodeOptions(profile, &options);
+
+    PngOutput output{};
+    if (encodePngParallel(image, options, output) != CONVERT_OK) {
+        CHECK_MESSAGE(false, "encoding %zux%zu", width, height);
+        return;
+    }
+    auto const *const content = static_cast<unsigned char const *>(output.content);
+    std::vector<unsigned char> const png(content, content + output.size);
+    std::free(output.content);
+
+    std::vector<unsigned char> decoded;
+    CHECK_MESSAGE(decodeWithSpng(png, width, height, decoded) && decoded == pixels, "spng, %zux%zu profile %d", width,
+                  height, profile);
+    CHECK_MESSAGE(decodeWithLodepng(png, width, height, decoded) && decoded == pixels, "lodepng, %zux%zu profile %d",
+                  width, height, profile);
+
+    //written chunk by chunk to a file, the bytes must be the same
+    std::FILE *const file = std::tmpfile();
+    if (file == nullptr) {
+        return;
+    }
+    PngOutput fileOutput{};
+    fileOutput.file = file;
+    CHECK(encodePngParallel(image, options, fileOutput) == CONVERT_OK && fileOutput.size == png.size());
+    std::vector<unsigned char> written(png.size());
+    std::rewind(file);
+    CHECK_MESSAGE(std::fread(written.data(), 1, written.size(), file) == png.size() && written == png,
+                  "file, %zux%zu", width, height);
+    std::fclose(file);
+}
+
+TEST(parallelPngRoundTripsThroughSpngAndLodepng) {
+    //1024 pixels wide, a strip is 512 rows
+    size_t const width = 1024;
+    size_t const stripRows = PARALLEL_PNG_STRIP_SIZE / (width * 4);
+    //one strip, one strip exactly, the second strip with a single row, two strips exactly, N strips with a short last
+    for (size_t const height: {size_t{1}, size_t{2}, stripRows - 1, stripRows, stripRows + 1, 2 * stripRows,
+                               4 * stripRows + 7}) {
+        checkRoundTrip(width, height, PNG_PROFILE_FAST);
+    }
+    //every filter, and the levels of the zlib header
+    checkRoundTrip(width, 2 * stripRows + 3, PNG_PROFILE_BALANCED);
+    checkRoundTrip(width, stripRows + 1, PNG_PROFILE_MAX);
+    //strips that are not a whole number of rows of 2MB
+    checkRoundTrip(1000, 1100, PNG_PROFILE_FAST);
+}
+
+TEST(parallelPngRoundTripsWithRowsLargerThanStrips) {
+    //each row is larger than a strip, every strip has a single row
+    checkRoundTrip(PARALLEL_PNG_STRIP_SIZE / 4 + 3, 3, PNG_PROFILE_FAST);
+}
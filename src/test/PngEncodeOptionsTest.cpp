@@ -0,0 +1,241 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <DirectXTex.h>
+#include <DDS.h>
+#include "DDSExtract.h"
+#include "DxTexWrapper.h"
+#include "FileConvert.h"
+#include "Test.h"
+
+/**
+ * RGBA8 pixels with 'padding' bytes after each row, set to a color that would make the image generic
+ */
+class TestImage {
+public:
+    TestImage(size_t const width, size_t const height, size_t const padding, unsigned char const (&rgba)[4])
+            : width(width), height(height), rowPitch(width * 4 + padding), pixels(rowPitch * height, 0x5a) {
+        for (size_t y = 0; y < height; y++) {
+            for (size_t x = 0; x < width; x++) {
+                std::memcpy(getPixel(x, y), rgba, 4);
+            }
+        }
+    }
+
+    unsigned char *getPixel(size_t const x, size_t const y) {
+        return pixels.data() + y * rowPitch + x * 4;
+    }
+
+    [[nodiscard]] DirectX::Image getImage() {
+        DirectX::Image image{};
+        image.width = width;
+        image.height = height;
+        image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        image.rowPitch = rowPitch;
+        image.slicePitch = rowPitch * height;
+        image.pixels = pixels.data();
+        return image;
+    }
+
+    size_t width;
+    size_t height;
+    size_t rowPitch;
+    std::vector<unsigned char> pixels;
+};
+
+/**
+ * An uncompressed RGBA8 DDS of one gray image
+ */
+static std::vector<unsigned char> getDDS(uint32_t const width, uint32_t const height) {
+    DirectX::DDS_HEADER header{};
+    header.size = sizeof(DirectX::DDS_HEADER);
+    header.width = width;
+    header.height = height;
+    header.mipMapCount = 1;
+    header.ddspf = {sizeof(DirectX::DDS_PIXELFORMAT), DDS_RGBA, 0, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000};
+    std::vector<unsigned char> dds(sizeof(uint32_t) + sizeof(header) + size_t{width} * height * 4, 0x80);
+    std::memcpy(dds.data(), &DirectX::DDS_MAGIC, sizeof(uint32_t));
+    std::memcpy(dds.data() + sizeof(uint32_t), &header, sizeof(header));
+    return dds;
+}
+
+static PngEncodeOptions getProfile(PngEncodeProfile const profile) {
+    PngEncodeOptions options{};
+    getPngEncodeOptions(profile, &options);
+    return options;
+}
+
+TEST(imageContentIsDetectedFromVisiblePixels) {
+    unsigned char const gray[4] = {0x80, 0x80, 0x80, 0xff};
+    for (size_t const padding: {size_t{0}, size_t{12}}) {
+        TestImage flat(9, 7, padding, gray);
+        CHECK_MESSAGE(detectPngImageContent(flat.getImage()) == PNG_CONTENT_FLAT, "padding %zu", padding);
+
+        TestImage alpha(9, 7, padding, gray);
+        alpha.getPixel(8, 6)[3] = 0;
+        CHECK_MESSAGE(detectPngImageContent(alpha.getImage()) == PNG_CONTENT_ALPHA_ONLY, "padding %zu", padding);
+
+        //a color change anywhere, even after an alpha change, makes the image generic
+        for (size_t channel = 0; channel < 3; channel++) {
+            TestImage generic(9, 7, padding, gray);
+            generic.getPixel(0, 3)[3] = 0;
+            generic.getPixel(8, 6)[channel]++;
+            CHECK_MESSAGE(detectPngImageContent(generic.getImage()) == PNG_CONTENT_GENERIC, "padding %zu channel %zu",
+                          padding, channel);
+        }
+    }
+
+    TestImage single(1, 1, 0, gray);
+    CHECK(detectPngImageContent(single.getImage()) == PNG_CONTENT_FLAT);
+    DirectX::Image empty = single.getImage();
+    empty.width = 0;
+    CHECK(detectPngImageContent(empty) == PNG_CONTENT_GENERIC);
+}
+
+TEST(encodeOptionsFollowImageContent) {
+    unsigned char const gray[4] = {0x80, 0x80, 0x80, 0xff};
+    TestImage flat(16, 16, 0, gray);
+    TestImage alpha(16, 16, 0, gray);
+    alpha.getPixel(3, 3)[3] = 7;
+    TestImage generic(16, 16, 0, gray);
+    generic.getPixel(3, 3)[0] = 7;
+
+    //without options, the balanced profile with no detection
+    for (TestImage *image: {&flat, &alpha, &generic}) {
+        PngEncodeOptions const resolved = resolvePngEncodeOptions(nullptr, image->getImage());
+        CHECK(resolved.profile == PNG_PROFILE_BALANCED && resolved.compressionLevel == -1 && !resolved.detectContent
+              && resolved.compressionStrategy == PNG_STRATEGY_FILTERED && resolved.filterChoice == PNG_FILTER_ALL);
+    }
+
+    for (PngEncodeProfile const profile: {PNG_PROFILE_BALANCED, PNG_PROFILE_FAST, PNG_PROFILE_MAX}) {
+        PngEncodeOptions const options = getProfile(profile);
+        CHECK(options.detectContent && isValidPngEncodeOptions(&options));
+
+        PngEncodeOptions resolved = resolvePngEncodeOptions(&options, flat.getImage());
+        CHECK_MESSAGE(resolved.compressionLevel == 1 && resolved.compressionStrategy == PNG_STRATEGY_RLE
+                      && resolved.filterChoice == PNG_FILTER_SUB, "profile %d", profile);
+
+        resolved = resolvePngEncodeOptions(&options, alpha.getImage());
+        CHECK_MESSAGE(resolved.compressionLevel == options.compressionLevel
+                      && resolved.compressionStrategy == options.compressionStrategy
+                      && resolved.filterChoice == PNG_FILTER_UP, "profile %d", profile);
+
+        resolved = resolvePngEncodeOptions(&options, generic.getImage());
+        CHECK_MESSAGE(std::memcmp(&resolved, &options, sizeof(options)) == 0, "profile %d", profile);
+
+        //detection off keeps the options for every content
+        PngEncodeOptions fixed = options;
+        fixed.detectContent = false;
+        for (TestImage *image: {&flat, &alpha, &generic}) {
+            resolved = resolvePngEncodeOptions(&fixed, image->getImage());
+            CHECK_MESSAGE(std::memcmp(&resolved, &fixed, sizeof(fixed)) == 0, "profile %d", profile);
+        }
+    }
+}
+
+TEST(encodeOptionsOutOfRangeAreRejected) {
+    PngEncodeOptions const valid = getProfile(PNG_PROFILE_BALANCED);
+    CHECK(isValidPngEncodeOptions(nullptr) && isValidPngEncodeOptions(&valid));
+
+    std::vector<PngEncodeOptions> invalid;
+    for (int const level: {-2, 10, 42}) {
+        invalid.push_back(valid);
+        invalid.back().compressionLevel = level;
+    }
+    for (int const strategy: {-1, 5}) {
+        invalid.push_back(valid);
+        invalid.back().compressionStrategy = static_cast<PngCompressionStrategy>(strategy);
+    }
+    for (int const filterChoice: {-1, 1, 4, PNG_FILTER_ALL + 1, 256}) {
+        invalid.push_back(valid);
+        invalid.back().filterChoice = filterChoice;
+    }
+
+    //the limits, and no filter at all
+    PngEncodeOptions limits = valid;
+    for (int level = -1; level <= 9; level++) {
+        limits.compressionLevel = level;
+        CHECK_MESSAGE(isValidPngEncodeOptions(&limits), "level %d", level);
+    }
+    for (int const strategy: {PNG_STRATEGY_DEFAULT, PNG_STRATEGY_FIXED}) {
+        limits.compressionStrategy = static_cast<PngCompressionStrategy>(strategy);
+        CHECK_MESSAGE(isValidPngEncodeOptions(&limits), "strategy %d", strategy);
+    }
+    for (int const filterChoice: {0, static_cast<int>(PNG_FILTER_NONE), static_cast<int>(PNG_FILTER_ALL)}) {
+        limits.filterChoice = filterChoice;
+        CHECK_MESSAGE(isValidPngEncodeOptions(&limits), "filter %d", filterChoice);
+    }
+
+    std::vector<unsigned char> const dds = getDDS(8, 8);
+    for (size_t i = 0; i < invalid.size(); i++) {
+        PngEncodeOptions const *const options = &invalid[i];
+        CHECK_MESSAGE(!isValidPngEncodeOptions(options), "case %zu", i);
+
+        ContentBuffer output{};
+        CHECK_MESSAGE(convertDDStoPNGEx(dds.data(), dds.size(), options, nullptr, nullptr, &output)
+                      == CONVERT_ERROR_INVALID_ARGUMENT && output.content == nullptr, "case %zu", i);
+        size_t outputSize = 0;
+        CHECK_MESSAGE(convertDDStoPNGInto(dds.data(), dds.size(), options, nullptr, 0, &outputSize)
+                      == CONVERT_ERROR_INVALID_ARGUMENT, "case %zu", i);
+        ConvertStatus status = CONVERT_OK;
+        DDSSubresource const subresource{0, 0, 0};
+        CHECK_MESSAGE(convertDDSSubresourcesToPNG(dds.data(), dds.size(), &subresource, 1, options, nullptr, nullptr,
+                                                  &output, &status) == CONVERT_ERROR_INVALID_ARGUMENT, "case %zu", i);
+        //rejected before the files are opened
+        CHECK_MESSAGE(convertDDStoPNGFile("missing.dds", "missing.png", options, nullptr)
+                      == CONVERT_ERROR_INVALID_ARGUMENT, "case %zu", i);
+
+        ConvertJob job{};
+        job.data = dds.data();
+        job.size = dds.size();
+        job.direction = CONVERT_DDS_TO_PNG;
+        job.pngOptions = options;
+        CHECK_MESSAGE(convertBatch(&job, 1) == CONVERT_ERROR_INVALID_ARGUMENT
+                      && job.status == CONVERT_ERROR_INVALID_ARGUMENT, "case %zu", i);
+    }
+
+    unsigned char const gray[4] = {0x80, 0x80, 0x80, 0xff};
+    TestImage image(8, 8, 0, gray);
+#ifdef DXTWRAPPER_USE_LIBSPNG
+    //the encoder reports the options spng refuses instead of keeping its defaults
+    PngEncodeOptions refused = valid;
+    refused.filterChoice = 256;
+    {
+        ErrorOutputScope const errors(false);
+        PngOutput png{};
+        CHECK(encodePng(image.getImage(), refused, png) == CONVERT_ERROR_ENCODE && png.content == nullptr);
+    }
+#endif
+    PngOutput png{};
+    CHECK(encodePng(image.getImage(), valid, png) == CONVERT_OK && png.content != nullptr);
+    ContentBuffer content{};
+    content.size = png.size;
+    content.content = png.content;
+    freeContentBuffer(&content);
+}
@@ -0,0 +1,276 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+#include <lodepng.h>
+#include "CpuFeatures.h"
+#include "PngDecoder.h"
+#include "PngUnfilter.h"
+#include "Test.h"
+
+/**
+ * Every kernel set this CPU can run, the scalar one first
+ */
+static std::vector<PngUnfilterKernels> getRunnablePngUnfilterKernels() {
+    std::vector<PngUnfilterKernels> kernels{{"scalar", unfilterSubScalar, unfilterUpScalar, unfilterAverageScalar,
+                                             unfilterPaethScalar}};
+#ifdef DXTWRAPPER_X86
+    if (getCpuFeatures().ssse3) {
+        kernels.push_back({"ssse3", unfilterSubSsse3, unfilterUpSsse3, unfilterAverageSsse3, unfilterPaethSsse3});
+    }
+#endif
+    return kernels;
+}
+
+/**
+ * Run one filter of 'kernels', 'dst' may overlap 'src' as unfilterPngRow allows
+ */
+static void unfilter(PngUnfilterKernels const &kernels, unsigned int const filter, unsigned char const *const src,
+                     unsigned char const *const previous, unsigned char *const dst, size_t const size,
+                     size_t const bpp) {
+    switch (filter) {
+        case PNG_ROW_FILTER_SUB:
+            kernels.sub(src, dst, size, bpp);
+            break;
+        case PNG_ROW_FILTER_UP:
+            kernels.up(src, previous, dst, size);
+            break;
+        case PNG_ROW_FILTER_AVERAGE:
+            kernels.average(src, previous, dst, size, bpp);
+            break;
+        default:
+            kernels.paeth(src, previous, dst, size, bpp);
+            break;
+    }
+}
+
+TEST(pngUnfilterKernelsMatchCpuFeatures) {
+    char const *expected = "scalar";
+#ifdef DXTWRAPPER_X86
+    if (getCpuFeatures().ssse3) {
+        expected = "ssse3";
+    }
+#endif
+    CHECK_MESSAGE(std::strcmp(getPngUnfilterKernels().name, expected) == 0, "selected %s",
+                  getPngUnfilterKernels().name);
+}
+
+TEST(pngUnfilterKernelsMatchScalar) {
+    std::mt19937 random(1);
+    for (PngUnfilterKernels const &kernels: getRunnablePngUnfilterKernels()) {
+        //the SSSE3 kernels handle 3 and 4 bytes per pixel, the other sizes go to the scalar ones
+        for (size_t const bpp: {size_t{1}, size_t{2}, size_t{3}, size_t{4}, size_t{6}, size_t{8}}) {
+            for (size_t const count: getKernelCounts()) {
+                size_t const size = count * bpp;
+                //exactly sized, so reads past the row are caught by the address sanitizer
+                std::vector<unsigned char> const src = getRandomBytes(size, random);
+                std::vector<unsigned char> const previous = getRandomBytes(size, random);
+                for (unsigned int filter = PNG_ROW_FILTER_SUB; filter <= PNG_ROW_FILTER_PAETH; filter++) {
+                    std::vector<unsigned char> expected(size);
+                    unfilter(getRunnablePngUnfilterKernels()[0], filter, src.data(), previous.data(),
+                             expected.data(), size, bpp);
+
+                    std::vector<unsigned char> dst(size + GUARD_SIZE, GUARD);
+                    unfilter(kernels, filter, src.data(), previous.data(), dst.data(), size, bpp);
+                    CHECK_MESSAGE(std::equal(expected.begin(), expected.end(), dst.begin()),
+                                  "%s, filter %u, %zu bytes per pixel, %zu pixels", kernels.name, filter, bpp, count);
+                    CHECK_MESSAGE(isGuardIntact(dst, size), "%s, filter %u, %zu bytes per pixel, %zu pixels",
+                                  kernels.name, filter, bpp, count);
+                }
+            }
+        }
+    }
+}
+
+TEST(pngUnfilterKernelsMatchScalarInPlace) {
+    std::mt19937 random(2);
+    for (PngUnfilterKernels const &kernels: getRunnablePngUnfilterKernels()) {
+        for (size_t const bpp: {size_t{3}, size_t{4}}) {
+            for (size_t const count: getKernelCounts()) {
+                size_t const size = count * bpp;
+                std::vector<unsigned char> const src = getRandomBytes(size, random);
+                std::vector<unsigned char> const previous = getRandomBytes(size, random);
+                //the row moved back over its filter type byte, and over the filter types of several rows
+                for (size_t const shift: {size_t{1}, size_t{5}}) {
+                    for (unsigned int filter = PNG_ROW_FILTER_SUB; filter <= PNG_ROW_FILTER_PAETH; filter++) {
+                        std::vector<unsigned char> expected(size);
+                        unfilter(getRunnablePngUnfilterKernels()[0], filter, src.data(), previous.data(),
+                                 expected.data(), size, bpp);
+
+                        std::vector<unsigned char> buffer(shift + size);
+                        std::copy(src.begin(), src.end(), buffer.begin() + static_cast<std::ptrdiff_t>(shift));
+                        unfilter(kernels, filter, buffer.data() + shift, previous.data(), buffer.data(), size, bpp);
+                        CHECK_MESSAGE(std::equal(expected.begin(), expected.end(), buffer.begin()),
+                                      "%s, filter %u, %zu bytes per pixel, %zu pixels, shift %zu", kernels.name,
+                                      filter, bpp, count, shift);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(unfilterPngRowRejectsInvalidFilters) {
+    unsigned char const src[4] = {1, 2, 3, 4};
+    unsigned char const previous[4] = {};
+    unsigned char dst[4];
+    CHECK(unfilterPngRow(PNG_ROW_FILTER_NONE, src, previous, dst, 4, 4) && std::memcmp(dst, src, 4) == 0);
+    CHECK(!unfilterPngRow(5, src, previous, dst, 4, 4));
+    CHECK(!unfilterPngRow(255, src, previous, dst, 4, 4));
+}
+
+static void appendBigEndian(std::vector<unsigned char> &png, uint32_t const value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        png.push_back(static_cast<unsigned char>(value >> shift));
+    }
+}
+
+static void appendChunk(std::vector<unsigned char> &png, char const *const type, unsigned char const *const data,
+                        size_t const size) {
+    appendBigEndian(png, static_cast<uint32_t>(size));
+    size_t const start = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data, data + size);
+    appendBigEndian(png, lodepng_crc32(&png[start], png.size() - start));
+}
+
+/**
+ * An 8-bit PNG of the filtered rows 'filtered', compressed by lodepng and split into IDAT chunks of 'chunkSize' bytes
+ */
+static std::vector<unsigned char> buildPng(uint32_t const width, uint32_t const height, unsigned char const colorType,
+                                           std::vector<unsigned char> const &filtered, size_t const chunkSize) {
+    std::vector<unsigned char> png{0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::vector<unsigned char> header;
+    appendBigEndian(header, width);
+    appendBigEndian(header, height);
+    header.insert(header.end(), {8, colorType, 0, 0, 0});
+    appendChunk(png, "IHDR", header.data(), header.size());
+
+    std::vector<unsigned char> compressed;
+    lodepng::compress(compressed, filtered);
+    for (size_t offset = 0; offset < compressed.size(); offset += chunkSize) {
+        appendChunk(png, "IDAT", &compressed[offset], std::min(chunkSize, compressed.size() - offset));
+    }
+    appendChunk(png, "IEND", nullptr, 0);
+    return png;
+}
+
+static std::vector<unsigned char> decodeWithLodepng(std::vector<unsigned char> const &png) {
+    std::vector<unsigned char> pixels;
+    unsigned int width;
+    unsigned int height;
+    return lodepng::decode(pixels, width, height, png) == 0 ? pixels : std::vector<unsigned char>{};
+}
+
+TEST(decodeTrustedPngMatchesLodepng) {
+    std::mt19937 random(3);
+    for (LodePNGColorType const colorType: {LCT_RGB, LCT_RGBA}) {
+        for (auto const &[width, height]: {std::pair{1u, 1u}, {3u, 2u}, {17u, 5u}, {64u, 33u}, {301u, 7u}}) {
+            size_t const bpp = colorType == LCT_RGBA ? 4 : 3;
+            //a smooth gradient with noise, so every filter is picked by the adaptive strategies
+            std::vector<unsigned char> image(size_t{width} * height * bpp);
+            for (size_t i = 0; i < image.size(); i++) {
+                image[i] = static_cast<unsigned char>(i / bpp % width * 3 + i / bpp / width * 5 + random() % 8);
+            }
+
+            for (LodePNGFilterStrategy const strategy: {LFS_ZERO, LFS_ONE, LFS_TWO, LFS_THREE, LFS_FOUR, LFS_MINSUM}) {
+                lodepng::State state;
+                state.encoder.auto_convert = 0;
+                state.encoder.filter_strategy = strategy;
+                state.info_raw.colortype = colorType;
+                state.info_png.color.colortype = colorType;
+                std::vector<unsigned char> png;
+                CHECK(lodepng::encode(png, image, width, height, state) == 0);
+                std::vector<unsigned char> const expected = decodeWithLodepng(png);
+
+                ImageData imageData{};
+                CHECK_MESSAGE(decodeTrustedPng(png.data(), png.size(), imageData) == CONVERT_OK
+                              && imageData.getPixels() == expected && imageData.getWidth() == width
+                              && imageData.getHeight() == height,
+                              "%zu bytes per pixel, %ux%u, strategy %d", bpp, width, height, strategy);
+
+                //into a buffer of the caller, RGBA rows need one more byte each to be unfiltered in place
+                size_t const pixelsSize = expected.size();
+                size_t const capacity = std::max(pixelsSize, (size_t{width} * bpp + 1) * height);
+                std::vector<unsigned char> pixels(capacity);
+                CHECK_MESSAGE(decodeTrustedPng(png.data(), png.size(), pixels.data(), pixelsSize, capacity)
+                              == CONVERT_OK && std::equal(expected.begin(), expected.end(), pixels.begin()),
+                              "%zu bytes per pixel, %ux%u, strategy %d", bpp, width, height, strategy);
+                CHECK(decodeTrustedPng(png.data(), png.size(), pixels.data(), pixelsSize, capacity - 1)
+                      == CONVERT_ERROR_BUFFER_TOO_SMALL);
+            }
+        }
+    }
+}
+
+TEST(decodeTrustedPngJoinsDataChunks) {
+    std::mt19937 random(4);
+    uint32_t const width = 40;
+    uint32_t const height = 30;
+    //unfiltered rows, each starts with filter type 0
+    std::vector<unsigned char> filtered;
+    std::vector<unsigned char> expected;
+    for (size_t y = 0; y < height; y++) {
+        filtered.push_back(PNG_ROW_FILTER_NONE);
+        std::vector<unsigned char> const row = getRandomBytes(width * 4, random);
+        filtered.insert(filtered.end(), row.begin(), row.end());
+        expected.insert(expected.end(), row.begin(), row.end());
+    }
+    for (size_t const chunkSize: {size_t{1}, size_t{7}, size_t{1000}, size_t{100000}}) {
+        std::vector<unsigned char> const png = buildPng(width, height, LCT_RGBA, filtered, chunkSize);
+        ImageData imageData{};
+        CHECK_MESSAGE(decodeTrustedPng(png.data(), png.size(), imageData) == CONVERT_OK
+                      && imageData.getPixels() == expected, "IDAT chunks of %zu bytes", chunkSize);
+    }
+}
+
+TEST(decodeTrustedPngRejectsInvalidImages) {
+    uint32_t const width = 8;
+    uint32_t const height = 4;
+    std::vector<unsigned char> filtered((width * 4 + 1) * height, 0);
+    std::vector<unsigned char> png = buildPng(width, height, LCT_RGBA, filtered, 1000);
+    ImageData imageData{};
+    CHECK(decodeTrustedPng(png.data(), png.size(), imageData) == CONVERT_OK);
+
+    //a filter type that doesn't exist, and image data shorter than the image
+    filtered[(width * 4 + 1) * 2] = 5;
+    png = buildPng(width, height, LCT_RGBA, filtered, 1000);
+    CHECK(decodeTrustedPng(png.data(), png.size(), imageData) == CONVERT_ERROR_DECODE);
+    filtered[(width * 4 + 1) * 2] = PNG_ROW_FILTER_NONE;
+    filtered.pop_back();
+    png = buildPng(width, height, LCT_RGBA, filtered, 1000);
+    CHECK(decodeTrustedPng(png.data(), png.size(), imageData) == CONVERT_ERROR_DECODE);
+
+    //the formats it doesn't decode are left to the PNG library
+    png = buildPng(width, height, LCT_GREY, std::vector<unsigned char>((width + 1) * height, 0), 1000);
+    CHECK(decodeTrustedPng(png.data(), png.size(), imageData) == CONVERT_ERROR_INVALID_ARGUMENT);
+}
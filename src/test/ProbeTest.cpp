@@ -0,0 +1,410 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include <DirectXTex.h>
+#include <DDS.h>
+#include "DDSHeader.h"
+#include "Probe.h"
+#include "Test.h"
+
+using DirectX::DDS_HEADER;
+using DirectX::DDS_HEADER_DXT10;
+using DirectX::DDS_PIXELFORMAT;
+
+static DDS_PIXELFORMAT getPixelFormat(uint32_t const flags, uint32_t const fourCC, uint32_t const bitCount,
+                                      uint32_t const r, uint32_t const g, uint32_t const b, uint32_t const a) {
+    return {sizeof(DDS_PIXELFORMAT), flags, fourCC, bitCount, r, g, b, a};
+}
+
+static DDS_PIXELFORMAT const RGBA8 = getPixelFormat(DDS_RGBA, 0, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+static DDS_PIXELFORMAT const DX10 = getPixelFormat(DDS_FOURCC, MAKEFOURCC('D', 'X', '1', '0'), 0, 0, 0, 0, 0);
+
+/**
+ * The headers of a DDS file without pixels, with the DX10 extension when the pixel format is DX10
+ */
+class DDSFile {
+public:
+    DDSFile(uint32_t const width, uint32_t const height, uint32_t const mipMapCount,
+            DDS_PIXELFORMAT const &pixelFormat = RGBA8) {
+        header.size = sizeof(DDS_HEADER);
+        header.width = width;
+        header.height = height;
+        header.mipMapCount = mipMapCount;
+        header.ddspf = pixelFormat;
+        extension.dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+        extension.resourceDimension = DirectX::DDS_DIMENSION_TEXTURE2D;
+        extension.arraySize = 1;
+    }
+
+    [[nodiscard]] std::vector<unsigned char> getBytes() const {
+        std::vector<unsigned char> bytes(sizeof(uint32_t) + sizeof(DDS_HEADER));
+        std::memcpy(bytes.data(), &DirectX::DDS_MAGIC, sizeof(uint32_t));
+        std::memcpy(bytes.data() + sizeof(uint32_t), &header, sizeof(header));
+        if (header.ddspf.fourCC == DX10.fourCC) {
+            auto const *const extensionBytes = reinterpret_cast<unsigned char const *>(&extension);
+            bytes.insert(bytes.end(), extensionBytes, extensionBytes + sizeof(extension));
+        }
+        return bytes;
+    }
+
+    [[nodiscard]] bool parse(DDSInfo &info) const {
+        std::vector<unsigned char> const bytes = getBytes();
+        return parseDDSHeader(bytes.data(), bytes.size(), info);
+    }
+
+    DDS_HEADER header{};
+    DDS_HEADER_DXT10 extension{};
+};
+
+TEST(ddsHeaderIsParsed) {
+    DDSInfo info;
+    CHECK(DDSFile(64, 32, 7).parse(info));
+    CHECK(info.width == 64 && info.height == 32 && info.depth == 1 && info.mipLevels == 7 && info.arraySize == 1);
+    CHECK(info.format == DXGI_FORMAT_R8G8B8A8_UNORM && !info.dx10ext && !info.cubemap && !info.volume);
+    CHECK(info.dataOffset == 128);
+
+    //no mip count is a single level
+    CHECK(DDSFile(64, 32, 0).parse(info) && info.mipLevels == 1);
+
+    DDSFile dx10(5, 3, 3, DX10);
+    dx10.extension.dxgiFormat = DXGI_FORMAT_BC7_UNORM;
+    CHECK(dx10.parse(info) && info.dx10ext && info.format == DXGI_FORMAT_BC7_UNORM && info.dataOffset == 148);
+
+    //magic, sizes of the header and the pixel format, dimensions
+    std::vector<unsigned char> bytes = DDSFile(4, 4, 1).getBytes();
+    bytes[0] = 'X';
+    CHECK(!parseDDSHeader(bytes.data(), bytes.size(), info));
+    DDSFile invalid(4, 4, 1);
+    invalid.header.size = 120;
+    CHECK(!invalid.parse(info));
+    invalid = DDSFile(4, 4, 1);
+    invalid.header.ddspf.size = 0;
+    CHECK(!invalid.parse(info));
+    CHECK(!DDSFile(0, 4, 1).parse(info));
+    CHECK(!DDSFile(4, 0, 1).parse(info));
+    CHECK(!parseDDSHeader(nullptr, 128, info));
+}
+
+TEST(ddsMipCountIsBoundedByLargestDimension) {
+    DDSInfo info;
+    //floor(log2(max(w, h, d))) + 1
+    struct Case {
+        uint32_t width;
+        uint32_t height;
+        uint32_t maxLevels;
+    };
+    for (Case const &c: {Case{1, 1, 1}, Case{2, 1, 2}, Case{1, 3, 2}, Case{4, 4, 3}, Case{5, 3, 3}, Case{64, 32, 7},
+                         Case{1, 1000, 10}, Case{1024, 1024, 11}, Case{65535, 1, 16}, Case{0x80000000u, 1, 32}}) {
+        CHECK_MESSAGE(DDSFile(c.width, c.height, c.maxLevels).parse(info) && info.mipLevels == c.maxLevels, "%ux%u",
+                      c.width, c.height);
+        CHECK_MESSAGE(!DDSFile(c.width, c.height, c.maxLevels + 1).parse(info), "%ux%u", c.width, c.height);
+    }
+    CHECK(!DDSFile(4, 4, 0xffffffffu).parse(info));
+
+    //the depth of a volume counts too
+    DDSFile volume(4, 4, 5);
+    volume.header.flags = DDS_HEADER_FLAGS_VOLUME;
+    volume.header.depth = 16;
+    CHECK(volume.parse(info) && info.volume && info.depth == 16 && info.mipLevels == 5);
+    volume.header.mipMapCount = 6;
+    CHECK(!volume.parse(info));
+
+    //in a DX10 header too
+    CHECK(DDSFile(8, 8, 4, DX10).parse(info));
+    CHECK(!DDSFile(8, 8, 5, DX10).parse(info));
+}
+
+TEST(legacyPixelFormatsMapToDxgi) {
+    struct Case {
+        DDS_PIXELFORMAT pixelFormat;
+        DXGI_FORMAT format;
+    };
+    Case const cases[] = {
+            {getPixelFormat(DDS_FOURCC, MAKEFOURCC('D', 'X', 'T', '1'), 0, 0, 0, 0, 0), DXGI_FORMAT_BC1_UNORM},
+            {getPixelFormat(DDS_FOURCC, MAKEFOURCC('D', 'X', 'T', '2'), 0, 0, 0, 0, 0), DXGI_FORMAT_BC2_UNORM},
+            {getPixelFormat(DDS_FOURCC, MAKEFOURCC('D', 'X', 'T', '3'), 0, 0, 0, 0, 0), DXGI_FORMAT_BC2_UNORM},
+            {getPixelFormat(DDS_FOURCC, MAKEFOURCC('D', 'X', 'T', '5'), 0, 0, 0, 0, 0), DXGI_FORMAT_BC3_UNORM},
+            {getPixelFormat(DDS_FOURCC, MAKEFOURCC('A', 'T', 'I', '1'), 0, 0, 0, 0, 0), DXGI_FORMAT_BC4_UNORM},
+            {getPixelFormat(DDS_FOURCC, MAKEFOURCC('B', 'C', '4', 'S'), 0, 0, 0, 0, 0), DXGI_FORMAT_BC4_SNORM},
+            {getPixelFormat(DDS_FOURCC, MAKEFOURCC('A', 'T', 'I', '2'), 0, 0, 0, 0, 0), DXGI_FORMAT_BC5_UNORM},
+            {getPixelFormat(DDS_FOURCC, MAKEFOURCC('B', 'C', '5', 'S'), 0, 0, 0, 0, 0), DXGI_FORMAT_BC5_SNORM},
+            {getPixelFormat(DDS_FOURCC, MAKEFOURCC('Y', 'U', 'Y', '2'), 0, 0, 0, 0, 0), DXGI_FORMAT_YUY2},
+            //D3DFMT_A16B16G16R16F
+            {getPixelFormat(DDS_FOURCC, 113, 0, 0, 0, 0, 0), DXGI_FORMAT_R16G16B16A16_FLOAT},
+            {getPixelFormat(DDS_FOURCC, MAKEFOURCC('X', 'Y', 'Z', 'W'), 0, 0, 0, 0, 0), DXGI_FORMAT_UNKNOWN},
+            {RGBA8, DXGI_FORMAT_R8G8B8A8_UNORM},
+            {getPixelFormat(DDS_RGB, 0, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0), DXGI_FORMAT_R8G8B8A8_UNORM},
+            {getPixelFormat(DDS_RGBA, 0, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000),
+             DXGI_FORMAT_B8G8R8A8_UNORM},
+            {getPixelFormat(DDS_RGB, 0, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0), DXGI_FORMAT_B8G8R8X8_UNORM},
+            {getPixelFormat(DDS_RGBA, 0, 32, 0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000),
+             DXGI_FORMAT_R10G10B10A2_UNORM},
+            {getPixelFormat(DDS_RGBA, 0, 32, 0x000003ff, 0x000ffc00, 0x3ff00000, 0xc0000000),
+             DXGI_FORMAT_R10G10B10A2_UNORM},
+            {getPixelFormat(DDS_RGB, 0, 32, 0x0000ffff, 0xffff0000, 0, 0), DXGI_FORMAT_R16G16_UNORM},
+            {getPixelFormat(DDS_RGB, 0, 32, 0xffffffff, 0, 0, 0), DXGI_FORMAT_R32_FLOAT},
+            {getPixelFormat(DDS_RGB, 0, 24, 0xff0000, 0x00ff00, 0x0000ff, 0), DXGI_FORMAT_UNKNOWN},
+            {getPixelFormat(DDS_RGBA, 0, 16, 0x7c00, 0x03e0, 0x001f, 0x8000), DXGI_FORMAT_B5G5R5A1_UNORM},
+            {getPixelFormat(DDS_RGB, 0, 16, 0xf800, 0x07e0, 0x001f, 0), DXGI_FORMAT_B5G6R5_UNORM},
+            {getPixelFormat(DDS_RGBA, 0, 16, 0x0f00, 0x00f0, 0x000f, 0xf000), DXGI_FORMAT_B4G4R4A4_UNORM},
+            {getPixelFormat(DDS_RGB, 0, 8, 0xff, 0, 0, 0), DXGI_FORMAT_R8_UNORM},
+            {getPixelFormat(DDS_LUMINANCE, 0, 8, 0xff, 0, 0, 0), DXGI_FORMAT_R8_UNORM},
+            {getPixelFormat(DDS_LUMINANCE, 0, 16, 0xffff, 0, 0, 0), DXGI_FORMAT_R16_UNORM},
+            {getPixelFormat(DDS_LUMINANCEA, 0, 16, 0x00ff, 0, 0, 0xff00), DXGI_FORMAT_R8G8_UNORM},
+            {getPixelFormat(DDS_ALPHA, 0, 8, 0, 0, 0, 0xff), DXGI_FORMAT_A8_UNORM},
+            {getPixelFormat(DDS_BUMPDUDV, 0, 16, 0x00ff, 0xff00, 0, 0), DXGI_FORMAT_R8G8_SNORM},
+            {getPixelFormat(DDS_BUMPDUDV, 0, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000),
+             DXGI_FORMAT_R8G8B8A8_SNORM},
+            {getPixelFormat(DDS_PAL8, 0, 8, 0, 0, 0, 0), DXGI_FORMAT_UNKNOWN},
+    };
+    for (size_t i = 0; i < std::size(cases); i++) {
+        bool noAlpha = true;
+        CHECK_MESSAGE(getLegacyDDSFormat(cases[i].pixelFormat, noAlpha) == cases[i].format, "case %zu", i);
+        //the same through the parser, an unknown format is not an invalid header
+        DDSInfo info;
+        CHECK_MESSAGE(DDSFile(4, 4, 1, cases[i].pixelFormat).parse(info) && info.format == cases[i].format
+                      && info.noAlpha == noAlpha, "case %zu", i);
+    }
+
+    //only X8B8G8R8 maps to a format with alpha it does not have
+    bool noAlpha = false;
+    CHECK(getLegacyDDSFormat(getPixelFormat(DDS_RGB, 0, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0), noAlpha)
+          == DXGI_FORMAT_R8G8B8A8_UNORM && noAlpha);
+    CHECK(getLegacyDDSFormat(RGBA8, noAlpha) == DXGI_FORMAT_R8G8B8A8_UNORM && !noAlpha);
+    CHECK(getLegacyDDSFormat(getPixelFormat(DDS_RGB, 0, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0), noAlpha)
+          == DXGI_FORMAT_B8G8R8X8_UNORM && !noAlpha);
+}
+
+TEST(ddsCubemapsArraysAndVolumesAreParsed) {
+    DDSInfo info;
+    //legacy cubemap, all faces only
+    DDSFile cube(16, 16, 5);
+    cube.header.caps2 = DDS_CUBEMAP_ALLFACES;
+    CHECK(cube.parse(info) && info.cubemap && info.arraySize == 6 && info.mipLevels == 5);
+    cube.header.caps2 = DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX;
+    CHECK(!cube.parse(info));
+
+    //DX10 cubemap arrays count 6 images per cube
+    DDSFile dx10(16, 16, 1, DX10);
+    dx10.extension.miscFlag = DirectX::DDS_RESOURCE_MISC_TEXTURECUBE;
+    dx10.extension.arraySize = 3;
+    CHECK(dx10.parse(info) && info.cubemap && info.arraySize == 18);
+    dx10.extension.miscFlag = 0;
+    CHECK(dx10.parse(info) && !info.cubemap && info.arraySize == 3);
+    dx10.extension.arraySize = 0;
+    CHECK(!dx10.parse(info));
+
+    //1D textures are one row high whatever the header says
+    DDSFile row(32, 7, 6, DX10);
+    row.extension.resourceDimension = DirectX::DDS_DIMENSION_TEXTURE1D;
+    CHECK(row.parse(info) && info.width == 32 && info.height == 1);
+
+    //volumes need the depth flag and a single item
+    DDSFile volume(8, 4, 3, DX10);
+    volume.extension.resourceDimension = DirectX::DDS_DIMENSION_TEXTURE3D;
+    volume.header.depth = 2;
+    CHECK(!volume.parse(info));
+    volume.header.flags = DDS_HEADER_FLAGS_VOLUME;
+    CHECK(volume.parse(info) && info.volume && info.depth == 2 && info.arraySize == 1);
+    volume.extension.arraySize = 2;
+    CHECK(!volume.parse(info));
+    volume.extension.arraySize = 1;
+    volume.header.depth = 0;
+    CHECK(!volume.parse(info));
+
+    DDSFile legacyVolume(4, 4, 1);
+    legacyVolume.header.flags = DDS_HEADER_FLAGS_VOLUME;
+    legacyVolume.header.depth = 9;
+    CHECK(legacyVolume.parse(info) && info.volume && info.depth == 9);
+
+    DDSFile unknownDimension(4, 4, 1, DX10);
+    unknownDimension.extension.resourceDimension = 7;
+    CHECK(!unknownDimension.parse(info));
+}
+
+TEST(truncatedHeadersAreRejected) {
+    ErrorOutputScope const errors(false);
+    DDSInfo info;
+    TextureInfo texture{};
+    std::vector<unsigned char> const dds = DDSFile(4, 4, 1).getBytes();
+    for (size_t size = 0; size < dds.size(); size++) {
+        CHECK_MESSAGE(!parseDDSHeader(dds.data(), size, info), "%zu bytes", size);
+        CHECK_MESSAGE(probeTexture(dds.data(), size, &texture) == CONVERT_ERROR_DECODE, "%zu bytes", size);
+    }
+    CHECK(probeTexture(dds.data(), dds.size(), &texture) == CONVERT_OK);
+
+    //the DX10 extension must be complete too
+    std::vector<unsigned char> const dx10 = DDSFile(4, 4, 1, DX10).getBytes();
+    CHECK(dx10.size() == PROBE_HEADER_SIZE);
+    for (size_t size = dds.size(); size < dx10.size(); size++) {
+        CHECK_MESSAGE(!parseDDSHeader(dx10.data(), size, info), "%zu bytes", size);
+    }
+    CHECK(parseDDSHeader(dx10.data(), dx10.size(), info));
+
+    //signature and IHDR, its 13 bytes of data end at 29
+    std::vector<unsigned char> const png = getPng(3, 2);
+    for (size_t const size: {size_t{0}, size_t{7}, size_t{8}, size_t{20}, size_t{28}}) {
+        CHECK_MESSAGE(probeTexture(png.data(), size, &texture) == CONVERT_ERROR_DECODE, "%zu bytes", size);
+    }
+    CHECK(probeTexture(png.data(), png.size(), &texture) == CONVERT_OK);
+    CHECK(probeTexture(nullptr, 0, &texture) == CONVERT_ERROR_INVALID_ARGUMENT);
+    CHECK(probeTexture(png.data(), png.size(), nullptr) == CONVERT_ERROR_INVALID_ARGUMENT);
+}
+
+/**
+ * Textures of every kind, 'i' selects one, the odd ones are invalid
+ */
+static std::vector<unsigned char> getProbeTexture(size_t const i) {
+    switch (i % 6) {
+        case 0:
+            return DDSFile(static_cast<uint32_t>(i + 1), 4, 1).getBytes();
+        case 2:
+            return getPng(i % 50 + 1, 3);
+        case 4: {
+            DDSFile cube(8, 8, 4, DX10);
+            cube.extension.miscFlag = DirectX::DDS_RESOURCE_MISC_TEXTURECUBE;
+            cube.extension.arraySize = 2;
+            return cube.getBytes();
+        }
+        case 1:
+            return DDSFile(4, 4, 4).getBytes();
+        case 3:
+            return {'G', 'I', 'F', '8', '9', 'a'};
+        default:
+            return {'D', 'D', 'S', ' ', 124, 0};
+    }
+}
+
+static void checkProbedTexture(size_t const i, TextureInfo const &info, ConvertStatus const status) {
+    switch (i % 6) {
+        case 0:
+            CHECK_MESSAGE(status == CONVERT_OK && info.container == TEXTURE_CONTAINER_DDS && info.width == i + 1
+                          && info.height == 4 && info.format == DXGI_FORMAT_R8G8B8A8_UNORM, "texture %zu", i);
+            break;
+        case 2:
+            CHECK_MESSAGE(status == CONVERT_OK && info.container == TEXTURE_CONTAINER_PNG && info.width == i % 50 + 1
+                          && info.height == 3 && info.mipLevels == 1 && info.bitDepth == 8 && info.colorType == 6,
+                          "texture %zu", i);
+            break;
+        case 4:
+            CHECK_MESSAGE(status == CONVERT_OK && info.cubemap && info.dx10ext && info.arraySize == 12
+                          && info.mipLevels == 4, "texture %zu", i);
+            break;
+        default:
+            CHECK_MESSAGE(status == CONVERT_ERROR_DECODE && info.container == TEXTURE_CONTAINER_UNKNOWN,
+                          "texture %zu", i);
+            break;
+    }
+}
+
+TEST(probeTexturesReportsEachTexture) {
+    //several batches of the pool
+    size_t const count = 2500;
+    std::vector<std::vector<unsigned char>> textures;
+    std::vector<void const *> data;
+    std::vector<size_t> sizes;
+    for (size_t i = 0; i < count; i++) {
+        textures.push_back(getProbeTexture(i));
+    }
+    for (std::vector<unsigned char> const &texture: textures) {
+        data.push_back(texture.data());
+        sizes.push_back(texture.size());
+    }
+    //an empty texture has no data
+    data[5] = nullptr;
+
+    std::vector<TextureInfo> infos(count);
+    std::vector<ConvertStatus> statuses(count, CONVERT_ERROR_IO);
+    CHECK(probeTextures(data.data(), sizes.data(), count, infos.data(), statuses.data()) == CONVERT_ERROR_DECODE);
+    for (size_t i = 0; i < count; i++) {
+        if (i == 5) {
+            CHECK(statuses[i] == CONVERT_ERROR_INVALID_ARGUMENT);
+            continue;
+        }
+        checkProbedTexture(i, infos[i], statuses[i]);
+    }
+
+    //only valid textures
+    CHECK(probeTextures(data.data(), sizes.data(), 1, infos.data(), statuses.data()) == CONVERT_OK);
+    CHECK(probeTextures(nullptr, nullptr, 0, nullptr, nullptr) == CONVERT_OK);
+    CHECK(probeTextures(nullptr, sizes.data(), 1, infos.data(), statuses.data()) == CONVERT_ERROR_INVALID_ARGUMENT);
+}
+
+TEST(probeTextureFilesReadsOnlyHeaders) {
+    std::filesystem::path const directory = std::filesystem::temp_directory_path()
+                                            / ("dxtexwrapper-probe-test-" + std::to_string(std::random_device{}()));
+    std::filesystem::create_directory(directory);
+    //more files than a batch of the pool
+    size_t const count = 40;
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; i++) {
+        names.push_back((directory / ("texture" + std::to_string(i))).string());
+        std::vector<unsigned char> texture = getProbeTexture(i);
+        //pixels after the headers are not read
+        texture.resize(texture.size() + 1000, 0xcd);
+        std::FILE *const file = std::fopen(names.back().c_str(), "wb");
+        CHECK(file != nullptr);
+        if (file != nullptr) {
+            std::fwrite(texture.data(), 1, texture.size(), file);
+            std::fclose(file);
+        }
+    }
+    //empty, missing and null paths
+    std::filesystem::resize_file(names[6], 0);
+    std::vector<char const *> paths;
+    for (std::string const &name: names) {
+        paths.push_back(name.c_str());
+    }
+    std::string const missing = (directory / "missing").string();
+    paths[7] = missing.c_str();
+    paths[9] = nullptr;
+
+    std::vector<TextureInfo> infos(count);
+    std::vector<ConvertStatus> statuses(count, CONVERT_OK);
+    CHECK(probeTextureFiles(paths.data(), count, infos.data(), statuses.data()) == CONVERT_ERROR_DECODE);
+    for (size_t i = 0; i < count; i++) {
+        if (i == 7 || i == 9) {
+            CHECK_MESSAGE(statuses[i] == CONVERT_ERROR_IO && infos[i].container == TEXTURE_CONTAINER_UNKNOWN,
+                          "texture %zu", i);
+            continue;
+        }
+        if (i == 6) {
+            CHECK(statuses[i] == CONVERT_ERROR_DECODE);
+            continue;
+        }
+        //the PNG is cut after PROBE_HEADER_SIZE bytes
+        checkProbedTexture(i, infos[i], statuses[i]);
+    }
+    CHECK(probeTextureFiles(nullptr, 1, infos.data(), statuses.data()) == CONVERT_ERROR_INVALID_ARGUMENT);
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,273 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include "ScratchArena.h"
+#include "ThreadPool.h"
+#include "Test.h"
+
+static constexpr size_t MB = size_t{1} << 20;
+//library default of setScratchArenaTrim
+static constexpr size_t DEFAULT_TRIM = 64 * MB;
+
+/**
+ * Run 'fn' on a new thread, with an arena that has no blocks yet
+ */
+template<typename F>
+static void runWithNewArena(F const &fn) {
+    std::thread thread(fn);
+    thread.join();
+}
+
+static bool isAligned(void const *const pointer) {
+    return reinterpret_cast<uintptr_t>(pointer) % ARENA_ALIGNMENT == 0;
+}
+
+TEST(arenaReallocatesLastAllocationInPlace) {
+    runWithNewArena([]() {
+        ArenaScope scope;
+        ScratchArena &arena = scope.arena;
+        auto *const first = static_cast<unsigned char *>(arena.allocate(100));
+        auto *const last = static_cast<unsigned char *>(arena.allocate(100));
+        CHECK(first != nullptr && last != nullptr && isAligned(first) && isAligned(last));
+        CHECK(arena.contains(first) && arena.contains(last) && !arena.contains(&scope));
+        std::memset(first, 1, 100);
+        std::memset(last, 2, 100);
+
+        //the last allocation grows and shrinks in place while its block has room
+        CHECK(arena.reallocate(last, 1000) == last);
+        CHECK(arena.reallocate(last, 10) == last);
+        CHECK(arena.reallocate(last, 100) == last && last[0] == 2 && last[99] == 2);
+
+        //the others move, with their content
+        auto *const moved = static_cast<unsigned char *>(arena.reallocate(first, 200));
+        CHECK(moved != nullptr && moved != first && isAligned(moved) && moved[0] == 1 && moved[99] == 1);
+
+        //the last allocation moves when the block has no room left, to a new block
+        auto *const grown = static_cast<unsigned char *>(arena.reallocate(moved, 4 * MB));
+        CHECK(grown != nullptr && grown != moved && isAligned(grown) && grown[0] == 1 && grown[99] == 1);
+        CHECK(arena.getCapacity() > 4 * MB);
+
+        CHECK(arena.reallocate(nullptr, 100) != nullptr);
+    });
+}
+
+TEST(arenaReleasesOnlyLastAllocation) {
+    runWithNewArena([]() {
+        ArenaScope scope;
+        ScratchArena &arena = scope.arena;
+        void *const first = arena.allocate(100);
+        void *const last = arena.allocate(100);
+
+        //the memory of the last allocation is reused right away
+        arena.release(last);
+        CHECK(arena.allocate(100) == last);
+
+        //the others wait for the reset
+        arena.release(first);
+        void *const next = arena.allocate(100);
+        CHECK(next != first && next != last);
+
+        arena.release(nullptr);
+        //released twice, the second time it is no longer the last allocation
+        arena.release(next);
+        arena.release(next);
+        CHECK(arena.allocate(100) == next);
+    });
+}
+
+TEST(arenaFrameRewindsAcrossBlocks) {
+    runWithNewArena([]() {
+        ArenaScope scope;
+        ScratchArena &arena = scope.arena;
+        void *const before = arena.allocate(100);
+        void *const expected = arena.allocate(100);
+        arena.release(expected);
+
+        void *large = nullptr;
+        size_t capacity = 0;
+        {
+            ArenaFrame frame;
+            //larger than the first block, the frame ends in a second block
+            large = arena.allocate(2 * MB);
+            CHECK(large != nullptr && arena.allocate(100) != nullptr);
+            capacity = arena.getCapacity();
+            CHECK(capacity >= 3 * MB);
+            {
+                ArenaFrame nested;
+                CHECK(arena.allocate(100) != nullptr);
+            }
+        }
+        //the frame gives back the memory of both blocks, without releasing them
+        CHECK(arena.allocate(100) == expected);
+        CHECK(arena.allocate(2 * MB) == large);
+        CHECK(arena.getCapacity() == capacity);
+        CHECK(arena.contains(before));
+    });
+
+    //a frame outside of a scope, on a thread that never used the arena
+    runWithNewArena([]() {
+        ScratchArena &arena = getScratchArena();
+        CHECK(!arena.isActive());
+        {
+            ArenaFrame frame;
+            CHECK(arena.allocate(100) != nullptr);
+        }
+        ArenaFrame frame;
+        void *const first = arena.allocate(100);
+        CHECK(first != nullptr);
+    });
+}
+
+TEST(arenaResetMergesBlocksAndTrims) {
+    runWithNewArena([]() {
+        ScratchArena &arena = getScratchArena();
+        //a conversion over several blocks, the reset keeps a single block for all of it
+        auto const convert = [&arena]() {
+            ArenaScope scope;
+            CHECK(arena.isActive());
+            {
+                //the outermost scope resets
+                ArenaScope nested;
+                CHECK(arena.allocate(MB / 2) != nullptr);
+            }
+            CHECK(arena.allocate(2 * MB) != nullptr);
+            CHECK(arena.allocate(3 * MB) != nullptr);
+        };
+        convert();
+        CHECK(!arena.isActive());
+        size_t const capacity = arena.getCapacity();
+        CHECK(capacity >= 5 * MB + MB / 2);
+
+        //the same conversion fits in the merged block
+        convert();
+        CHECK(arena.getCapacity() == capacity);
+        {
+            ArenaScope scope;
+            void *const first = arena.allocate(MB / 2);
+            void *const second = arena.allocate(5 * MB);
+            CHECK(first != nullptr && second != nullptr && arena.getCapacity() == capacity);
+        }
+
+        //over the trim size, the blocks are released
+        setScratchArenaTrim(4 * MB);
+        convert();
+        CHECK(arena.getCapacity() == 0);
+
+        //below, one block is kept
+        setScratchArenaTrim(DEFAULT_TRIM);
+        {
+            ArenaScope scope;
+            CHECK(arena.allocate(100) != nullptr);
+        }
+        CHECK(arena.getCapacity() > 0 && arena.getCapacity() <= 2 * MB);
+
+        //nothing is kept
+        setScratchArenaTrim(0);
+        {
+            ArenaScope scope;
+            CHECK(arena.allocate(100) != nullptr);
+        }
+        CHECK(arena.getCapacity() == 0);
+        setScratchArenaTrim(DEFAULT_TRIM);
+    });
+}
+
+TEST(arenaFrameOutsideScopeTrims) {
+    runWithNewArena([]() {
+        ScratchArena &arena = getScratchArena();
+        //a task over several blocks, the outermost frame merges them like a scope
+        auto const task = [&arena]() {
+            ArenaFrame frame;
+            CHECK(arena.allocate(2 * MB) != nullptr);
+            CHECK(arena.allocate(3 * MB) != nullptr);
+        };
+        task();
+        size_t const capacity = arena.getCapacity();
+        CHECK(capacity >= 5 * MB);
+        task();
+        CHECK(arena.getCapacity() == capacity);
+
+        //a frame that starts after allocations of another only rewinds
+        {
+            ArenaFrame outer;
+            void *const first = arena.allocate(100);
+            {
+                ArenaFrame inner;
+                CHECK(arena.allocate(6 * MB) != nullptr);
+            }
+            CHECK(arena.getCapacity() > capacity && arena.contains(first));
+        }
+        CHECK(arena.getCapacity() >= 6 * MB);
+
+        //inside a conversion the scope resets, not the frame
+        setScratchArenaTrim(4 * MB);
+        {
+            ArenaScope scope;
+            {
+                ArenaFrame frame;
+                CHECK(arena.allocate(5 * MB) != nullptr);
+            }
+            CHECK(arena.getCapacity() >= 5 * MB);
+        }
+        CHECK(arena.getCapacity() == 0);
+
+        //over the trim size, the blocks are released
+        task();
+        CHECK(arena.getCapacity() == 0);
+        setScratchArenaTrim(DEFAULT_TRIM);
+    });
+
+    //the workers of the pool keep no more than the trim size between tasks
+    setScratchArenaTrim(MB);
+    constexpr size_t tasks = 64;
+    getThreadPool()->parallelFor(tasks, [](size_t const, size_t const) {
+        ArenaFrame frame;
+        CHECK(frame.arena.allocate(4 * MB) != nullptr);
+    });
+    std::atomic<size_t> largest{0};
+    getThreadPool()->parallelFor(tasks, [&largest](size_t const, size_t const) {
+        size_t const capacity = getScratchArena().getCapacity();
+        size_t previous = largest.load();
+        while (capacity > previous && !largest.compare_exchange_weak(previous, capacity)) {
+        }
+    });
+    setScratchArenaTrim(DEFAULT_TRIM);
+    CHECK_MESSAGE(largest.load() <= MB, "%zu bytes", largest.load());
+}
+
+TEST(arenaRejectsOversizedAllocations) {
+    runWithNewArena([]() {
+        ArenaScope scope;
+        CHECK(scope.arena.allocate(SIZE_MAX) == nullptr);
+        CHECK(scope.arena.allocateArray<uint64_t>(SIZE_MAX / 4) == nullptr);
+        //the arena still works after a failure
+        CHECK(scope.arena.allocate(100) != nullptr);
+    });
+}
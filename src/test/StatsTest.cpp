@@ -0,0 +1,328 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Stats.h"
+#include "Test.h"
+
+/**
+ * Enables the counters from a reset state, and disables them and the tracing at the end of the test
+ */
+class StatsSession {
+public:
+    StatsSession() {
+        resetStats();
+        setStatsEnabled(true);
+    }
+
+    ~StatsSession() {
+        setStatsEnabled(false);
+        setTraceCallbacks(nullptr, nullptr, nullptr);
+        resetStats();
+    }
+
+    StatsSession(StatsSession const &) = delete;
+
+    StatsSession &operator=(StatsSession const &) = delete;
+};
+
+static ConvertStats getCurrentStats() {
+    ConvertStats stats{};
+    CHECK(getStats(&stats) == CONVERT_OK);
+    return stats;
+}
+
+static void recordSpans(StatsStage const stage, size_t const spans, size_t const bytesIn, size_t const bytesOut) {
+    for (size_t i = 0; i < spans; i++) {
+        StatsScope scope(stage, bytesIn);
+        scope.finish(i % 2 == 0 ? CONVERT_OK : CONVERT_ERROR_DECODE, bytesOut);
+    }
+}
+
+static uint64_t getHistogramTotal(StageStats const &stage) {
+    uint64_t total = 0;
+    for (uint64_t const spans: stage.histogram) {
+        total += spans;
+    }
+    return total;
+}
+
+/**
+ * Runs a thread that records its spans, then waits until release() before exiting
+ */
+class ParkedThread {
+public:
+    ParkedThread(StatsStage const stage, size_t const spans) : thread([this, stage, spans]() {
+        recordSpans(stage, spans, 1, 2);
+        std::unique_lock<std::mutex> lock(mutex);
+        recorded = true;
+        condition.notify_all();
+        condition.wait(lock, [this]() { return released; });
+    }) {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this]() { return recorded; });
+    }
+
+    ~ParkedThread() {
+        release();
+    }
+
+    ParkedThread(ParkedThread const &) = delete;
+
+    ParkedThread &operator=(ParkedThread const &) = delete;
+
+    void release() {
+        if (thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                released = true;
+            }
+            condition.notify_all();
+            thread.join();
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool recorded = false;
+    bool released = false;
+    std::thread thread;
+};
+
+TEST(statsAreSummedOverLiveAndExitedThreads) {
+    StatsSession session;
+    constexpr size_t threads = 4;
+    constexpr size_t spans = 25;
+    std::vector<std::thread> exited;
+    for (size_t i = 0; i < threads; i++) {
+        exited.emplace_back(recordSpans, STATS_STAGE_DDS_WRITE, spans, 10, 3);
+    }
+    for (std::thread &thread: exited) {
+        thread.join();
+    }
+    recordSpans(STATS_STAGE_DDS_WRITE, spans, 10, 3);
+    ParkedThread live(STATS_STAGE_DDS_WRITE, spans);
+
+    //the parked thread is counted while alive and after its counters are merged into the exited threads
+    for (int pass = 0; pass < 2; pass++) {
+        StageStats const stage = getCurrentStats().stages[STATS_STAGE_DDS_WRITE];
+        uint64_t const total = (threads + 2) * spans;
+        CHECK_MESSAGE(stage.count == total, "pass %d count %llu", pass, static_cast<unsigned long long>(stage.count));
+        CHECK(stage.failures == (threads + 2) * (spans / 2));
+        CHECK(stage.bytesIn == (threads + 1) * spans * 10 + spans);
+        CHECK(stage.bytesOut == (threads + 1) * spans * 3 + spans * 2);
+        CHECK(stage.maxNanoseconds <= stage.totalNanoseconds);
+        CHECK(getHistogramTotal(stage) == total);
+        live.release();
+    }
+    CHECK(getCurrentStats().stages[STATS_STAGE_PNG_TO_DDS].count == 0);
+}
+
+TEST(resetStatsClearsEveryThread) {
+    StatsSession session;
+    std::thread(recordSpans, STATS_STAGE_PNG_DECODE, 5, 1, 1).join();
+    recordSpans(STATS_STAGE_PNG_DECODE, 5, 1, 1);
+    ParkedThread live(STATS_STAGE_PNG_DECODE, 5);
+    CHECK(getCurrentStats().stages[STATS_STAGE_PNG_DECODE].count == 15);
+
+    resetStats();
+    StageStats stage = getCurrentStats().stages[STATS_STAGE_PNG_DECODE];
+    CHECK(stage.count == 0 && stage.failures == 0 && stage.bytesIn == 0 && stage.totalNanoseconds == 0);
+    CHECK(getHistogramTotal(stage) == 0);
+
+    //counters recorded before the reset are not merged when their thread exits
+    live.release();
+    CHECK(getCurrentStats().stages[STATS_STAGE_PNG_DECODE].count == 0);
+
+    recordSpans(STATS_STAGE_PNG_DECODE, 3, 4, 1);
+    stage = getCurrentStats().stages[STATS_STAGE_PNG_DECODE];
+    CHECK(stage.count == 3 && stage.failures == 1 && stage.bytesIn == 12 && stage.bytesOut == 3);
+
+    //disabled counters keep their values and stop recording
+    setStatsEnabled(false);
+    recordSpans(STATS_STAGE_PNG_DECODE, 3, 4, 1);
+    CHECK(getCurrentStats().stages[STATS_STAGE_PNG_DECODE].count == 3);
+    CHECK(getStats(nullptr) == CONVERT_ERROR_INVALID_ARGUMENT);
+}
+
+TEST(nestedScopesCountAllocationsInEveryParent) {
+    StatsSession session;
+    StatsScope::countAllocation(1000);
+    {
+        StatsScope outer(STATS_STAGE_PNG_TO_DDS, 0);
+        StatsScope::countAllocation(50);
+        {
+            StatsScope inner(STATS_STAGE_PNG_DECODE, 0);
+            StatsScope::countAllocation(100);
+            {
+                StatsScope innermost(STATS_STAGE_MIP_GENERATION, 0);
+                StatsScope::countAllocation(7);
+            }
+            StatsScope::countAllocation(100);
+        }
+        {
+            StatsScope sibling(STATS_STAGE_BC_ENCODE, 0);
+            StatsScope::countAllocation(3);
+        }
+    }
+    StatsScope::countAllocation(1000);
+
+    ConvertStats const stats = getCurrentStats();
+    StageStats const &mips = stats.stages[STATS_STAGE_MIP_GENERATION];
+    StageStats const &decode = stats.stages[STATS_STAGE_PNG_DECODE];
+    StageStats const &encode = stats.stages[STATS_STAGE_BC_ENCODE];
+    StageStats const &convert = stats.stages[STATS_STAGE_PNG_TO_DDS];
+    CHECK(mips.allocations == 1 && mips.allocatedBytes == 7);
+    CHECK(decode.allocations == 3 && decode.allocatedBytes == 207);
+    CHECK(encode.allocations == 1 && encode.allocatedBytes == 3);
+    CHECK(convert.allocations == 5 && convert.allocatedBytes == 260);
+    CHECK(stats.stages[STATS_STAGE_DDS_LOAD].allocations == 0);
+}
+
+/**
+ * Expected bucket of a span: under 1us in bucket 0, [2^(i-1), 2^i) us in bucket i
+ */
+static size_t getExpectedBucket(uint64_t const nanoseconds) {
+    uint64_t const microseconds = nanoseconds / 1000;
+    size_t bucket = 0;
+    while (bucket + 1 < STATS_HISTOGRAM_BUCKETS && (uint64_t{1} << bucket) <= microseconds) {
+        bucket++;
+    }
+    return bucket;
+}
+
+TEST(spanDurationSelectsHistogramBucket) {
+    StatsSession session;
+    CHECK(getExpectedBucket(999) == 0);
+    CHECK(getExpectedBucket(1000) == 1);
+    CHECK(getExpectedBucket(2000) == 2);
+    CHECK(getExpectedBucket(2047999) == 11);
+    CHECK(getExpectedBucket(2048000) == 12);
+    CHECK(getExpectedBucket(UINT64_MAX) == STATS_HISTOGRAM_BUCKETS - 1);
+
+    std::chrono::microseconds const sleeps[] = {std::chrono::microseconds(0), std::chrono::microseconds(300),
+                                                std::chrono::microseconds(2500), std::chrono::microseconds(20000)};
+    for (std::chrono::microseconds const sleep: sleeps) {
+        resetStats();
+        {
+            StatsScope scope(STATS_STAGE_PNG_ENCODE, 0);
+            if (sleep.count() != 0) {
+                std::this_thread::sleep_for(sleep);
+            }
+        }
+        StageStats const stage = getCurrentStats().stages[STATS_STAGE_PNG_ENCODE];
+        auto const sleepCount = static_cast<long long>(sleep.count());
+        CHECK_MESSAGE(stage.count == 1 && stage.maxNanoseconds == stage.totalNanoseconds, "sleep %lldus", sleepCount);
+        CHECK_MESSAGE(stage.totalNanoseconds >= static_cast<uint64_t>(sleep.count()) * 1000, "sleep %lldus",
+                      sleepCount);
+        size_t const expected = getExpectedBucket(stage.totalNanoseconds);
+        CHECK_MESSAGE(stage.histogram[expected] == 1 && getHistogramTotal(stage) == 1, "sleep %lldus bucket %zu",
+                      sleepCount, expected);
+    }
+}
+
+class TraceRecorder {
+public:
+    std::mutex mutex;
+    std::vector<uintptr_t> open;
+    std::vector<StatsStage> ended;
+    uintptr_t nextSpan = 1;
+    size_t mismatches = 0;
+    TraceSpan last{};
+};
+
+static void *beginTrace(StatsStage const stage, void *const userData) {
+    auto &recorder = *static_cast<TraceRecorder *>(userData);
+    std::lock_guard<std::mutex> lock(recorder.mutex);
+    //the stage is kept in the low bits of the handle to check it comes back with the end callback
+    uintptr_t const span = (recorder.nextSpan++ << 4) | static_cast<uintptr_t>(stage);
+    recorder.open.push_back(span);
+    return reinterpret_cast<void *>(span);
+}
+
+static void endTrace(void *const span, TraceSpan const *const info, void *const userData) {
+    auto &recorder = *static_cast<TraceRecorder *>(userData);
+    std::lock_guard<std::mutex> lock(recorder.mutex);
+    auto const handle = reinterpret_cast<uintptr_t>(span);
+    //spans of one thread end in reverse order of their begin
+    if (recorder.open.empty() || recorder.open.back() != handle ||
+        (handle & 0xf) != static_cast<uintptr_t>(info->stage)) {
+        recorder.mismatches++;
+    } else {
+        recorder.open.pop_back();
+    }
+    recorder.ended.push_back(info->stage);
+    recorder.last = *info;
+}
+
+TEST(traceCallbacksPairEveryBeginWithItsEnd) {
+    StatsSession session;
+    setStatsEnabled(false);
+    TraceRecorder recorder;
+    setTraceCallbacks(beginTrace, endTrace, &recorder);
+    {
+        StatsScope outer(STATS_STAGE_DDS_TO_PNG, 40);
+        {
+            StatsScope load(STATS_STAGE_DDS_LOAD, 40);
+            load.finish(CONVERT_OK, 64);
+        }
+        {
+            StatsScope encode(STATS_STAGE_PNG_ENCODE, 64);
+            encode.setBytesIn(65);
+            encode.finish(CONVERT_ERROR_ENCODE, 9);
+        }
+        {
+            std::lock_guard<std::mutex> lock(recorder.mutex);
+            CHECK(recorder.open.size() == 1 && recorder.mismatches == 0);
+            CHECK(recorder.last.stage == STATS_STAGE_PNG_ENCODE && recorder.last.status == CONVERT_ERROR_ENCODE);
+            CHECK(recorder.last.bytesIn == 65 && recorder.last.bytesOut == 9);
+        }
+        outer.finish(CONVERT_OK, 9);
+    }
+    CHECK(recorder.open.empty() && recorder.mismatches == 0);
+    CHECK((recorder.ended == std::vector<StatsStage>{STATS_STAGE_DDS_LOAD, STATS_STAGE_PNG_ENCODE,
+                                                       STATS_STAGE_DDS_TO_PNG}));
+    CHECK(recorder.last.stage == STATS_STAGE_DDS_TO_PNG && recorder.last.bytesIn == 40);
+
+    //tracing alone does not record counters
+    CHECK(getCurrentStats().stages[STATS_STAGE_DDS_TO_PNG].count == 0);
+
+    //a span ends with the callbacks it started with, and no span starts once they are removed
+    recorder.ended.clear();
+    {
+        StatsScope scope(STATS_STAGE_DDS_WRITE, 0);
+        setTraceCallbacks(nullptr, nullptr, nullptr);
+        StatsScope untraced(STATS_STAGE_BC_ENCODE, 0);
+    }
+    CHECK(recorder.open.empty() && recorder.mismatches == 0);
+    CHECK(recorder.ended == std::vector<StatsStage>{STATS_STAGE_DDS_WRITE});
+}
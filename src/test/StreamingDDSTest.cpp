@@ -0,0 +1,117 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <random>
+#include <vector>
+#include <lodepng.h>
+#include "DxTexWrapper.h"
+#include "StreamingDDS.h"
+#include "Test.h"
+
+/**
+ * Random pixels, so an error in any level or row of the box filter changes the output
+ */
+static std::vector<unsigned char> getLodePng(unsigned int const width, unsigned int const height,
+                                             bool const interlaced) {
+    std::mt19937 random(width * 131 + height);
+    std::vector<unsigned char> pixels = getRandomBytes(size_t{width} * height * 4, random);
+    lodepng::State state;
+    state.info_png.interlace_method = interlaced ? 1 : 0;
+    std::vector<unsigned char> png;
+    lodepng::encode(png, pixels, width, height, state);
+    return png;
+}
+
+/**
+ * The streamed texture must have the same bytes as the conversion of the whole image
+ */
+static void checkStreamMatchesRegular(unsigned int const width, unsigned int const height, bool const interlaced) {
+    std::vector<unsigned char> const png = getLodePng(width, height, interlaced);
+    for (bool const dx10ext: {false, true}) {
+        for (bool const bgra: {false, true}) {
+            ContentBuffer regular{};
+            ContentBuffer streamed{};
+            ConvertStatus const regularStatus =
+                    convertPNGtoDDSEx(png.data(), png.size(), dx10ext, bgra, nullptr, nullptr, &regular);
+            ConvertStatus const streamedStatus =
+                    convertPNGtoDDSStreamEx(png.data(), png.size(), dx10ext, bgra, nullptr, nullptr, &streamed);
+            CHECK_MESSAGE(regularStatus == CONVERT_OK && streamedStatus == CONVERT_OK,
+                          "%ux%u interlaced %d dx10 %d bgra %d", width, height, interlaced, dx10ext, bgra);
+            std::vector<unsigned char> const expected = takeContent(regular);
+            std::vector<unsigned char> const actual = takeContent(streamed);
+            CHECK_MESSAGE(!expected.empty() && actual == expected, "%ux%u interlaced %d dx10 %d bgra %d", width,
+                          height, interlaced, dx10ext, bgra);
+        }
+    }
+}
+
+TEST(streamedDDSMatchesRegularConversion) {
+    //even, odd, and both, where the last row and column are folded into the next level
+    for (unsigned int const width: {1u, 2u, 3u, 4u, 7u, 16u, 33u}) {
+        for (unsigned int const height: {1u, 2u, 3u, 5u, 8u, 31u}) {
+            checkStreamMatchesRegular(width, height, false);
+        }
+    }
+    //a single row or column, every level is 1 pixel wide or high
+    checkStreamMatchesRegular(1, 257, false);
+    checkStreamMatchesRegular(257, 1, false);
+    checkStreamMatchesRegular(1, 64, false);
+    checkStreamMatchesRegular(64, 1, false);
+    checkStreamMatchesRegular(127, 65, false);
+}
+
+TEST(streamedDDSFallsBackForInterlacedPng) {
+    for (unsigned int const size: {1u, 7u, 32u, 45u}) {
+        std::vector<unsigned char> const png = getLodePng(size, size + 2, true);
+
+        //the rows of Adam7 arrive out of order, streaming is refused before writing to the output
+        size_t ddsSize = 0;
+        CHECK(convertPNGtoDDSInto(png.data(), png.size(), false, false, nullptr, 0, &ddsSize) == CONVERT_OK);
+        std::vector<unsigned char> output(ddsSize);
+        CHECK_MESSAGE(streamPNGtoDDS(png.data(), png.size(), false, false, output.data(), output.size())
+                      == CONVERT_ERROR_INVALID_ARGUMENT, "%ux%u", size, size + 2);
+
+        //the caller buffer variant uses the regular conversion
+        std::vector<unsigned char> expected(ddsSize);
+        std::vector<unsigned char> streamed(ddsSize);
+        size_t expectedSize = 0;
+        size_t streamedSize = 0;
+        CHECK(convertPNGtoDDSInto(png.data(), png.size(), false, false, expected.data(), expected.size(),
+                                  &expectedSize) == CONVERT_OK);
+        CHECK_MESSAGE(convertPNGtoDDSStreamInto(png.data(), png.size(), false, false, streamed.data(),
+                                                streamed.size(), &streamedSize) == CONVERT_OK
+                      && streamedSize == expectedSize && streamed == expected, "%ux%u", size, size + 2);
+
+        checkStreamMatchesRegular(size, size + 2, true);
+    }
+}
+
+TEST(mipChainPixelsSizeCoversEveryLevel) {
+    CHECK(getMipChainPixelsSize(1, 1, 1) == 4);
+    CHECK(getMipChainPixelsSize(4, 4, 3) == (16 + 4 + 1) * 4);
+    CHECK(getMipChainPixelsSize(5, 3, 3) == (15 + 2 + 1) * 4);
+    CHECK(getMipChainPixelsSize(8, 1, 4) == (8 + 4 + 2 + 1) * 4);
+}
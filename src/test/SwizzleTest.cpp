@@ -0,0 +1,156 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "CpuFeatures.h"
+#include "Swizzle.h"
+#include "Test.h"
+
+/**
+ * Every kernel set this CPU can run, the scalar one first
+ */
+static std::vector<SwizzleKernels> getRunnableSwizzleKernels() {
+    std::vector<SwizzleKernels> kernels{{"scalar", swizzleRGBAtoBGRAScalar, expandRGBtoRGBAScalar,
+                                         premultiplyAlphaScalar}};
+#ifdef DXTWRAPPER_X86
+    if (getCpuFeatures().ssse3) {
+        kernels.push_back({"ssse3", swizzleRGBAtoBGRASsse3, expandRGBtoRGBASsse3, premultiplyAlphaSsse3});
+    }
+    if (getCpuFeatures().avx2) {
+        kernels.push_back({"avx2", swizzleRGBAtoBGRAAvx2, expandRGBtoRGBAAvx2, premultiplyAlphaAvx2});
+    }
+#endif
+    return kernels;
+}
+
+TEST(swizzleKernelsMatchCpuFeatures) {
+    char const *expected = "scalar";
+#ifdef DXTWRAPPER_X86
+    if (getCpuFeatures().avx2) {
+        expected = "avx2";
+    } else if (getCpuFeatures().ssse3) {
+        expected = "ssse3";
+    }
+#endif
+    CHECK_MESSAGE(std::strcmp(getSwizzleKernels().name, expected) == 0, "selected %s", getSwizzleKernels().name);
+}
+
+TEST(swizzleRGBAtoBGRAMatchesScalar) {
+    std::mt19937 random(1);
+    for (SwizzleKernels const &kernels: getRunnableSwizzleKernels()) {
+        for (size_t const count: getKernelCounts()) {
+            //unaligned starts too, the kernels use unaligned loads
+            for (size_t offset = 0; offset < 4; offset++) {
+                std::vector<unsigned char> const pixels = getRandomBytes(count * 4, random);
+                std::vector<unsigned char> expected = pixels;
+                swizzleRGBAtoBGRAScalar(expected.data(), expected.size());
+
+                std::vector<unsigned char> buffer(offset + count * 4 + GUARD_SIZE, GUARD);
+                std::copy(pixels.begin(), pixels.end(), buffer.begin() + offset);
+                kernels.swizzleRGBAtoBGRA(buffer.data() + offset, count * 4);
+                CHECK_MESSAGE(std::equal(expected.begin(), expected.end(), buffer.begin() + offset),
+                              "%s, %zu pixels at offset %zu", kernels.name, count, offset);
+                CHECK_MESSAGE(isGuardIntact(buffer, offset + count * 4), "%s, %zu pixels", kernels.name, count);
+            }
+        }
+    }
+}
+
+TEST(expandRGBtoRGBAMatchesScalar) {
+    std::mt19937 random(2);
+    for (SwizzleKernels const &kernels: getRunnableSwizzleKernels()) {
+        for (size_t const count: getKernelCounts()) {
+            //exactly sized, so reads past the last pixel are caught by the address sanitizer
+            std::vector<unsigned char> const rgb = getRandomBytes(count * 3, random);
+            std::vector<unsigned char> expected(count * 4);
+            for (size_t i = 0; i < count; i++) {
+                std::copy_n(&rgb[i * 3], 3, &expected[i * 4]);
+                expected[i * 4 + 3] = 0xff;
+            }
+
+            std::vector<unsigned char> buffer(count * 4 + GUARD_SIZE, GUARD);
+            kernels.expandRGBtoRGBA(rgb.data(), buffer.data(), count);
+            CHECK_MESSAGE(std::equal(expected.begin(), expected.end(), buffer.begin()), "%s, %zu pixels",
+                          kernels.name, count);
+            CHECK_MESSAGE(isGuardIntact(buffer, count * 4), "%s, %zu pixels", kernels.name, count);
+        }
+    }
+}
+
+TEST(premultiplyAlphaMatchesScalar) {
+    std::mt19937 random(3);
+    for (SwizzleKernels const &kernels: getRunnableSwizzleKernels()) {
+        for (size_t const count: getKernelCounts()) {
+            for (size_t offset = 0; offset < 4; offset++) {
+                std::vector<unsigned char> const pixels = getRandomBytes(count * 4, random);
+                std::vector<unsigned char> expected = pixels;
+                premultiplyAlphaScalar(expected.data(), expected.size());
+
+                std::vector<unsigned char> buffer(offset + count * 4 + GUARD_SIZE, GUARD);
+                std::copy(pixels.begin(), pixels.end(), buffer.begin() + offset);
+                kernels.premultiplyAlpha(buffer.data() + offset, count * 4);
+                CHECK_MESSAGE(std::equal(expected.begin(), expected.end(), buffer.begin() + offset),
+                              "%s, %zu pixels at offset %zu", kernels.name, count, offset);
+                CHECK_MESSAGE(isGuardIntact(buffer, offset + count * 4), "%s, %zu pixels", kernels.name, count);
+            }
+        }
+    }
+}
+
+/**
+ * Every color and alpha pair, each kernel must round c * a / 255 to nearest and keep alpha
+ */
+TEST(premultiplyAlphaRoundsToNearest) {
+    std::vector<unsigned char> pixels(256 * 256 * 4);
+    for (unsigned int a = 0; a < 256; a++) {
+        for (unsigned int c = 0; c < 256; c++) {
+            unsigned char *const pixel = &pixels[(a * 256 + c) * 4];
+            pixel[0] = static_cast<unsigned char>(c);
+            pixel[1] = static_cast<unsigned char>(255 - c);
+            pixel[2] = static_cast<unsigned char>(c ^ 0x55);
+            pixel[3] = static_cast<unsigned char>(a);
+        }
+    }
+
+    for (SwizzleKernels const &kernels: getRunnableSwizzleKernels()) {
+        std::vector<unsigned char> result = pixels;
+        kernels.premultiplyAlpha(result.data(), result.size());
+        size_t mismatches = 0;
+        for (size_t i = 0; i < pixels.size(); i += 4) {
+            unsigned int const a = pixels[i + 3];
+            for (size_t channel = 0; channel < 3; channel++) {
+                //c * a / 255 is never halfway, 255 is odd
+                unsigned int const expected = (pixels[i + channel] * a * 2 + 255) / 510;
+                mismatches += result[i + channel] != expected;
+            }
+            mismatches += result[i + 3] != a;
+        }
+        CHECK_MESSAGE(mismatches == 0, "%s, %zu channels", kernels.name, mismatches);
+    }
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "DxTexWrapper.h"
+
+/**
+ * A test registered with TEST, run by dxtexwrapper-tests
+ */
+class TestCase {
+public:
+    char const *name;
+    void (*function)();
+};
+
+/**
+ * Every test of the executable, in the order of registration
+ */
+std::vector<TestCase> &getTestCases();
+
+class TestRegistration {
+public:
+    TestRegistration(char const *const name, void (*const function)()) {
+        getTestCases().push_back({name, function});
+    }
+};
+
+/**
+ * Fail the running test, it continues to the end so every failed check is reported
+ */
+void reportFailure(char const *file, int line, char const *expression, char const *format, ...);
+
+#define TEST(name)                                                                                                     \
+    static void name();                                                                                                \
+    static TestRegistration const name##Registration(#name, name);                                                     \
+    static void name()
+
+#define CHECK(condition)                                                                                               \
+    do {                                                                                                               \
+        if (!(condition)) {                                                                                            \
+            reportFailure(__FILE__, __LINE__, #condition, nullptr);                                                    \
+        }                                                                                                              \
+    } while (false)
+
+//the message identifies the case, like the kernel and the size
+#define CHECK_MESSAGE(condition, format, ...)                                                                          \
+    do {                                                                                                               \
+        if (!(condition)) {                                                                                            \
+            reportFailure(__FILE__, __LINE__, #condition, format, __VA_ARGS__);                                        \
+        }                                                                                                              \
+    } while (false)
+
+//bytes or values after the output of a kernel, it must not write them
+constexpr size_t GUARD_SIZE = 64;
+constexpr unsigned char GUARD = 0xa5;
+
+template<typename T>
+bool isGuardIntact(std::vector<T> const &buffer, size_t const size, T const guard) {
+    return std::all_of(buffer.begin() + static_cast<std::ptrdiff_t>(size), buffer.end(),
+                       [guard](T const value) { return value == guard; });
+}
+
+inline bool isGuardIntact(std::vector<unsigned char> const &buffer, size_t const size) {
+    return isGuardIntact(buffer, size, GUARD);
+}
+
+inline std::vector<unsigned char> getRandomBytes(size_t const size, std::mt19937 &random) {
+    std::vector<unsigned char> bytes(size);
+    for (unsigned char &byte: bytes) {
+        byte = static_cast<unsigned char>(random());
+    }
+    return bytes;
+}
+
+/**
+ * Element counts for the kernels: every count up to several iterations of the widest loop, and larger ones with tails
+ * of every length
+ */
+inline std::vector<size_t> getKernelCounts() {
+    std::vector<size_t> counts;
+    for (size_t count = 0; count <= 40; count++) {
+        counts.push_back(count);
+    }
+    for (size_t count = 1000; count < 1016; count++) {
+        counts.push_back(count);
+    }
+    return counts;
+}
+
+/**
+ * The bytes of a buffer returned by the library, which is freed
+ */
+inline std::vector<unsigned char> takeContent(ContentBuffer &content) {
+    auto const *const bytes = static_cast<unsigned char const *>(content.content);
+    std::vector<unsigned char> result(bytes, bytes + content.size);
+    freeContentBuffer(&content);
+    return result;
+}
+
+/**
+ * A PNG of a gradient with noise, written by the library encoder. Odd sizes make the mip chain fold its last row and
+ * column
+ */
+inline std::vector<unsigned char> getPng(size_t const width, size_t const height) {
+    std::mt19937 random(static_cast<unsigned int>(width * 31 + height));
+    std::vector<unsigned char> pixels(width * height * 4);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = static_cast<unsigned char>(i / 4 % width + random() % 16);
+    }
+    DirectX::Image image{};
+    image.width = width;
+    image.height = height;
+    image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    image.rowPitch = width * 4;
+    image.slicePitch = pixels.size();
+    image.pixels = pixels.data();
+    PngOutput output{};
+    if (encodePng(image, resolvePngEncodeOptions(nullptr, image), output) != CONVERT_OK) {
+        return {};
+    }
+    auto const *const content = static_cast<unsigned char const *>(output.content);
+    std::vector<unsigned char> png(content, content + output.size);
+    std::free(output.content);
+    return png;
+}
@@ -0,0 +1,88 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+/*
+ * dxtexwrapper-tests: unit tests of the kernels and codecs. Run without arguments for every test, or with the names
+ * of the tests to run. The exit status is 0 when every test passed.
+ */
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include "Test.h"
+
+static bool failed = false;
+
+std::vector<TestCase> &getTestCases() {
+    static std::vector<TestCase> testCases;
+    return testCases;
+}
+
+void reportFailure(char const *const file, int const line, char const *const expression, char const *const format,
+                   ...) {
+    failed = true;
+    std::fprintf(stderr, "%s:%d: check failed: %s", file, line, expression);
+    if (format != nullptr) {
+        std::fputs(" (", stderr);
+        va_list args;
+        va_start(args, format);
+        std::vfprintf(stderr, format, args);
+        va_end(args);
+        std::fputc(')', stderr);
+    }
+    std::fputc('\n', stderr);
+}
+
+static bool isSelected(char const *const name, int const argc, char **const argv) {
+    if (argc < 2) {
+        return true;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    size_t run = 0;
+    size_t failures = 0;
+    for (TestCase const &testCase: getTestCases()) {
+        if (!isSelected(testCase.name, argc, argv)) {
+            continue;
+        }
+        failed = false;
+        testCase.function();
+        run++;
+        if (failed) {
+            failures++;
+        }
+        std::printf("%s %s\n", failed ? "FAIL" : "ok  ", testCase.name);
+    }
+    std::printf("%zu tests, %zu failed\n", run, failures);
+    return failures == 0 && run > 0 ? 0 : 1;
+}
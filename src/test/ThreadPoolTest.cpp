@@ -0,0 +1,96 @@
+/*
+    MIT License
+
+    Copyright (c) 2022 Emerson Pinter
+
+     https://github.com/epinter/dxtexwrapper
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "Test.h"
+#include "ThreadPool.h"
+
+TEST(parallelForRunsEveryIndexOnce) {
+    ThreadPool pool(4);
+    for (size_t const count: {1, 2, 3, 4, 5, 17, 1000}) {
+        std::vector<std::atomic<int>> runs(count);
+        std::atomic<bool> validWorker{true};
+        pool.parallelFor(count, [&](size_t const index, size_t const worker) {
+            runs[index]++;
+            if (worker >= pool.getWorkerCount()) {
+                validWorker = false;
+            }
+        });
+        for (size_t i = 0; i < count; i++) {
+            CHECK_MESSAGE(runs[i].load() == 1, "index %zu of %zu ran %d times", i, count, runs[i].load());
+        }
+        CHECK(validWorker.load());
+    }
+}
+
+//jobs of the outer call running on the current thread
+static thread_local int runningJobs = 0;
+
+/**
+ * Jobs with nested calls, like a batch of conversions generating mipmaps. While a worker waits for its nested call it
+ * may only run indices of that call: another job run on top of the first would share its thread-local state.
+ */
+TEST(nestedParallelForRunsOnlyItsOwnIndices) {
+    ThreadPool pool(4);
+    std::atomic<int> nestedJobs{0};
+    std::atomic<int> innerRuns{0};
+    for (int round = 0; round < 10; round++) {
+        pool.parallelFor(16, [&](size_t, size_t) {
+            if (runningJobs++ != 0) {
+                nestedJobs++;
+            }
+            pool.parallelFor(8, [&](size_t, size_t) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                innerRuns++;
+            });
+            runningJobs--;
+        });
+    }
+    CHECK_MESSAGE(nestedJobs.load() == 0, "%d jobs started inside another one", nestedJobs.load());
+    CHECK(innerRuns.load() == 10 * 16 * 8);
+}
+
+TEST(parallelForFromManyThreads) {
+    ThreadPool pool(3);
+    std::atomic<int> runs{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] {
+            for (int call = 0; call < 50; call++) {
+                pool.parallelFor(7, [&](size_t, size_t) {
+                    pool.parallelFor(3, [&](size_t, size_t) { runs++; });
+                });
+            }
+        });
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    CHECK(runs.load() == 4 * 50 * 7 * 3);
+}